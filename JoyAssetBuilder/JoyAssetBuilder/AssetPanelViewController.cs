@@ -26,6 +26,7 @@ namespace JoyAssetBuilder
             imageList.Images.Add(AssetType.Model.ToString(), Properties.Resources.Model3D_outline_16x);
             imageList.Images.Add(AssetType.Texture.ToString(), Properties.Resources.Image_16x);
             imageList.Images.Add(AssetType.Shader.ToString(), Properties.Resources.MaterialDiffuse_16x);
+            imageList.Images.Add(AssetType.Scene.ToString(), Properties.Resources.Database_16x);
             m_view.ImageList = imageList;
             GetDirsAndFiles(m_dataPath, null);
             m_view.ExpandAll();
@@ -79,8 +80,14 @@ namespace JoyAssetBuilder
                         fileItem = new AssetTreeNode(AssetType.Texture, file);
                         break;
                     case ".shader":
+                    case ".comp":
                         fileItem = new AssetTreeNode(AssetType.Shader, file);
                         break;
+                    case ".json":
+                        // materials are json too, only scenes are cooked
+                        if (Path.GetFileName(path) != "scenes") continue;
+                        fileItem = new AssetTreeNode(AssetType.Scene, file);
+                        break;
                     default:
                         continue;
                 }
@@ -104,9 +111,10 @@ namespace JoyAssetBuilder
 
         public void BuildUnbuilded()
         {
+            BuildShaders(m_assetToBuilds.Where(x => !x.Built));
             m_assetToBuilds.ForEach(x =>
             {
-                if (x.Built) return;
+                if (x.Built || IsShader(x)) return;
                 x.Build(out string resultMessage);
                 m_logBox.AppendText(resultMessage);
             });
@@ -114,11 +122,33 @@ namespace JoyAssetBuilder
 
         public void BuildAll()
         {
+            BuildShaders(m_assetToBuilds);
             m_assetToBuilds.ForEach(x =>
             {
+                if (IsShader(x)) return;
                 x.Build(out string resultMessage);
                 m_logBox.AppendText(resultMessage);
             });
         }
+
+        private static bool IsShader(IBuildable buildable)
+        {
+            return buildable is AssetTreeNode node && node.Type == AssetType.Shader;
+        }
+
+        // Shaders are compiled together, so all their stages go to the native compiler in one parallel batch
+        private void BuildShaders(IEnumerable<IBuildable> buildables)
+        {
+            List<AssetTreeNode> shaders = buildables.Where(IsShader).Cast<AssetTreeNode>().ToList();
+            if (shaders.Count == 0) return;
+
+            bool[] built = ShaderBuilder.CompileBatch(shaders.Select(x => x.AssetPath).ToList(), out string resultMessage);
+            for (int i = 0; i < shaders.Count; i++)
+            {
+                shaders[i].SetBuilt(built[i]);
+            }
+
+            m_logBox.AppendText(resultMessage);
+        }
     }
 }
\ No newline at end of file
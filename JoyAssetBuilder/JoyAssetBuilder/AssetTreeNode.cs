@@ -20,7 +20,8 @@ namespace JoyAssetBuilder
         Folder,
         Model,
         Texture,
-        Shader
+        Shader,
+        Scene
     }
 
     public class AssetTreeNode : TreeNode, IBuildable
@@ -33,6 +34,9 @@ namespace JoyAssetBuilder
         bool IBuildable.Built => _mBuilt;
         private bool _mBuilt = false;
 
+        public AssetType Type => m_type;
+        public string AssetPath => m_path;
+
         public AssetTreeNode(AssetType type, string path)
         {
             m_type = type;
@@ -66,11 +70,20 @@ namespace JoyAssetBuilder
                 case AssetType.Shader:
                     _mBuilt = ShaderBuilder.Compile(m_path, out resultMessage);
                     break;
+                case AssetType.Scene:
+                    _mBuilt = SceneBuilder.BuildScene(m_path, out resultMessage);
+                    break;
                 default:
                     throw new ArgumentOutOfRangeException();
             }
 
             BackColor = _mBuilt ? okColor : errorColor;
         }
+
+        public void SetBuilt(bool built)
+        {
+            _mBuilt = built;
+            BackColor = _mBuilt ? okColor : errorColor;
+        }
     }
 }
\ No newline at end of file
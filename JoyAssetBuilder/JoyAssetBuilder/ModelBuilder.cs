@@ -17,35 +17,44 @@ namespace JoyAssetBuilder
             UInt64* vertexSize,
             IntPtr* indexPtr,
             UInt64* indexSize,
+            IntPtr* occluderPtr,
+            UInt64* occluderSize,
             IntPtr* errorMessage);
 
         static unsafe int BuildModel(string modelFileName,
             out byte[] vertexBuffer,
             out byte[] indexBuffer,
+            out byte[] occluderBuffer,
             out string errorMessage)
         {
             IntPtr vertexData = IntPtr.Zero;
             UInt64 vertexDataSize;
             IntPtr indexData = IntPtr.Zero;
             UInt64 indexDataSize;
+            IntPtr occluderData = IntPtr.Zero;
+            UInt64 occluderDataSize;
             IntPtr errorMessagePtr = IntPtr.Zero;
 
             int result = BuildModel(modelFileName,
                 &vertexData, &vertexDataSize,
                 &indexData, &indexDataSize,
+                &occluderData, &occluderDataSize,
                 &errorMessagePtr);
             if (result == 0)
             {
                 vertexBuffer = new byte[vertexDataSize];
                 indexBuffer = new byte[indexDataSize];
+                occluderBuffer = new byte[occluderDataSize];
                 Marshal.Copy(vertexData, vertexBuffer, 0, (int)vertexDataSize);
                 Marshal.Copy(indexData, indexBuffer, 0, (int)indexDataSize);
+                Marshal.Copy(occluderData, occluderBuffer, 0, (int)occluderDataSize);
                 errorMessage = null;
             }
             else
             {
                 vertexBuffer = null;
                 indexBuffer = null;
+                occluderBuffer = null;
                 errorMessage = Marshal.PtrToStringAnsi(errorMessagePtr);
             }
 
@@ -55,7 +64,8 @@ namespace JoyAssetBuilder
 
         public static bool BuildModel(string modelPath, out string resultMessage)
         {
-            int result = BuildModel(modelPath, out var vertexBuffer, out var indexBuffer, out var buidlResult);
+            int result = BuildModel(modelPath, out var vertexBuffer, out var indexBuffer, out var occluderBuffer,
+                out var buidlResult);
             if (result != 0)
             {
                 resultMessage = Path.GetFileName(modelPath) + ": Error building model\n" + buidlResult +
@@ -68,6 +78,8 @@ namespace JoyAssetBuilder
             fileStream.Write(BitConverter.GetBytes(indexBuffer.Length), 0, 4);
             fileStream.Write(vertexBuffer, 0, vertexBuffer.Length);
             fileStream.Write(indexBuffer, 0, indexBuffer.Length);
+            // see MeshOccluder.h
+            fileStream.Write(occluderBuffer, 0, occluderBuffer.Length);
             fileStream.Close();
             resultMessage = Path.GetFileName(modelPath) + ": OK" + Environment.NewLine;
             return true;
@@ -180,12 +180,36 @@ namespace JoyAssetBuilder.Properties {
             }
         }
         
+        /// <summary>
+        ///   Looks up a localized string similar to const uint joyMaterialWordCount = 64;
+        ///	layout(set = 3, binding = 0) uniform sampler2D joyTextures[1024];
+        ///	layout(std430, set = 3, binding = 1) readonly buffer JoyMaterials{
+        ///		uint data[];
+        ///	} joyMaterials;.
+        /// </summary>
+        internal static string JOY_BINDLESS {
+            get {
+                return ResourceManager.GetString("JOY_BINDLESS", resourceCulture);
+            }
+        }
+        
+        /// <summary>
+        ///   Looks up a localized string similar to layout(location = 4) in mat4 joyInstanceModel;
+        ///	layout(location = 8) in uint joyInstanceMaterialSlot;.
+        /// </summary>
+        internal static string JOY_INSTANCE_DATA {
+            get {
+                return ResourceManager.GetString("JOY_INSTANCE_DATA", resourceCulture);
+            }
+        }
+        
         /// <summary>
         ///   Looks up a localized string similar to layout(set = 1, binding = 0) uniform JoyData{
         ///		vec3 cameraWorldPos;
         ///		mat4 cameraProjMatrix;
         ///		float time;
         ///		float deltaTime;
+        ///		mat4 cameraViewMatrix;
         ///	} joyData;.
         /// </summary>
         internal static string JOY_VARIABLES {
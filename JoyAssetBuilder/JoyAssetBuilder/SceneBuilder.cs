@@ -0,0 +1,63 @@
+﻿using System;
+using System.IO;
+using System.Runtime.InteropServices;
+
+namespace JoyAssetBuilder
+{
+    public class SceneBuilder
+    {
+        #region Dll
+
+        const string dllPath = @"D:\CppProjects\JoyEngine\JoyAssetBuilder\x64\Debug\JoyDataBuilderLib.dll";
+
+        [DllImport(dllPath, CallingConvention = CallingConvention.Cdecl)]
+        static extern unsafe int BuildScene(
+            string sceneFileName,
+            IntPtr* sceneDataPtr,
+            UInt64* sceneDataSize,
+            IntPtr* errorMessage);
+
+        static unsafe int BuildScene(string sceneFileName,
+            out byte[] sceneBuffer,
+            out string errorMessage)
+        {
+            IntPtr sceneData = IntPtr.Zero;
+            UInt64 sceneDataSize;
+            IntPtr errorMessagePtr = IntPtr.Zero;
+
+            int result = BuildScene(sceneFileName, &sceneData, &sceneDataSize, &errorMessagePtr);
+            if (result == 0)
+            {
+                sceneBuffer = new byte[sceneDataSize];
+                Marshal.Copy(sceneData, sceneBuffer, 0, (int)sceneDataSize);
+                errorMessage = null;
+            }
+            else
+            {
+                sceneBuffer = null;
+                errorMessage = Marshal.PtrToStringAnsi(errorMessagePtr);
+            }
+
+            return result;
+        }
+        #endregion
+
+        public static bool BuildScene(string scenePath, out string resultMessage)
+        {
+            int result = BuildScene(scenePath, out var sceneBuffer, out var buildResult);
+            if (result != 0)
+            {
+                resultMessage = Path.GetFileName(scenePath) + ": Error building scene\n" + buildResult +
+                                Environment.NewLine;
+                return false;
+            }
+
+            // Blob is loaded in place by the engine, so it's written as is
+            FileStream fileStream = new FileStream(scenePath + ".data", FileMode.Create);
+            fileStream.Write(sceneBuffer, 0, sceneBuffer.Length);
+            fileStream.Close();
+            resultMessage = Path.GetFileName(scenePath) + ": OK" + Environment.NewLine;
+            return true;
+        }
+    }
+}
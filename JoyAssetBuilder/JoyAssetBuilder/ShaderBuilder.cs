@@ -14,12 +14,16 @@ namespace JoyAssetBuilder
         private enum ShaderType : uint
         {
             Vertex = 1 << 0,
-            Fragment = 1 << 1
+            Fragment = 1 << 1,
+            Compute = 1 << 2
         };
 
 
         private const string dllPath = @"D:\CppProjects\JoyEngine\JoyAssetBuilder\x64\Release\JoyShaderBuilderLib.dll";
 
+        // Hidden folder, so the asset panel does not list it
+        private const string cacheDirectory = @"D:\CppProjects\JoyEngine\JoyData\.shader_cache";
+
 
         private struct ShaderDefine
         {
@@ -42,6 +46,24 @@ namespace JoyAssetBuilder
                     ShaderUsage = (uint)(ShaderType.Fragment),
                     DefineString = Properties.Resources.GBUFFER_TEXTURES
                 }
+            },
+            {
+                // Per instance model matrix and bindless material slot, right after the vertex inputs.
+                // Shared material of the shader needs "isInstanced", MVP model is identity then
+                "JOY_INSTANCE_DATA", new ShaderDefine()
+                {
+                    ShaderUsage = (uint)(ShaderType.Vertex),
+                    DefineString = Properties.Resources.JOY_INSTANCE_DATA
+                }
+            },
+            {
+                // Textures and material parameters of "isBindless" shared materials, indexed by the material slot.
+                // Parameters of a material are joyMaterialWordCount words from slot * joyMaterialWordCount
+                "JOY_BINDLESS", new ShaderDefine()
+                {
+                    ShaderUsage = (uint)(ShaderType.Vertex | ShaderType.Fragment),
+                    DefineString = Properties.Resources.JOY_BINDLESS
+                }
             }
         };
 
@@ -90,6 +112,63 @@ namespace JoyAssetBuilder
         [DllImport(dllPath, CallingConvention = CallingConvention.Cdecl)]
         static extern void ReleaseInternalData();
 
+        [StructLayout(LayoutKind.Sequential)]
+        private struct ShaderCompileJob
+        {
+            public IntPtr ShaderText;
+            public int ShaderTextSize;
+            public ShaderType Type;
+        }
+
+        [StructLayout(LayoutKind.Sequential)]
+        private struct ShaderCompileOutput
+        {
+            public IntPtr DataPtr;
+            public UInt64 DataSize;
+            public IntPtr ErrorMessage;
+            public int Status;
+            public int FromCache;
+        }
+
+        [DllImport(dllPath, CallingConvention = CallingConvention.Cdecl)]
+        static extern IntPtr CompileGLSLBatch(
+            [In] ShaderCompileJob[] jobs,
+            int jobCount,
+            string cacheDirectory,
+            [In, Out] ShaderCompileOutput[] outputs);
+
+        [DllImport(dllPath, CallingConvention = CallingConvention.Cdecl)]
+        static extern void ReleaseBatch(IntPtr batch);
+
+        [DllImport(dllPath, CallingConvention = CallingConvention.Cdecl)]
+        static extern unsafe int BuildShaderLayout(byte[] vertexData, UInt64 vertexDataSize,
+            byte[] fragmentData, UInt64 fragmentDataSize,
+            IntPtr* layoutPtr, UInt64* layoutSize, IntPtr* errorMessage);
+
+        static unsafe int BuildShaderLayout(byte[] vertexData, byte[] fragmentData, out byte[] layout,
+            out string errorMessage)
+        {
+            IntPtr layoutData = IntPtr.Zero;
+            UInt64 layoutSize;
+            IntPtr errorMessagePtr = IntPtr.Zero;
+            int result = BuildShaderLayout(vertexData, (UInt64)vertexData.Length,
+                fragmentData, (UInt64)fragmentData.Length,
+                &layoutData, &layoutSize, &errorMessagePtr);
+            if (result == 0)
+            {
+                layout = new byte[layoutSize];
+                Marshal.Copy(layoutData, layout, 0, (int)layoutSize);
+                errorMessage = null;
+            }
+            else
+            {
+                layout = null;
+                errorMessage = Marshal.PtrToStringAnsi(errorMessagePtr);
+            }
+
+            return result;
+        }
+
         [DllImport(dllPath, CallingConvention = CallingConvention.Cdecl)]
         static extern void ReleaseCompiler();
 
@@ -109,8 +188,11 @@ namespace JoyAssetBuilder
 
         #endregion
 
-        public static bool Compile(string shaderPath, out string message)
+        private static bool GenerateSources(string shaderPath, out string vertexSource, out string fragmentSource,
+            out string message)
         {
+            vertexSource = null;
+            fragmentSource = null;
             string shader = File.ReadAllText(shaderPath);
 
             const string vertInputAttr = "vert_input";
@@ -323,41 +405,150 @@ namespace JoyAssetBuilder
 
             Console.WriteLine(fragmentShaderStr);
 
-            InitializeCompiler();
+            vertexSource = vertexShaderStr.ToString();
+            fragmentSource = fragmentShaderStr.ToString();
+            message = null;
+            return true;
+        }
 
-            int vResult = CompileGLSL(vertexShaderStr.ToString(), ShaderType.Vertex, out var vertexData,
-                out var vErrorMessage);
-            ReleaseInternalData();
+        public static bool Compile(string shaderPath, out string message)
+        {
+            bool[] built = CompileBatch(new List<string> { shaderPath }, out message);
+            return built[0];
+        }
 
-            int fResult = CompileGLSL(fragmentShaderStr.ToString(), ShaderType.Fragment, out var fragmentData,
-                out var fErrorMessage);
-            ReleaseInternalData();
+        private static bool IsComputeShader(string shaderPath)
+        {
+            return Path.GetExtension(shaderPath) == ".comp";
+        }
 
-            ReleaseCompiler();
+        // Compiles the vertex and fragment stages of all shaders in one parallel native call.
+        // Compute shaders are plain glsl, one stage each, cooked without a layout.
+        // Unchanged stages are served from the SPIR-V cache.
+        public static bool[] CompileBatch(IList<string> shaderPaths, out string message)
+        {
+            StringBuilder log = new StringBuilder();
+            bool[] built = new bool[shaderPaths.Count];
+            List<int> jobOwners = new List<int>();
+            List<int> jobStarts = new List<int>();
+            List<ShaderCompileJob> jobs = new List<ShaderCompileJob>();
 
-            if (vResult != 0)
-            {
-                message = Path.GetFileName(shaderPath) + ": Error compiling vertex shader\n" + vErrorMessage +
-                          Environment.NewLine;
-                return false;
-            }
-            else if (fResult != 0)
+            for (int i = 0; i < shaderPaths.Count; i++)
             {
-                message = Path.GetFileName(shaderPath) + ": Error compiling fragment shader\n" + fErrorMessage +
-                          Environment.NewLine;
-                return false;
+                if (IsComputeShader(shaderPaths[i]))
+                {
+                    string computeSource = File.ReadAllText(shaderPaths[i]);
+                    jobOwners.Add(i);
+                    jobStarts.Add(jobs.Count);
+                    jobs.Add(new ShaderCompileJob()
+                    {
+                        ShaderText = Marshal.StringToHGlobalAnsi(computeSource),
+                        ShaderTextSize = computeSource.Length,
+                        Type = ShaderType.Compute
+                    });
+                    continue;
+                }
+
+                if (!GenerateSources(shaderPaths[i], out string vertexSource, out string fragmentSource,
+                        out string generateMessage))
+                {
+                    log.Append(generateMessage);
+                    continue;
+                }
+
+                jobOwners.Add(i);
+                jobStarts.Add(jobs.Count);
+                jobs.Add(new ShaderCompileJob()
+                {
+                    ShaderText = Marshal.StringToHGlobalAnsi(vertexSource),
+                    ShaderTextSize = vertexSource.Length,
+                    Type = ShaderType.Vertex
+                });
+                jobs.Add(new ShaderCompileJob()
+                {
+                    ShaderText = Marshal.StringToHGlobalAnsi(fragmentSource),
+                    ShaderTextSize = fragmentSource.Length,
+                    Type = ShaderType.Fragment
+                });
             }
-            else
+
+            ShaderCompileJob[] jobArray = jobs.ToArray();
+            ShaderCompileOutput[] outputs = new ShaderCompileOutput[jobArray.Length];
+            IntPtr batch = CompileGLSLBatch(jobArray, jobArray.Length, cacheDirectory, outputs);
+
+            for (int j = 0; j < jobOwners.Count; j++)
             {
+                string shaderPath = shaderPaths[jobOwners[j]];
+                if (IsComputeShader(shaderPath))
+                {
+                    ShaderCompileOutput computeOutput = outputs[jobStarts[j]];
+                    if (computeOutput.Status != 0)
+                    {
+                        log.Append(Path.GetFileName(shaderPath) + ": Error compiling compute shader\n" +
+                                   Marshal.PtrToStringAnsi(computeOutput.ErrorMessage) + Environment.NewLine);
+                        continue;
+                    }
+
+                    byte[] computeData = new byte[computeOutput.DataSize];
+                    Marshal.Copy(computeOutput.DataPtr, computeData, 0, computeData.Length);
+                    File.WriteAllBytes(shaderPath + ".data", computeData);
+
+                    log.Append(Path.GetFileName(shaderPath) + (computeOutput.FromCache != 0 ? ": OK (cached)" : ": OK") +
+                               Environment.NewLine);
+                    built[jobOwners[j]] = true;
+                    continue;
+                }
+
+                ShaderCompileOutput vertexOutput = outputs[jobStarts[j]];
+                ShaderCompileOutput fragmentOutput = outputs[jobStarts[j] + 1];
+
+                if (vertexOutput.Status != 0)
+                {
+                    log.Append(Path.GetFileName(shaderPath) + ": Error compiling vertex shader\n" +
+                               Marshal.PtrToStringAnsi(vertexOutput.ErrorMessage) + Environment.NewLine);
+                    continue;
+                }
+
+                if (fragmentOutput.Status != 0)
+                {
+                    log.Append(Path.GetFileName(shaderPath) + ": Error compiling fragment shader\n" +
+                               Marshal.PtrToStringAnsi(fragmentOutput.ErrorMessage) + Environment.NewLine);
+                    continue;
+                }
+
+                byte[] vertexData = new byte[vertexOutput.DataSize];
+                byte[] fragmentData = new byte[fragmentOutput.DataSize];
+                Marshal.Copy(vertexOutput.DataPtr, vertexData, 0, vertexData.Length);
+                Marshal.Copy(fragmentOutput.DataPtr, fragmentData, 0, fragmentData.Length);
+
+                if (BuildShaderLayout(vertexData, fragmentData, out var layoutData, out var layoutError) != 0)
+                {
+                    log.Append(Path.GetFileName(shaderPath) + ": Error reflecting shader layout\n" + layoutError +
+                               Environment.NewLine);
+                    continue;
+                }
+
                 FileStream fileStream = new FileStream(shaderPath + ".data", FileMode.Create);
                 fileStream.Write(BitConverter.GetBytes(vertexData.Length), 0, 4);
                 fileStream.Write(BitConverter.GetBytes(fragmentData.Length), 0, 4);
                 fileStream.Write(vertexData, 0, vertexData.Length);
                 fileStream.Write(fragmentData, 0, fragmentData.Length);
+                fileStream.Write(layoutData, 0, layoutData.Length);
                 fileStream.Close();
-                message = Path.GetFileName(shaderPath) + ": OK" + Environment.NewLine;
-                return true;
+
+                bool cached = vertexOutput.FromCache != 0 && fragmentOutput.FromCache != 0;
+                log.Append(Path.GetFileName(shaderPath) + (cached ? ": OK (cached)" : ": OK") + Environment.NewLine);
+                built[jobOwners[j]] = true;
             }
+
+            ReleaseBatch(batch);
+            foreach (ShaderCompileJob job in jobArray)
+            {
+                Marshal.FreeHGlobal(job.ShaderText);
+            }
+
+            message = log.ToString();
+            return built;
         }
     }
 }
\ No newline at end of file
@@ -2,15 +2,22 @@
 #define MODEL_LOADER_H
 
 #include "JoyAssetHeaders.h"
-#include "tiny_obj_loader.h"
+#include "ObjParser.h"
 #include <stdexcept>
 #include <fstream>
+#include <array>
+#include <algorithm>
+#include <map>
+#include <cfloat>
+#include <cstring>
+
+#include "ResourceManager/MeshOccluder.h"
 
 class ModelLoader
 {
 public:
 	[[nodiscard]]
-	static bool getFileStream(std::ifstream& stream, const std::string& filename, std::string errorMessage)
+	static bool getFileStream(std::ifstream& stream, const std::string& filename, std::string& errorMessage)
 	{
 		stream.open(filename);
 		if (!stream.is_open())
@@ -27,66 +34,63 @@ public:
 	                      const std::string& filename,
 	                      std::string& errorMessage)
 	{
-		bool res;
-		std::ifstream stream;
-		res = getFileStream(stream, filename, errorMessage);
-		if (!res)
-		{
-			return false;
-		}
-
-		tinyobj::attrib_t attrib;
-		std::vector<tinyobj::shape_t> shapes;
-		std::vector<tinyobj::material_t> materials;
-		std::string warn, err;
-
-		res = tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, &stream);
-		if (!res)
-		{
-			errorMessage = err;
-			return false;
-		}
+		return ObjParser::LoadModel(vertices, indices, filename, errorMessage);
+	}
 
-		uint32_t vertSize = 0;
-		for (const auto& shape : shapes)
-		{
-			vertSize += shape.mesh.indices.size();
-		}
-		vertices.resize(vertSize);
-		indices.resize(vertSize);
+	// Occluder section which goes after the index data, see MeshOccluder.h.
+	// Counts are zero if the mesh is too small to hide anything or too dense to rasterize every frame
+	static void BuildOccluder(const std::vector<Vertex>& vertices,
+	                          const std::vector<uint32_t>& indices,
+	                          std::vector<char>& occluder)
+	{
+		JoyEngine::MeshOccluderHeader header = {0, 0};
+		std::vector<float> positions;
+		std::vector<uint32_t> occluderIndices;
 
-		uint32_t vertIndex = 0;
-		for (const auto& shape : shapes)
+		const size_t triangleCount = indices.size() / 3;
+		if (triangleCount > 0 && triangleCount <= JoyEngine::MESH_OCCLUDER_MAX_TRIANGLES)
 		{
-			for (const auto& index : shape.mesh.indices)
+			float min[3] = {FLT_MAX, FLT_MAX, FLT_MAX};
+			float max[3] = {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+			for (const auto& vertex : vertices)
 			{
-				vertices[vertIndex].pos = {
-					attrib.vertices[3 * index.vertex_index + 0],
-					attrib.vertices[3 * index.vertex_index + 1],
-					attrib.vertices[3 * index.vertex_index + 2]
-				};
-				vertices[vertIndex].normal = {
-					attrib.normals[3 * index.normal_index + 0],
-					attrib.normals[3 * index.normal_index + 1],
-					attrib.normals[3 * index.normal_index + 2]
-				};
-				vertices[vertIndex].texCoord = {
-					attrib.texcoords[2 * index.texcoord_index + 0],
-					1.0f - attrib.texcoords[2 * index.texcoord_index + 1]
-				};
-
-				vertices[vertIndex].color = {1.0f, 1.0f, 1.0f};
-
-				indices[vertIndex] = vertIndex;
-				vertIndex++;
+				const float pos[3] = {vertex.pos.x, vertex.pos.y, vertex.pos.z};
+				for (int i = 0; i < 3; i++)
+				{
+					min[i] = std::min(min[i], pos[i]);
+					max[i] = std::max(max[i], pos[i]);
+				}
+			}
+			const float dx = max[0] - min[0];
+			const float dy = max[1] - min[1];
+			const float dz = max[2] - min[2];
+			if (dx * dy + dy * dz + dz * dx >= JoyEngine::MESH_OCCLUDER_MIN_HALF_AREA)
+			{
+				// vertices are split by normals and texture coordinates, occluder needs positions only
+				std::map<std::array<float, 3>, uint32_t> welded;
+				for (size_t i = 0; i < triangleCount * 3; i++)
+				{
+					const auto& pos = vertices[indices[i]].pos;
+					const auto [it, isInserted] = welded.try_emplace(
+						std::array<float, 3>{pos.x, pos.y, pos.z},
+						static_cast<uint32_t>(positions.size() / 3));
+					if (isInserted)
+					{
+						positions.insert(positions.end(), {pos.x, pos.y, pos.z});
+					}
+					occluderIndices.push_back(it->second);
+				}
+				header.vertexCount = static_cast<uint32_t>(positions.size() / 3);
+				header.indexCount = static_cast<uint32_t>(occluderIndices.size());
 			}
-		}
-		if (stream.is_open())
-		{
-			stream.close();
 		}
 
-		return true;
+		const size_t positionsSize = positions.size() * sizeof(float);
+		const size_t indicesSize = occluderIndices.size() * sizeof(uint32_t);
+		occluder.resize(sizeof(header) + positionsSize + indicesSize);
+		memcpy(occluder.data(), &header, sizeof(header));
+		memcpy(occluder.data() + sizeof(header), positions.data(), positionsSize);
+		memcpy(occluder.data() + sizeof(header) + positionsSize, occluderIndices.data(), indicesSize);
 	}
 };
 
@@ -0,0 +1,640 @@
+#ifndef OBJ_PARSER_H
+#define OBJ_PARSER_H
+
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "JoyAssetHeaders.h"
+
+// Parallel Wavefront OBJ parser.
+// The file is memory mapped and cut into chunks at line boundaries. Every chunk is parsed
+// independently (pass A), then prefix sums over per-chunk counts give each chunk its global
+// attribute base and output offset, so face indices are resolved and written in parallel (pass B).
+// The output matches ModelLoader: one vertex per triangle corner in file order, indices[i] = i.
+class ObjParser
+{
+public:
+	[[nodiscard]]
+	static bool LoadModel(std::vector<Vertex>& vertices,
+	                      std::vector<uint32_t>& indices,
+	                      const std::string& filename,
+	                      std::string& errorMessage,
+	                      uint32_t threadCount = 0)
+	{
+		MappedFile file;
+		if (!file.Open(filename))
+		{
+			errorMessage = "Cannot map file " + filename;
+			return false;
+		}
+		return ParseBuffer(file.data, file.size, vertices, indices, errorMessage, threadCount);
+	}
+
+	[[nodiscard]]
+	static bool ParseBuffer(const char* data,
+	                        size_t size,
+	                        std::vector<Vertex>& vertices,
+	                        std::vector<uint32_t>& indices,
+	                        std::string& errorMessage,
+	                        uint32_t threadCount = 0)
+	{
+		if (threadCount == 0)
+		{
+			threadCount = std::max(1u, std::thread::hardware_concurrency());
+		}
+
+		std::vector<Chunk> chunks;
+		SplitIntoChunks(data, size, threadCount, chunks);
+
+		RunParallel(static_cast<uint32_t>(chunks.size()), threadCount, [&chunks](uint32_t i)
+		{
+			ParseChunk(chunks[i]);
+		});
+
+		size_t positionCount = 0;
+		size_t texcoordCount = 0;
+		size_t normalCount = 0;
+		size_t cornerCount = 0;
+		for (auto& chunk : chunks)
+		{
+			if (!chunk.error.empty())
+			{
+				errorMessage = chunk.error;
+				return false;
+			}
+			chunk.positionBase = positionCount;
+			chunk.texcoordBase = texcoordCount;
+			chunk.normalBase = normalCount;
+			chunk.outputOffset = cornerCount;
+			positionCount += chunk.positions.size() / 3;
+			texcoordCount += chunk.texcoords.size() / 2;
+			normalCount += chunk.normals.size() / 3;
+			cornerCount += chunk.corners.size();
+		}
+
+		if (cornerCount > UINT32_MAX)
+		{
+			errorMessage = "Model has too many vertices";
+			return false;
+		}
+
+		vertices.resize(cornerCount);
+		indices.resize(cornerCount);
+
+		std::atomic<bool> failed = false;
+		RunParallel(static_cast<uint32_t>(chunks.size()), threadCount, [&](uint32_t i)
+		{
+			if (!ResolveChunk(chunks, i, positionCount, texcoordCount, normalCount, vertices, indices))
+			{
+				failed = true;
+			}
+		});
+
+		if (failed)
+		{
+			for (const auto& chunk : chunks)
+			{
+				if (!chunk.error.empty())
+				{
+					errorMessage = chunk.error;
+					break;
+				}
+			}
+			return false;
+		}
+
+		return true;
+	}
+
+private:
+	static constexpr size_t MIN_CHUNK_SIZE = 1 << 20;
+	static constexpr uint8_t RELATIVE_V = 1 << 0;
+	static constexpr uint8_t RELATIVE_VT = 1 << 1;
+	static constexpr uint8_t RELATIVE_VN = 1 << 2;
+	static constexpr int32_t NO_INDEX = INT32_MIN;
+
+	struct MappedFile
+	{
+		HANDLE fileHandle = INVALID_HANDLE_VALUE;
+		HANDLE mappingHandle = nullptr;
+		const char* data = nullptr;
+		size_t size = 0;
+
+		MappedFile() = default;
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		~MappedFile()
+		{
+			if (data != nullptr) UnmapViewOfFile(data);
+			if (mappingHandle != nullptr) CloseHandle(mappingHandle);
+			if (fileHandle != INVALID_HANDLE_VALUE) CloseHandle(fileHandle);
+		}
+
+		bool Open(const std::string& filename)
+		{
+			fileHandle = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+			                         OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+			if (fileHandle == INVALID_HANDLE_VALUE)
+			{
+				return false;
+			}
+			LARGE_INTEGER fileSize;
+			if (!GetFileSizeEx(fileHandle, &fileSize))
+			{
+				return false;
+			}
+			size = static_cast<size_t>(fileSize.QuadPart);
+			if (size == 0)
+			{
+				// Empty files cannot be mapped, but they are still valid (empty) models
+				return true;
+			}
+			mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			if (mappingHandle == nullptr)
+			{
+				return false;
+			}
+			data = static_cast<const char*>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+			return data != nullptr;
+		}
+	};
+
+	struct Corner
+	{
+		int32_t v;
+		int32_t vt;
+		int32_t vn;
+		uint8_t relativeMask;
+	};
+
+	struct Chunk
+	{
+		const char* begin = nullptr;
+		const char* end = nullptr;
+
+		std::vector<float> positions;
+		std::vector<float> texcoords;
+		std::vector<float> normals;
+		std::vector<Corner> corners;
+
+		size_t positionBase = 0;
+		size_t texcoordBase = 0;
+		size_t normalBase = 0;
+		size_t outputOffset = 0;
+
+		std::string error;
+	};
+
+	template <typename Func>
+	static void RunParallel(uint32_t taskCount, uint32_t threadCount, Func func)
+	{
+		const uint32_t workerCount = std::min(taskCount, threadCount);
+		if (workerCount <= 1)
+		{
+			for (uint32_t i = 0; i < taskCount; i++)
+			{
+				func(i);
+			}
+			return;
+		}
+
+		std::atomic<uint32_t> next = 0;
+		auto worker = [&]()
+		{
+			for (uint32_t i = next++; i < taskCount; i = next++)
+			{
+				func(i);
+			}
+		};
+
+		std::vector<std::thread> threads;
+		threads.reserve(workerCount - 1);
+		for (uint32_t i = 0; i < workerCount - 1; i++)
+		{
+			threads.emplace_back(worker);
+		}
+		worker();
+		for (auto& thread : threads)
+		{
+			thread.join();
+		}
+	}
+
+	static void SplitIntoChunks(const char* data, size_t size, uint32_t threadCount, std::vector<Chunk>& chunks)
+	{
+		// A few chunks per thread keep the workers busy when line density is uneven
+		const size_t desiredCount = std::max<size_t>(1, std::min<size_t>(threadCount * 4, size / MIN_CHUNK_SIZE));
+		const size_t chunkSize = size / desiredCount + 1;
+
+		const char* cursor = data;
+		const char* end = data + size;
+		while (cursor < end)
+		{
+			const char* chunkEnd = cursor + std::min<size_t>(chunkSize, end - cursor);
+			while (chunkEnd < end && *(chunkEnd - 1) != '\n')
+			{
+				chunkEnd++;
+			}
+			Chunk chunk;
+			chunk.begin = cursor;
+			chunk.end = chunkEnd;
+			chunks.push_back(std::move(chunk));
+			cursor = chunkEnd;
+		}
+		if (chunks.empty())
+		{
+			chunks.emplace_back();
+		}
+	}
+
+	static bool IsSpace(char c)
+	{
+		return c == ' ' || c == '\t' || c == '\r';
+	}
+
+	static void SkipSpaces(const char*& p, const char* end)
+	{
+		while (p < end && IsSpace(*p)) p++;
+	}
+
+	static bool ParseFloat(const char*& p, const char* end, float& value)
+	{
+		// Clinger's fast path: when the decimal mantissa fits into 53 bits and the power of ten
+		// is exactly representable, a single multiplication or division is correctly rounded.
+		// Everything else (long mantissas, big exponents, nan/inf) falls back to strtod.
+		static constexpr double powersOfTen[] = {
+			1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+			1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+		};
+
+		const char* start = p;
+		bool negative = false;
+		if (p < end && (*p == '-' || *p == '+'))
+		{
+			negative = *p == '-';
+			p++;
+		}
+
+		uint64_t mantissa = 0;
+		int32_t exponent = 0;
+		uint32_t digits = 0;
+		bool truncated = false;
+		bool anyDigits = false;
+
+		while (p < end && *p >= '0' && *p <= '9')
+		{
+			anyDigits = true;
+			if (digits < 19)
+			{
+				mantissa = mantissa * 10 + (*p - '0');
+				if (mantissa != 0) digits++;
+			}
+			else
+			{
+				truncated = true;
+				exponent++;
+			}
+			p++;
+		}
+		if (p < end && *p == '.')
+		{
+			p++;
+			while (p < end && *p >= '0' && *p <= '9')
+			{
+				anyDigits = true;
+				if (digits < 19)
+				{
+					mantissa = mantissa * 10 + (*p - '0');
+					if (mantissa != 0) digits++;
+					exponent--;
+				}
+				else
+				{
+					truncated = true;
+				}
+				p++;
+			}
+		}
+		if (anyDigits && p < end && (*p == 'e' || *p == 'E'))
+		{
+			const char* exponentStart = p;
+			p++;
+			bool negativeExponent = false;
+			if (p < end && (*p == '-' || *p == '+'))
+			{
+				negativeExponent = *p == '-';
+				p++;
+			}
+			if (p < end && *p >= '0' && *p <= '9')
+			{
+				int32_t e = 0;
+				while (p < end && *p >= '0' && *p <= '9')
+				{
+					if (e < 100000) e = e * 10 + (*p - '0');
+					p++;
+				}
+				exponent += negativeExponent ? -e : e;
+			}
+			else
+			{
+				p = exponentStart;
+			}
+		}
+
+		if (anyDigits && !truncated && mantissa <= (1ull << 53) && exponent >= -22 && exponent <= 22)
+		{
+			double result = static_cast<double>(mantissa);
+			result = exponent < 0 ? result / powersOfTen[-exponent] : result * powersOfTen[exponent];
+			value = static_cast<float>(negative ? -result : result);
+			return true;
+		}
+
+		// The mapped buffer is not null terminated, so strtod works on a bounded copy
+		p = start;
+		char buffer[128];
+		size_t length = 0;
+		while (p + length < end && length < sizeof(buffer) - 1 && !IsSpace(p[length]) && p[length] != '\n')
+		{
+			buffer[length] = p[length];
+			length++;
+		}
+		buffer[length] = '\0';
+		char* parsedEnd = nullptr;
+		const double result = strtod(buffer, &parsedEnd);
+		if (parsedEnd == buffer)
+		{
+			return false;
+		}
+		p += parsedEnd - buffer;
+		value = static_cast<float>(result);
+		return true;
+	}
+
+	static bool ParseInt(const char*& p, const char* end, int32_t& value)
+	{
+		bool negative = false;
+		if (p < end && (*p == '-' || *p == '+'))
+		{
+			negative = *p == '-';
+			p++;
+		}
+		if (p >= end || *p < '0' || *p > '9')
+		{
+			return false;
+		}
+		int64_t result = 0;
+		while (p < end && *p >= '0' && *p <= '9')
+		{
+			result = result * 10 + (*p - '0');
+			if (result > INT32_MAX) return false;
+			p++;
+		}
+		value = static_cast<int32_t>(negative ? -result : result);
+		return true;
+	}
+
+	static bool ParseFloats(const char*& p, const char* end, std::vector<float>& out, uint32_t count, uint32_t required)
+	{
+		for (uint32_t i = 0; i < count; i++)
+		{
+			SkipSpaces(p, end);
+			float value = 0.0f;
+			if (p >= end || *p == '\n' || !ParseFloat(p, end, value))
+			{
+				if (i < required) return false;
+				value = 0.0f;
+			}
+			out.push_back(value);
+		}
+		return true;
+	}
+
+	// Face indices are stored as zero based. Negative (relative) indices are stored relative to the
+	// chunk-local attribute count and flagged, because the chunk does not know its global base yet.
+	static bool ParseIndex(int32_t raw, size_t localCount, int32_t& index, bool& relative)
+	{
+		if (raw > 0)
+		{
+			index = raw - 1;
+			relative = false;
+			return true;
+		}
+		if (raw < 0)
+		{
+			index = static_cast<int32_t>(static_cast<int64_t>(localCount) + raw);
+			relative = true;
+			return true;
+		}
+		return false;
+	}
+
+	static bool ParseFaceVertex(const char*& p, const char* end, const Chunk& chunk, Corner& corner)
+	{
+		corner = {NO_INDEX, NO_INDEX, NO_INDEX, 0};
+		bool relative = false;
+		int32_t raw;
+
+		if (!ParseInt(p, end, raw) || !ParseIndex(raw, chunk.positions.size() / 3, corner.v, relative))
+		{
+			return false;
+		}
+		if (relative) corner.relativeMask |= RELATIVE_V;
+
+		if (p < end && *p == '/')
+		{
+			p++;
+			if (p < end && *p != '/')
+			{
+				if (!ParseInt(p, end, raw) || !ParseIndex(raw, chunk.texcoords.size() / 2, corner.vt, relative))
+				{
+					return false;
+				}
+				if (relative) corner.relativeMask |= RELATIVE_VT;
+			}
+			if (p < end && *p == '/')
+			{
+				p++;
+				if (!ParseInt(p, end, raw) || !ParseIndex(raw, chunk.normals.size() / 3, corner.vn, relative))
+				{
+					return false;
+				}
+				if (relative) corner.relativeMask |= RELATIVE_VN;
+			}
+		}
+		return p >= end || IsSpace(*p) || *p == '\n';
+	}
+
+	static void ParseChunk(Chunk& chunk)
+	{
+		std::vector<Corner> polygon;
+		const char* p = chunk.begin;
+		const char* end = chunk.end;
+
+		while (p < end)
+		{
+			SkipSpaces(p, end);
+			bool ok = true;
+
+			if (p + 1 < end && p[0] == 'v' && IsSpace(p[1]))
+			{
+				p += 1;
+				ok = ParseFloats(p, end, chunk.positions, 3, 3);
+			}
+			else if (p + 2 < end && p[0] == 'v' && p[1] == 't' && IsSpace(p[2]))
+			{
+				p += 2;
+				ok = ParseFloats(p, end, chunk.texcoords, 2, 1);
+			}
+			else if (p + 2 < end && p[0] == 'v' && p[1] == 'n' && IsSpace(p[2]))
+			{
+				p += 2;
+				ok = ParseFloats(p, end, chunk.normals, 3, 3);
+			}
+			else if (p + 1 < end && p[0] == 'f' && IsSpace(p[1]))
+			{
+				p += 1;
+				polygon.clear();
+				while (true)
+				{
+					SkipSpaces(p, end);
+					if (p >= end || *p == '\n' || *p == '#') break;
+					Corner corner;
+					if (!ParseFaceVertex(p, end, chunk, corner))
+					{
+						ok = false;
+						break;
+					}
+					polygon.push_back(corner);
+				}
+				if (ok && polygon.size() < 3)
+				{
+					ok = false;
+				}
+				if (ok)
+				{
+					// Fan triangulation, the same as tinyobj does for convex polygons
+					for (size_t k = 1; k + 1 < polygon.size(); k++)
+					{
+						chunk.corners.push_back(polygon[0]);
+						chunk.corners.push_back(polygon[k]);
+						chunk.corners.push_back(polygon[k + 1]);
+					}
+				}
+			}
+
+			if (!ok)
+			{
+				chunk.error = "Cannot parse line: " + LineText(chunk.begin, p, end);
+				return;
+			}
+
+			// Everything else (comments, groups, materials, smoothing) does not affect the output
+			while (p < end && *p != '\n') p++;
+			if (p < end) p++;
+		}
+	}
+
+	static std::string LineText(const char* begin, const char* p, const char* end)
+	{
+		const char* lineBegin = p;
+		while (lineBegin > begin && *(lineBegin - 1) != '\n') lineBegin--;
+		const char* lineEnd = p;
+		while (lineEnd < end && *lineEnd != '\n' && *lineEnd != '\r') lineEnd++;
+		return std::string(lineBegin, lineEnd);
+	}
+
+	static bool Resolve(int32_t index, bool relative, size_t base, size_t total, size_t& result)
+	{
+		const int64_t global = relative ? static_cast<int64_t>(base) + index : index;
+		if (global < 0 || static_cast<size_t>(global) >= total)
+		{
+			return false;
+		}
+		result = static_cast<size_t>(global);
+		return true;
+	}
+
+	static bool ResolveChunk(std::vector<Chunk>& chunks,
+	                         uint32_t chunkIndex,
+	                         size_t positionCount,
+	                         size_t texcoordCount,
+	                         size_t normalCount,
+	                         std::vector<Vertex>& vertices,
+	                         std::vector<uint32_t>& indices)
+	{
+		Chunk& chunk = chunks[chunkIndex];
+
+		// Attributes may be referenced from any chunk, so look up the owning chunk by global index
+		auto fetch = [&chunks](size_t globalIndex, size_t Chunk::* base, std::vector<float> Chunk::* data,
+		                       uint32_t stride, size_t hint) -> const float*
+		{
+			size_t c = hint;
+			while (c > 0 && chunks[c].*base > globalIndex) c--;
+			while (c + 1 < chunks.size() && chunks[c + 1].*base <= globalIndex) c++;
+			return &(chunks[c].*data)[(globalIndex - chunks[c].*base) * stride];
+		};
+
+		for (size_t i = 0; i < chunk.corners.size(); i++)
+		{
+			const Corner& corner = chunk.corners[i];
+			const size_t outIndex = chunk.outputOffset + i;
+			Vertex& vertex = vertices[outIndex];
+			size_t global;
+
+			if (!Resolve(corner.v, corner.relativeMask & RELATIVE_V, chunk.positionBase, positionCount, global))
+			{
+				chunk.error = "Vertex index out of range";
+				return false;
+			}
+			const float* pos = fetch(global, &Chunk::positionBase, &Chunk::positions, 3, chunkIndex);
+			vertex.pos = {pos[0], pos[1], pos[2]};
+
+			if (corner.vn != NO_INDEX)
+			{
+				if (!Resolve(corner.vn, corner.relativeMask & RELATIVE_VN, chunk.normalBase, normalCount, global))
+				{
+					chunk.error = "Normal index out of range";
+					return false;
+				}
+				const float* normal = fetch(global, &Chunk::normalBase, &Chunk::normals, 3, chunkIndex);
+				vertex.normal = {normal[0], normal[1], normal[2]};
+			}
+			else
+			{
+				vertex.normal = {0.0f, 0.0f, 0.0f};
+			}
+
+			if (corner.vt != NO_INDEX)
+			{
+				if (!Resolve(corner.vt, corner.relativeMask & RELATIVE_VT, chunk.texcoordBase, texcoordCount, global))
+				{
+					chunk.error = "Texcoord index out of range";
+					return false;
+				}
+				const float* uv = fetch(global, &Chunk::texcoordBase, &Chunk::texcoords, 2, chunkIndex);
+				vertex.texCoord = {uv[0], 1.0f - uv[1]};
+			}
+			else
+			{
+				vertex.texCoord = {0.0f, 1.0f};
+			}
+
+			vertex.color = {1.0f, 1.0f, 1.0f};
+			indices[outIndex] = static_cast<uint32_t>(outIndex);
+		}
+		return true;
+	}
+};
+
+#endif //OBJ_PARSER_H
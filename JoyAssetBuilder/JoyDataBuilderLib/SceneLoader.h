@@ -0,0 +1,576 @@
+#ifndef SCENE_LOADER_H
+#define SCENE_LOADER_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include <rapidjson/document.h>
+
+#include "Common/HashDefs.h"
+#include "SceneManager/SceneBlob.h"
+
+// Cooks scene json into the load-in-place JoyEngine::SceneBlob format
+class SceneLoader
+{
+public:
+	[[nodiscard]]
+	static bool LoadScene(const std::string& filename, std::vector<char>& blob, std::string& errorMessage)
+	{
+		std::vector<char> text;
+		if (!ReadText(filename, text))
+		{
+			errorMessage = "Cannot open " + filename;
+			return false;
+		}
+
+		rapidjson::Document json;
+		json.ParseInsitu(text.data());
+		if (json.HasParseError())
+		{
+			errorMessage = "Cannot parse " + filename;
+			return false;
+		}
+		if (!json.IsObject() || !json.HasMember("type") || std::string(json["type"].GetString()) != "scene")
+		{
+			errorMessage = filename + " is not a scene";
+			return false;
+		}
+
+		Builder builder;
+		builder.sceneName = builder.AddString(json["name"].GetString());
+		if (json.HasMember("cellSize"))
+		{
+			builder.cellSize = json["cellSize"].GetFloat();
+		}
+		builder.streamingRadius = json.HasMember("streamingRadius")
+			                          ? json["streamingRadius"].GetFloat()
+			                          : builder.cellSize * 2;
+		if (builder.cellSize <= 0 || builder.streamingRadius <= 0)
+		{
+			errorMessage = "cellSize and streamingRadius must be positive";
+			return false;
+		}
+
+		for (const auto& obj : json["objects"].GetArray())
+		{
+			if (!builder.AddObject(obj, errorMessage))
+			{
+				return false;
+			}
+		}
+		if (!builder.ResolveHierarchy(errorMessage))
+		{
+			return false;
+		}
+
+		builder.Write(blob);
+#ifdef _DEBUG
+		if (!CheckBlob(blob, json, errorMessage))
+		{
+			errorMessage = filename + ": cooked blob differs from json, " + errorMessage;
+			return false;
+		}
+#endif
+		return true;
+	}
+
+	// Reads the blob back through the engine view and compares it with the source json.
+	// Objects are reordered by cell, their name offsets still grow in json order
+	[[nodiscard]]
+	static bool CheckBlob(const std::vector<char>& blob, const rapidjson::Value& json, std::string& errorMessage)
+	{
+		JoyEngine::SceneBlobView view;
+		if (!view.Map(blob.data(), blob.size()))
+		{
+			errorMessage = "header";
+			return false;
+		}
+		const JoyEngine::SceneBlobHeader& header = *view.header;
+		const auto& jsonObjects = json["objects"].GetArray();
+		if (header.objectCount != jsonObjects.Size() || strcmp(view.GetString(header.nameOffset), json["name"].GetString()) != 0)
+		{
+			errorMessage = "scene name or object count";
+			return false;
+		}
+
+		std::vector<uint32_t> cellOfObject(header.objectCount);
+		uint32_t nextObject = 0;
+		for (uint32_t c = 0; c < header.cellCount; c++)
+		{
+			const JoyEngine::SceneBlobCell& cell = view.cells[c];
+			const bool isGlobal = cell.flags & JoyEngine::SceneBlobCellGlobal;
+			if (cell.firstObject != nextObject || cell.objectCount == 0 ||
+				cell.firstObject + cell.objectCount > header.objectCount || (isGlobal && c != 0))
+			{
+				errorMessage = "cell " + std::to_string(c);
+				return false;
+			}
+			std::fill_n(cellOfObject.begin() + cell.firstObject, cell.objectCount, c);
+			nextObject += cell.objectCount;
+		}
+		if (nextObject != header.objectCount)
+		{
+			errorMessage = "cells don't cover all objects";
+			return false;
+		}
+
+		std::vector<uint32_t> jsonOrder(header.objectCount);
+		std::iota(jsonOrder.begin(), jsonOrder.end(), 0);
+		std::sort(jsonOrder.begin(), jsonOrder.end(), [&view](uint32_t a, uint32_t b)
+		{
+			return view.objects[a].nameOffset < view.objects[b].nameOffset;
+		});
+
+		uint32_t componentCount = 0;
+		uint32_t fieldCount = 0;
+		uint32_t valueCount = 0;
+		std::vector<double> numbers;
+		for (uint32_t j = 0; j < header.objectCount; j++)
+		{
+			const uint32_t i = jsonOrder[j];
+			const JoyEngine::SceneBlobObject& object = view.objects[i];
+			const rapidjson::Value& obj = jsonObjects[j];
+			errorMessage = std::string("object ") + obj["name"].GetString();
+
+			if (strcmp(view.GetString(object.nameOffset), obj["name"].GetString()) != 0)
+			{
+				return false;
+			}
+			if (object.parent != JoyEngine::SCENE_BLOB_NO_PARENT)
+			{
+				// parents go first inside the same cell
+				if (object.parent >= i || cellOfObject[object.parent] != cellOfObject[i] ||
+					!obj.HasMember("parent") || object.parent != jsonOrder[obj["parent"].GetUint()])
+				{
+					return false;
+				}
+			}
+			else if (obj.HasMember("parent"))
+			{
+				return false;
+			}
+
+			JoyEngine::SceneBlobTransform transform = {};
+			const rapidjson::Value& transformValue = obj["transform"];
+			ReadVec3(transformValue["localPosition"], transform.localPosition);
+			ReadVec3(transformValue["localRotation"], transform.localRotation);
+			ReadVec3(transformValue["localScale"], transform.localScale);
+			if (memcmp(&transform, &view.transforms[i], sizeof(transform)) != 0)
+			{
+				return false;
+			}
+
+			const auto& jsonComponents = obj["components"].GetArray();
+			if (object.firstComponent != componentCount || object.componentCount != jsonComponents.Size() ||
+				object.firstComponent + object.componentCount > header.componentCount)
+			{
+				return false;
+			}
+			for (uint32_t k = 0; k < object.componentCount; k++)
+			{
+				const JoyEngine::SceneBlobComponentData& component = view.components[componentCount++];
+				const rapidjson::Value& componentValue = jsonComponents[k];
+				const std::string type = componentValue["type"].GetString();
+				if (type == "renderer")
+				{
+					JoyEngine::SceneBlobGuid mesh = {};
+					JoyEngine::SceneBlobGuid material = {};
+					ReadGuid(componentValue["model"].GetString(), mesh);
+					ReadGuid(componentValue["material"].GetString(), material);
+					if (component.type != JoyEngine::SceneBlobRenderer ||
+						memcmp(&mesh, &component.mesh, sizeof(mesh)) != 0 ||
+						memcmp(&material, &component.material, sizeof(material)) != 0)
+					{
+						return false;
+					}
+					continue;
+				}
+				if (type == "camera")
+				{
+					if (component.type != JoyEngine::SceneBlobCamera)
+					{
+						return false;
+					}
+					continue;
+				}
+				if (component.type != JoyEngine::SceneBlobComponent)
+				{
+					return false;
+				}
+				const uint32_t jsonFieldCount = componentValue.HasMember("fields")
+					                                ? componentValue["fields"].MemberCount()
+					                                : 0;
+				if (strcmp(view.GetString(component.classNameOffset), componentValue["component"].GetString()) != 0 ||
+					component.firstField != fieldCount || component.fieldCount != jsonFieldCount ||
+					component.firstField + component.fieldCount > header.fieldCount)
+				{
+					return false;
+				}
+				if (jsonFieldCount == 0)
+				{
+					continue;
+				}
+				for (auto m = componentValue["fields"].MemberBegin(); m != componentValue["fields"].MemberEnd(); ++m)
+				{
+					const JoyEngine::SceneBlobField& field = view.fields[fieldCount++];
+					numbers.clear();
+					FlattenNumbers(m->value, numbers);
+					if (strcmp(view.GetString(field.nameOffset), m->name.GetString()) != 0 ||
+						field.nameHash != strHash(m->name.GetString()) ||
+						field.firstValue != valueCount || field.valueCount != numbers.size() ||
+						field.firstValue + field.valueCount > header.valueCount ||
+						!std::equal(numbers.begin(), numbers.end(), view.values + field.firstValue))
+					{
+						return false;
+					}
+					valueCount += field.valueCount;
+				}
+			}
+		}
+		if (componentCount != header.componentCount || fieldCount != header.fieldCount ||
+			valueCount != header.valueCount)
+		{
+			errorMessage = "component, field or value count";
+			return false;
+		}
+		errorMessage.clear();
+		return true;
+	}
+
+private:
+	static constexpr float DEFAULT_CELL_SIZE = 32.0f;
+
+	struct Builder
+	{
+		uint32_t sceneName = 0;
+		float cellSize = DEFAULT_CELL_SIZE;
+		float streamingRadius = 0;
+		std::vector<JoyEngine::SceneBlobObject> objects;
+		std::vector<bool> objectIsGlobal;
+		// filled by ResolveHierarchy
+		std::vector<uint32_t> objectRoots;
+		std::vector<uint32_t> objectDepths;
+		std::vector<JoyEngine::SceneBlobTransform> transforms;
+		std::vector<JoyEngine::SceneBlobComponentData> components;
+		std::vector<JoyEngine::SceneBlobField> fields;
+		std::vector<double> values;
+		std::vector<char> strings;
+
+		uint32_t AddString(const char* str)
+		{
+			const auto offset = static_cast<uint32_t>(strings.size());
+			strings.insert(strings.end(), str, str + strlen(str) + 1);
+			return offset;
+		}
+
+		bool AddObject(const rapidjson::Value& obj, std::string& errorMessage)
+		{
+			JoyEngine::SceneBlobObject object = {};
+			object.nameOffset = AddString(obj["name"].GetString());
+			object.firstComponent = static_cast<uint32_t>(components.size());
+			object.parent = JoyEngine::SCENE_BLOB_NO_PARENT;
+			if (obj.HasMember("parent"))
+			{
+				if (!obj["parent"].IsUint())
+				{
+					errorMessage = std::string("Parent is not an object index in object ") + obj["name"].GetString();
+					return false;
+				}
+				object.parent = obj["parent"].GetUint();
+			}
+
+			JoyEngine::SceneBlobTransform transform = {};
+			const rapidjson::Value& transformValue = obj["transform"];
+			if (!ReadVec3(transformValue["localPosition"], transform.localPosition) ||
+				!ReadVec3(transformValue["localRotation"], transform.localRotation) ||
+				!ReadVec3(transformValue["localScale"], transform.localScale))
+			{
+				errorMessage = std::string("Wrong transform in object ") + obj["name"].GetString();
+				return false;
+			}
+			transforms.push_back(transform);
+
+			bool isGlobal = false;
+			for (const auto& componentValue : obj["components"].GetArray())
+			{
+				JoyEngine::SceneBlobComponentData component = {};
+				const std::string type = componentValue["type"].GetString();
+				if (type == "renderer")
+				{
+					component.type = JoyEngine::SceneBlobRenderer;
+					if (!ReadGuid(componentValue["model"].GetString(), component.mesh) ||
+						!ReadGuid(componentValue["material"].GetString(), component.material))
+					{
+						errorMessage = std::string("Wrong renderer GUID in object ") + obj["name"].GetString();
+						return false;
+					}
+				}
+				else if (type == "camera")
+				{
+					component.type = JoyEngine::SceneBlobCamera;
+					// streaming is driven by the camera, so it has to be always loaded
+					isGlobal = true;
+				}
+				else if (type == "component")
+				{
+					component.type = JoyEngine::SceneBlobComponent;
+					component.classNameOffset = AddString(componentValue["component"].GetString());
+					component.firstField = static_cast<uint32_t>(fields.size());
+					if (componentValue.HasMember("fields"))
+					{
+						for (auto m = componentValue["fields"].MemberBegin(); m != componentValue["fields"].MemberEnd(); ++m)
+						{
+							JoyEngine::SceneBlobField field = {};
+							field.nameOffset = AddString(m->name.GetString());
+							field.nameHash = strHash(m->name.GetString());
+							field.firstValue = static_cast<uint32_t>(values.size());
+							if (!FlattenNumbers(m->value, values))
+							{
+								errorMessage = std::string("Field ") + m->name.GetString() +
+									" is not a number or an array of numbers";
+								return false;
+							}
+							field.valueCount = static_cast<uint32_t>(values.size()) - field.firstValue;
+							fields.push_back(field);
+						}
+					}
+					component.fieldCount = static_cast<uint32_t>(fields.size()) - component.firstField;
+				}
+				else
+				{
+					errorMessage = "Unknown component type " + type;
+					return false;
+				}
+				components.push_back(component);
+			}
+
+			object.componentCount = static_cast<uint32_t>(components.size()) - object.firstComponent;
+			objects.push_back(object);
+			objectIsGlobal.push_back(isGlobal);
+			return true;
+		}
+
+		// Hierarchy is streamed as a whole, so it goes to the cell of its root
+		// and is global if any of its objects is global
+		bool ResolveHierarchy(std::string& errorMessage)
+		{
+			objectRoots.resize(objects.size());
+			objectDepths.resize(objects.size());
+			for (uint32_t i = 0; i < objects.size(); i++)
+			{
+				uint32_t root = i;
+				uint32_t depth = 0;
+				while (objects[root].parent != JoyEngine::SCENE_BLOB_NO_PARENT)
+				{
+					if (objects[root].parent >= objects.size())
+					{
+						errorMessage = "Wrong parent index " + std::to_string(objects[root].parent);
+						return false;
+					}
+					root = objects[root].parent;
+					if (++depth > objects.size())
+					{
+						errorMessage = "Cycle in hierarchy of object " + std::string(&strings[objects[i].nameOffset]);
+						return false;
+					}
+				}
+				objectRoots[i] = root;
+				objectDepths[i] = depth;
+			}
+			for (uint32_t i = 0; i < objects.size(); i++)
+			{
+				if (objectIsGlobal[i])
+				{
+					objectIsGlobal[objectRoots[i]] = true;
+				}
+			}
+			return true;
+		}
+
+		struct CellKey
+		{
+			bool global;
+			int32_t x;
+			int32_t z;
+
+			bool operator<(const CellKey& other) const
+			{
+				if (global != other.global) return global;
+				if (x != other.x) return x < other.x;
+				return z < other.z;
+			}
+
+			bool operator==(const CellKey& other) const
+			{
+				return global == other.global && (global || (x == other.x && z == other.z));
+			}
+		};
+
+		CellKey GetCellKey(size_t objectIndex) const
+		{
+			const uint32_t root = objectRoots[objectIndex];
+			if (objectIsGlobal[root])
+			{
+				return {true, 0, 0};
+			}
+			const float* position = transforms[root].localPosition;
+			return {
+				false,
+				static_cast<int32_t>(std::floor(position[0] / cellSize)),
+				static_cast<int32_t>(std::floor(position[2] / cellSize))
+			};
+		}
+
+		// Sorts objects by cell, so every cell is a contiguous range of objects, and by depth inside the cell.
+		// Components, fields and values keep their order, objects still point to them by index
+		void BuildCells(std::vector<JoyEngine::SceneBlobCell>& cells,
+		                std::vector<JoyEngine::SceneBlobObject>& sortedObjects,
+		                std::vector<JoyEngine::SceneBlobTransform>& sortedTransforms) const
+		{
+			std::vector<CellKey> keys(objects.size());
+			for (size_t i = 0; i < objects.size(); i++)
+			{
+				keys[i] = GetCellKey(i);
+			}
+			std::vector<uint32_t> order(objects.size());
+			std::iota(order.begin(), order.end(), 0);
+			std::stable_sort(order.begin(), order.end(), [this, &keys](uint32_t a, uint32_t b)
+			{
+				if (keys[a] < keys[b]) return true;
+				if (keys[b] < keys[a]) return false;
+				return objectDepths[a] < objectDepths[b];
+			});
+			std::vector<uint32_t> sortedIndices(objects.size());
+			for (uint32_t i = 0; i < order.size(); i++)
+			{
+				sortedIndices[order[i]] = i;
+			}
+
+			for (uint32_t i = 0; i < order.size(); i++)
+			{
+				const CellKey& key = keys[order[i]];
+				if (cells.empty() || !(keys[order[i - 1]] == key))
+				{
+					JoyEngine::SceneBlobCell cell = {};
+					cell.x = key.x;
+					cell.z = key.z;
+					cell.firstObject = i;
+					cell.flags = key.global ? JoyEngine::SceneBlobCellGlobal : 0;
+					cells.push_back(cell);
+				}
+				cells.back().objectCount++;
+				sortedObjects.push_back(objects[order[i]]);
+				if (sortedObjects.back().parent != JoyEngine::SCENE_BLOB_NO_PARENT)
+				{
+					sortedObjects.back().parent = sortedIndices[sortedObjects.back().parent];
+				}
+				sortedTransforms.push_back(transforms[order[i]]);
+			}
+		}
+
+		void Write(std::vector<char>& blob) const
+		{
+			std::vector<JoyEngine::SceneBlobCell> cells;
+			std::vector<JoyEngine::SceneBlobObject> sortedObjects;
+			std::vector<JoyEngine::SceneBlobTransform> sortedTransforms;
+			BuildCells(cells, sortedObjects, sortedTransforms);
+
+			JoyEngine::SceneBlobHeader header = {};
+			header.magic = JoyEngine::SCENE_BLOB_MAGIC;
+			header.version = JoyEngine::SCENE_BLOB_VERSION;
+			header.nameOffset = sceneName;
+			header.cellSize = cellSize;
+			header.streamingRadius = streamingRadius;
+			header.cellCount = static_cast<uint32_t>(cells.size());
+			header.objectCount = static_cast<uint32_t>(objects.size());
+			header.componentCount = static_cast<uint32_t>(components.size());
+			header.fieldCount = static_cast<uint32_t>(fields.size());
+			header.valueCount = static_cast<uint32_t>(values.size());
+			header.stringTableSize = static_cast<uint32_t>(strings.size());
+
+			blob.clear();
+			blob.resize(sizeof(JoyEngine::SceneBlobHeader));
+			header.cellsOffset = Append(blob, cells.data(), cells.size() * sizeof(JoyEngine::SceneBlobCell));
+			header.objectsOffset = Append(blob, sortedObjects.data(), sortedObjects.size() * sizeof(JoyEngine::SceneBlobObject));
+			header.transformsOffset = Append(blob, sortedTransforms.data(), sortedTransforms.size() * sizeof(JoyEngine::SceneBlobTransform));
+			header.componentsOffset = Append(blob, components.data(), components.size() * sizeof(JoyEngine::SceneBlobComponentData));
+			header.fieldsOffset = Append(blob, fields.data(), fields.size() * sizeof(JoyEngine::SceneBlobField));
+			header.valuesOffset = Append(blob, values.data(), values.size() * sizeof(double));
+			header.stringsOffset = Append(blob, strings.data(), strings.size());
+			header.totalSize = blob.size();
+			memcpy(blob.data(), &header, sizeof(JoyEngine::SceneBlobHeader));
+		}
+
+		static uint64_t Append(std::vector<char>& blob, const void* data, size_t size)
+		{
+			const size_t alignment = JoyEngine::SCENE_BLOB_ALIGNMENT;
+			blob.resize((blob.size() + alignment - 1) / alignment * alignment, 0);
+			const uint64_t offset = blob.size();
+			const auto* bytes = static_cast<const char*>(data);
+			blob.insert(blob.end(), bytes, bytes + size);
+			return offset;
+		}
+	};
+
+	static bool ReadText(const std::string& filename, std::vector<char>& text)
+	{
+		FILE* file = nullptr;
+		if (fopen_s(&file, filename.c_str(), "rb") != 0 || file == nullptr)
+		{
+			return false;
+		}
+		fseek(file, 0, SEEK_END);
+		const long size = ftell(file);
+		fseek(file, 0, SEEK_SET);
+		text.resize(static_cast<size_t>(size) + 1);
+		const size_t read = fread(text.data(), 1, static_cast<size_t>(size), file);
+		fclose(file);
+		text[read] = '\0';
+		return true;
+	}
+
+	static bool ReadVec3(const rapidjson::Value& value, float* out)
+	{
+		if (!value.IsArray() || value.Size() != 3) return false;
+		for (uint32_t i = 0; i < 3; i++)
+		{
+			if (!value[i].IsNumber()) return false;
+			out[i] = value[i].GetFloat();
+		}
+		return true;
+	}
+
+	static bool ReadGuid(const char* str, JoyEngine::SceneBlobGuid& guid)
+	{
+		return sscanf_s(str,
+		                "%8x-%4hx-%4hx-%2hhx%2hhx-%2hhx%2hhx%2hhx%2hhx%2hhx%2hhx",
+		                &guid.data1, &guid.data2, &guid.data3,
+		                &guid.data4[0], &guid.data4[1], &guid.data4[2], &guid.data4[3],
+		                &guid.data4[4], &guid.data4[5], &guid.data4[6], &guid.data4[7]) == 11;
+	}
+
+	static bool FlattenNumbers(const rapidjson::Value& value, std::vector<double>& out)
+	{
+		if (value.IsNumber())
+		{
+			out.push_back(value.GetDouble());
+			return true;
+		}
+		if (value.IsArray())
+		{
+			for (const auto& v : value.GetArray())
+			{
+				if (!FlattenNumbers(v, out)) return false;
+			}
+			return true;
+		}
+		return false;
+	}
+};
+
+#endif //SCENE_LOADER_H
@@ -3,6 +3,7 @@
 #include <vector>
 
 #include "ModelLoader.h"
+#include "SceneLoader.h"
 #include "TextureLoader.h"
 
 //int main()
@@ -54,7 +55,9 @@ std::string errorMessage;
 
 std::vector<Vertex> vertices;
 std::vector<uint32_t> indices;
+std::vector<char> occluderData;
 std::vector<unsigned char> textureData;
+std::vector<char> sceneData;
 
 extern "C" __declspec(dllexport) int __cdecl BuildModel(
 	const char* modelFileName,
@@ -62,6 +65,8 @@ extern "C" __declspec(dllexport) int __cdecl BuildModel(
 	unsigned long long* vertexDataSize,
 	const void** indexDataPtr,
 	unsigned long long* indexDataSize,
+	const void** occluderDataPtr,
+	unsigned long long* occluderDataSize,
 	const char** errorMessageCStr)
 {
 	const std::string filename = std::string(modelFileName);
@@ -71,11 +76,14 @@ extern "C" __declspec(dllexport) int __cdecl BuildModel(
 		*errorMessageCStr = errorMessage.c_str();
 		return 1;
 	}
+	ModelLoader::BuildOccluder(vertices, indices, occluderData);
 
 	*vertexDataPtr = vertices.data();
 	*vertexDataSize = vertices.size() * sizeof(Vertex);
 	*indexDataPtr = indices.data();
 	*indexDataSize = indices.size() * sizeof(uint32_t);
+	*occluderDataPtr = occluderData.data();
+	*occluderDataSize = occluderData.size();
 	return 0;
 }
 
@@ -99,3 +107,22 @@ extern "C" __declspec(dllexport) int __cdecl BuildTexture(
 
 	return 0;
 }
+
+extern "C" __declspec(dllexport) int __cdecl BuildScene(
+	const char* sceneFileName,
+	const void** sceneDataPtr,
+	unsigned long long* sceneDataSize,
+	const char** errorMessageCStr)
+{
+	const std::string filename = std::string(sceneFileName);
+	bool res = SceneLoader::LoadScene(filename, sceneData, errorMessage);
+	if (!res)
+	{
+		*errorMessageCStr = errorMessage.c_str();
+		return 1;
+	}
+	*sceneDataPtr = sceneData.data();
+	*sceneDataSize = sceneData.size();
+
+	return 0;
+}
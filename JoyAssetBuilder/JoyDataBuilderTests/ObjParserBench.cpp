@@ -0,0 +1,104 @@
+#include "ObjParserBench.h"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <thread>
+#include <vector>
+
+#include "ObjParser.h"
+#include "ObjReference.h"
+
+// best of repeatCount runs in seconds, the best run is the least disturbed by the rest of the system
+template <typename F>
+static double Measure(uint32_t repeatCount, const F& function)
+{
+	double best = std::numeric_limits<double>::max();
+	for (uint32_t i = 0; i < repeatCount; i++)
+	{
+		const auto startTime = std::chrono::high_resolution_clock::now();
+		function();
+		const auto endTime = std::chrono::high_resolution_clock::now();
+		best = std::min(best, std::chrono::duration<double>(endTime - startTime).count());
+	}
+	return best;
+}
+
+// Every parser reads the file itself, as the cook does. ObjParser output is checked against tinyobj
+static void BenchModel(const std::string& name, const std::string& filename, uint32_t repeatCount)
+{
+	std::vector<Vertex> referenceVertices;
+	std::vector<uint32_t> referenceIndices;
+	std::vector<Vertex> vertices;
+	std::vector<uint32_t> indices;
+	std::string errorMessage;
+	bool isLoaded = true;
+
+	const double tinyObjTime = Measure(repeatCount, [&]()
+	{
+		isLoaded &= ObjReference::LoadModel(referenceVertices, referenceIndices, filename, errorMessage);
+	});
+	const double singleThreadTime = Measure(repeatCount, [&]()
+	{
+		isLoaded &= ObjParser::LoadModel(vertices, indices, filename, errorMessage, 1);
+	});
+	const double parallelTime = Measure(repeatCount, [&]()
+	{
+		isLoaded &= ObjParser::LoadModel(vertices, indices, filename, errorMessage);
+	});
+
+	const bool isSame = isLoaded &&
+		ObjReference::CompareModels(vertices, indices, referenceVertices, referenceIndices, errorMessage);
+
+	constexpr double MEGABYTE = 1024.0 * 1024.0;
+	std::cout << std::fixed << std::setprecision(1)
+		<< std::setw(20) << name
+		<< std::setw(12) << indices.size() / 3
+		<< std::setw(10) << std::filesystem::file_size(filename) / MEGABYTE
+		<< std::setw(12) << tinyObjTime * 1e3
+		<< std::setw(12) << singleThreadTime * 1e3
+		<< std::setw(12) << parallelTime * 1e3
+		<< (isSame ? "" : "  " + errorMessage) << std::endl;
+}
+
+void RunObjParserBench(const std::string& modelsPath)
+{
+	// 1.25 triangles per cell
+	constexpr int GRID_SIZE = 2829;
+
+	std::cout << "parse time in ms, " << std::thread::hardware_concurrency() << " hardware threads" << std::endl
+		<< std::setw(20) << "model"
+		<< std::setw(12) << "triangles"
+		<< std::setw(10) << "MB"
+		<< std::setw(12) << "tinyobj"
+		<< std::setw(12) << "parser, 1"
+		<< std::setw(12) << "parser, all" << std::endl;
+
+	std::vector<std::filesystem::path> filenames;
+	std::error_code error;
+	for (const auto& entry : std::filesystem::directory_iterator(modelsPath, error))
+	{
+		if (entry.is_regular_file() && entry.path().extension() == ".obj")
+		{
+			filenames.push_back(entry.path());
+		}
+	}
+	std::sort(filenames.begin(), filenames.end());
+	for (const auto& filename : filenames)
+	{
+		BenchModel(filename.filename().string(), filename.string(), 5);
+	}
+
+	// written to the working directory once and parsed from disk like the rest
+	const std::string generatedFilename = "generated_10m.obj";
+	{
+		std::ofstream out(generatedFilename, std::ios::binary);
+		ObjReference::WriteGridModel(out, GRID_SIZE);
+	}
+	BenchModel("generated", generatedFilename, 1);
+	std::filesystem::remove(generatedFilename, error);
+}
@@ -0,0 +1,10 @@
+#ifndef OBJ_PARSER_BENCH_H
+#define OBJ_PARSER_BENCH_H
+
+#include <string>
+
+// Parse time of tinyobj and ObjParser on the models of JoyData and on a generated model of 10M triangles.
+// Numbers are meaningful in Release builds only
+void RunObjParserBench(const std::string& modelsPath);
+
+#endif //OBJ_PARSER_BENCH_H
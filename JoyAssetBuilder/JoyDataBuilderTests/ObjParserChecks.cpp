@@ -0,0 +1,127 @@
+#include "ObjParserChecks.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+#include "ObjParser.h"
+#include "ObjReference.h"
+
+uint32_t ObjParserChecks::m_failureCount = 0;
+
+uint32_t ObjParserChecks::Run(const std::string& modelsPath)
+{
+	m_failureCount = 0;
+	CheckCompareModels();
+	CheckGeneratedModel();
+	CheckDataModels(modelsPath);
+	return m_failureCount;
+}
+
+void ObjParserChecks::Fail(const std::string& message)
+{
+	std::cerr << message << std::endl;
+	m_failureCount++;
+}
+
+// a mismatch has to be reported for the array it is in
+void ObjParserChecks::CheckCompareModels()
+{
+	std::vector<Vertex> vertices(3);
+	for (uint32_t i = 0; i < vertices.size(); i++)
+	{
+		vertices[i].pos = {static_cast<float>(i), 0.0f, 0.0f};
+		vertices[i].normal = {0.0f, 1.0f, 0.0f};
+		vertices[i].texCoord = {0.0f, 1.0f};
+	}
+	const std::vector<uint32_t> indices = {0, 1, 2};
+
+	std::string errorMessage;
+	if (!ObjReference::CompareModels(vertices, indices, vertices, indices, errorMessage))
+	{
+		Fail("CompareModels: equal models differ, " + errorMessage);
+	}
+
+	const std::vector<uint32_t> otherIndices = {0, 2, 1};
+	if (ObjReference::CompareModels(vertices, otherIndices, vertices, indices, errorMessage) ||
+		errorMessage.rfind("index 1 ", 0) != 0)
+	{
+		Fail("CompareModels: different indices reported as \"" + errorMessage + "\"");
+	}
+
+	std::vector<Vertex> otherVertices = vertices;
+	otherVertices[2].texCoord.y = 0.5f;
+	if (ObjReference::CompareModels(otherVertices, indices, vertices, indices, errorMessage) ||
+		errorMessage != "texture coordinate of vertex 2 differs")
+	{
+		Fail("CompareModels: different texture coordinates reported as \"" + errorMessage + "\"");
+	}
+}
+
+// The model is big enough to be split into several chunks, it is parsed on one and on several threads
+void ObjParserChecks::CheckGeneratedModel()
+{
+	constexpr int GRID_SIZE = 200;
+
+	std::ostringstream out;
+	ObjReference::WriteGridModel(out, GRID_SIZE);
+	const std::string obj = out.str();
+
+	std::string errorMessage;
+	std::vector<Vertex> referenceVertices;
+	std::vector<uint32_t> referenceIndices;
+	std::istringstream stream(obj);
+	if (!ObjReference::LoadModel(referenceVertices, referenceIndices, stream, errorMessage))
+	{
+		Fail("Generated model: tinyobj failed, " + errorMessage);
+		return;
+	}
+
+	for (const uint32_t threadCount : {1u, 4u})
+	{
+		std::vector<Vertex> vertices;
+		std::vector<uint32_t> indices;
+		if (!ObjParser::ParseBuffer(obj.data(), obj.size(), vertices, indices, errorMessage, threadCount) ||
+			!ObjReference::CompareModels(vertices, indices, referenceVertices, referenceIndices, errorMessage))
+		{
+			Fail("Generated model on " + std::to_string(threadCount) + " threads: " + errorMessage);
+		}
+	}
+}
+
+// the check debug builds of JoyDataBuilderLib used to make on every cooked model
+void ObjParserChecks::CheckDataModels(const std::string& modelsPath)
+{
+	std::vector<std::string> filenames;
+	std::error_code error;
+	for (const auto& entry : std::filesystem::directory_iterator(modelsPath, error))
+	{
+		if (entry.is_regular_file() && entry.path().extension() == ".obj")
+		{
+			filenames.push_back(entry.path().string());
+		}
+	}
+	if (filenames.empty())
+	{
+		Fail("No models in " + modelsPath);
+		return;
+	}
+	std::sort(filenames.begin(), filenames.end());
+
+	for (const auto& filename : filenames)
+	{
+		std::string errorMessage;
+		std::vector<Vertex> vertices;
+		std::vector<uint32_t> indices;
+		std::vector<Vertex> referenceVertices;
+		std::vector<uint32_t> referenceIndices;
+		if (!ObjParser::LoadModel(vertices, indices, filename, errorMessage) ||
+			!ObjReference::LoadModel(referenceVertices, referenceIndices, filename, errorMessage) ||
+			!ObjReference::CompareModels(vertices, indices, referenceVertices, referenceIndices, errorMessage))
+		{
+			Fail(filename + ": " + errorMessage);
+		}
+	}
+}
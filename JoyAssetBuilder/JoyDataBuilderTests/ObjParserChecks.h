@@ -0,0 +1,27 @@
+#ifndef OBJ_PARSER_CHECKS_H
+#define OBJ_PARSER_CHECKS_H
+
+#include <cstdint>
+#include <string>
+
+// ObjParser output compared to tinyobj, on a generated model and on every model of JoyData
+class ObjParserChecks
+{
+public:
+	// returns the number of failed checks, each of them is printed to std::cerr
+	static uint32_t Run(const std::string& modelsPath);
+
+private:
+	static void CheckCompareModels();
+
+	static void CheckGeneratedModel();
+
+	static void CheckDataModels(const std::string& modelsPath);
+
+	static void Fail(const std::string& message);
+
+private:
+	static uint32_t m_failureCount;
+};
+
+#endif //OBJ_PARSER_CHECKS_H
@@ -0,0 +1,224 @@
+#ifndef OBJ_REFERENCE_H
+#define OBJ_REFERENCE_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "JoyAssetHeaders.h"
+#include "tiny_obj_loader.h"
+
+// Single threaded tinyobj loading with the output of ObjParser, which ObjParser is checked and measured against,
+// and models generated for both
+class ObjReference
+{
+public:
+	[[nodiscard]]
+	static bool LoadModel(std::vector<Vertex>& vertices,
+	                      std::vector<uint32_t>& indices,
+	                      const std::string& filename,
+	                      std::string& errorMessage)
+	{
+		std::ifstream stream(filename);
+		if (!stream.is_open())
+		{
+			errorMessage = "Cannot open stream";
+			return false;
+		}
+		return LoadModel(vertices, indices, stream, errorMessage);
+	}
+
+	[[nodiscard]]
+	static bool LoadModel(std::vector<Vertex>& vertices,
+	                      std::vector<uint32_t>& indices,
+	                      std::istream& stream,
+	                      std::string& errorMessage)
+	{
+		bool res;
+		tinyobj::attrib_t attrib;
+		std::vector<tinyobj::shape_t> shapes;
+		std::vector<tinyobj::material_t> materials;
+		std::string warn, err;
+
+		res = tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, &stream);
+		if (!res)
+		{
+			errorMessage = err;
+			return false;
+		}
+
+		size_t vertSize = 0;
+		for (const auto& shape : shapes)
+		{
+			vertSize += shape.mesh.indices.size();
+		}
+		vertices.resize(vertSize);
+		indices.resize(vertSize);
+
+		uint32_t vertIndex = 0;
+		for (const auto& shape : shapes)
+		{
+			for (const auto& index : shape.mesh.indices)
+			{
+				vertices[vertIndex].pos = {
+					attrib.vertices[3 * index.vertex_index + 0],
+					attrib.vertices[3 * index.vertex_index + 1],
+					attrib.vertices[3 * index.vertex_index + 2]
+				};
+				// missing attributes get the same defaults as in ObjParser
+				if (index.normal_index >= 0)
+				{
+					vertices[vertIndex].normal = {
+						attrib.normals[3 * index.normal_index + 0],
+						attrib.normals[3 * index.normal_index + 1],
+						attrib.normals[3 * index.normal_index + 2]
+					};
+				}
+				else
+				{
+					vertices[vertIndex].normal = {0.0f, 0.0f, 0.0f};
+				}
+				if (index.texcoord_index >= 0)
+				{
+					vertices[vertIndex].texCoord = {
+						attrib.texcoords[2 * index.texcoord_index + 0],
+						1.0f - attrib.texcoords[2 * index.texcoord_index + 1]
+					};
+				}
+				else
+				{
+					vertices[vertIndex].texCoord = {0.0f, 1.0f};
+				}
+
+				vertices[vertIndex].color = {1.0f, 1.0f, 1.0f};
+
+				indices[vertIndex] = vertIndex;
+				vertIndex++;
+			}
+		}
+
+		return true;
+	}
+
+	// Floats may differ in the last bit, tinyobj parses through double.
+	// errorMessage tells which array differs first and where
+	[[nodiscard]]
+	static bool CompareModels(const std::vector<Vertex>& vertices,
+	                          const std::vector<uint32_t>& indices,
+	                          const std::vector<Vertex>& referenceVertices,
+	                          const std::vector<uint32_t>& referenceIndices,
+	                          std::string& errorMessage)
+	{
+		if (vertices.size() != referenceVertices.size())
+		{
+			errorMessage = "vertex count " + std::to_string(vertices.size()) +
+				" instead of " + std::to_string(referenceVertices.size());
+			return false;
+		}
+		if (indices.size() != referenceIndices.size())
+		{
+			errorMessage = "index count " + std::to_string(indices.size()) +
+				" instead of " + std::to_string(referenceIndices.size());
+			return false;
+		}
+
+		const auto index = std::mismatch(indices.begin(), indices.end(), referenceIndices.begin());
+		if (index.first != indices.end())
+		{
+			errorMessage = "index " + std::to_string(index.first - indices.begin()) + " is " +
+				std::to_string(*index.first) + " instead of " + std::to_string(*index.second);
+			return false;
+		}
+
+		auto isNear = [](float a, float b)
+		{
+			return std::abs(a - b) <= 1e-6f * std::max(1.0f, std::abs(b));
+		};
+
+		for (size_t i = 0; i < vertices.size(); i++)
+		{
+			const Vertex& v = vertices[i];
+			const Vertex& r = referenceVertices[i];
+			const char* attribute = nullptr;
+			if (!isNear(v.pos.x, r.pos.x) || !isNear(v.pos.y, r.pos.y) || !isNear(v.pos.z, r.pos.z))
+			{
+				attribute = "position";
+			}
+			else if (!isNear(v.normal.x, r.normal.x) || !isNear(v.normal.y, r.normal.y) ||
+				!isNear(v.normal.z, r.normal.z))
+			{
+				attribute = "normal";
+			}
+			else if (!isNear(v.texCoord.x, r.texCoord.x) || !isNear(v.texCoord.y, r.texCoord.y))
+			{
+				attribute = "texture coordinate";
+			}
+			if (attribute != nullptr)
+			{
+				errorMessage = std::string(attribute) + " of vertex " + std::to_string(i) + " differs";
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// Grid of gridSize * gridSize cells with vertices interleaved with faces, relative indices,
+	// quads and missing attributes. Every four cells of a row make five triangles
+	static void WriteGridModel(std::ostream& out, int gridSize)
+	{
+		out << "# generated\n";
+		char line[256];
+		for (int row = 0; row <= gridSize; row++)
+		{
+			out << "g row" << row << "\n";
+			for (int column = 0; column <= gridSize; column++)
+			{
+				snprintf(line, sizeof(line), "v %.4f %.6f %.3e\nvt %.5f %.5f\nvn 0 %.6f %.6f\n",
+				         column * 0.37f - 50.0f, std::sin(row * 0.1f + column * 0.05f), row * -0.125f,
+				         static_cast<float>(column) / gridSize, static_cast<float>(row) / gridSize,
+				         std::cos(column * 0.01f), std::sin(column * 0.01f));
+				out << line;
+			}
+			if (row == 0)
+			{
+				continue;
+			}
+			for (int column = 0; column < gridSize; column++)
+			{
+				// 1-based index of the vertex in the previous row
+				const int a = (row - 1) * (gridSize + 1) + column + 1;
+				const int b = a + gridSize + 1;
+				const int lastIndex = (row + 1) * (gridSize + 1);
+				switch (column % 4)
+				{
+				case 0:
+					snprintf(line, sizeof(line), "f %d/%d/%d %d/%d/%d %d/%d/%d %d/%d/%d\n",
+					         a, a, a, a + 1, a + 1, a + 1, b + 1, b + 1, b + 1, b, b, b);
+					break;
+				case 1:
+					snprintf(line, sizeof(line), "f %d/%d/%d %d/%d/%d %d/%d/%d\n",
+					         a - lastIndex - 1, a - lastIndex - 1, a - lastIndex - 1,
+					         a - lastIndex, a - lastIndex, a - lastIndex,
+					         b - lastIndex, b - lastIndex, b - lastIndex);
+					break;
+				case 2:
+					snprintf(line, sizeof(line), "# no texcoords\nf %d//%d %d//%d %d//%d\n",
+					         a, a, a + 1, a + 1, b + 1, b + 1);
+					break;
+				default:
+					snprintf(line, sizeof(line), "f %d/%d %d/%d %d/%d\n", a, a, b + 1, b + 1, b, b);
+					break;
+				}
+				out << line;
+			}
+		}
+	}
+};
+
+#endif //OBJ_REFERENCE_H
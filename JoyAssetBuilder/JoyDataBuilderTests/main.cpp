@@ -0,0 +1,36 @@
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include "ObjParserBench.h"
+#include "ObjParserChecks.h"
+
+static const std::string g_modelsPath = R"(D:\CppProjects\JoyEngine\JoyData\models)";
+
+// Checks ObjParser against tinyobj, "bench" argument also measures both of them
+int main(int argc, char** argv)
+{
+	const bool isBench = argc == 2 && strcmp(argv[1], "bench") == 0;
+	if (argc > 1 && !isBench)
+	{
+		std::cerr << "Usage: JoyDataBuilderTests [bench]" << std::endl;
+		return 1;
+	}
+
+	const uint32_t failureCount = ObjParserChecks::Run(g_modelsPath);
+	if (failureCount != 0)
+	{
+		std::cerr << failureCount << " checks failed" << std::endl;
+		return 1;
+	}
+	std::cout << "All checks passed" << std::endl;
+
+	if (isBench)
+	{
+#ifdef _DEBUG
+		std::cout << "Debug build, numbers are not representative" << std::endl;
+#endif
+		RunObjParserBench(g_modelsPath);
+	}
+	return 0;
+}
@@ -0,0 +1,92 @@
+#ifndef SHADER_CACHE_H
+#define SHADER_CACHE_H
+
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// On-disk SPIR-V cache.
+// Entries are keyed by a hash of the preprocessed source (so includes and macros are taken into account)
+// mixed with everything else that changes the output: shader kind, compile options and compiler version.
+class ShaderCache
+{
+public:
+	static constexpr uint64_t FNV_OFFSET = 14695981039346656037ull;
+	static constexpr uint64_t FNV_PRIME = 1099511628211ull;
+
+	// Bump when the cache key or entry layout changes
+	static constexpr uint32_t CACHE_VERSION = 1;
+
+	static uint64_t Hash(const void* data, size_t size, uint64_t hash = FNV_OFFSET)
+	{
+		const auto* bytes = static_cast<const unsigned char*>(data);
+		for (size_t i = 0; i < size; i++)
+		{
+			hash ^= bytes[i];
+			hash *= FNV_PRIME;
+		}
+		return hash;
+	}
+
+	template <typename T>
+	static uint64_t HashValue(const T& value, uint64_t hash)
+	{
+		return Hash(&value, sizeof(T), hash);
+	}
+
+	static std::string GetEntryPath(const std::string& cacheDirectory, uint64_t key)
+	{
+		char name[32];
+		snprintf(name, sizeof(name), "%016llx.spv", static_cast<unsigned long long>(key));
+		return (std::filesystem::path(cacheDirectory) / name).string();
+	}
+
+	static bool Read(const std::string& cacheDirectory, uint64_t key, std::vector<char>& data)
+	{
+		std::ifstream stream(GetEntryPath(cacheDirectory, key), std::ios::binary | std::ios::ate);
+		if (!stream.is_open())
+		{
+			return false;
+		}
+		const std::streamsize size = stream.tellg();
+		// SPIR-V is a stream of 32-bit words, anything else is a broken entry
+		if (size <= 0 || size % 4 != 0)
+		{
+			return false;
+		}
+		data.resize(static_cast<size_t>(size));
+		stream.seekg(0, std::ios::beg);
+		return static_cast<bool>(stream.read(data.data(), size));
+	}
+
+	static void Write(const std::string& cacheDirectory, uint64_t key, const char* data, size_t size)
+	{
+		std::error_code error;
+		std::filesystem::create_directories(cacheDirectory, error);
+
+		// Several workers (or builder instances) may produce the same entry,
+		// so write to a unique temporary file and move it in place
+		const std::string entryPath = GetEntryPath(cacheDirectory, key);
+		const std::string tempPath = entryPath + "." +
+			std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+		{
+			std::ofstream stream(tempPath, std::ios::binary | std::ios::trunc);
+			if (!stream.is_open())
+			{
+				return;
+			}
+			stream.write(data, static_cast<std::streamsize>(size));
+		}
+		std::filesystem::rename(tempPath, entryPath, error);
+		if (error)
+		{
+			std::filesystem::remove(tempPath, error);
+		}
+	}
+};
+
+#endif //SHADER_CACHE_H
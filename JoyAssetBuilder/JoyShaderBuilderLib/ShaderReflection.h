@@ -0,0 +1,573 @@
+#ifndef SHADER_REFLECTION_H
+#define SHADER_REFLECTION_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "Common/HashDefs.h"
+#include "ResourceManager/ShaderLayout.h"
+
+// Minimal SPIR-V reflection.
+// Walks the module once, collects names, decorations, types and resource variables
+// (descriptor sets and push constants), then merges several stages into one JoyEngine::ShaderLayout blob.
+class ShaderReflection
+{
+public:
+	[[nodiscard]]
+	static bool BuildLayout(const std::vector<std::pair<const uint32_t*, size_t>>& stages,
+	                        const std::vector<VkShaderStageFlagBits>& stageFlags,
+	                        std::vector<char>& layoutData,
+	                        std::string& errorMessage)
+	{
+		Layout layout;
+		for (size_t i = 0; i < stages.size(); i++)
+		{
+			Module module;
+			if (!module.Parse(stages[i].first, stages[i].second, errorMessage))
+			{
+				return false;
+			}
+			if (!ReflectStage(module, stageFlags[i], layout, errorMessage))
+			{
+				return false;
+			}
+		}
+		Serialize(layout, layoutData);
+		return true;
+	}
+
+private:
+	enum Op : uint16_t
+	{
+		OpName = 5,
+		OpMemberName = 6,
+		OpTypeBool = 20,
+		OpTypeInt = 21,
+		OpTypeFloat = 22,
+		OpTypeVector = 23,
+		OpTypeMatrix = 24,
+		OpTypeImage = 25,
+		OpTypeSampler = 26,
+		OpTypeSampledImage = 27,
+		OpTypeArray = 28,
+		OpTypeRuntimeArray = 29,
+		OpTypeStruct = 30,
+		OpTypePointer = 32,
+		OpConstant = 43,
+		OpVariable = 59,
+		OpDecorate = 71,
+		OpMemberDecorate = 72,
+	};
+
+	enum Decoration : uint32_t
+	{
+		DecorationBlock = 2,
+		DecorationBufferBlock = 3,
+		DecorationArrayStride = 6,
+		DecorationMatrixStride = 7,
+		DecorationBinding = 33,
+		DecorationDescriptorSet = 34,
+		DecorationOffset = 35,
+	};
+
+	enum StorageClass : uint32_t
+	{
+		StorageClassUniformConstant = 0,
+		StorageClassUniform = 2,
+		StorageClassPushConstant = 9,
+		StorageClassStorageBuffer = 12,
+	};
+
+	static constexpr uint32_t SPIRV_MAGIC = 0x07230203;
+	static constexpr uint32_t DIM_BUFFER = 5;
+	static constexpr uint32_t DIM_SUBPASS_DATA = 6;
+	static constexpr uint32_t NO_VALUE = UINT32_MAX;
+
+	struct TypeInfo
+	{
+		uint16_t op = 0;
+		std::vector<uint32_t> operands; // instruction words after the result id
+	};
+
+	struct Decorations
+	{
+		uint32_t set = NO_VALUE;
+		uint32_t binding = NO_VALUE;
+		uint32_t arrayStride = 0;
+		bool block = false;
+		bool bufferBlock = false;
+	};
+
+	struct MemberDecorations
+	{
+		uint32_t offset = 0;
+		uint32_t matrixStride = 0;
+	};
+
+	struct Variable
+	{
+		uint32_t id;
+		uint32_t typeId;
+		uint32_t storageClass;
+	};
+
+	struct Module
+	{
+		std::unordered_map<uint32_t, TypeInfo> types;
+		std::unordered_map<uint32_t, uint32_t> constants;
+		std::unordered_map<uint32_t, std::string> names;
+		std::map<std::pair<uint32_t, uint32_t>, std::string> memberNames;
+		std::unordered_map<uint32_t, Decorations> decorations;
+		std::map<std::pair<uint32_t, uint32_t>, MemberDecorations> memberDecorations;
+		std::vector<Variable> variables;
+
+		bool Parse(const uint32_t* words, size_t wordCount, std::string& errorMessage)
+		{
+			if (wordCount < 5 || words[0] != SPIRV_MAGIC)
+			{
+				errorMessage = "Invalid SPIR-V module";
+				return false;
+			}
+
+			size_t i = 5;
+			while (i < wordCount)
+			{
+				const uint16_t opcode = static_cast<uint16_t>(words[i] & 0xFFFF);
+				const uint16_t length = static_cast<uint16_t>(words[i] >> 16);
+				if (length == 0 || i + length > wordCount)
+				{
+					errorMessage = "Truncated SPIR-V instruction";
+					return false;
+				}
+				const uint32_t* op = words + i;
+
+				switch (opcode)
+				{
+				case OpName:
+					names[op[1]] = ReadString(op + 2, length - 2);
+					break;
+				case OpMemberName:
+					memberNames[{op[1], op[2]}] = ReadString(op + 3, length - 3);
+					break;
+				case OpDecorate:
+					ReadDecoration(decorations[op[1]], op[2], length > 3 ? op[3] : 0);
+					break;
+				case OpMemberDecorate:
+					{
+						MemberDecorations& member = memberDecorations[{op[1], op[2]}];
+						if (op[3] == DecorationOffset) member.offset = op[4];
+						if (op[3] == DecorationMatrixStride) member.matrixStride = op[4];
+						break;
+					}
+				case OpTypeBool:
+				case OpTypeInt:
+				case OpTypeFloat:
+				case OpTypeVector:
+				case OpTypeMatrix:
+				case OpTypeImage:
+				case OpTypeSampler:
+				case OpTypeSampledImage:
+				case OpTypeArray:
+				case OpTypeRuntimeArray:
+				case OpTypeStruct:
+				case OpTypePointer:
+					types[op[1]] = {opcode, std::vector<uint32_t>(op + 2, op + length)};
+					break;
+				case OpConstant:
+					// Only 32-bit constants are interesting, they are used as array lengths
+					constants[op[2]] = op[3];
+					break;
+				case OpVariable:
+					variables.push_back({op[2], op[1], op[3]});
+					break;
+				default:
+					break;
+				}
+				i += length;
+			}
+			return true;
+		}
+
+		static std::string ReadString(const uint32_t* words, size_t maxWords)
+		{
+			const char* str = reinterpret_cast<const char*>(words);
+			return std::string(str, strnlen(str, maxWords * sizeof(uint32_t)));
+		}
+
+		static void ReadDecoration(Decorations& dec, uint32_t decoration, uint32_t value)
+		{
+			switch (decoration)
+			{
+			case DecorationBlock:
+				dec.block = true;
+				break;
+			case DecorationBufferBlock:
+				dec.bufferBlock = true;
+				break;
+			case DecorationArrayStride:
+				dec.arrayStride = value;
+				break;
+			case DecorationBinding:
+				dec.binding = value;
+				break;
+			case DecorationDescriptorSet:
+				dec.set = value;
+				break;
+			default:
+				break;
+			}
+		}
+
+		[[nodiscard]] const TypeInfo& Type(uint32_t id) const
+		{
+			static const TypeInfo empty;
+			const auto it = types.find(id);
+			return it == types.end() ? empty : it->second;
+		}
+
+		[[nodiscard]] Decorations Decoration(uint32_t id) const
+		{
+			const auto it = decorations.find(id);
+			return it == decorations.end() ? Decorations() : it->second;
+		}
+
+		[[nodiscard]] std::string Name(uint32_t id) const
+		{
+			const auto it = names.find(id);
+			return it == names.end() ? std::string() : it->second;
+		}
+
+		// std140/std430 size as the layout decorations describe it
+		[[nodiscard]] uint32_t SizeOf(uint32_t typeId, uint32_t matrixStride) const
+		{
+			const TypeInfo& type = Type(typeId);
+			switch (type.op)
+			{
+			case OpTypeBool:
+				return 4;
+			case OpTypeInt:
+			case OpTypeFloat:
+				return type.operands[0] / 8;
+			case OpTypeVector:
+				return SizeOf(type.operands[0], 0) * type.operands[1];
+			case OpTypeMatrix:
+				return matrixStride != 0
+					       ? matrixStride * type.operands[1]
+					       : SizeOf(type.operands[0], 0) * type.operands[1];
+			case OpTypeArray:
+				{
+					const uint32_t stride = Decoration(typeId).arrayStride;
+					const uint32_t count = constants.count(type.operands[1]) ? constants.at(type.operands[1]) : 0;
+					return (stride != 0 ? stride : SizeOf(type.operands[0], matrixStride)) * count;
+				}
+			case OpTypeStruct:
+				{
+					uint32_t size = 0;
+					for (uint32_t m = 0; m < type.operands.size(); m++)
+					{
+						const auto it = memberDecorations.find({typeId, m});
+						const MemberDecorations member = it == memberDecorations.end() ? MemberDecorations() : it->second;
+						size = std::max(size, member.offset + SizeOf(type.operands[m], member.matrixStride));
+					}
+					return size;
+				}
+			default:
+				return 0;
+			}
+		}
+
+		// strHash of the serializable type with the same GLSL layout, see SerializationUtils.
+		// Only the type is looked at, member names don't matter, so vec4 is always "vec4" and never "color"
+		[[nodiscard]] uint32_t SerializableTypeHash(uint32_t typeId) const
+		{
+			const TypeInfo& type = Type(typeId);
+			switch (type.op)
+			{
+			case OpTypeInt:
+				return type.operands[1] != 0 ? strHash("int") : strHash("uint");
+			case OpTypeFloat:
+				return type.operands[0] == 32 ? strHash("float") : 0;
+			case OpTypeVector:
+				{
+					if (Type(type.operands[0]).op != OpTypeFloat) return 0;
+					switch (type.operands[1])
+					{
+					case 2: return strHash("vec2");
+					case 3: return strHash("vec3");
+					case 4: return strHash("vec4");
+					default: return 0;
+					}
+				}
+			case OpTypeMatrix:
+				{
+					const TypeInfo& column = Type(type.operands[0]);
+					if (column.op != OpTypeVector || column.operands[1] != type.operands[1]) return 0;
+					switch (type.operands[1])
+					{
+					case 3: return strHash("mat3");
+					case 4: return strHash("mat4");
+					default: return 0;
+					}
+				}
+			default:
+				return 0;
+			}
+		}
+	};
+
+	struct Member
+	{
+		std::string name;
+		JoyEngine::ShaderMemberDesc desc;
+	};
+
+	struct Binding
+	{
+		std::string name;
+		JoyEngine::ShaderBindingDesc desc;
+		std::vector<Member> members;
+	};
+
+	struct Layout
+	{
+		std::map<std::pair<uint32_t, uint32_t>, Binding> bindings;
+		std::vector<JoyEngine::ShaderPushConstantDesc> pushConstants;
+	};
+
+	static void ReflectMembers(const Module& module, uint32_t structId, std::vector<Member>& members)
+	{
+		const TypeInfo& type = module.Type(structId);
+		for (uint32_t m = 0; m < type.operands.size(); m++)
+		{
+			const auto nameIt = module.memberNames.find({structId, m});
+			const auto decIt = module.memberDecorations.find({structId, m});
+			const MemberDecorations dec = decIt == module.memberDecorations.end() ? MemberDecorations() : decIt->second;
+
+			uint32_t memberType = type.operands[m];
+			uint32_t arrayCount = 1;
+			uint32_t arrayStride = 0;
+			const TypeInfo& memberInfo = module.Type(memberType);
+			if (memberInfo.op == OpTypeArray)
+			{
+				arrayCount = module.constants.count(memberInfo.operands[1]) ? module.constants.at(memberInfo.operands[1]) : 0;
+				arrayStride = module.Decoration(memberType).arrayStride;
+				memberType = memberInfo.operands[0];
+			}
+
+			Member member;
+			member.name = nameIt == module.memberNames.end() ? std::string() : nameIt->second;
+			member.desc = {
+				0,
+				module.SerializableTypeHash(memberType),
+				dec.offset,
+				module.SizeOf(type.operands[m], dec.matrixStride),
+				arrayCount,
+				arrayStride
+			};
+			members.push_back(member);
+		}
+	}
+
+	static bool ReflectStage(const Module& module, VkShaderStageFlagBits stage, Layout& layout, std::string& errorMessage)
+	{
+		for (const Variable& variable : module.variables)
+		{
+			if (variable.storageClass != StorageClassUniformConstant &&
+				variable.storageClass != StorageClassUniform &&
+				variable.storageClass != StorageClassPushConstant &&
+				variable.storageClass != StorageClassStorageBuffer)
+			{
+				continue;
+			}
+
+			const TypeInfo& pointer = module.Type(variable.typeId);
+			if (pointer.op != OpTypePointer)
+			{
+				continue;
+			}
+			uint32_t typeId = pointer.operands[1];
+
+			if (variable.storageClass == StorageClassPushConstant)
+			{
+				std::vector<Member> members;
+				ReflectMembers(module, typeId, members);
+				uint32_t begin = UINT32_MAX;
+				for (const auto& member : members)
+				{
+					begin = std::min(begin, member.desc.offset);
+				}
+				if (members.empty())
+				{
+					continue;
+				}
+				layout.pushConstants.push_back({begin, module.SizeOf(typeId, 0) - begin, static_cast<uint32_t>(stage)});
+				continue;
+			}
+
+			uint32_t descriptorCount = 1;
+			const TypeInfo* type = &module.Type(typeId);
+			if (type->op == OpTypeArray)
+			{
+				descriptorCount = module.constants.count(type->operands[1]) ? module.constants.at(type->operands[1]) : 1;
+				typeId = type->operands[0];
+				type = &module.Type(typeId);
+			}
+			else if (type->op == OpTypeRuntimeArray)
+			{
+				descriptorCount = 0;
+				typeId = type->operands[0];
+				type = &module.Type(typeId);
+			}
+
+			VkDescriptorType descriptorType;
+			switch (type->op)
+			{
+			case OpTypeSampledImage:
+				descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+				break;
+			case OpTypeSampler:
+				descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER;
+				break;
+			case OpTypeImage:
+				{
+					const uint32_t dim = type->operands[1];
+					const uint32_t sampled = type->operands[5];
+					if (dim == DIM_SUBPASS_DATA)
+						descriptorType = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+					else if (dim == DIM_BUFFER)
+						descriptorType = sampled == 2
+							                 ? VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER
+							                 : VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER;
+					else
+						descriptorType = sampled == 2
+							                 ? VK_DESCRIPTOR_TYPE_STORAGE_IMAGE
+							                 : VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+					break;
+				}
+			case OpTypeStruct:
+				{
+					const Decorations typeDecorations = module.Decoration(typeId);
+					descriptorType = variable.storageClass == StorageClassStorageBuffer || typeDecorations.bufferBlock
+						                 ? VK_DESCRIPTOR_TYPE_STORAGE_BUFFER
+						                 : VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+					break;
+				}
+			default:
+				continue;
+			}
+
+			const Decorations dec = module.Decoration(variable.id);
+			if (dec.set == NO_VALUE || dec.binding == NO_VALUE)
+			{
+				errorMessage = "Resource " + module.Name(variable.id) + " has no set or binding decoration";
+				return false;
+			}
+
+			auto it = layout.bindings.find({dec.set, dec.binding});
+			if (it != layout.bindings.end())
+			{
+				if (it->second.desc.descriptorType != static_cast<uint32_t>(descriptorType))
+				{
+					errorMessage = "Stages disagree on the type of set " + std::to_string(dec.set) +
+						" binding " + std::to_string(dec.binding);
+					return false;
+				}
+				it->second.desc.stageFlags |= stage;
+				continue;
+			}
+
+			Binding binding;
+			// Blocks are named by their type ("uniform Data {...} data;"), samplers by the variable
+			binding.name = module.Name(variable.id);
+			if (type->op == OpTypeStruct)
+			{
+				if (binding.name.empty()) binding.name = module.Name(typeId);
+				ReflectMembers(module, typeId, binding.members);
+			}
+			binding.desc = {
+				dec.set,
+				dec.binding,
+				static_cast<uint32_t>(descriptorType),
+				descriptorCount,
+				static_cast<uint32_t>(stage),
+				type->op == OpTypeStruct ? module.SizeOf(typeId, 0) : 0,
+				0,
+				static_cast<uint32_t>(binding.members.size()),
+				0
+			};
+			layout.bindings.insert({{dec.set, dec.binding}, binding});
+		}
+		return true;
+	}
+
+	static uint32_t AddString(std::vector<char>& strings, const std::string& str)
+	{
+		const auto offset = static_cast<uint32_t>(strings.size());
+		strings.insert(strings.end(), str.begin(), str.end());
+		strings.push_back('\0');
+		return offset;
+	}
+
+	static void Serialize(Layout& layout, std::vector<char>& data)
+	{
+		// Stages that share the same push constant block are merged into one range
+		std::vector<JoyEngine::ShaderPushConstantDesc> pushConstants;
+		for (const auto& range : layout.pushConstants)
+		{
+			auto it = std::find_if(pushConstants.begin(), pushConstants.end(), [&range](const auto& r)
+			{
+				return r.offset == range.offset && r.size == range.size;
+			});
+			if (it != pushConstants.end())
+				it->stageFlags |= range.stageFlags;
+			else
+				pushConstants.push_back(range);
+		}
+
+		std::vector<char> strings;
+		std::vector<JoyEngine::ShaderBindingDesc> bindings;
+		std::vector<JoyEngine::ShaderMemberDesc> members;
+		for (auto& [key, binding] : layout.bindings)
+		{
+			binding.desc.nameOffset = AddString(strings, binding.name);
+			binding.desc.firstMember = static_cast<uint32_t>(members.size());
+			for (auto& member : binding.members)
+			{
+				member.desc.nameOffset = AddString(strings, member.name);
+				members.push_back(member.desc);
+			}
+			bindings.push_back(binding.desc);
+		}
+
+		const JoyEngine::ShaderLayoutHeader header = {
+			JoyEngine::SHADER_LAYOUT_MAGIC,
+			JoyEngine::SHADER_LAYOUT_VERSION,
+			static_cast<uint32_t>(bindings.size()),
+			static_cast<uint32_t>(members.size()),
+			static_cast<uint32_t>(pushConstants.size()),
+			static_cast<uint32_t>(strings.size())
+		};
+
+		data.clear();
+		Append(data, &header, sizeof(header));
+		Append(data, bindings.data(), bindings.size() * sizeof(JoyEngine::ShaderBindingDesc));
+		Append(data, members.data(), members.size() * sizeof(JoyEngine::ShaderMemberDesc));
+		Append(data, pushConstants.data(), pushConstants.size() * sizeof(JoyEngine::ShaderPushConstantDesc));
+		Append(data, strings.data(), strings.size());
+	}
+
+	static void Append(std::vector<char>& data, const void* src, size_t size)
+	{
+		const auto* bytes = static_cast<const char*>(src);
+		data.insert(data.end(), bytes, bytes + size);
+	}
+};
+
+#endif //SHADER_REFLECTION_H
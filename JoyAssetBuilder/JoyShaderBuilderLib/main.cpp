@@ -1,11 +1,17 @@
+#include <algorithm>
+#include <atomic>
 #include <cstring>
 #include <iostream>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include <shaderc/shaderc.hpp>
 #include <JoyAssetHeaders.h>
 
+#include "ShaderCache.h"
+#include "ShaderReflection.h"
+
 const char* s = "Hello from c++";
 
 extern "C" __declspec(dllexport) void __cdecl GetString(char** string)
@@ -13,18 +19,179 @@ extern "C" __declspec(dllexport) void __cdecl GetString(char** string)
 	*string = const_cast<char*>(s);
 }
 
-shaderc_compiler_t compiler;
-shaderc_compilation_result_t result;
-
 enum ShaderType
 {
 	Vertex = 1 << 0,
-	Fragment = 1 << 1
+	Fragment = 1 << 1,
+	Compute = 1 << 2
+};
+
+struct ShaderCompileJob
+{
+	const char* shaderText;
+	int shaderTextSize;
+	ShaderType type;
+};
+
+struct ShaderCompileOutput
+{
+	const char* dataPtr;
+	unsigned long long dataSize;
+	const char* errorMessage;
+	int status;
+	int fromCache;
+};
+
+// Compilers are created lazily, one per thread, so every entry point below is re-entrant
+struct ThreadCompiler
+{
+	shaderc_compiler_t compiler = nullptr;
+	shaderc_compilation_result_t result = nullptr;
+
+	~ThreadCompiler()
+	{
+		ReleaseResult();
+		Release();
+	}
+
+	shaderc_compiler_t Get()
+	{
+		if (compiler == nullptr)
+		{
+			compiler = shaderc_compiler_initialize();
+		}
+		return compiler;
+	}
+
+	void ReleaseResult()
+	{
+		if (result != nullptr)
+		{
+			shaderc_result_release(result);
+			result = nullptr;
+		}
+	}
+
+	void Release()
+	{
+		if (compiler != nullptr)
+		{
+			shaderc_compiler_release(compiler);
+			compiler = nullptr;
+		}
+	}
 };
 
+thread_local ThreadCompiler threadCompiler;
+
+struct CompileBatch
+{
+	std::vector<std::vector<char>> spirv;
+	std::vector<std::string> errors;
+};
+
+bool GetShaderKind(ShaderType type, shaderc_shader_kind& kind)
+{
+	switch (type)
+	{
+	case Vertex:
+		kind = shaderc_vertex_shader;
+		return true;
+	case Fragment:
+		kind = shaderc_fragment_shader;
+		return true;
+	case Compute:
+		kind = shaderc_compute_shader;
+		return true;
+	default:
+		return false;
+	}
+}
+
+uint64_t GetCacheKey(const char* preprocessedText, size_t preprocessedSize, shaderc_shader_kind kind)
+{
+	unsigned int spvVersion = 0;
+	unsigned int spvRevision = 0;
+	shaderc_get_spv_version(&spvVersion, &spvRevision);
+
+	uint64_t key = ShaderCache::Hash(preprocessedText, preprocessedSize);
+	key = ShaderCache::HashValue(kind, key);
+	key = ShaderCache::HashValue(ShaderCache::CACHE_VERSION, key);
+	key = ShaderCache::HashValue(spvVersion, key);
+	key = ShaderCache::HashValue(spvRevision, key);
+	// Default compile options, "main" entry point. Hash them here when options become configurable
+	key = ShaderCache::Hash("main", 4, key);
+	return key;
+}
+
+void CompileJob(const ShaderCompileJob& job, const std::string& cacheDirectory,
+                CompileBatch& batch, size_t index, ShaderCompileOutput& output)
+{
+	output = {};
+
+	shaderc_shader_kind kind;
+	if (!GetShaderKind(job.type, kind))
+	{
+		output.status = shaderc_compilation_status_configuration_error;
+		return;
+	}
+
+	shaderc_compiler_t compiler = threadCompiler.Get();
+	uint64_t cacheKey = 0;
+	const bool useCache = !cacheDirectory.empty();
+
+	if (useCache)
+	{
+		shaderc_compilation_result_t preprocessed = shaderc_compile_into_preprocessed_text(
+			compiler, job.shaderText, job.shaderTextSize, kind, "", "main", nullptr);
+		const shaderc_compilation_status status = shaderc_result_get_compilation_status(preprocessed);
+		if (status != shaderc_compilation_status_success)
+		{
+			batch.errors[index] = shaderc_result_get_error_message(preprocessed);
+			shaderc_result_release(preprocessed);
+			output.status = status;
+			output.errorMessage = batch.errors[index].c_str();
+			return;
+		}
+		cacheKey = GetCacheKey(shaderc_result_get_bytes(preprocessed), shaderc_result_get_length(preprocessed), kind);
+		shaderc_result_release(preprocessed);
+
+		if (ShaderCache::Read(cacheDirectory, cacheKey, batch.spirv[index]))
+		{
+			output.dataPtr = batch.spirv[index].data();
+			output.dataSize = batch.spirv[index].size();
+			output.fromCache = 1;
+			return;
+		}
+	}
+
+	shaderc_compilation_result_t result = shaderc_compile_into_spv(
+		compiler, job.shaderText, job.shaderTextSize, kind, "", "main", nullptr);
+	const shaderc_compilation_status status = shaderc_result_get_compilation_status(result);
+	output.status = status;
+	if (status != shaderc_compilation_status_success)
+	{
+		batch.errors[index] = shaderc_result_get_error_message(result);
+		output.errorMessage = batch.errors[index].c_str();
+	}
+	else
+	{
+		const char* bytes = shaderc_result_get_bytes(result);
+		const size_t length = shaderc_result_get_length(result);
+		batch.spirv[index].assign(bytes, bytes + length);
+		output.dataPtr = batch.spirv[index].data();
+		output.dataSize = length;
+		if (useCache)
+		{
+			ShaderCache::Write(cacheDirectory, cacheKey, bytes, length);
+		}
+	}
+	shaderc_result_release(result);
+}
+
 extern "C" __declspec(dllexport) void __cdecl InitializeCompiler()
 {
-	compiler = shaderc_compiler_initialize();
+	threadCompiler.Get();
 }
 
 extern "C" __declspec(dllexport) int __cdecl CompileGLSL(
@@ -36,53 +203,126 @@ extern "C" __declspec(dllexport) int __cdecl CompileGLSL(
 	const char** errorMessage)
 {
 	shaderc_shader_kind kind;
-	switch (type)
+	if (!GetShaderKind(type, kind))
 	{
-	case Vertex:
-		kind = shaderc_vertex_shader;
-		break;
-	case Fragment:
-		kind = shaderc_fragment_shader;
-		break;
-	default:
 		return shaderc_compilation_status_configuration_error;
 	}
-	result = shaderc_compile_into_spv(
-		compiler,
+	threadCompiler.ReleaseResult();
+	threadCompiler.result = shaderc_compile_into_spv(
+		threadCompiler.Get(),
 		shaderText,
 		shaderTextSize,
 		kind,
 		"",
 		"main",
 		nullptr);
+	shaderc_compilation_result_t result = threadCompiler.result;
 	shaderc_compilation_status status = shaderc_result_get_compilation_status(result);
 	if (status != shaderc_compilation_status_success)
 	{
-		//std::cout << "error: " << shaderc_result_get_error_message(result) << std::endl;
 		*errorMessage = shaderc_result_get_error_message(result);
 	}
 	else
 	{
-		//std::cout << "EVERYTHING IS ALRIGHT" << std::endl;
 		*dataPtr = shaderc_result_get_bytes(result);
 		*dataSize = shaderc_result_get_length(result);
 	}
 	return status;
 }
 
-extern "C" __declspec(dllexport) void __cdecl ReleaseInternalData()
+// Compiles all jobs in parallel, each worker thread owns its compiler.
+// Outputs point into the returned batch object and stay valid until ReleaseBatch.
+// Pass an empty or null cacheDirectory to bypass the SPIR-V cache.
+extern "C" __declspec(dllexport) void* __cdecl CompileGLSLBatch(
+	const ShaderCompileJob* jobs,
+	int jobCount,
+	const char* cacheDirectory,
+	ShaderCompileOutput* outputs)
 {
-	if (result != nullptr)
+	auto* batch = new CompileBatch();
+	if (jobCount <= 0)
+	{
+		return batch;
+	}
+	batch->spirv.resize(jobCount);
+	batch->errors.resize(jobCount);
+
+	const std::string cacheDir = cacheDirectory != nullptr ? cacheDirectory : "";
+	const uint32_t workerCount = std::min(
+		static_cast<uint32_t>(jobCount),
+		std::max(1u, std::thread::hardware_concurrency()));
+
+	std::atomic<int> next = 0;
+	auto worker = [&]()
+	{
+		for (int i = next++; i < jobCount; i = next++)
+		{
+			CompileJob(jobs[i], cacheDir, *batch, i, outputs[i]);
+		}
+	};
+
+	std::vector<std::thread> threads;
+	threads.reserve(workerCount - 1);
+	for (uint32_t i = 0; i < workerCount - 1; i++)
+	{
+		threads.emplace_back(worker);
+	}
+	worker();
+	for (auto& thread : threads)
 	{
-		shaderc_result_release(result);
+		thread.join();
 	}
+
+	return batch;
+}
+
+extern "C" __declspec(dllexport) void __cdecl ReleaseBatch(void* batch)
+{
+	delete static_cast<CompileBatch*>(batch);
 }
 
+thread_local std::vector<char> layoutData;
+thread_local std::string layoutError;
 
-extern "C" __declspec(dllexport) void __cdecl ReleaseCompiler()
+// Reflects descriptor bindings and push constants of both stages into a JoyEngine::ShaderLayout blob.
+// The blob stays valid until the next call on the same thread.
+extern "C" __declspec(dllexport) int __cdecl BuildShaderLayout(
+	const char* vertexData,
+	unsigned long long vertexDataSize,
+	const char* fragmentData,
+	unsigned long long fragmentDataSize,
+	const char** layoutPtr,
+	unsigned long long* layoutSize,
+	const char** errorMessage)
 {
-	if (compiler != nullptr)
+	// SPIR-V words must be aligned, the incoming buffers are not guaranteed to be
+	std::vector<uint32_t> vertexWords(vertexDataSize / sizeof(uint32_t));
+	std::vector<uint32_t> fragmentWords(fragmentDataSize / sizeof(uint32_t));
+	memcpy(vertexWords.data(), vertexData, vertexWords.size() * sizeof(uint32_t));
+	memcpy(fragmentWords.data(), fragmentData, fragmentWords.size() * sizeof(uint32_t));
+
+	const bool res = ShaderReflection::BuildLayout(
+		{{vertexWords.data(), vertexWords.size()}, {fragmentWords.data(), fragmentWords.size()}},
+		{VK_SHADER_STAGE_VERTEX_BIT, VK_SHADER_STAGE_FRAGMENT_BIT},
+		layoutData,
+		layoutError);
+	if (!res)
 	{
-		shaderc_compiler_release(compiler);
+		*errorMessage = layoutError.c_str();
+		return 1;
 	}
+	*layoutPtr = layoutData.data();
+	*layoutSize = layoutData.size();
+	return 0;
+}
+
+extern "C" __declspec(dllexport) void __cdecl ReleaseInternalData()
+{
+	threadCompiler.ReleaseResult();
+}
+
+
+extern "C" __declspec(dllexport) void __cdecl ReleaseCompiler()
+{
+	threadCompiler.Release();
 }
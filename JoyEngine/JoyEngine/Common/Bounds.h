@@ -0,0 +1,184 @@
+#ifndef BOUNDS_H
+#define BOUNDS_H
+
+#include <cfloat>
+#include <cmath>
+#include <algorithm>
+
+#include <glm/glm.hpp>
+
+namespace JoyEngine
+{
+	// Axis aligned bounding box. Empty box has min > max, so union with it is the other box
+	struct AABB
+	{
+		glm::vec3 min = glm::vec3(FLT_MAX);
+		glm::vec3 max = glm::vec3(-FLT_MAX);
+
+		AABB() = default;
+
+		AABB(glm::vec3 min, glm::vec3 max) : min(min), max(max)
+		{
+		}
+
+		[[nodiscard]] bool IsEmpty() const noexcept { return min.x > max.x || min.y > max.y || min.z > max.z; }
+
+		[[nodiscard]] glm::vec3 GetCenter() const noexcept { return (min + max) * 0.5f; }
+
+		[[nodiscard]] glm::vec3 GetExtents() const noexcept { return (max - min) * 0.5f; }
+
+		// half of the surface area, SAH only compares areas
+		[[nodiscard]] float GetHalfArea() const noexcept
+		{
+			const glm::vec3 d = max - min;
+			return d.x * d.y + d.y * d.z + d.z * d.x;
+		}
+
+		void Add(glm::vec3 point) noexcept
+		{
+			min = glm::min(min, point);
+			max = glm::max(max, point);
+		}
+
+		void Add(const AABB& other) noexcept
+		{
+			min = glm::min(min, other.min);
+			max = glm::max(max, other.max);
+		}
+
+		[[nodiscard]] bool Contains(const AABB& other) const noexcept
+		{
+			return min.x <= other.min.x && min.y <= other.min.y && min.z <= other.min.z &&
+				max.x >= other.max.x && max.y >= other.max.y && max.z >= other.max.z;
+		}
+
+		[[nodiscard]] bool Intersects(const AABB& other) const noexcept
+		{
+			return min.x <= other.max.x && min.y <= other.max.y && min.z <= other.max.z &&
+				max.x >= other.min.x && max.y >= other.min.y && max.z >= other.min.z;
+		}
+
+		[[nodiscard]] bool IntersectsSphere(glm::vec3 center, float radius) const noexcept
+		{
+			const glm::vec3 d = center - glm::clamp(center, min, max);
+			return glm::dot(d, d) <= radius * radius;
+		}
+
+		[[nodiscard]] bool operator==(const AABB& other) const noexcept
+		{
+			return min == other.min && max == other.max;
+		}
+
+		[[nodiscard]] static AABB Union(const AABB& a, const AABB& b) noexcept
+		{
+			return AABB(glm::min(a.min, b.min), glm::max(a.max, b.max));
+		}
+
+		// bounds of the box transformed by affine matrix
+		[[nodiscard]] AABB Transform(const glm::mat4& m) const noexcept
+		{
+			const glm::vec3 center = glm::vec3(m * glm::vec4(GetCenter(), 1.0f));
+			const glm::vec3 extents = GetExtents();
+			glm::vec3 newExtents;
+			for (int i = 0; i < 3; i++)
+			{
+				newExtents[i] = std::abs(m[0][i]) * extents.x + std::abs(m[1][i]) * extents.y + std::abs(m[2][i]) * extents.z;
+			}
+			return AABB(center - newExtents, center + newExtents);
+		}
+	};
+
+	struct Ray
+	{
+		glm::vec3 origin;
+		glm::vec3 direction;
+
+		Ray(glm::vec3 origin, glm::vec3 direction) : origin(origin), direction(direction)
+		{
+		}
+
+		// slab test, inverseDirection is 1 / direction.
+		// Returns true and entry distance if the box is hit closer than maxDistance
+		[[nodiscard]] bool Intersects(const AABB& box, glm::vec3 inverseDirection, float maxDistance,
+		                              float& distance) const noexcept
+		{
+			const glm::vec3 t0 = (box.min - origin) * inverseDirection;
+			const glm::vec3 t1 = (box.max - origin) * inverseDirection;
+			const glm::vec3 tMin = glm::min(t0, t1);
+			const glm::vec3 tMax = glm::max(t0, t1);
+			const float enter = std::max(std::max(tMin.x, tMin.y), std::max(tMin.z, 0.0f));
+			const float exit = std::min(std::min(tMax.x, tMax.y), std::min(tMax.z, maxDistance));
+			distance = enter;
+			return enter <= exit;
+		}
+	};
+
+	enum class FrustumTest
+	{
+		Outside,
+		Intersects,
+		Inside
+	};
+
+	// Planes point inside, point p is inside a plane if dot(plane.xyz, p) + plane.w >= 0
+	struct Frustum
+	{
+		enum Plane
+		{
+			Left = 0,
+			Right,
+			Bottom,
+			Top,
+			Near,
+			Far,
+			PlaneCount
+		};
+
+		glm::vec4 planes[PlaneCount];
+
+		// planes of clip space -w <= x, y, z <= w extracted from projection * view
+		[[nodiscard]] static Frustum FromMatrix(const glm::mat4& viewProj) noexcept
+		{
+			const glm::vec4 row0 = glm::vec4(viewProj[0][0], viewProj[1][0], viewProj[2][0], viewProj[3][0]);
+			const glm::vec4 row1 = glm::vec4(viewProj[0][1], viewProj[1][1], viewProj[2][1], viewProj[3][1]);
+			const glm::vec4 row2 = glm::vec4(viewProj[0][2], viewProj[1][2], viewProj[2][2], viewProj[3][2]);
+			const glm::vec4 row3 = glm::vec4(viewProj[0][3], viewProj[1][3], viewProj[2][3], viewProj[3][3]);
+
+			Frustum frustum;
+			frustum.planes[Left] = row3 + row0;
+			frustum.planes[Right] = row3 - row0;
+			frustum.planes[Bottom] = row3 + row1;
+			frustum.planes[Top] = row3 - row1;
+			frustum.planes[Near] = row3 + row2;
+			frustum.planes[Far] = row3 - row2;
+			for (auto& plane : frustum.planes)
+			{
+				plane /= glm::length(glm::vec3(plane));
+			}
+			return frustum;
+		}
+
+		[[nodiscard]] FrustumTest Test(const AABB& box) const noexcept
+		{
+			const glm::vec3 center = box.GetCenter();
+			const glm::vec3 extents = box.GetExtents();
+			FrustumTest result = FrustumTest::Inside;
+			for (const auto& plane : planes)
+			{
+				const float distance = glm::dot(glm::vec3(plane), center) + plane.w;
+				const float radius = glm::dot(glm::abs(glm::vec3(plane)), extents);
+				if (distance < -radius)
+				{
+					return FrustumTest::Outside;
+				}
+				if (distance < radius)
+				{
+					result = FrustumTest::Intersects;
+				}
+			}
+			return result;
+		}
+	};
+}
+
+#endif //BOUNDS_H
@@ -0,0 +1,266 @@
+#include "JobSystem.h"
+
+namespace JoyEngine
+{
+	static constexpr uint32_t INVALID_WORKER = 0xFFFFFFFF;
+
+	thread_local uint32_t JobSystem::t_workerIndex = INVALID_WORKER;
+
+	JobDeque::JobDeque(uint32_t capacity) :
+		m_mask(static_cast<int64_t>(capacity) - 1),
+		m_buffer(new std::atomic<Job*>[capacity])
+	{
+		ASSERT((capacity & (capacity - 1)) == 0);
+	}
+
+	bool JobDeque::Push(Job* job)
+	{
+		const int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+		const int64_t top = m_top.load(std::memory_order_acquire);
+		if (bottom - top > m_mask)
+		{
+			return false;
+		}
+		// release on the slot itself publishes job data to the thief which loads it
+		m_buffer[bottom & m_mask].store(job, std::memory_order_release);
+		std::atomic_thread_fence(std::memory_order_release);
+		m_bottom.store(bottom + 1, std::memory_order_relaxed);
+		return true;
+	}
+
+	Job* JobDeque::Pop()
+	{
+		const int64_t bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+		m_bottom.store(bottom, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		int64_t top = m_top.load(std::memory_order_relaxed);
+		if (top > bottom)
+		{
+			m_bottom.store(bottom + 1, std::memory_order_relaxed);
+			return nullptr;
+		}
+		Job* job = m_buffer[bottom & m_mask].load(std::memory_order_relaxed);
+		if (top == bottom)
+		{
+			// the last job, race with thieves
+			if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+			{
+				job = nullptr;
+			}
+			m_bottom.store(bottom + 1, std::memory_order_relaxed);
+		}
+		return job;
+	}
+
+	Job* JobDeque::Steal()
+	{
+		int64_t top = m_top.load(std::memory_order_acquire);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		const int64_t bottom = m_bottom.load(std::memory_order_acquire);
+		if (top >= bottom)
+		{
+			return nullptr;
+		}
+		Job* job = m_buffer[top & m_mask].load(std::memory_order_acquire);
+		if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+		{
+			return nullptr;
+		}
+		return job;
+	}
+
+	JobSystem::JobSystem(uint32_t threadCount, uint32_t attachedThreadCount)
+	{
+		if (threadCount == 0)
+		{
+			threadCount = std::max(1u, std::thread::hardware_concurrency());
+		}
+		for (uint32_t i = 0; i < threadCount + attachedThreadCount; i++)
+		{
+			m_workers.push_back(std::make_unique<Worker>(JOB_CAPACITY));
+		}
+		m_nextAttachedWorker = threadCount;
+		t_workerIndex = 0;
+		for (uint32_t i = 1; i < threadCount; i++)
+		{
+			m_workers[i]->thread = std::thread(&JobSystem::WorkerLoop, this, i);
+		}
+	}
+
+	JobSystem::~JobSystem()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_sleepMutex);
+			m_isStopping = true;
+		}
+		m_sleepCondition.notify_all();
+		for (uint32_t i = 1; i < m_workers.size(); i++)
+		{
+			if (m_workers[i]->thread.joinable())
+			{
+				m_workers[i]->thread.join();
+			}
+		}
+		ASSERT_DESC(m_pendingJobs == 0, "Job system is destroyed with pending jobs");
+		t_workerIndex = INVALID_WORKER;
+	}
+
+	void JobSystem::WorkerLoop(uint32_t index)
+	{
+		t_workerIndex = index;
+		uint32_t spinCount = 0;
+		while (!m_isStopping.load(std::memory_order_relaxed))
+		{
+			if (RunOneJob())
+			{
+				spinCount = 0;
+				continue;
+			}
+			if (++spinCount < SPIN_COUNT)
+			{
+				std::this_thread::yield();
+				continue;
+			}
+			spinCount = 0;
+			std::unique_lock<std::mutex> lock(m_sleepMutex);
+			m_sleepingWorkers.fetch_add(1, std::memory_order_seq_cst);
+			m_sleepCondition.wait(lock, [this]()
+			{
+				return m_pendingJobs.load(std::memory_order_seq_cst) > 0 || m_isStopping.load(std::memory_order_relaxed);
+			});
+			m_sleepingWorkers.fetch_sub(1, std::memory_order_relaxed);
+		}
+	}
+
+	void JobSystem::Wait(const JobCounter& counter)
+	{
+		while (!counter.IsDone())
+		{
+			if (!RunOneJob())
+			{
+				std::this_thread::yield();
+			}
+		}
+	}
+
+	void JobSystem::AttachThread()
+	{
+		ASSERT_DESC(t_workerIndex == INVALID_WORKER, "Thread is a worker already");
+		const uint32_t index = m_nextAttachedWorker.fetch_add(1, std::memory_order_relaxed);
+		ASSERT_DESC(index < m_workers.size(), "No attached worker left");
+		t_workerIndex = index;
+	}
+
+	Job* JobSystem::AllocateJob()
+	{
+		Worker& worker = *m_workers[GetWorkerIndex()];
+		// slots still in flight are skipped, one of them may be a job up the stack of this very thread
+		for (uint32_t i = 0; i < JOB_CAPACITY; i++)
+		{
+			Job* job = &worker.jobs[worker.nextJob & (JOB_CAPACITY - 1)];
+			worker.nextJob++;
+			if (job->m_isFinished.load(std::memory_order_acquire))
+			{
+				return job;
+			}
+		}
+		return nullptr;
+	}
+
+	void JobSystem::Schedule(Job* job, JobCounter* dependency)
+	{
+		if (dependency != nullptr)
+		{
+			std::lock_guard<std::mutex> lock(dependency->m_mutex);
+			// counter reaches zero only under the lock after releasing continuations, so none is lost
+			if (!dependency->IsDone())
+			{
+				dependency->m_continuations.push_back(job);
+				return;
+			}
+		}
+		Push(job);
+	}
+
+	void JobSystem::Push(Job* job)
+	{
+		// counted before push, so thieves never see it negative
+		m_pendingJobs.fetch_add(1, std::memory_order_seq_cst);
+		if (!m_workers[GetWorkerIndex()]->deque.Push(job))
+		{
+			// deque is full of jobs from other rings, there is no better place for this one
+			m_pendingJobs.fetch_sub(1, std::memory_order_relaxed);
+			Execute(job);
+			return;
+		}
+		if (m_sleepingWorkers.load(std::memory_order_seq_cst) > 0)
+		{
+			std::lock_guard<std::mutex> lock(m_sleepMutex);
+			m_sleepCondition.notify_one();
+		}
+	}
+
+	bool JobSystem::RunOneJob()
+	{
+		const uint32_t index = GetWorkerIndex();
+		Job* job = m_workers[index]->deque.Pop();
+		if (job == nullptr)
+		{
+			const auto workerCount = static_cast<uint32_t>(m_workers.size());
+			for (uint32_t i = 1; i < workerCount && job == nullptr; i++)
+			{
+				job = m_workers[(index + i) % workerCount]->deque.Steal();
+			}
+		}
+		if (job == nullptr)
+		{
+			return false;
+		}
+		m_pendingJobs.fetch_sub(1, std::memory_order_relaxed);
+		Execute(job);
+		return true;
+	}
+
+	void JobSystem::Execute(Job* job)
+	{
+		job->m_invoke(job->m_storage);
+		JobCounter* counter = job->m_counter;
+		job->m_isFinished.store(true, std::memory_order_release);
+		if (counter == nullptr)
+		{
+			return;
+		}
+
+		// not the last job, nobody waits for this decrement
+		uint32_t value = counter->m_value.load(std::memory_order_relaxed);
+		while (value > 1)
+		{
+			if (counter->m_value.compare_exchange_weak(value, value - 1, std::memory_order_acq_rel))
+			{
+				return;
+			}
+		}
+
+		std::vector<Job*> continuations;
+		{
+			// the last one is decremented under the lock, so dependent jobs are not lost
+			// and waiter destroys the counter only after the lock is released
+			std::lock_guard<std::mutex> lock(counter->m_mutex);
+			if (counter->m_value.fetch_sub(1, std::memory_order_acq_rel) != 1)
+			{
+				return;
+			}
+			continuations.swap(counter->m_continuations);
+		}
+		for (Job* continuation : continuations)
+		{
+			Push(continuation);
+		}
+	}
+
+	uint32_t JobSystem::GetWorkerIndex() const noexcept
+	{
+		ASSERT_DESC(t_workerIndex < m_workers.size(), "Jobs can be used only from worker threads");
+		return t_workerIndex;
+	}
+}
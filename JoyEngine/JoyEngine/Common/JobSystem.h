@@ -0,0 +1,241 @@
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+#include <vector>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <algorithm>
+#include <type_traits>
+#include <new>
+#include <cstddef>
+#include <cstdint>
+
+#include "Utils/Assert.h"
+
+namespace JoyEngine
+{
+	class Job;
+
+	// Number of unfinished jobs. Jobs may wait for a counter or be scheduled when it reaches zero
+	class JobCounter
+	{
+	public:
+		JobCounter() = default;
+
+		JobCounter(const JobCounter&) = delete;
+
+		JobCounter& operator=(const JobCounter&) = delete;
+
+		~JobCounter()
+		{
+			ASSERT_DESC(IsDone(), "Counter is destroyed while its jobs are running");
+			// the last job may still hold the lock after waiter has seen zero
+			std::lock_guard<std::mutex> lock(m_mutex);
+		}
+
+		[[nodiscard]] bool IsDone() const noexcept { return m_value.load(std::memory_order_acquire) == 0; }
+
+	private:
+		friend class JobSystem;
+
+		std::atomic<uint32_t> m_value = 0;
+		// jobs which depend on this counter, guarded by mutex
+		std::mutex m_mutex;
+		std::vector<Job*> m_continuations;
+	};
+
+	// Callable is stored in place, so scheduling a job never allocates
+	class alignas(64) Job
+	{
+	public:
+		static constexpr size_t STORAGE_SIZE = 64;
+
+		Job() = default;
+
+		Job(const Job&) = delete;
+
+		Job& operator=(const Job&) = delete;
+
+		template <typename F>
+		void Set(F&& function, JobCounter* counter)
+		{
+			using Functor = std::decay_t<F>;
+			static_assert(sizeof(Functor) <= STORAGE_SIZE, "Job captures too much, capture pointers instead");
+			static_assert(alignof(Functor) <= alignof(std::max_align_t));
+			new(m_storage) Functor(std::forward<F>(function));
+			m_invoke = [](void* storage)
+			{
+				Functor* functor = std::launder(static_cast<Functor*>(storage));
+				(*functor)();
+				functor->~Functor();
+			};
+			m_counter = counter;
+			m_isFinished.store(false, std::memory_order_relaxed);
+		}
+
+	private:
+		friend class JobSystem;
+
+		alignas(std::max_align_t) unsigned char m_storage[STORAGE_SIZE];
+		void (*m_invoke)(void*) = nullptr;
+		JobCounter* m_counter = nullptr;
+		// slot can be reused
+		std::atomic<bool> m_isFinished = true;
+	};
+
+	// Chase-Lev work-stealing deque of fixed capacity.
+	// Owner thread pushes and pops at the bottom, other threads steal from the top
+	class JobDeque
+	{
+	public:
+		explicit JobDeque(uint32_t capacity);
+
+		// Returns false if deque is full. Owner thread only
+		bool Push(Job* job);
+
+		// Owner thread only
+		Job* Pop();
+
+		Job* Steal();
+
+	private:
+		const int64_t m_mask;
+		std::unique_ptr<std::atomic<Job*>[]> m_buffer;
+		alignas(64) std::atomic<int64_t> m_top = 0;
+		alignas(64) std::atomic<int64_t> m_bottom = 0;
+	};
+
+	// Work-stealing job system with one worker per core, the thread which creates the system is worker 0.
+	// Every worker has its own deque and ring of jobs, idle workers steal from others.
+	// Jobs can be scheduled only from worker threads, other long living threads can attach as workers.
+	class JobSystem
+	{
+	public:
+		// 0 means one worker per hardware thread, including the creating thread.
+		// Attached workers are extra, they run jobs only while their thread waits for some
+		explicit JobSystem(uint32_t threadCount = 0, uint32_t attachedThreadCount = 0);
+
+		~JobSystem();
+
+		JobSystem(const JobSystem&) = delete;
+
+		JobSystem& operator=(const JobSystem&) = delete;
+
+		// counter is incremented now and decremented when job is finished.
+		// Job with dependency is scheduled when dependency reaches zero
+		template <typename F>
+		void Run(F&& function, JobCounter* counter = nullptr, JobCounter* dependency = nullptr)
+		{
+			Job* job = AllocateJob();
+			if (job == nullptr)
+			{
+				// every slot of the ring is queued or up the stack, running one of them here could
+				// allocate again and recurse without bound, so the new job runs right away instead
+				if (dependency != nullptr)
+				{
+					Wait(*dependency);
+				}
+				function();
+				return;
+			}
+			job->Set(std::forward<F>(function), counter);
+			if (counter != nullptr)
+			{
+				counter->m_value.fetch_add(1, std::memory_order_relaxed);
+			}
+			Schedule(job, dependency);
+		}
+
+		// Runs other jobs until counter reaches zero
+		void Wait(const JobCounter& counter);
+
+		// Makes the calling thread one of the attached workers for the rest of its life
+		void AttachThread();
+
+		// Calls function(begin, end) for ranges covering [0, count) and waits for them.
+		// grain 0 splits the range into a few chunks per worker
+		template <typename F>
+		void ParallelFor(uint32_t count, const F& function, uint32_t grain = 0)
+		{
+			if (count == 0)
+			{
+				return;
+			}
+			if (grain == 0)
+			{
+				grain = GetGrainSize(count);
+			}
+			JobCounter counter;
+			// the first chunk is run by the calling thread
+			for (uint32_t begin = grain; begin < count; begin += grain)
+			{
+				const uint32_t end = std::min(count - begin, grain) + begin;
+				Run([&function, begin, end]() { function(begin, end); }, &counter);
+			}
+			function(0u, std::min(grain, count));
+			Wait(counter);
+		}
+
+		[[nodiscard]] uint32_t GetThreadCount() const noexcept { return static_cast<uint32_t>(m_workers.size()); }
+
+		[[nodiscard]] uint32_t GetGrainSize(uint32_t count) const noexcept
+		{
+			return std::max(1u, count / (GetThreadCount() * CHUNKS_PER_THREAD));
+		}
+
+		// index of the calling worker in [0, GetThreadCount()), for per worker resources
+		[[nodiscard]] uint32_t GetWorkerIndex() const noexcept;
+
+	private:
+		struct Worker
+		{
+			explicit Worker(uint32_t capacity) : deque(capacity), jobs(new Job[capacity])
+			{
+			}
+
+			JobDeque deque;
+			std::unique_ptr<Job[]> jobs;
+			uint32_t nextJob = 0;
+			std::thread thread;
+		};
+
+	private:
+		void WorkerLoop(uint32_t index);
+
+		// Returns nullptr if every job of the calling worker's ring is in flight
+		Job* AllocateJob();
+
+		void Schedule(Job* job, JobCounter* dependency);
+
+		void Push(Job* job);
+
+		// Returns false if there was nothing to run
+		bool RunOneJob();
+
+		void Execute(Job* job);
+
+	private:
+		// per worker, power of two
+		static constexpr uint32_t JOB_CAPACITY = 4096;
+		static constexpr uint32_t CHUNKS_PER_THREAD = 4;
+		// failed steal attempts before going to sleep
+		static constexpr uint32_t SPIN_COUNT = 64;
+
+		static thread_local uint32_t t_workerIndex;
+
+		std::vector<std::unique_ptr<Worker>> m_workers;
+		// attached workers follow the ones with their own threads
+		std::atomic<uint32_t> m_nextAttachedWorker = 0;
+
+		std::atomic<uint32_t> m_pendingJobs = 0;
+		std::atomic<uint32_t> m_sleepingWorkers = 0;
+		std::atomic<bool> m_isStopping = false;
+		std::mutex m_sleepMutex;
+		std::condition_variable m_sleepCondition;
+	};
+}
+
+#endif //JOB_SYSTEM_H
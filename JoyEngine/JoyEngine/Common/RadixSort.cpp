@@ -0,0 +1,100 @@
+#include "RadixSort.h"
+
+#include <algorithm>
+
+#include "JoyContext.h"
+#include "Common/JobSystem.h"
+
+namespace JoyEngine
+{
+	void RadixSort::Sort(std::vector<SortItem>& items)
+	{
+		const auto count = static_cast<uint32_t>(items.size());
+		if (count < 2)
+		{
+			return;
+		}
+
+		uint64_t allOnes = ~0ull;
+		uint64_t anyOnes = 0;
+		for (const SortItem& item : items)
+		{
+			allOnes &= item.key;
+			anyOnes |= item.key;
+		}
+		const uint64_t changingBits = allOnes ^ anyOnes;
+
+		const uint32_t grain = count < MIN_PARALLEL_COUNT
+			                       ? count
+			                       : std::max(MIN_CHUNK_SIZE, JoyContext::Jobs->GetGrainSize(count));
+		const uint32_t chunkCount = (count + grain - 1) / grain;
+		m_scratch.resize(count);
+		m_offsets.resize(chunkCount);
+
+		std::vector<SortItem>* source = &items;
+		std::vector<SortItem>* destination = &m_scratch;
+		for (uint32_t shift = 0; shift < 64; shift += 8)
+		{
+			if (((changingBits >> shift) & (RADIX - 1)) == 0)
+			{
+				continue;
+			}
+
+			const auto histogram = [this, source, shift, grain](uint32_t begin, uint32_t end)
+			{
+				std::array<uint32_t, RADIX>& counts = m_offsets[begin / grain];
+				counts.fill(0);
+				for (uint32_t i = begin; i < end; i++)
+				{
+					counts[((*source)[i].key >> shift) & (RADIX - 1)]++;
+				}
+			};
+
+			// chunk c writes its items of a digit after the items of the same digit from chunks before it
+			const auto scatter = [this, source, destination, shift, grain](uint32_t begin, uint32_t end)
+			{
+				std::array<uint32_t, RADIX>& offsets = m_offsets[begin / grain];
+				for (uint32_t i = begin; i < end; i++)
+				{
+					const SortItem& item = (*source)[i];
+					(*destination)[offsets[(item.key >> shift) & (RADIX - 1)]++] = item;
+				}
+			};
+
+			if (chunkCount == 1)
+			{
+				histogram(0, count);
+			}
+			else
+			{
+				JoyContext::Jobs->ParallelFor(count, histogram, grain);
+			}
+
+			uint32_t offset = 0;
+			for (uint32_t digit = 0; digit < RADIX; digit++)
+			{
+				for (uint32_t chunk = 0; chunk < chunkCount; chunk++)
+				{
+					const uint32_t digitCount = m_offsets[chunk][digit];
+					m_offsets[chunk][digit] = offset;
+					offset += digitCount;
+				}
+			}
+
+			if (chunkCount == 1)
+			{
+				scatter(0, count);
+			}
+			else
+			{
+				JoyContext::Jobs->ParallelFor(count, scatter, grain);
+			}
+			std::swap(source, destination);
+		}
+
+		if (source != &items)
+		{
+			items.swap(m_scratch);
+		}
+	}
+}
@@ -0,0 +1,35 @@
+#ifndef RADIX_SORT_H
+#define RADIX_SORT_H
+
+#include <vector>
+#include <array>
+#include <cstdint>
+
+namespace JoyEngine
+{
+	struct SortItem
+	{
+		uint64_t key;
+		uint32_t value;
+	};
+
+	// Stable LSD radix sort by key, a byte per pass. Bytes which are the same in every key are skipped.
+	// Big arrays are histogrammed and scattered in chunks on workers, has to be called from a worker thread
+	class RadixSort
+	{
+	public:
+		void Sort(std::vector<SortItem>& items);
+
+	private:
+		static constexpr uint32_t RADIX = 256;
+		// smaller arrays are sorted on the calling thread
+		static constexpr uint32_t MIN_PARALLEL_COUNT = 4096;
+		static constexpr uint32_t MIN_CHUNK_SIZE = 1024;
+
+		std::vector<SortItem> m_scratch;
+		// per chunk histogram of the current byte, turned into scatter offsets
+		std::vector<std::array<uint32_t, RADIX>> m_offsets;
+	};
+}
+
+#endif //RADIX_SORT_H
@@ -19,6 +19,10 @@ namespace JoyEngine {
         void DecreaseRefCount() { m_refCount--; }
 
         [[nodiscard]] virtual bool IsLoaded() const noexcept = 0;
+
+        // last reference is released, frames queued before may still use the resource until it's destroyed
+        virtual void OnRetired() {}
+
         [[nodiscard]] GUID GetGuid() const noexcept { return m_guid; }
 
     private:
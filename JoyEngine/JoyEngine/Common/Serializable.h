@@ -1,6 +1,8 @@
 #ifndef SERIALIZABLE_H
 #define SERIALIZABLE_H
 
+#include <cstdint>
+
 namespace JoyEngine {
 	class Serializable {
 	public:
@@ -8,6 +10,12 @@ namespace JoyEngine {
 
 		virtual ~Serializable() = default;
 
+		// overridden by DECLARE_CLASS_NAME, 0 for classes without reflection
+		[[nodiscard]] virtual uint32_t GetClassHash() const noexcept { return 0; }
+
+		// object pointer which reflected fields are accessed from, see FieldInfo::GetPtr
+		[[nodiscard]] virtual void* GetFieldsBase() noexcept { return nullptr; }
+
 		//virtual void Serialize() = 0;
 	};
 }
@@ -6,46 +6,70 @@ namespace JoyEngine
 {
 	SerializableClassFactory* SerializableClassFactory::m_instance = nullptr;
 
-	void SerializableClassFactory::RegisterClass(const std::string& className, SerializedObjectCreatorBase* creator)
+	void SerializableClassFactory::RegisterClass(const char* className, SerializedObjectCreatorBase* creator,
+	                                             const FieldInfo* fields, uint32_t fieldCount)
 	{
-		GetInstance()->m_classCreatorStorage.insert(std::make_pair(className, creator));
+		const uint32_t classHash = strHash(className);
+		ASSERT_DESC(GetInstance()->m_classStorage.find(classHash) == GetInstance()->m_classStorage.end(),
+		            "Class is registered twice or has the same name hash as other class");
+		GetInstance()->m_classStorage.insert({classHash, {creator, fields, fieldCount}});
 	}
 
-	void SerializableClassFactory::RegisterClassFieldOffset(const std::string& className, const std::string& filedName,
-	                                                        FieldInfo fieldInfo)
+	const SerializableClassFactory::ClassInfo& SerializableClassFactory::GetClassInfo(
+		const std::string& className) const
 	{
-		if (GetInstance()->m_fieldOffsetStorage.find(className) == GetInstance()->m_fieldOffsetStorage.end())
-		{
-			GetInstance()->m_fieldOffsetStorage.insert({className, std::map<std::string, FieldInfo>()});
-		}
-		if (GetInstance()->m_fieldOffsetStorage[className].find(filedName) == GetInstance()->m_fieldOffsetStorage[
-			className].end())
-		{
-			GetInstance()->m_fieldOffsetStorage[className].insert({filedName, fieldInfo});
-		}
-		else
+		const auto classInfo = m_classStorage.find(strHash(className.c_str()));
+		ASSERT(classInfo != m_classStorage.end());
+		return classInfo->second;
+	}
+
+	const FieldInfo* SerializableClassFactory::GetFields(uint32_t classHash, uint32_t& fieldCount) const
+	{
+		const auto classInfo = m_classStorage.find(classHash);
+		if (classInfo == m_classStorage.end())
 		{
-			GetInstance()->m_fieldOffsetStorage[className][filedName].fieldOffset = fieldInfo.fieldOffset;
+			fieldCount = 0;
+			return nullptr;
 		}
+		fieldCount = classInfo->second.fieldCount;
+		return classInfo->second.fields;
 	}
 
-	std::unique_ptr<Serializable> SerializableClassFactory::Deserialize(rapidjson::Value& fieldsJson,
+	ComponentPtr<> SerializableClassFactory::Deserialize(rapidjson::Value& fieldsJson,
 	                                                                    const std::string& className)
 	{
-		ASSERT(GetInstance()->m_classCreatorStorage.find(className) != GetInstance()->m_classCreatorStorage.end());
+		const ClassInfo& classInfo = GetInstance()->GetClassInfo(className);
 
-		SerializedObjectCreatorBase* creator = GetInstance()->m_classCreatorStorage.find(className)->second;
-		std::unique_ptr<Serializable> object = creator->Create();
-		ASSERT(GetInstance()->m_fieldOffsetStorage.find(className) != GetInstance()->m_fieldOffsetStorage.end());
-		auto fieldOffsetStorage = GetInstance()->m_fieldOffsetStorage[className];
+		void* fieldsBase = nullptr;
+		ComponentPtr<> object = classInfo.creator->Create(fieldsBase);
 		for (auto member = fieldsJson.MemberBegin(); member != fieldsJson.MemberEnd(); member++)
 		{
-			const std::string fieldName = member->name.GetString();
-			uint32_t typeHash = fieldOffsetStorage[fieldName].typeHash;
-			void* fieldOffset = fieldOffsetStorage[fieldName].fieldOffset;
+			const FieldInfo* field = classInfo.FindField(strHash(member->name.GetString()));
+			ASSERT(field != nullptr);
 			rapidjson::Value& val = member->value;
-			SerializationUtils::DeserializeAndWriteCppToPtr(typeHash, val, fieldOffset);
+			SerializationUtils::DeserializeAndWriteCppToPtr(field->typeHash, val, field->GetPtr(fieldsBase));
+		}
+		return object;
+	}
+
+	ComponentPtr<> SerializableClassFactory::Deserialize(const SerializedFieldData* fields,
+	                                                                    uint32_t fieldCount,
+	                                                                    const std::string& className)
+	{
+		const ClassInfo& classInfo = GetInstance()->GetClassInfo(className);
+
+		void* fieldsBase = nullptr;
+		ComponentPtr<> object = classInfo.creator->Create(fieldsBase);
+		for (uint32_t i = 0; i < fieldCount; i++)
+		{
+			const FieldInfo* field = classInfo.FindField(fields[i].nameHash);
+			ASSERT(field != nullptr);
+			SerializationUtils::DeserializeAndWriteCppToPtr(
+				field->typeHash,
+				fields[i].values,
+				fields[i].valueCount,
+				field->GetPtr(fieldsBase));
 		}
-		return std::move(object);
+		return object;
 	}
 }
@@ -2,7 +2,12 @@
 #define SERIALIZATION_H
 
 #include <string>
-#include <map>
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
 #include <glm/glm.hpp>
 #include <rapidjson/document.h>
 
@@ -10,6 +15,7 @@
 #include "Common/Color.h"
 #include "Serializable.h"
 #include "HashDefs.h"
+#include "Components/ComponentStorage.h"
 
 //    =============== USAGE: ===================
 //    
@@ -33,53 +39,131 @@
 
 #define DECLARE_CLASS(className) \
 static SerializedObjectCreator<className> className##_creator = SerializedObjectCreator<className>(#className);
-#define DECLARE_CLASS_NAME(T) static constexpr const char* className = #T;
 
-// TODO correct check for Serializable class !
-#define REFLECT_FIELD(T, v) FieldRegistrator v##_registrator = FieldRegistrator \
-(className, #v, FieldInfo(HASH(T) != HASH(Serializable)? HASH(T) : HASH(Serializable), &(v))); T v;
+// Every REFLECT_FIELD declares GetFieldInfo overload for next FieldIndex, counting from fieldCounterBase.
+// Template overload catches indices after the last field, so ReflectionTable knows where to stop.
+// Fields are reached through pointers to members, offsetof isn't defined for polymorphic classes
+#define DECLARE_CLASS_NAME(T) static constexpr const char* className = #T; \
+static constexpr uint32_t classHash = strHash(#T); \
+using ReflectedClass = T; \
+uint32_t GetClassHash() const noexcept override { return classHash; } \
+void* GetFieldsBase() noexcept override { return static_cast<ReflectedClass*>(this); } \
+template <uint32_t I> struct FieldIndex {}; \
+static constexpr uint32_t fieldCounterBase = __COUNTER__; \
+template <uint32_t I> static constexpr NoFieldInfo GetFieldInfo(FieldIndex<I>) { return {}; } \
+template <typename> friend struct ReflectionTable;
+
+#define REFLECT_FIELD(T, v) static constexpr FieldInfo GetFieldInfo(FieldIndex<__COUNTER__ - fieldCounterBase - 1>) \
+{ return FieldInfo(#v, strHash(#v), HASH(T), &JoyEngine::GetFieldPtr<ReflectedClass, T, &ReflectedClass::v>, sizeof(T)); } T v;
 
 namespace JoyEngine
 {
 	class SerializableClassFactory;
 
+	// fieldsBase is the reflected class pointer returned by GetFieldsBase
+	template <typename C, typename T, T C::* Member>
+	constexpr void* GetFieldPtr(void* fieldsBase) noexcept
+	{
+		return &(static_cast<C*>(fieldsBase)->*Member);
+	}
+
+	struct FieldInfo
+	{
+		using FieldPtrGetter = void* (*)(void* fieldsBase) noexcept;
+
+		constexpr FieldInfo(const char* name, uint32_t nameHash, uint32_t typeHash, FieldPtrGetter getPtr,
+		                    size_t size) :
+			name(name), nameHash(nameHash), typeHash(typeHash), getPtr(getPtr), size(size)
+		{
+		}
+
+		[[nodiscard]] void* GetPtr(void* fieldsBase) const noexcept { return getPtr(fieldsBase); }
+
+		const char* name;
+		uint32_t nameHash;
+		uint32_t typeHash; // HASH of c++ type
+		FieldPtrGetter getPtr;
+		size_t size;
+	};
+
+	struct NoFieldInfo
+	{
+	};
+
+	// Field table of class declared with DECLARE_CLASS_NAME, collected from GetFieldInfo overloads at compile time
+	template <typename T>
+	struct ReflectionTable
+	{
+		template <uint32_t I>
+		static constexpr bool HasField()
+		{
+			return std::is_same_v<decltype(T::GetFieldInfo(typename T::template FieldIndex<I>())), FieldInfo>;
+		}
+
+		template <uint32_t I = 0>
+		static constexpr uint32_t CountFields()
+		{
+			if constexpr (HasField<I>())
+			{
+				return CountFields<I + 1>();
+			}
+			else
+			{
+				return I;
+			}
+		}
+
+		static constexpr uint32_t fieldCount = CountFields();
+
+		template <size_t... I>
+		static constexpr std::array<FieldInfo, sizeof...(I)> MakeFields(std::index_sequence<I...>)
+		{
+			return {T::GetFieldInfo(typename T::template FieldIndex<I>())...};
+		}
+
+		static constexpr std::array<FieldInfo, fieldCount> fields = MakeFields(
+			std::make_index_sequence<fieldCount>());
+	};
+
 	class SerializedObjectCreatorBase
 	{
 	public:
 		SerializedObjectCreatorBase() = default;
 
-		virtual std::unique_ptr<Serializable> Create() = 0;
+		// fieldsBase is set to the pointer reflected fields are accessed from
+		virtual ComponentPtr<> Create(void*& fieldsBase) = 0;
 	};
 
 	template <typename Type>
 	class SerializedObjectCreator final : public SerializedObjectCreatorBase
 	{
 	public:
-		explicit SerializedObjectCreator(const std::string& className);
+		explicit SerializedObjectCreator(const char* className);
 
-		std::unique_ptr<Serializable> Create() override;
+		ComponentPtr<> Create(void*& fieldsBase) override;
 	};
 
-	struct FieldInfo
+	// field of a cooked object, see SceneBlobField
+	struct SerializedFieldData
 	{
-		FieldInfo() = default;
-
-		FieldInfo(uint32_t typeHash, void* fieldOffset) : typeHash(typeHash), fieldOffset(fieldOffset)
-		{
-		}
-
-		uint32_t typeHash;
-		void* fieldOffset;
+		uint32_t nameHash;
+		const double* values;
+		uint32_t valueCount;
 	};
 
 	class SerializableClassFactory
 	{
 	public:
-		void RegisterClass(const std::string& className, SerializedObjectCreatorBase* creator);
+		void RegisterClass(const char* className, SerializedObjectCreatorBase* creator,
+		                   const FieldInfo* fields, uint32_t fieldCount);
+
+		ComponentPtr<> Deserialize(rapidjson::Value& fieldsJson, const std::string& className);
 
-		void RegisterClassFieldOffset(const std::string& className, const std::string& filedName, FieldInfo fieldInfo);
+		ComponentPtr<> Deserialize(const SerializedFieldData* fields, uint32_t fieldCount,
+		                           const std::string& className);
 
-		std::unique_ptr<Serializable> Deserialize(rapidjson::Value& fieldsJson, const std::string& className);
+		// Returns nullptr if class is not registered
+		[[nodiscard]] const FieldInfo* GetFields(uint32_t classHash, uint32_t& fieldCount) const;
 
 		// don't want to make storages static because of exceptions before main()
 		static SerializableClassFactory* GetInstance()
@@ -92,32 +176,49 @@ namespace JoyEngine
 		}
 
 	private:
-		static SerializableClassFactory* m_instance;
-		std::map<std::string, std::map<std::string, FieldInfo>> m_fieldOffsetStorage;
-		std::map<std::string, SerializedObjectCreatorBase*> m_classCreatorStorage;
-	};
-
-	class FieldRegistrator
-	{
-	public:
-		FieldRegistrator(const std::string& className, const std::string& filedName, FieldInfo fieldInfo)
+		struct ClassInfo
 		{
-			SerializableClassFactory::GetInstance()->RegisterClassFieldOffset(className, filedName, fieldInfo);
-		}
+			SerializedObjectCreatorBase* creator;
+			const FieldInfo* fields;
+			uint32_t fieldCount;
+
+			[[nodiscard]] const FieldInfo* FindField(uint32_t nameHash) const noexcept
+			{
+				for (uint32_t i = 0; i < fieldCount; i++)
+				{
+					if (fields[i].nameHash == nameHash)
+					{
+						return &fields[i];
+					}
+				}
+				return nullptr;
+			}
+		};
+
+		[[nodiscard]] const ClassInfo& GetClassInfo(const std::string& className) const;
+
+	private:
+		static SerializableClassFactory* m_instance;
+		// key is strHash of class name
+		std::unordered_map<uint32_t, ClassInfo> m_classStorage;
 	};
 
 	template <typename Type>
-	SerializedObjectCreator<Type>::SerializedObjectCreator(const std::string& className)
+	SerializedObjectCreator<Type>::SerializedObjectCreator(const char* className)
 	{
-		SerializableClassFactory::GetInstance()->RegisterClass(className, this);
+		SerializableClassFactory::GetInstance()->RegisterClass(
+			className,
+			this,
+			ReflectionTable<Type>::fields.data(),
+			ReflectionTable<Type>::fieldCount);
 	}
 
 	template <typename Type>
-	std::unique_ptr<Serializable> SerializedObjectCreator<Type>::Create()
+	ComponentPtr<> SerializedObjectCreator<Type>::Create(void*& fieldsBase)
 	{
-		std::unique_ptr<Type> asset = std::make_unique<Type>();
-		ASSERT(dynamic_cast<Serializable*>(asset.get()) != nullptr);
-		return std::unique_ptr<Type>(std::move(asset));
+		ComponentPtr<Type> component = ComponentStorage::GetInstance()->Create<Type>();
+		fieldsBase = component.get();
+		return component;
 	}
 }
 
@@ -1,37 +1,12 @@
 #include "SerializationUtils.h"
 
-#include <glm/glm.hpp>
-#include "Color.h"
+#include <cstddef>
+#include <cstring>
 
-#include "HashDefs.h"
+#include "Utils/Assert.h"
 
 namespace JoyEngine
 {
-	const std::map<uint32_t, size_t> SerializationUtils::m_typeSizes = {
-		{strHash("int"), sizeof(int32_t)},
-		{strHash("uint"), sizeof(uint32_t)},
-		{strHash("float"), sizeof(float)},
-		{strHash("vec2"), sizeof(glm::vec2)},
-		{strHash("vec3"), sizeof(glm::vec3)},
-		{strHash("vec4"), sizeof(glm::vec4)},
-		{strHash("mat3"), sizeof(glm::mat3)},
-		{strHash("mat4"), sizeof(glm::mat4)},
-		{strHash("color"), sizeof(Color)},
-
-	};
-
-	const std::map<uint32_t, uint32_t> SerializationUtils::m_typeMapping = {
-		{HASH(int32_t), strHash("int")},
-		{HASH(uint32_t), strHash("uint")},
-		{HASH(float), strHash("float")},
-		{HASH(glm::vec2), strHash("vec2")},
-		{HASH(glm::vec3), strHash("vec3")},
-		{HASH(glm::vec4), strHash("vec4")},
-		{HASH(glm::mat3), strHash("mat3")},
-		{HASH(glm::mat4), strHash("mat4")},
-		{HASH(Color), strHash("color")},
-	};
-
 	size_t SerializationUtils::GetTypeSize(const std::string& type)
 	{
 		return GetTypeSize(strHash(type.c_str()));
@@ -44,14 +19,16 @@ namespace JoyEngine
 
 	size_t SerializationUtils::GetTypeSize(uint32_t typeHash)
 	{
-		ASSERT(m_typeSizes.find(typeHash) != m_typeSizes.end());
-		return m_typeSizes.find(typeHash)->second;
+		const size_t size = SerializableTypes::GetSize(typeHash);
+		ASSERT(size != 0);
+		return size;
 	}
 
-	size_t SerializationUtils::GetType(uint32_t cppTypeHash)
+	uint32_t SerializationUtils::GetType(uint32_t cppTypeHash)
 	{
-		ASSERT(m_typeMapping.find(cppTypeHash) != m_typeMapping.end());
-		return m_typeMapping.find(cppTypeHash)->second;
+		const uint32_t typeHash = SerializableTypes::GetTypeHash(cppTypeHash);
+		ASSERT(typeHash != 0);
+		return typeHash;
 	}
 
 	template <typename T>
@@ -138,72 +115,143 @@ namespace JoyEngine
 	{
 		ASSERT(count > 0);
 
-		switch (typeHash)
+		[[maybe_unused]] const bool isSupported = SerializableTypes::Dispatch(typeHash, [&val, ptr, count](auto type)
 		{
-		case strHash("int"):
+			using TypeInfo = decltype(type);
+			using T = typename TypeInfo::ElementType;
+			if constexpr (TypeInfo::components == 1)
 			{
 				if (count == 1)
 				{
-					Read<int32_t>(val, ptr);
+					Read<T>(val, ptr);
 				}
 				else
 				{
-					ReadArray<int32_t>(val, ptr, count);
+					ReadArray<T>(val, ptr, count);
 				}
-				break;
 			}
-		case strHash("uint"):
+			else
 			{
-				if (count == 1)
+				ReadStruct<T>(val, ptr, count, TypeInfo::components);
+			}
+		});
+		ASSERT_DESC(isSupported, "Unsupported type");
+	}
+
+	template <typename T>
+	void ReadNumbers(const double* values, uint32_t valueCount, void* ptr)
+	{
+		for (uint32_t i = 0; i < valueCount; i++)
+		{
+			T v = static_cast<T>(values[i]);
+			memcpy(static_cast<char*>(ptr) + i * sizeof(T), &v, sizeof(T));
+		}
+	}
+
+	void SerializationUtils::DeserializeAndWriteCppToPtr(uint32_t cppTypeHash, const double* values,
+	                                                     uint32_t valueCount, void* ptr)
+	{
+		DeserializeToPtr(GetType(cppTypeHash), values, valueCount, ptr);
+	}
+
+	void SerializationUtils::DeserializeToPtr(uint32_t typeHash,
+	                                          const double* values, uint32_t valueCount, void* ptr,
+	                                          uint32_t count)
+	{
+		ASSERT(count > 0);
+
+		[[maybe_unused]] const bool isSupported = SerializableTypes::Dispatch(typeHash, [values, valueCount, ptr, count](auto type)
+		{
+			using TypeInfo = decltype(type);
+			ASSERT(valueCount == TypeInfo::components * count);
+			ReadNumbers<typename TypeInfo::ElementType>(values, valueCount, ptr);
+		});
+		ASSERT_DESC(isSupported, "Unsupported type");
+	}
+
+	static constexpr uint32_t STD140_VEC4_SIZE = 16;
+
+	template <typename TypeInfo>
+	constexpr uint32_t GetStd140ColumnStride()
+	{
+		return TypeInfo::columns > 1
+			       ? STD140_VEC4_SIZE
+			       : TypeInfo::rows * sizeof(typename TypeInfo::ElementType);
+	}
+
+	template <typename TypeInfo>
+	constexpr uint32_t GetStd140ElementSize()
+	{
+		return (TypeInfo::columns - 1) * GetStd140ColumnStride<TypeInfo>() +
+			TypeInfo::rows * sizeof(typename TypeInfo::ElementType);
+	}
+
+	template <typename TypeInfo>
+	constexpr uint32_t GetStd140ArrayStride(uint32_t arrayStride)
+	{
+		return arrayStride != 0
+			       ? arrayStride
+			       : (GetStd140ElementSize<TypeInfo>() + STD140_VEC4_SIZE - 1) / STD140_VEC4_SIZE * STD140_VEC4_SIZE;
+	}
+
+	size_t SerializationUtils::GetStd140Size(uint32_t typeHash, uint32_t count, uint32_t arrayStride)
+	{
+		ASSERT(count > 0);
+
+		size_t size = 0;
+		[[maybe_unused]] const bool isSupported = SerializableTypes::Dispatch(typeHash, [&size, count, arrayStride](auto type)
+		{
+			using TypeInfo = decltype(type);
+			size = (count - 1) * GetStd140ArrayStride<TypeInfo>(arrayStride) + GetStd140ElementSize<TypeInfo>();
+		});
+		ASSERT_DESC(isSupported, "Unsupported type");
+		return size;
+	}
+
+	void SerializationUtils::DeserializeToStd140(uint32_t typeHash, const rapidjson::Value& val, void* ptr,
+	                                             uint32_t count, uint32_t arrayStride)
+	{
+		ASSERT(count > 0);
+
+		[[maybe_unused]] const bool isSupported = SerializableTypes::Dispatch(typeHash, [&val, ptr, count, arrayStride](auto type)
+		{
+			using TypeInfo = decltype(type);
+			using T = typename TypeInfo::ElementType;
+			constexpr uint32_t columnStride = GetStd140ColumnStride<TypeInfo>();
+			const uint32_t stride = GetStd140ArrayStride<TypeInfo>(arrayStride);
+			if (count > 1)
+			{
+				ASSERT(val.IsArray() && val.Size() == count);
+			}
+
+			T element[TypeInfo::components];
+			for (uint32_t i = 0; i < count; i++)
+			{
+				const rapidjson::Value& elementVal = count == 1 ? val : val[i];
+				if constexpr (TypeInfo::components == 1)
 				{
-					Read<uint32_t>(val, ptr);
+					Read<T>(elementVal, element);
 				}
 				else
 				{
-					ReadArray<uint32_t>(val, ptr, count);
+					ReadArray<T>(elementVal, element, TypeInfo::components);
 				}
-				break;
-			}
-		case strHash("float"):
-			{
-				if (count == 1)
+
+				char* elementPtr = static_cast<char*>(ptr) + i * stride;
+				if constexpr (TypeInfo::columns == 1)
 				{
-					Read<float>(val, ptr);
+					memcpy(elementPtr, element, sizeof(element));
 				}
 				else
 				{
-					ReadArray<float>(val, ptr, count);
+					for (uint32_t c = 0; c < TypeInfo::columns; c++)
+					{
+						memcpy(elementPtr + c * columnStride, element + c * TypeInfo::rows,
+						       TypeInfo::rows * sizeof(T));
+					}
 				}
-				break;
-			}
-		case strHash("vec2"):
-			{
-				ReadStruct<float>(val, ptr, count, 2);
-				break;
-			}
-		case strHash("vec3"):
-			{
-				ReadStruct<float>(val, ptr, count, 3);
-				break;
 			}
-		case strHash("vec4"):
-		case strHash("color"):
-			{
-				ReadStruct<float>(val, ptr, count, 4);
-				break;
-			}
-		case strHash("mat3"):
-			{
-				ReadStruct<float>(val, ptr, count, 9);
-				break;
-			}
-		case strHash("mat4"):
-			{
-				ReadStruct<float>(val, ptr, count, 16);
-				break;
-			}
-		default:
-			ASSERT(false);
-		}
+		});
+		ASSERT_DESC(isSupported, "Unsupported type");
 	}
 }
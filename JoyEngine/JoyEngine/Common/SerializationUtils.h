@@ -1,12 +1,85 @@
 #ifndef SERIALIZATION_UTILS_H
 #define SERIALIZATION_UTILS_H
 
-#include <map>
-#include <xstring>
+#include <cstdint>
+#include <string>
 #include <rapidjson/document.h>
+#include <glm/glm.hpp>
+
+#include "Color.h"
+#include "HashDefs.h"
 
 namespace JoyEngine
 {
+	template <typename T, typename TElement, uint32_t TColumns, uint32_t TRows>
+	struct SerializableTypeInfo
+	{
+		using Type = T;
+		using ElementType = TElement;
+		// matrix columns, 1 for scalars and vectors
+		static constexpr uint32_t columns = TColumns;
+		// components in a column
+		static constexpr uint32_t rows = TRows;
+		static constexpr uint32_t components = TColumns * TRows;
+	};
+
+	// name is the serializable type used in data files, T is the c++ type used in REFLECT_FIELD
+#define DECLARE_SERIALIZABLE_TYPE(name, T, TElement, columns, rows) \
+	struct SerializableType_##name : SerializableTypeInfo<T, TElement, columns, rows> \
+	{ \
+		static constexpr uint32_t hash = strHash(#name); \
+		static constexpr uint32_t cppHash = HASH(T); \
+	};
+
+	DECLARE_SERIALIZABLE_TYPE(int, int32_t, int32_t, 1, 1)
+	DECLARE_SERIALIZABLE_TYPE(uint, uint32_t, uint32_t, 1, 1)
+	DECLARE_SERIALIZABLE_TYPE(float, float, float, 1, 1)
+	DECLARE_SERIALIZABLE_TYPE(vec2, glm::vec2, float, 1, 2)
+	DECLARE_SERIALIZABLE_TYPE(vec3, glm::vec3, float, 1, 3)
+	DECLARE_SERIALIZABLE_TYPE(vec4, glm::vec4, float, 1, 4)
+	DECLARE_SERIALIZABLE_TYPE(mat3, glm::mat3, float, 3, 3)
+	DECLARE_SERIALIZABLE_TYPE(mat4, glm::mat4, float, 4, 4)
+	DECLARE_SERIALIZABLE_TYPE(color, Color, float, 1, 4)
+
+	// Lookups unroll into comparisons with constant hashes, no tables involved
+	template <typename... Types>
+	struct SerializableTypeList
+	{
+		// 0 if type is not supported
+		static constexpr size_t GetSize(uint32_t hash) noexcept
+		{
+			size_t size = 0;
+			((hash == Types::hash ? (size = sizeof(typename Types::Type), true) : false) || ...);
+			return size;
+		}
+
+		// serializable type hash from c++ type hash, 0 if type is not supported
+		static constexpr uint32_t GetTypeHash(uint32_t cppHash) noexcept
+		{
+			uint32_t hash = 0;
+			((cppHash == Types::cppHash ? (hash = Types::hash, true) : false) || ...);
+			return hash;
+		}
+
+		// calls f(TypeInfo()) for the type with given hash, returns false if type is not supported
+		template <typename F>
+		static bool Dispatch(uint32_t hash, F&& f)
+		{
+			return ((hash == Types::hash ? (f(Types()), true) : false) || ...);
+		}
+	};
+
+	using SerializableTypes = SerializableTypeList<
+		SerializableType_int,
+		SerializableType_uint,
+		SerializableType_float,
+		SerializableType_vec2,
+		SerializableType_vec3,
+		SerializableType_vec4,
+		SerializableType_mat3,
+		SerializableType_mat4,
+		SerializableType_color>;
+
 	class SerializationUtils
 	{
 	public:
@@ -14,14 +87,20 @@ namespace JoyEngine
 		static size_t GetTypeSize(uint32_t typeHash);
 		static size_t GetTypeSize(const std::string& type);
 
-		static size_t GetType(uint32_t cppTypeHash);
+		static uint32_t GetType(uint32_t cppTypeHash);
 		static void DeserializeAndWriteCppToPtr(uint32_t typeHash, const rapidjson::Value& val, void* ptr);
 		static void DeserializeToPtr(uint32_t typeHash, const rapidjson::Value&, void* ptr, uint32_t count=1);
-	private:
-		// size of standard serializable type
-		static const std::map<uint32_t, size_t> m_typeSizes;
-		// map from real c++ type to serializable type e.g glm::vec4 -> color
-		static const std::map<uint32_t, uint32_t> m_typeMapping;
+
+		// cooked data stores numbers flattened, e.g. vec3 -> 3 values
+		static void DeserializeAndWriteCppToPtr(uint32_t cppTypeHash, const double* values, uint32_t valueCount, void* ptr);
+		static void DeserializeToPtr(uint32_t typeHash, const double* values, uint32_t valueCount, void* ptr,
+		                             uint32_t count = 1);
+
+		// Uniform block layout: matrix columns are vec4 aligned, array elements are arrayStride apart.
+		// arrayStride 0 means std140 default, element size rounded up to vec4
+		static size_t GetStd140Size(uint32_t typeHash, uint32_t count, uint32_t arrayStride);
+		static void DeserializeToStd140(uint32_t typeHash, const rapidjson::Value& val, void* ptr, uint32_t count,
+		                                uint32_t arrayStride);
 	};
 }
 #endif // SERIALIZATION_UTILS_H
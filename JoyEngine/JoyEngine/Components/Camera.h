@@ -7,11 +7,14 @@
 namespace JoyEngine {
     class Camera : public Component {
     public:
+        DECLARE_COMPONENT_ACCESS(ComponentDataNone, ComponentDataNone)
+
         virtual void Enable() override;
         virtual void Disable() override;
         virtual void Update() override;
         glm::mat4x4 GetProjMatrix();
         glm::mat4x4 GetViewMatrix();
+        [[nodiscard]] float GetFar() const noexcept { return m_far; }
 
     private:
         float m_aspect;
@@ -3,10 +3,18 @@
 
 #include "SceneManager/Transform.h"
 #include "Common/Serializable.h"
+#include "ComponentAccess.h"
 
 namespace JoyEngine {
+	class ComponentPoolBase;
+
+	// Components live in ComponentStorage pools, create them with ComponentStorage::Create.
+	// Derived types declare what their Update touches with DECLARE_COMPONENT_ACCESS,
+	// undeclared types may touch anything and are updated on the main thread
 	class Component : public Serializable {
 	public:
+		DECLARE_COMPONENT_ACCESS(ComponentDataAll, ComponentDataAll)
+
 		Component() = default;
 
 		virtual ~Component() = default;
@@ -22,10 +30,18 @@ namespace JoyEngine {
 
 		bool IsEnabled() const noexcept { return m_enabled; }
 
+		[[nodiscard]] ComponentPoolBase* GetPool() const noexcept { return m_pool; }
+
 	protected:
 		Transform* m_transform;
 
 		bool m_enabled = false;
+
+	private:
+		friend class ComponentPoolBase;
+
+		ComponentPoolBase* m_pool = nullptr;
+		uint32_t m_poolIndex = 0;
 	};
 }
 
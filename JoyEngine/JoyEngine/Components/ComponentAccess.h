@@ -0,0 +1,77 @@
+#ifndef COMPONENT_ACCESS_H
+#define COMPONENT_ACCESS_H
+
+#include <cstdint>
+
+// Declares data which Update of the component reads and writes, e.g.
+// DECLARE_COMPONENT_ACCESS(ComponentDataInput, ComponentDataOwnTransform)
+// Has to be placed in the public section of the component class
+#define DECLARE_COMPONENT_ACCESS(reads, writes) \
+static constexpr ComponentAccess componentAccess = {static_cast<uint32_t>(reads), static_cast<uint32_t>(writes)};
+
+namespace JoyEngine
+{
+	enum ComponentDataFlags : uint32_t
+	{
+		ComponentDataNone = 0,
+		// fields of the component itself
+		ComponentDataSelf = 1 << 0,
+		// local position, rotation and scale of the component's game object
+		ComponentDataOwnTransform = 1 << 1,
+		// world matrices, they depend on local data of all ancestors
+		ComponentDataWorldTransforms = 1 << 2,
+		ComponentDataInput = 1 << 3,
+		// cameras, lights and renderers registered in RenderManager
+		ComponentDataRender = 1 << 4,
+		// resources, component storage and everything else which is not thread safe
+		ComponentDataEngine = 1 << 5,
+		ComponentDataAll = 0xFFFFFFFF
+	};
+
+	// Read and write sets of component type, define how its pool is scheduled.
+	// Pools are updated in order of creation, pools which don't conflict with the earlier ones are updated together
+	struct ComponentAccess
+	{
+		uint32_t reads;
+		uint32_t writes;
+
+		// Update has no effects and can be skipped
+		[[nodiscard]] constexpr bool IsEmpty() const noexcept
+		{
+			return reads == ComponentDataNone && writes == ComponentDataNone;
+		}
+
+		// Components of the type can be updated on any thread
+		[[nodiscard]] constexpr bool IsThreadSafe() const noexcept
+		{
+			return !((reads | writes) & ComponentDataEngine);
+		}
+
+		// Components of the type can be updated concurrently with each other:
+		// they write only data of their own objects and don't read world matrices which they change
+		[[nodiscard]] constexpr bool IsParallel() const noexcept
+		{
+			return IsThreadSafe() &&
+				(writes & ~(ComponentDataSelf | ComponentDataOwnTransform)) == 0 &&
+				!((writes & ComponentDataOwnTransform) && (reads & ComponentDataWorldTransforms));
+		}
+
+		// Two types conflict if one writes what the other reads or writes.
+		// Objects may have components of both types, so own transform is shared between types
+		[[nodiscard]] constexpr bool ConflictsWith(const ComponentAccess& other) const noexcept
+		{
+			return (GetAffected(writes) & (other.reads | GetAffected(other.writes))) != 0 ||
+				(GetAffected(other.writes) & (reads | GetAffected(writes))) != 0;
+		}
+
+	private:
+		// fields of a component are not shared with other types
+		[[nodiscard]] static constexpr uint32_t GetAffected(uint32_t writes) noexcept
+		{
+			writes &= ~ComponentDataSelf;
+			return writes & ComponentDataOwnTransform ? writes | ComponentDataWorldTransforms : writes;
+		}
+	};
+}
+
+#endif //COMPONENT_ACCESS_H
@@ -0,0 +1,189 @@
+#ifndef COMPONENT_POOL_H
+#define COMPONENT_POOL_H
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <new>
+#include <utility>
+#include <algorithm>
+
+#include "Component.h"
+#include "ComponentAccess.h"
+#include "Utils/Assert.h"
+
+namespace JoyEngine
+{
+	class ComponentPoolBase
+	{
+	public:
+		explicit ComponentPoolBase(ComponentAccess access) : m_access(access)
+		{
+		}
+
+		virtual ~ComponentPoolBase() = default;
+
+		// updates all enabled components of the pool,
+		// components may create and destroy other components of the same type
+		virtual void Update() = 0;
+
+		// updates enabled components in slots [begin, end), chunks of one pool may be updated concurrently.
+		// Components must not create or destroy components of the same type
+		virtual void Update(uint32_t begin, uint32_t end) = 0;
+
+		virtual void Destroy(Component* component) = 0;
+
+		// upper bound of slot indices
+		[[nodiscard]] virtual uint32_t GetSlotCount() = 0;
+
+		[[nodiscard]] const ComponentAccess& GetAccess() const noexcept { return m_access; }
+
+	protected:
+		static void SetPoolData(Component* component, ComponentPoolBase* pool, uint32_t index) noexcept
+		{
+			component->m_pool = pool;
+			component->m_poolIndex = index;
+		}
+
+		static uint32_t GetPoolIndex(const Component* component) noexcept
+		{
+			return component->m_poolIndex;
+		}
+
+	private:
+		const ComponentAccess m_access;
+	};
+
+	// Components of one type in contiguous pages.
+	// Pages are never moved, so component pointers stay valid, freed slots are reused.
+	// Creation and destruction may happen on loading threads, so pool is guarded by shared mutex:
+	// slots are created and destroyed exclusively and updated under shared lock
+	template <typename T>
+	class ComponentPool final : public ComponentPoolBase
+	{
+	public:
+		ComponentPool() : ComponentPoolBase(T::componentAccess)
+		{
+		}
+
+		~ComponentPool() override
+		{
+			for (uint32_t i = 0; i < m_slotCount; i++)
+			{
+				ASSERT_DESC(!GetPage(i).isAlive[i % PAGE_SIZE], "Component is destroyed after its pool");
+			}
+		}
+
+		template <typename... Args>
+		T* Create(Args&&... args)
+		{
+			std::unique_lock<std::shared_mutex> lock(m_mutex);
+			uint32_t index;
+			if (!m_freeSlots.empty())
+			{
+				index = m_freeSlots.back();
+				m_freeSlots.pop_back();
+			}
+			else
+			{
+				if (m_slotCount == m_pages.size() * PAGE_SIZE)
+				{
+					m_pages.push_back(std::make_unique<Page>());
+				}
+				index = m_slotCount++;
+			}
+
+			Page& page = GetPage(index);
+			T* component = new(page.slots[index % PAGE_SIZE].storage) T(std::forward<Args>(args)...);
+			page.isAlive[index % PAGE_SIZE] = true;
+			SetPoolData(component, this, index);
+			return component;
+		}
+
+		void Destroy(Component* component) override
+		{
+			std::unique_lock<std::shared_mutex> lock(m_mutex);
+			const uint32_t index = GetPoolIndex(component);
+			Page& page = GetPage(index);
+			ASSERT(page.isAlive[index % PAGE_SIZE] && GetSlot(index) == component);
+			static_cast<T*>(component)->~T();
+			page.isAlive[index % PAGE_SIZE] = false;
+			m_freeSlots.push_back(index);
+		}
+
+		void Update() override
+		{
+			// m_slotCount is re-read, components created during update are updated in the same frame
+			for (uint32_t i = 0;; i++)
+			{
+				T* component;
+				{
+					// lock is not held during component update, so it can create and destroy components
+					std::shared_lock<std::shared_mutex> lock(m_mutex);
+					if (i >= m_slotCount) break;
+					if (!GetPage(i).isAlive[i % PAGE_SIZE]) continue;
+					component = GetSlot(i);
+				}
+				if (component->IsEnabled())
+				{
+					// qualified call, so there is no virtual dispatch in the loop
+					component->T::Update();
+				}
+			}
+		}
+
+		void Update(uint32_t begin, uint32_t end) override
+		{
+			std::shared_lock<std::shared_mutex> lock(m_mutex);
+			end = std::min(end, m_slotCount);
+			for (uint32_t i = begin; i < end; i++)
+			{
+				if (!GetPage(i).isAlive[i % PAGE_SIZE]) continue;
+				T* component = GetSlot(i);
+				if (component->IsEnabled())
+				{
+					component->T::Update();
+				}
+			}
+		}
+
+		[[nodiscard]] uint32_t GetSlotCount() override
+		{
+			std::shared_lock<std::shared_mutex> lock(m_mutex);
+			return m_slotCount;
+		}
+
+	private:
+		static constexpr uint32_t PAGE_SIZE = 256;
+
+		struct Slot
+		{
+			alignas(T) unsigned char storage[sizeof(T)];
+		};
+
+		struct Page
+		{
+			Slot slots[PAGE_SIZE];
+			bool isAlive[PAGE_SIZE] = {};
+		};
+
+		Page& GetPage(uint32_t index) const noexcept
+		{
+			return *m_pages[index / PAGE_SIZE];
+		}
+
+		T* GetSlot(uint32_t index) const noexcept
+		{
+			return std::launder(reinterpret_cast<T*>(GetPage(index).slots[index % PAGE_SIZE].storage));
+		}
+
+	private:
+		std::shared_mutex m_mutex;
+		std::vector<std::unique_ptr<Page>> m_pages;
+		uint32_t m_slotCount = 0;
+		std::vector<uint32_t> m_freeSlots;
+	};
+}
+
+#endif //COMPONENT_POOL_H
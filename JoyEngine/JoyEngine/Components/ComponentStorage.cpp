@@ -0,0 +1,126 @@
+#include "ComponentStorage.h"
+
+#include <algorithm>
+
+#include "JoyContext.h"
+#include "Common/JobSystem.h"
+
+namespace JoyEngine
+{
+	ComponentStorage* ComponentStorage::m_instance = nullptr;
+	std::atomic<uint32_t> ComponentStorage::m_typeCounter = 0;
+
+	void ComponentDeleter::operator()(Component* component) const
+	{
+		ComponentStorage::GetInstance()->Destroy(component);
+	}
+
+	void ComponentStorage::Destroy(Component* component)
+	{
+		ASSERT(component->GetPool() != nullptr);
+		component->GetPool()->Destroy(component);
+	}
+
+	void ComponentStorage::Update()
+	{
+		std::vector<ComponentPoolBase*> pools;
+		{
+			std::lock_guard<std::mutex> lock(m_poolsMutex);
+			pools = m_updateOrder;
+		}
+		if (m_isDeterministic || JoyContext::Jobs == nullptr)
+		{
+			UpdateSerial(pools);
+			return;
+		}
+		// pools are only added, so the count tells whether waves are outdated
+		if (m_wavesPoolCount != pools.size())
+		{
+			BuildWaves(pools);
+		}
+		for (const auto& wave : m_waves)
+		{
+			UpdateWave(wave);
+		}
+	}
+
+	void ComponentStorage::UpdateSerial(const std::vector<ComponentPoolBase*>& pools)
+	{
+		for (ComponentPoolBase* pool : pools)
+		{
+			if (!pool->GetAccess().IsEmpty())
+			{
+				pool->Update();
+			}
+		}
+	}
+
+	void ComponentStorage::UpdateWave(const std::vector<ComponentPoolBase*>& wave)
+	{
+		JobSystem* jobs = JoyContext::Jobs;
+		JobCounter counter;
+		std::vector<ComponentPoolBase*> mainThreadPools;
+		for (ComponentPoolBase* pool : wave)
+		{
+			const ComponentAccess& access = pool->GetAccess();
+			if (!access.IsThreadSafe())
+			{
+				mainThreadPools.push_back(pool);
+			}
+			else if (access.IsParallel())
+			{
+				const uint32_t count = pool->GetSlotCount();
+				const uint32_t chunkSize = std::max(MIN_CHUNK_SIZE, jobs->GetGrainSize(count));
+				for (uint32_t begin = 0; begin < count; begin += chunkSize)
+				{
+					const uint32_t end = std::min(count - begin, chunkSize) + begin;
+					jobs->Run([pool, begin, end]() { pool->Update(begin, end); }, &counter);
+				}
+			}
+			else
+			{
+				jobs->Run([pool]() { pool->Update(); }, &counter);
+			}
+		}
+		// updated while workers run the jobs of the wave
+		for (ComponentPoolBase* pool : mainThreadPools)
+		{
+			pool->Update();
+		}
+		jobs->Wait(counter);
+	}
+
+	void ComponentStorage::BuildWaves(const std::vector<ComponentPoolBase*>& pools)
+	{
+		m_waves.clear();
+		for (ComponentPoolBase* pool : pools)
+		{
+			const ComponentAccess& access = pool->GetAccess();
+			if (access.IsEmpty())
+			{
+				continue;
+			}
+			// after the last wave which has a conflicting pool, so conflicting pools keep creation order
+			size_t waveIndex = m_waves.size();
+			while (waveIndex > 0)
+			{
+				const auto& wave = m_waves[waveIndex - 1];
+				const bool hasConflict = std::any_of(wave.begin(), wave.end(), [&access](ComponentPoolBase* other)
+				{
+					return access.ConflictsWith(other->GetAccess());
+				});
+				if (hasConflict)
+				{
+					break;
+				}
+				waveIndex--;
+			}
+			if (waveIndex == m_waves.size())
+			{
+				m_waves.emplace_back();
+			}
+			m_waves[waveIndex].push_back(pool);
+		}
+		m_wavesPoolCount = pools.size();
+	}
+}
@@ -0,0 +1,107 @@
+#ifndef COMPONENT_STORAGE_H
+#define COMPONENT_STORAGE_H
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <type_traits>
+
+#include "Component.h"
+#include "ComponentPool.h"
+
+namespace JoyEngine
+{
+	struct ComponentDeleter
+	{
+		void operator()(Component* component) const;
+	};
+
+	// Owns the component until it's added to game object
+	template <typename T = Component>
+	using ComponentPtr = std::unique_ptr<T, ComponentDeleter>;
+
+	// Pools of all component types. Pools are updated in order of creation, split into waves by declared access:
+	// a pool goes to the wave after the last wave with a conflicting pool.
+	// Pools of one wave are updated concurrently on job system, parallel pools are also split into chunks.
+	// Pools which don't touch anything are skipped, undeclared ones are updated on the main thread alone
+	class ComponentStorage
+	{
+	public:
+		template <typename T, typename... Args>
+		ComponentPtr<T> Create(Args&&... args)
+		{
+			static_assert(std::is_base_of_v<Component, T>, "Only components are stored in pools");
+			return ComponentPtr<T>(GetPool<T>()->Create(std::forward<Args>(args)...));
+		}
+
+		void Destroy(Component* component);
+
+		void Update();
+
+		// Deterministic mode updates all pools on the main thread in order of creation,
+		// so replays don't depend on scheduling even if some component declares its access wrong
+		void SetDeterministic(bool isDeterministic) noexcept { m_isDeterministic = isDeterministic; }
+
+		[[nodiscard]] bool IsDeterministic() const noexcept { return m_isDeterministic; }
+
+		// don't want to make storages static because of exceptions before main()
+		static ComponentStorage* GetInstance()
+		{
+			if (m_instance == nullptr)
+			{
+				m_instance = new ComponentStorage();
+			}
+			return m_instance;
+		}
+
+	private:
+		template <typename T>
+		static uint32_t GetTypeIndex()
+		{
+			static const uint32_t index = m_typeCounter++;
+			return index;
+		}
+
+		template <typename T>
+		ComponentPool<T>* GetPool()
+		{
+			const uint32_t typeIndex = GetTypeIndex<T>();
+			std::lock_guard<std::mutex> lock(m_poolsMutex);
+			if (typeIndex >= m_pools.size())
+			{
+				m_pools.resize(typeIndex + 1);
+			}
+			if (m_pools[typeIndex] == nullptr)
+			{
+				m_pools[typeIndex] = std::make_unique<ComponentPool<T>>();
+				m_updateOrder.push_back(m_pools[typeIndex].get());
+			}
+			return static_cast<ComponentPool<T>*>(m_pools[typeIndex].get());
+		}
+
+		void UpdateSerial(const std::vector<ComponentPoolBase*>& pools);
+
+		void UpdateWave(const std::vector<ComponentPoolBase*>& wave);
+
+		void BuildWaves(const std::vector<ComponentPoolBase*>& pools);
+
+	private:
+		// components updated by one job at least, so tiny pools are not split
+		static constexpr uint32_t MIN_CHUNK_SIZE = 64;
+
+		static ComponentStorage* m_instance;
+		static std::atomic<uint32_t> m_typeCounter;
+
+		std::mutex m_poolsMutex;
+		std::vector<std::unique_ptr<ComponentPoolBase>> m_pools;
+		std::vector<ComponentPoolBase*> m_updateOrder;
+
+		// main thread only
+		std::vector<std::vector<ComponentPoolBase*>> m_waves;
+		size_t m_wavesPoolCount = 0;
+		bool m_isDeterministic = false;
+	};
+}
+
+#endif //COMPONENT_STORAGE_H
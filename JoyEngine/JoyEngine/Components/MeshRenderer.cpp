@@ -3,17 +3,20 @@
 #include "JoyContext.h"
 
 #include "ResourceManager/ResourceManager.h"
+#include "RenderManager/RenderManager.h"
 #include "Common/Resource.h"
 
 namespace JoyEngine {
     void MeshRenderer::Enable() {
         ASSERT(m_mesh != nullptr && m_material != nullptr);
         m_material->GetSharedMaterial()->RegisterMeshRenderer(this);
+        JoyContext::Render->RegisterMeshRenderer(this);
         m_enabled = true;
     }
 
     void MeshRenderer::Disable() {
         m_material->GetSharedMaterial()->UnregisterMeshRenderer(this);
+        JoyContext::Render->UnregisterMeshRenderer(this);
         m_enabled = false;
     }
 
@@ -51,4 +54,8 @@ namespace JoyEngine {
     {
         return m_mesh->IsLoaded() && m_material->IsLoaded();
     }
+
+    AABB MeshRenderer::GetWorldBounds() const {
+        return m_mesh->GetBounds().Transform(m_transform->GetModelMatrix());
+    }
 }
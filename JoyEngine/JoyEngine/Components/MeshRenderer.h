@@ -8,12 +8,15 @@
 #include "Utils/Assert.h"
 #include "ResourceManager/Mesh.h"
 #include "ResourceManager/Material.h"
+#include "SceneManager/BoundingVolumeHierarchy.h"
 
 namespace JoyEngine {
     class Material;
 
     class MeshRenderer : public Component {
     public:
+        DECLARE_COMPONENT_ACCESS(ComponentDataNone, ComponentDataNone)
+
         MeshRenderer() = default;
 
         void Enable() final;
@@ -35,9 +38,16 @@ namespace JoyEngine {
 
         [[nodiscard]] bool IsReady() const noexcept;
 
+        // mesh bounds transformed by the current model matrix
+        [[nodiscard]] AABB GetWorldBounds() const;
+
     private:
-        Mesh* m_mesh;
-        Material* m_material;
+        friend class RenderManager;
+
+        Mesh* m_mesh = nullptr;
+        Material* m_material = nullptr;
+        // in RenderManager renderer tree while enabled
+        uint32_t m_proxy = BoundingVolumeHierarchy::INVALID_HANDLE;
     };
 }
 
@@ -52,6 +52,20 @@ namespace JoyEngine
 			return GetStream(filename);
 		}
 
+		// true if the asset has cooked data which is not older than its source
+		bool HasRawData(GUID guid)
+		{
+			ASSERT(m_pathDatabase.find(guid) != m_pathDatabase.end());
+			const std::filesystem::path path = m_dataPath + m_pathDatabase[guid].string();
+			const std::filesystem::path rawPath = m_dataPath + m_pathDatabase[guid].string() + ".data";
+			std::error_code error;
+			if (!std::filesystem::exists(rawPath, error))
+			{
+				return false;
+			}
+			return std::filesystem::last_write_time(rawPath, error) >= std::filesystem::last_write_time(path, error);
+		}
+
 		rapidjson::Document GetSerializedData(const GUID&, DataType);
 
 	private:
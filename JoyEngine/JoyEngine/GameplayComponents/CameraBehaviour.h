@@ -13,6 +13,9 @@ namespace JoyEngine
 		REFLECT_FIELD(float, m_speed);
 
 	public :
+		// world matrix of its own object is read to move in local space
+		DECLARE_COMPONENT_ACCESS(ComponentDataInput | ComponentDataWorldTransforms, ComponentDataOwnTransform)
+
 		CameraBehaviour() = default;
 
 		void Enable() final;
@@ -15,6 +15,8 @@ namespace JoyEngine {
 
 
     public :
+        DECLARE_COMPONENT_ACCESS(ComponentDataNone, ComponentDataOwnTransform)
+
         RoomBehaviour() = default;
 
         void Enable() final;
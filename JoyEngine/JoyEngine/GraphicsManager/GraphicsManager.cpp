@@ -215,6 +215,8 @@ namespace JoyEngine
 		VkPhysicalDeviceFeatures deviceFeatures{};
 		memset(&deviceFeatures, 0, sizeof(VkPhysicalDeviceFeatures));
 		deviceFeatures.samplerAnisotropy = VK_TRUE;
+		// JOY_BINDLESS textures are indexed by material slot
+		deviceFeatures.shaderSampledImageArrayDynamicIndexing = VK_TRUE;
 
 		VkDeviceCreateInfo createInfo{
 			VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
@@ -2,6 +2,7 @@
 #define GRAPHICS_MANAGER_H
 
 #include <vector>
+#include <mutex>
 
 #include "windows.h"
 #include <vulkan/vulkan.h>
@@ -41,6 +42,12 @@ namespace JoyEngine
 
 		[[nodiscard]] VkCommandPool GetCommandPool() const noexcept { return m_commandPool; }
 
+		[[nodiscard]] uint32_t GetGraphicsQueueFamily() const noexcept { return m_queueFamilyIndices->graphicsFamily.value(); }
+
+		// Queues are used by render thread and loaders, lock it around vkQueueSubmit, vkQueuePresentKHR and vkQueueWaitIdle.
+		// Command pool of GetCommandPool is not guarded, it's for the game thread only
+		[[nodiscard]] std::mutex& GetQueueMutex() noexcept { return m_queueMutex; }
+
 	private:
 		void CreateInstance();
 
@@ -82,6 +89,8 @@ namespace JoyEngine
 		VkQueue m_transferQueue;
 
 		VkCommandPool m_commandPool;
+
+		std::mutex m_queueMutex;
 	};
 }
 
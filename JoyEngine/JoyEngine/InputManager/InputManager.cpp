@@ -142,11 +142,14 @@ namespace JoyEngine
 
 	bool InputManager::GetKeyDown(KeyCode code)
 	{
-		return m_keyStates[code] == true;
+		// find doesn't insert, so keys can be read from component update jobs
+		const auto it = m_keyStates.find(code);
+		return it != m_keyStates.end() && it->second;
 	}
 
 	bool InputManager::GetKeyUp(KeyCode code)
 	{
-		return m_keyStates[code] == false;
+		const auto it = m_keyStates.find(code);
+		return it == m_keyStates.end() || !it->second;
 	}
 }
@@ -18,9 +18,11 @@ namespace JoyEngine
 
 	RenderManager* JoyContext::Render = nullptr;
 
+	JobSystem* JoyContext::Jobs = nullptr;
+
 	void JoyContext::Init(InputManager* inputManager, GraphicsManager* graphicsContext, MemoryManager* memoryManager, DataManager* dataManager,
 		DescriptorSetManager* descriptorSetManager, ResourceManager* resourceManager, SceneManager* sceneManager,
-		RenderManager* renderManager)
+		RenderManager* renderManager, JobSystem* jobSystem)
 	{
 		Input = inputManager;
 		Graphics = graphicsContext;
@@ -30,6 +32,6 @@ namespace JoyEngine
 		Resource = resourceManager;
 		Scene = sceneManager;
 		Render = renderManager;
-		
+		Jobs = jobSystem;
 	}
 }
@@ -11,6 +11,7 @@ namespace JoyEngine
 	class ResourceManager;
 	class SceneManager;
 	class RenderManager;
+	class JobSystem;
 
 	class JoyContext
 	{
@@ -23,7 +24,8 @@ namespace JoyEngine
 			DescriptorSetManager* descriptorSetManager,
 			ResourceManager* resourceManager,
 			SceneManager* sceneManager,
-			RenderManager* renderManager
+			RenderManager* renderManager,
+			JobSystem* jobSystem
 		);
 
 		static InputManager* Input;
@@ -34,6 +36,7 @@ namespace JoyEngine
 		static ResourceManager* Resource;
 		static SceneManager* Scene;
 		static RenderManager* Render;
+		static JobSystem* Jobs;
 	};
 }
 
@@ -11,6 +11,7 @@
 #include "GraphicsManager/GraphicsManager.h"
 #include "Common/Time.h"
 #include "InputManager/InputManager.h"
+#include "Common/JobSystem.h"
 
 namespace JoyEngine
 {
@@ -25,7 +26,9 @@ namespace JoyEngine
 		m_descriptorSetManager(new DescriptorSetManager()),
 		m_resourceManager(new ResourceManager()),
 		m_sceneManager(new SceneManager()),
-		m_renderManager(new RenderManager())
+		m_renderManager(new RenderManager()),
+		// render thread records frames with jobs
+		m_jobSystem(new JobSystem(0, 1))
 	{
 		ASSERT(m_inputManager != nullptr);
 		ASSERT(m_graphicsContext != nullptr);
@@ -35,6 +38,7 @@ namespace JoyEngine
 		ASSERT(m_resourceManager != nullptr);
 		ASSERT(m_sceneManager != nullptr);
 		ASSERT(m_renderManager != nullptr);
+		ASSERT(m_jobSystem != nullptr);
 
 		JoyContext::Init(
 			m_inputManager.get(),
@@ -44,7 +48,8 @@ namespace JoyEngine
 			m_descriptorSetManager.get(),
 			m_resourceManager.get(),
 			m_sceneManager.get(),
-			m_renderManager.get()
+			m_renderManager.get(),
+			m_jobSystem.get()
 		);
 
 		OutputDebugStringA("Context created\n");
@@ -76,7 +81,9 @@ namespace JoyEngine
 		Time::Update();
 
 		m_memoryManager->Update();
+		m_resourceManager->Update();
 		m_sceneManager->Update();
+		// queues the frame for render thread, which may still be recording the previous one
 		m_renderManager->Update();
 	}
 
@@ -87,10 +94,11 @@ namespace JoyEngine
 
 	JoyEngine::~JoyEngine()
 	{
-		Stop();
+		Stop(); // join render thread, wait for GPU and renderer tree rebuild
 		// will destroy managers in certain order
 		m_inputManager = nullptr;
 		m_sceneManager = nullptr; // unregister mesh renderers, remove descriptor set, pipelines, pipeline layouts
+		m_jobSystem = nullptr; // join workers, scene has waited for its jobs
 		m_resourceManager = nullptr; //delete all scene render data (buffers, textures)
 		m_renderManager = nullptr; //delete swapchain, synchronisation, framebuffers
 		m_descriptorSetManager = nullptr;
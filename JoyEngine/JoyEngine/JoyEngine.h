@@ -24,6 +24,8 @@ namespace JoyEngine
 
 	class RenderManager;
 
+	class JobSystem;
+
 	class IWindowHandler
 	{
 	public:
@@ -67,6 +69,7 @@ namespace JoyEngine
 		std::unique_ptr<ResourceManager> m_resourceManager;
 		std::unique_ptr<SceneManager> m_sceneManager;
 		std::unique_ptr<RenderManager> m_renderManager;
+		std::unique_ptr<JobSystem> m_jobSystem;
 	};
 }
 
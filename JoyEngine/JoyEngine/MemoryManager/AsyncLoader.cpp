@@ -28,11 +28,13 @@ namespace JoyEngine
 		m_binaryStream.read(static_cast<char*>(ptr->GetMappedPtr()), m_loadSize);
 	}
 
-	BufferLoadCommand::BufferLoadCommand(VkBuffer gpuBuffer, std::ifstream& binaryStream, uint32_t streamOffset,
+	BufferLoadCommand::BufferLoadCommand(VkBuffer gpuBuffer, VkDeviceSize bufferOffset, std::ifstream& binaryStream,
+	                                     uint32_t streamOffset,
 	                                     VkDeviceSize loadSize,
 	                                     const std::function<void()>& onLoadedCallback) :
 		LoadCommand(binaryStream, streamOffset, onLoadedCallback),
-		m_gpuBuffer(gpuBuffer)
+		m_gpuBuffer(gpuBuffer),
+		m_bufferOffset(bufferOffset)
 	{
 		m_loadSize = loadSize;
 	}
@@ -41,7 +43,7 @@ namespace JoyEngine
 	{
 		const VkBufferCopy copyRegion{
 			0,
-			0,
+			m_bufferOffset,
 			m_loadSize
 		};
 		vkCmdCopyBuffer(commandBuffer, m_stagingBuffer->GetBuffer(), m_gpuBuffer, 1, &copyRegion);
@@ -239,6 +241,7 @@ namespace JoyEngine
 			nullptr
 		};
 
+		std::lock_guard<std::mutex> lock(JoyContext::Graphics->GetQueueMutex());
 		if (vkQueueSubmit(
 			JoyContext::Graphics->GetGraphicsQueue(),
 			1,
@@ -250,11 +253,11 @@ namespace JoyEngine
 	}
 
 	void AsyncLoader::LoadDataToBuffer(
-		std::ifstream& stream, uint32_t offset, uint64_t bufferSize, VkBuffer gpuBuffer,
+		std::ifstream& stream, uint32_t offset, uint64_t bufferSize, VkBuffer gpuBuffer, VkDeviceSize bufferOffset,
 		const std::function<void()>& callback)
 	{
 		m_commandsQueue.push_back(
-			std::make_unique<BufferLoadCommand>(gpuBuffer, stream, offset, bufferSize, callback));
+			std::make_unique<BufferLoadCommand>(gpuBuffer, bufferOffset, stream, offset, bufferSize, callback));
 	}
 
 	void AsyncLoader::LoadDataToImage(
@@ -40,6 +40,7 @@ namespace JoyEngine
 	public:
 		BufferLoadCommand(
 			VkBuffer gpuBuffer,
+			VkDeviceSize bufferOffset,
 			std::ifstream& binaryStream,
 			uint32_t streamOffset,
 			VkDeviceSize loadSize,
@@ -47,6 +48,7 @@ namespace JoyEngine
 		void WriteCommandBuffer(VkCommandBuffer& commandBuffer) override;
 	private:
 		VkBuffer m_gpuBuffer;
+		VkDeviceSize m_bufferOffset;
 	};
 
 	class ImageLoadCommand : public LoadCommand
@@ -77,7 +79,7 @@ namespace JoyEngine
 		~AsyncLoader();
 		void Update();
 		void LoadDataToBuffer(std::ifstream& stream, uint32_t offset, uint64_t bufferSize,
-		                      VkBuffer gpuBuffer, const std::function<void()>& callback);
+		                      VkBuffer gpuBuffer, VkDeviceSize bufferOffset, const std::function<void()>& callback);
 		void LoadDataToImage(std::ifstream& stream, uint32_t offset,
 			uint32_t width,
 			uint32_t height,
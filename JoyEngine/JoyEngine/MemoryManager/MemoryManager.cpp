@@ -127,9 +127,21 @@ namespace JoyEngine
 	}
 
 	void MemoryManager::LoadDataToBufferAsync(std::ifstream& stream, uint32_t offset, uint64_t bufferSize,
-	                                          VkBuffer gpuBuffer, const std::function<void()>& callback) const
+	                                          VkBuffer gpuBuffer, VkDeviceSize bufferOffset,
+	                                          const std::function<void()>& callback) const
 	{
-		m_dataLoader->LoadDataToBuffer(stream, offset, bufferSize, gpuBuffer, callback);
+		m_dataLoader->LoadDataToBuffer(stream, offset, bufferSize, gpuBuffer, bufferOffset, callback);
+	}
+
+	void MemoryManager::CopyBufferRegions(VkBuffer srcBuffer, VkBuffer dstBuffer, const std::vector<VkBufferCopy>& regions)
+	{
+		if (regions.empty())
+		{
+			return;
+		}
+		VkCommandBuffer commandBuffer = BeginSingleTimeCommands();
+		vkCmdCopyBuffer(commandBuffer, srcBuffer, dstBuffer, static_cast<uint32_t>(regions.size()), regions.data());
+		EndSingleTimeCommands(commandBuffer);
 	}
 
 	void MemoryManager::LoadDataToImageAsync(std::ifstream& stream, uint32_t offset,
@@ -259,8 +271,11 @@ namespace JoyEngine
 		submitInfo.commandBufferCount = 1;
 		submitInfo.pCommandBuffers = &commandBuffer;
 
-		vkQueueSubmit(JoyContext::Graphics->GetGraphicsQueue(), 1, &submitInfo, VK_NULL_HANDLE);
-		vkQueueWaitIdle(JoyContext::Graphics->GetGraphicsQueue());
+		{
+			std::lock_guard<std::mutex> lock(JoyContext::Graphics->GetQueueMutex());
+			vkQueueSubmit(JoyContext::Graphics->GetGraphicsQueue(), 1, &submitInfo, VK_NULL_HANDLE);
+			vkQueueWaitIdle(JoyContext::Graphics->GetGraphicsQueue());
+		}
 
 		vkFreeCommandBuffers(JoyContext::Graphics->GetDevice(), JoyContext::Graphics->GetCommandPool(), 1,
 		                     &commandBuffer);
@@ -2,6 +2,7 @@
 #define MEMORY_MANAGER_H
 
 #include <fstream>
+#include <vector>
 #include <vulkan/vulkan.h>
 #include <MemoryManager/AsyncLoader.h>
 
@@ -27,7 +28,8 @@ namespace JoyEngine
 		void LoadDataToBufferAsync(
 			std::ifstream& stream,
 			uint32_t offset,
-			uint64_t bufferSize, VkBuffer gpuBuffer, const std::function<void()>& callback) const;
+			uint64_t bufferSize, VkBuffer gpuBuffer, VkDeviceSize bufferOffset,
+			const std::function<void()>& callback) const;
 
 		void LoadDataToImageAsync(
 			std::ifstream& stream, uint32_t offset, uint32_t width, uint32_t height,
@@ -47,6 +49,9 @@ namespace JoyEngine
 			uint32_t height,
 			VkImage gpuImage);
 
+		// waits until the copy is finished, so does everything submitted before it
+		void CopyBufferRegions(VkBuffer srcBuffer, VkBuffer dstBuffer, const std::vector<VkBufferCopy>& regions);
+
 	private:
 		void CopyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
 
@@ -0,0 +1,152 @@
+#include "BindlessRegistry.h"
+
+#include <cstring>
+
+#include "JoyContext.h"
+#include "GraphicsManager/GraphicsManager.h"
+#include "ResourceManager/DescriptorSetManager.h"
+#include "ResourceManager/Texture.h"
+#include "Utils/Assert.h"
+
+namespace JoyEngine
+{
+	BindlessRegistry::BindlessRegistry(uint32_t imageCount) :
+		m_textures(1, nullptr),
+		m_changedTextureSlots(imageCount)
+	{
+		// sets are allocated with undefined descriptors, so their first write is the whole array
+		for (auto& slots : m_changedTextureSlots)
+		{
+			slots.resize(TEXTURE_SLOT_COUNT);
+			for (uint32_t i = 0; i < TEXTURE_SLOT_COUNT; i++)
+			{
+				slots[i] = i;
+			}
+		}
+
+		m_materialBuffer = std::make_unique<Buffer>(
+			MATERIAL_SLOT_COUNT * MATERIAL_DATA_SIZE,
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+	}
+
+	uint32_t BindlessRegistry::RegisterTexture()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (!m_freeTextureSlots.empty())
+		{
+			const uint32_t slot = m_freeTextureSlots.back();
+			m_freeTextureSlots.pop_back();
+			return slot;
+		}
+		ASSERT_DESC(m_textures.size() < TEXTURE_SLOT_COUNT, "Out of bindless texture slots");
+		if (m_textures.size() == TEXTURE_SLOT_COUNT)
+		{
+			return FALLBACK_TEXTURE_SLOT;
+		}
+		m_textures.push_back(nullptr);
+		return static_cast<uint32_t>(m_textures.size() - 1);
+	}
+
+	void BindlessRegistry::SetTexture(uint32_t slot, Texture* texture)
+	{
+		if (slot == FALLBACK_TEXTURE_SLOT)
+		{
+			return;
+		}
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_textures[slot] = texture;
+		for (auto& slots : m_changedTextureSlots)
+		{
+			slots.push_back(slot);
+		}
+	}
+
+	void BindlessRegistry::UnregisterTexture(uint32_t slot)
+	{
+		if (slot == FALLBACK_TEXTURE_SLOT)
+		{
+			return;
+		}
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_textures[slot] = nullptr;
+		for (auto& slots : m_changedTextureSlots)
+		{
+			slots.push_back(slot);
+		}
+		m_freeTextureSlots.push_back(slot);
+	}
+
+	uint32_t BindlessRegistry::RegisterMaterial(const void* data, size_t size)
+	{
+		ASSERT(size <= MATERIAL_DATA_SIZE);
+		uint32_t slot;
+		if (!m_freeMaterialSlots.empty())
+		{
+			slot = m_freeMaterialSlots.back();
+			m_freeMaterialSlots.pop_back();
+		}
+		else
+		{
+			ASSERT_DESC(m_materialSlotCount < MATERIAL_SLOT_COUNT, "Out of bindless material slots");
+			slot = m_materialSlotCount++;
+		}
+
+		// queued frames don't read the slot, it was free when they were built
+		const std::unique_ptr<BufferMappedPtr> ptr = m_materialBuffer->GetMappedPtr(
+			static_cast<VkDeviceSize>(slot) * MATERIAL_DATA_SIZE,
+			MATERIAL_DATA_SIZE);
+		memset(ptr->GetMappedPtr(), 0, MATERIAL_DATA_SIZE);
+		memcpy(ptr->GetMappedPtr(), data, size);
+		return slot;
+	}
+
+	void BindlessRegistry::UnregisterMaterial(uint32_t slot)
+	{
+		m_freeMaterialSlots.push_back(slot);
+	}
+
+	bool BindlessRegistry::WriteDescriptors(uint32_t imageIndex, VkDescriptorSet descriptorSet)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		std::vector<uint32_t>& slots = m_changedTextureSlots[imageIndex];
+		if (slots.empty())
+		{
+			return false;
+		}
+
+		std::vector<VkDescriptorImageInfo> imageInfos(slots.size());
+		std::vector<VkWriteDescriptorSet> descriptorWrites(slots.size());
+		for (uint32_t i = 0; i < slots.size(); i++)
+		{
+			Texture* texture = slots[i] < m_textures.size() && m_textures[slots[i]] != nullptr
+				                   ? m_textures[slots[i]]
+				                   : JoyContext::DescriptorSet->GetTexture();
+			imageInfos[i] = {
+				texture->GetSampler(),
+				texture->GetImageView(),
+				VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+			};
+			descriptorWrites[i] = {
+				VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+				nullptr,
+				descriptorSet,
+				0,
+				slots[i],
+				1,
+				VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+				&imageInfos[i],
+				nullptr,
+				nullptr
+			};
+		}
+		vkUpdateDescriptorSets(
+			JoyContext::Graphics->GetDevice(),
+			static_cast<uint32_t>(descriptorWrites.size()),
+			descriptorWrites.data(),
+			0,
+			nullptr);
+		slots.clear();
+		return true;
+	}
+}
@@ -0,0 +1,76 @@
+#ifndef BINDLESS_REGISTRY_H
+#define BINDLESS_REGISTRY_H
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <cstdint>
+
+#include <vulkan/vulkan.h>
+
+#include "ResourceManager/Buffer.h"
+
+namespace JoyEngine
+{
+	class Texture;
+
+	// Slots of the JOY_BINDLESS set: textures in a sampled image array and parameters of materials
+	// in a storage buffer. Instances carry the material slot, so bindless materials have no descriptor sets
+	// and draws of different ones are not separated by binds.
+	// Every texture slot is written, empty ones and loading textures show the fallback texture.
+	// Slots are taken and released on game thread, render thread writes changed texture slots
+	// into the set of a swapchain image before recording it
+	class BindlessRegistry
+	{
+	public:
+		explicit BindlessRegistry(uint32_t imageCount);
+
+		BindlessRegistry(const BindlessRegistry&) = delete;
+
+		BindlessRegistry& operator=(const BindlessRegistry&) = delete;
+
+		// slot shows the fallback texture until SetTexture
+		[[nodiscard]] uint32_t RegisterTexture();
+
+		// texture has been loaded
+		void SetTexture(uint32_t slot, Texture* texture);
+
+		// frames queued after it don't reference the texture, it has to live until frames before have finished
+		void UnregisterTexture(uint32_t slot);
+
+		// copies parameters of the material, they don't change while the slot is registered
+		[[nodiscard]] uint32_t RegisterMaterial(const void* data, size_t size);
+
+		// frames which could draw the material have finished
+		void UnregisterMaterial(uint32_t slot);
+
+		// render thread, frame previously recorded for the image has finished.
+		// Returns whether the set was written, command buffers which bind it have to be recorded again
+		bool WriteDescriptors(uint32_t imageIndex, VkDescriptorSet descriptorSet);
+
+		[[nodiscard]] VkBuffer GetMaterialBuffer() const noexcept { return m_materialBuffer->GetBuffer(); }
+
+		// must match sizes in JOY_BINDLESS shader define
+		static constexpr uint32_t TEXTURE_SLOT_COUNT = 1024;
+		static constexpr uint32_t MATERIAL_SLOT_COUNT = 4096;
+		static constexpr uint32_t MATERIAL_DATA_SIZE = 256;
+		// "no texture" in material parameters
+		static constexpr uint32_t FALLBACK_TEXTURE_SLOT = 0;
+		static constexpr uint32_t INVALID_SLOT = UINT32_MAX;
+
+	private:
+		std::mutex m_mutex;
+		// nullptr shows the fallback texture
+		std::vector<Texture*> m_textures;
+		std::vector<uint32_t> m_freeTextureSlots;
+		// per swapchain image, texture slots changed since its set was written
+		std::vector<std::vector<uint32_t>> m_changedTextureSlots;
+
+		// game thread only
+		std::unique_ptr<Buffer> m_materialBuffer;
+		uint32_t m_materialSlotCount = 0;
+		std::vector<uint32_t> m_freeMaterialSlots;
+	};
+}
+
+#endif //BINDLESS_REGISTRY_H
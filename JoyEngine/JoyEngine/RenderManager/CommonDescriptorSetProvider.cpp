@@ -1,9 +1,9 @@
 ﻿#include "CommonDescriptorSetProvider.h"
 
+#include <algorithm>
 
 #include "JoyContext.h"
 #include "RenderManager.h"
-#include "Common/Time.h"
 #include "GraphicsManager/GraphicsManager.h"
 #include "ResourceManager/DescriptorSetManager.h"
 #include "Utils/Assert.h"
@@ -13,7 +13,23 @@ namespace JoyEngine
 {
 	CommonDescriptorSetProvider::CommonDescriptorSetProvider()
 	{
-		uint32_t defines[] = {strHash(JoyVariablesStr), strHash(GBufferTexturesStr)};
+		const uint32_t imageCount = JoyContext::Render->GetSwapchain()->GetSwapchainImageCount();
+		m_bindlessRegistry = std::make_unique<BindlessRegistry>(imageCount);
+
+		std::vector<uint32_t> defines = {strHash(JoyVariablesStr), strHash(GBufferTexturesStr)};
+
+		VkPhysicalDeviceProperties properties{};
+		vkGetPhysicalDeviceProperties(JoyContext::Graphics->GetPhysicalDevice(), &properties);
+		const uint32_t maxSampledImageCount = std::min({
+			properties.limits.maxPerStageDescriptorSamplers,
+			properties.limits.maxPerStageDescriptorSampledImages,
+			properties.limits.maxDescriptorSetSamplers,
+			properties.limits.maxDescriptorSetSampledImages
+		});
+		if (maxSampledImageCount >= BindlessRegistry::TEXTURE_SLOT_COUNT)
+		{
+			defines.push_back(strHash(JoyBindlessStr));
+		}
 
 		for (const auto& defineHash : defines)
 		{
@@ -23,7 +39,10 @@ namespace JoyEngine
 			uint32_t bindingsCount = 0;
 			std::vector<VkDescriptorSetLayoutBinding> bindings;
 			std::vector<VkDescriptorType> types;
+			// per binding, 1 if empty
+			std::vector<uint32_t> descriptorCounts;
 			VkShaderStageFlags stageFlagBits = 0;
+			uint32_t poolSetCount = DESCRIPTOR_POOL_SIZE;
 			data->setLayoutHash = 0;
 
 			switch (defineHash)
@@ -80,21 +99,53 @@ namespace JoyEngine
 					);
 					break;
 				}
+			case strHash(JoyBindlessStr):
+				{
+					// textures and material parameters are owned by bindless registry
+					bindingsCount = 2;
+					bindings.resize(bindingsCount);
+					types = {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER};
+					descriptorCounts = {BindlessRegistry::TEXTURE_SLOT_COUNT, 1};
+					stageFlagBits = VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_VERTEX_BIT;
+					data->setIndex = 3;
+					// the only sets of the layout
+					poolSetCount = imageCount;
+
+					data->m_bindings.emplace_back(BindingBase{
+						VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+						{},
+						nullptr,
+						{}
+					});
+					data->m_bindings.emplace_back(BindingBase{
+						VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+						{},
+						nullptr,
+						{}
+					});
+					break;
+				}
 			default:
 				{
 					ASSERT(false);
 				}
 			}
 
+			if (descriptorCounts.empty())
+			{
+				descriptorCounts.resize(bindingsCount, 1);
+			}
+			std::vector<VkDescriptorType> poolTypes;
 			for (uint32_t i = 0; i < bindingsCount; i++)
 			{
 				bindings[i] = {
 					i,
 					types[i],
-					1,
+					descriptorCounts[i],
 					stageFlagBits,
 					nullptr
 				};
+				poolTypes.insert(poolTypes.end(), descriptorCounts[i], types[i]);
 				uint64_t binding_hash = i
 					| bindings[i].descriptorType << 8
 					| bindings[i].descriptorCount << 16
@@ -116,18 +167,12 @@ namespace JoyEngine
 				JoyContext::Graphics->GetAllocationCallbacks(),
 				&data->setLayout);
 			ASSERT(res == VK_SUCCESS);
-			JoyContext::DescriptorSet->RegisterPool(data->setLayoutHash, data->setLayout, types);
+			JoyContext::DescriptorSet->RegisterPool(data->setLayoutHash, data->setLayout, poolTypes, poolSetCount);
 		}
 
 		CreateDescriptorSets();
 	}
 
-
-	void CommonDescriptorSetProvider::SetCamera(Camera* camera)
-	{
-		m_camera = camera;
-	}
-
 	void CommonDescriptorSetProvider::CreateDescriptorSets()
 	{
 		for (const auto& pair : m_data)
@@ -145,6 +190,13 @@ namespace JoyEngine
 
 			for (int i = 0; i < data->m_bindings.size(); i++)
 			{
+				// texture array is written by bindless registry before the image is recorded
+				if (defineHash == strHash(JoyBindlessStr) &&
+					data->m_bindings[i].type == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER)
+				{
+					continue;
+				}
+
 				VkDescriptorImageInfo* imageInfoPtr = nullptr;
 				VkDescriptorBufferInfo* bufferInfoPtr = nullptr;
 				VkBufferView* texelBufferViewPtr = nullptr;
@@ -178,6 +230,16 @@ namespace JoyEngine
 							imageInfoPtr = &imageInfo;
 							break;
 						}
+					case strHash(JoyBindlessStr):
+						{
+							bufferInfo = {
+								m_bindlessRegistry->GetMaterialBuffer(),
+								0,
+								VK_WHOLE_SIZE
+							};
+							bufferInfoPtr = &bufferInfo;
+							break;
+						}
 					default:
 						{
 							ASSERT(false);
@@ -208,7 +270,7 @@ namespace JoyEngine
 		}
 	}
 
-	void CommonDescriptorSetProvider::UpdateDescriptorSetData(uint32_t imageIndex) const
+	bool CommonDescriptorSetProvider::UpdateDescriptorSetData(uint32_t imageIndex, const RenderSnapshot& snapshot) const
 	{
 		std::unique_ptr<BufferMappedPtr> ptr =
 			m_data.find(strHash(JoyVariablesStr))->second->
@@ -216,12 +278,20 @@ namespace JoyEngine
 			GetMappedPtr(0, sizeof(JoyData));
 
 		JoyData data{
-			m_camera->GetTransform()->GetPosition(),
-			m_camera->GetProjMatrix(),
-			Time::GetTime(),
-			Time::GetDeltaTime()
+			snapshot.cameraPosition,
+			snapshot.proj,
+			snapshot.time,
+			snapshot.deltaTime,
+			snapshot.view
 		};
 		memcpy(ptr->GetMappedPtr(), &data, sizeof(data));
+
+		const auto bindless = m_data.find(strHash(JoyBindlessStr));
+		if (bindless != m_data.end())
+		{
+			return m_bindlessRegistry->WriteDescriptors(imageIndex, bindless->second->descriptorSets[imageIndex]);
+		}
+		return false;
 	}
 
 	SharedBindingData* CommonDescriptorSetProvider::GetBindingData(uint32_t defineHash)
@@ -4,7 +4,8 @@
 #include <map>
 
 #include "Common/HashDefs.h"
-#include "Components/Camera.h"
+#include "RenderSnapshot.h"
+#include "BindlessRegistry.h"
 #include "ResourceManager/SharedMaterial.h"
 #include "ResourceManager/Texture.h"
 
@@ -25,16 +26,20 @@ namespace JoyEngine
 	{
 	public:
 		CommonDescriptorSetProvider();
-		void SetCamera(Camera* camera);
 		void CreateDescriptorSets();
-		void UpdateDescriptorSetData(uint32_t imageIndex) const;
+		// render thread. Returns whether descriptor sets of the image were written,
+		// command buffers recorded with them have to be recorded again
+		[[nodiscard]] bool UpdateDescriptorSetData(uint32_t imageIndex, const RenderSnapshot& snapshot) const;
 		[[nodiscard]] SharedBindingData* GetBindingData(uint32_t defineHash);
+		[[nodiscard]] BindlessRegistry* GetBindlessRegistry() const noexcept { return m_bindlessRegistry.get(); }
 		~CommonDescriptorSetProvider();
 	private:
 		static constexpr const char* JoyVariablesStr = "JOY_VARIABLES";
 		static constexpr const char* GBufferTexturesStr = "GBUFFER_TEXTURES";
+		static constexpr const char* JoyBindlessStr = "JOY_BINDLESS";
 
-		Camera* m_camera = nullptr;
+		// slots are handed out even when device can't have the bindless set, nothing reads them then
+		std::unique_ptr<BindlessRegistry> m_bindlessRegistry;
 		std::map<uint32_t, std::unique_ptr<SharedBindingData>> m_data;
 	};
 }
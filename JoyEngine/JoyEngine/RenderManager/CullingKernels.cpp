@@ -0,0 +1,160 @@
+#include "CullingKernels.h"
+
+#include <immintrin.h>
+
+#include "Utils/CpuFeatures.h"
+
+namespace JoyEngine
+{
+	CullingKernels::CullFunc CullingKernels::m_cull =
+		IsAvxSupported() ? CullAvx : IsSse2Supported() ? CullSse : CullScalar;
+
+	const char* CullingKernels::m_cullName =
+		IsAvxSupported() ? "avx" : IsSse2Supported() ? "sse" : "scalar";
+
+	static bool IsVisible(const Frustum& frustum, const BoundsStreams& in, uint32_t i)
+	{
+		for (const auto& plane : frustum.planes)
+		{
+			const float distance = plane.x * in.center[0][i] + plane.y * in.center[1][i] + plane.z * in.center[2][i] +
+				plane.w;
+			const float radius = std::abs(plane.x) * in.extents[0][i] + std::abs(plane.y) * in.extents[1][i] +
+				std::abs(plane.z) * in.extents[2][i];
+			if (distance < -radius)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// appends indices of set bits of visibleMask, offset by first
+	static uint32_t AppendVisible(uint32_t visibleMask, uint32_t first, uint32_t* visible)
+	{
+		uint32_t count = 0;
+		unsigned long bit;
+		while (_BitScanForward(&bit, visibleMask))
+		{
+			visible[count++] = first + bit;
+			visibleMask &= visibleMask - 1;
+		}
+		return count;
+	}
+
+	uint32_t CullingKernels::CullScalar(const Frustum& frustum, const BoundsStreams& in, uint32_t begin, uint32_t end,
+	                                    uint32_t* visible)
+	{
+		uint32_t count = 0;
+		for (uint32_t i = begin; i < end; i++)
+		{
+			if (IsVisible(frustum, in, i))
+			{
+				visible[count++] = i;
+			}
+		}
+		return count;
+	}
+
+	uint32_t CullingKernels::CullSse(const Frustum& frustum, const BoundsStreams& in, uint32_t begin, uint32_t end,
+	                                 uint32_t* visible)
+	{
+		__m128 planes[Frustum::PlaneCount][7];
+		for (uint32_t p = 0; p < Frustum::PlaneCount; p++)
+		{
+			const glm::vec4& plane = frustum.planes[p];
+			planes[p][0] = _mm_set1_ps(plane.x);
+			planes[p][1] = _mm_set1_ps(plane.y);
+			planes[p][2] = _mm_set1_ps(plane.z);
+			planes[p][3] = _mm_set1_ps(plane.w);
+			planes[p][4] = _mm_set1_ps(std::abs(plane.x));
+			planes[p][5] = _mm_set1_ps(std::abs(plane.y));
+			planes[p][6] = _mm_set1_ps(std::abs(plane.z));
+		}
+		const __m128 zero = _mm_setzero_ps();
+
+		uint32_t count = 0;
+		uint32_t i = begin;
+		for (; i + 4 <= end; i += 4)
+		{
+			const __m128 cx = _mm_loadu_ps(in.center[0] + i);
+			const __m128 cy = _mm_loadu_ps(in.center[1] + i);
+			const __m128 cz = _mm_loadu_ps(in.center[2] + i);
+			const __m128 ex = _mm_loadu_ps(in.extents[0] + i);
+			const __m128 ey = _mm_loadu_ps(in.extents[1] + i);
+			const __m128 ez = _mm_loadu_ps(in.extents[2] + i);
+
+			__m128 outside = zero;
+			for (const auto& plane : planes)
+			{
+				const __m128 distance = _mm_add_ps(
+					_mm_add_ps(_mm_add_ps(_mm_mul_ps(plane[0], cx), _mm_mul_ps(plane[1], cy)), _mm_mul_ps(plane[2], cz)),
+					plane[3]);
+				const __m128 radius = _mm_add_ps(
+					_mm_add_ps(_mm_mul_ps(plane[4], ex), _mm_mul_ps(plane[5], ey)), _mm_mul_ps(plane[6], ez));
+				outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, _mm_sub_ps(zero, radius)));
+			}
+			count += AppendVisible(~_mm_movemask_ps(outside) & 0xF, i, visible + count);
+		}
+		for (; i < end; i++)
+		{
+			if (IsVisible(frustum, in, i))
+			{
+				visible[count++] = i;
+			}
+		}
+		return count;
+	}
+
+	uint32_t CullingKernels::CullAvx(const Frustum& frustum, const BoundsStreams& in, uint32_t begin, uint32_t end,
+	                                 uint32_t* visible)
+	{
+		__m256 planes[Frustum::PlaneCount][7];
+		for (uint32_t p = 0; p < Frustum::PlaneCount; p++)
+		{
+			const glm::vec4& plane = frustum.planes[p];
+			planes[p][0] = _mm256_set1_ps(plane.x);
+			planes[p][1] = _mm256_set1_ps(plane.y);
+			planes[p][2] = _mm256_set1_ps(plane.z);
+			planes[p][3] = _mm256_set1_ps(plane.w);
+			planes[p][4] = _mm256_set1_ps(std::abs(plane.x));
+			planes[p][5] = _mm256_set1_ps(std::abs(plane.y));
+			planes[p][6] = _mm256_set1_ps(std::abs(plane.z));
+		}
+		const __m256 zero = _mm256_setzero_ps();
+
+		uint32_t count = 0;
+		uint32_t i = begin;
+		for (; i + 8 <= end; i += 8)
+		{
+			const __m256 cx = _mm256_loadu_ps(in.center[0] + i);
+			const __m256 cy = _mm256_loadu_ps(in.center[1] + i);
+			const __m256 cz = _mm256_loadu_ps(in.center[2] + i);
+			const __m256 ex = _mm256_loadu_ps(in.extents[0] + i);
+			const __m256 ey = _mm256_loadu_ps(in.extents[1] + i);
+			const __m256 ez = _mm256_loadu_ps(in.extents[2] + i);
+
+			__m256 outside = zero;
+			for (const auto& plane : planes)
+			{
+				const __m256 distance = _mm256_add_ps(
+					_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(plane[0], cx), _mm256_mul_ps(plane[1], cy)),
+					              _mm256_mul_ps(plane[2], cz)),
+					plane[3]);
+				const __m256 radius = _mm256_add_ps(
+					_mm256_add_ps(_mm256_mul_ps(plane[4], ex), _mm256_mul_ps(plane[5], ey)), _mm256_mul_ps(plane[6], ez));
+				outside = _mm256_or_ps(outside, _mm256_cmp_ps(distance, _mm256_sub_ps(zero, radius), _CMP_LT_OQ));
+			}
+			count += AppendVisible(~_mm256_movemask_ps(outside) & 0xFF, i, visible + count);
+		}
+		// upper halves of ymm registers are dirty, avoid SSE transition penalty in the tail and after return
+		_mm256_zeroupper();
+		for (; i < end; i++)
+		{
+			if (IsVisible(frustum, in, i))
+			{
+				visible[count++] = i;
+			}
+		}
+		return count;
+	}
+}
@@ -0,0 +1,50 @@
+#ifndef CULLING_KERNELS_H
+#define CULLING_KERNELS_H
+
+#include <cstdint>
+
+#include "Common/Bounds.h"
+
+namespace JoyEngine
+{
+	// Centers and extents of world space boxes in structure-of-arrays layout
+	struct BoundsStreams
+	{
+		const float* center[3];
+		const float* extents[3];
+	};
+
+	// Batch frustum test of boxes, same result as Frustum::Test(box) != FrustumTest::Outside.
+	// The fastest kernel supported by CPU is selected once at startup
+	class CullingKernels
+	{
+	public:
+		// writes indices of boxes in [begin, end) which are not outside the frustum to visible
+		// in ascending order, returns their count
+		using CullFunc = uint32_t(*)(const Frustum& frustum, const BoundsStreams& in, uint32_t begin, uint32_t end,
+		                             uint32_t* visible);
+
+		static uint32_t CullScalar(const Frustum& frustum, const BoundsStreams& in, uint32_t begin, uint32_t end,
+		                           uint32_t* visible);
+
+		static uint32_t CullSse(const Frustum& frustum, const BoundsStreams& in, uint32_t begin, uint32_t end,
+		                        uint32_t* visible);
+
+		static uint32_t CullAvx(const Frustum& frustum, const BoundsStreams& in, uint32_t begin, uint32_t end,
+		                        uint32_t* visible);
+
+		static uint32_t Cull(const Frustum& frustum, const BoundsStreams& in, uint32_t begin, uint32_t end,
+		                     uint32_t* visible)
+		{
+			return m_cull(frustum, in, begin, end, visible);
+		}
+
+		[[nodiscard]] static const char* GetCullName() noexcept { return m_cullName; }
+
+	private:
+		static CullFunc m_cull;
+		static const char* m_cullName;
+	};
+}
+
+#endif //CULLING_KERNELS_H
@@ -0,0 +1,63 @@
+#ifndef DRAW_SORT_KEY_H
+#define DRAW_SORT_KEY_H
+
+#include <cstdint>
+
+#include "Utils/GUID.h"
+
+namespace JoyEngine
+{
+	// 64 bit key of a draw packet, packets sorted by it are recorded with the fewest state changes.
+	// From the highest bits: pass, pipeline, material, mesh, quantized view depth.
+	// Depth is the lowest, so draws with the same state go front to back
+	namespace DrawSortKey
+	{
+		enum Pass : uint32_t
+		{
+			GBufferPass = 0,
+			MaterialPass = 1
+		};
+
+		constexpr uint32_t PASS_MASK = 0x3;
+		constexpr uint32_t PIPELINE_MASK = 0x3fff;
+		constexpr uint32_t MATERIAL_MASK = 0xffff;
+		constexpr uint32_t MESH_MASK = 0xffff;
+		constexpr uint32_t DEPTH_MASK = 0xffff;
+
+		[[nodiscard]] constexpr uint64_t Make(uint32_t pass, uint32_t pipeline, uint32_t material, uint32_t mesh,
+		                                      uint32_t depth) noexcept
+		{
+			return static_cast<uint64_t>(pass & PASS_MASK) << 62 |
+				static_cast<uint64_t>(pipeline & PIPELINE_MASK) << 48 |
+				static_cast<uint64_t>(material & MATERIAL_MASK) << 32 |
+				static_cast<uint64_t>(mesh & MESH_MASK) << 16 |
+				static_cast<uint64_t>(depth & DEPTH_MASK);
+		}
+
+		// Resources with the same guid get the same id. Different ones may collide,
+		// their draws are just not grouped as well
+		[[nodiscard]] inline uint32_t GetId(const GUID& guid) noexcept
+		{
+			uint32_t hash = 2166136261u;
+			const auto mix = [&hash](uint32_t byte)
+			{
+				hash = (hash ^ byte) * 16777619u;
+			};
+			for (uint32_t i = 0; i < 4; i++)
+			{
+				mix(guid.Data1 >> (i * 8) & 0xff);
+			}
+			mix(guid.Data2 & 0xff);
+			mix(guid.Data2 >> 8);
+			mix(guid.Data3 & 0xff);
+			mix(guid.Data3 >> 8);
+			for (const uint8_t byte : guid.Data4)
+			{
+				mix(byte);
+			}
+			return (hash ^ hash >> 16) & MESH_MASK;
+		}
+	}
+}
+
+#endif //DRAW_SORT_KEY_H
@@ -0,0 +1,643 @@
+#include "HiZCulling.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "JoyContext.h"
+
+#include "Utils/Assert.h"
+#include "DataManager/DataManager.h"
+#include "GraphicsManager/GraphicsManager.h"
+#include "MemoryManager/MemoryManager.h"
+#include "ResourceManager/DescriptorSetManager.h"
+
+namespace JoyEngine
+{
+	std::string ParseVkResult(VkResult res);
+
+	namespace
+	{
+		const GUID DOWNSAMPLE_SHADER_GUID = GUID::StringToGuid("c9c01006-6778-42f7-b031-3eaa21970611");
+		const GUID CULL_SHADER_GUID = GUID::StringToGuid("c1aad5c9-62f3-4451-be9d-417281057b72");
+
+		uint32_t FloorPowerOfTwo(uint32_t value)
+		{
+			uint32_t result = 1;
+			while (result * 2 <= value)
+			{
+				result *= 2;
+			}
+			return result;
+		}
+	}
+
+	HiZCulling::HiZCulling(Texture* depthAttachment, VkFormat depthFormat, uint32_t width, uint32_t height,
+	                       uint32_t imageCount) :
+		m_depthAttachment(depthAttachment),
+		m_depthAspect(depthFormat == VK_FORMAT_D32_SFLOAT || depthFormat == VK_FORMAT_D16_UNORM
+			              ? VK_IMAGE_ASPECT_DEPTH_BIT
+			              : VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT),
+		m_depthWidth(width),
+		m_depthHeight(height),
+		m_objectCounts(imageCount, 0),
+		m_viewProjs(imageCount, glm::mat4(1.0f))
+	{
+		CreatePyramid();
+
+		CreatePass(m_downsamplePass, DOWNSAMPLE_SHADER_GUID,
+		           {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE},
+		           sizeof(DownsampleConstants));
+		CreatePass(m_cullPass, CULL_SHADER_GUID,
+		           {
+			           VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+			           VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+			           VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+			           VK_DESCRIPTOR_TYPE_STORAGE_BUFFER
+		           },
+		           sizeof(CullConstants));
+
+		for (uint32_t i = 0; i < imageCount; i++)
+		{
+			m_objects.emplace_back(std::make_unique<Buffer>(
+				MAX_DRAW_COUNT * sizeof(CullObject),
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT));
+		}
+		m_visibility = std::make_unique<Buffer>(
+			MAX_VISIBILITY_COUNT * sizeof(uint32_t),
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		m_commands = std::make_unique<Buffer>(
+			PhaseCount * MAX_DRAW_COUNT * sizeof(VkDrawIndexedIndirectCommand),
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+		CreateDescriptorSets();
+	}
+
+	HiZCulling::~HiZCulling()
+	{
+		JoyContext::DescriptorSet->Free(m_downsampleSets);
+		JoyContext::DescriptorSet->Free(m_cullSets);
+		DestroyPass(m_downsamplePass);
+		DestroyPass(m_cullPass);
+
+		const VkDevice device = JoyContext::Graphics->GetDevice();
+		const VkAllocationCallbacks* allocator = JoyContext::Graphics->GetAllocationCallbacks();
+		vkDestroySampler(device, m_sampler, allocator);
+		for (const VkImageView view : m_pyramidLevelViews)
+		{
+			vkDestroyImageView(device, view, allocator);
+		}
+		vkDestroyImageView(device, m_pyramidView, allocator);
+		vkDestroyImage(device, m_pyramid, allocator);
+		vkFreeMemory(device, m_pyramidMemory, allocator);
+	}
+
+	void HiZCulling::CreatePyramid()
+	{
+		const VkDevice device = JoyContext::Graphics->GetDevice();
+		const VkAllocationCallbacks* allocator = JoyContext::Graphics->GetAllocationCallbacks();
+
+		m_pyramidWidth = FloorPowerOfTwo(m_depthWidth);
+		m_pyramidHeight = FloorPowerOfTwo(m_depthHeight);
+		m_pyramidLevelCount = 1;
+		while ((std::max(m_pyramidWidth, m_pyramidHeight) >> m_pyramidLevelCount) > 0)
+		{
+			m_pyramidLevelCount++;
+		}
+
+		const VkImageCreateInfo imageInfo{
+			VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+			nullptr,
+			0,
+			VK_IMAGE_TYPE_2D,
+			VK_FORMAT_R32_SFLOAT,
+			{m_pyramidWidth, m_pyramidHeight, 1},
+			m_pyramidLevelCount,
+			1,
+			VK_SAMPLE_COUNT_1_BIT,
+			VK_IMAGE_TILING_OPTIMAL,
+			VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+			VK_SHARING_MODE_EXCLUSIVE,
+			0,
+			nullptr,
+			VK_IMAGE_LAYOUT_UNDEFINED
+		};
+		VkResult res = vkCreateImage(device, &imageInfo, allocator, &m_pyramid);
+		ASSERT_DESC(res == VK_SUCCESS, ParseVkResult(res));
+
+		VkMemoryRequirements memRequirements;
+		vkGetImageMemoryRequirements(device, m_pyramid, &memRequirements);
+		JoyContext::Memory->AllocateMemory(memRequirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_pyramidMemory);
+		res = vkBindImageMemory(device, m_pyramid, m_pyramidMemory, 0);
+		ASSERT_DESC(res == VK_SUCCESS, ParseVkResult(res));
+
+		// whole pyramid for culling and a view per level for downsampling
+		for (uint32_t level = 0; level <= m_pyramidLevelCount; level++)
+		{
+			const bool isWhole = level == m_pyramidLevelCount;
+			const VkImageViewCreateInfo viewInfo{
+				VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+				nullptr,
+				0,
+				m_pyramid,
+				VK_IMAGE_VIEW_TYPE_2D,
+				VK_FORMAT_R32_SFLOAT,
+				{
+					VK_COMPONENT_SWIZZLE_IDENTITY,
+					VK_COMPONENT_SWIZZLE_IDENTITY,
+					VK_COMPONENT_SWIZZLE_IDENTITY,
+					VK_COMPONENT_SWIZZLE_IDENTITY
+				},
+				{
+					VK_IMAGE_ASPECT_COLOR_BIT,
+					isWhole ? 0 : level,
+					isWhole ? m_pyramidLevelCount : 1,
+					0,
+					1
+				}
+			};
+			VkImageView view;
+			res = vkCreateImageView(device, &viewInfo, allocator, &view);
+			ASSERT_DESC(res == VK_SUCCESS, ParseVkResult(res));
+			if (isWhole)
+			{
+				m_pyramidView = view;
+			}
+			else
+			{
+				m_pyramidLevelViews.push_back(view);
+			}
+		}
+
+		// shaders only fetch texels
+		const VkSamplerCreateInfo samplerInfo{
+			VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
+			nullptr,
+			0,
+			VK_FILTER_NEAREST,
+			VK_FILTER_NEAREST,
+			VK_SAMPLER_MIPMAP_MODE_NEAREST,
+			VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+			VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+			VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+			0.0f,
+			VK_FALSE,
+			1.0f,
+			VK_FALSE,
+			VK_COMPARE_OP_ALWAYS,
+			0.0f,
+			static_cast<float>(m_pyramidLevelCount),
+			VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE,
+			VK_FALSE
+		};
+		res = vkCreateSampler(device, &samplerInfo, allocator, &m_sampler);
+		ASSERT_DESC(res == VK_SUCCESS, ParseVkResult(res));
+	}
+
+	void HiZCulling::CreatePass(ComputePass& pass, GUID shaderGuid, const std::vector<VkDescriptorType>& types,
+	                            uint32_t pushConstantSize) const
+	{
+		const VkDevice device = JoyContext::Graphics->GetDevice();
+		const VkAllocationCallbacks* allocator = JoyContext::Graphics->GetAllocationCallbacks();
+
+		std::vector<VkDescriptorSetLayoutBinding> bindings(types.size());
+		for (uint32_t i = 0; i < bindings.size(); i++)
+		{
+			bindings[i] = {
+				i,
+				types[i],
+				1,
+				VK_SHADER_STAGE_COMPUTE_BIT,
+				nullptr
+			};
+			// same hash as common descriptor sets, so identical layouts share the pool
+			const uint64_t bindingHash = i
+				| bindings[i].descriptorType << 8
+				| bindings[i].descriptorCount << 16
+				| bindings[i].stageFlags << 24;
+			pass.setLayoutHash ^= bindingHash;
+		}
+
+		const VkDescriptorSetLayoutCreateInfo layoutInfo{
+			VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+			nullptr,
+			0,
+			static_cast<uint32_t>(bindings.size()),
+			bindings.data()
+		};
+		VkResult res = vkCreateDescriptorSetLayout(device, &layoutInfo, allocator, &pass.setLayout);
+		ASSERT_DESC(res == VK_SUCCESS, ParseVkResult(res));
+		JoyContext::DescriptorSet->RegisterPool(pass.setLayoutHash, pass.setLayout, types);
+
+		const VkPushConstantRange pushConstantRange = {
+			VK_SHADER_STAGE_COMPUTE_BIT,
+			0,
+			pushConstantSize
+		};
+		const VkPipelineLayoutCreateInfo pipelineLayoutInfo{
+			VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+			nullptr,
+			0,
+			1,
+			&pass.setLayout,
+			1,
+			&pushConstantRange
+		};
+		res = vkCreatePipelineLayout(device, &pipelineLayoutInfo, allocator, &pass.pipelineLayout);
+		ASSERT_DESC(res == VK_SUCCESS, ParseVkResult(res));
+
+		// plain SPIR-V cooked by the asset builder
+		const std::vector<char> shaderData = JoyContext::Data->GetData(shaderGuid, true);
+		const VkShaderModuleCreateInfo moduleInfo{
+			VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
+			nullptr,
+			0,
+			shaderData.size(),
+			reinterpret_cast<const uint32_t*>(shaderData.data())
+		};
+		VkShaderModule shaderModule;
+		res = vkCreateShaderModule(device, &moduleInfo, allocator, &shaderModule);
+		ASSERT_DESC(res == VK_SUCCESS, ParseVkResult(res));
+
+		const VkComputePipelineCreateInfo pipelineInfo{
+			VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+			nullptr,
+			0,
+			{
+				VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+				nullptr,
+				0,
+				VK_SHADER_STAGE_COMPUTE_BIT,
+				shaderModule,
+				"main",
+				nullptr
+			},
+			pass.pipelineLayout,
+			VK_NULL_HANDLE,
+			-1
+		};
+		res = vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, allocator, &pass.pipeline);
+		ASSERT_DESC(res == VK_SUCCESS, ParseVkResult(res));
+
+		vkDestroyShaderModule(device, shaderModule, allocator);
+	}
+
+	void HiZCulling::DestroyPass(ComputePass& pass) const
+	{
+		const VkDevice device = JoyContext::Graphics->GetDevice();
+		const VkAllocationCallbacks* allocator = JoyContext::Graphics->GetAllocationCallbacks();
+		vkDestroyPipeline(device, pass.pipeline, allocator);
+		vkDestroyPipelineLayout(device, pass.pipelineLayout, allocator);
+		vkDestroyDescriptorSetLayout(device, pass.setLayout, allocator);
+		JoyContext::DescriptorSet->UnregisterPool(pass.setLayoutHash);
+	}
+
+	void HiZCulling::CreateDescriptorSets()
+	{
+		m_downsampleSets = JoyContext::DescriptorSet->Allocate(m_downsamplePass.setLayoutHash, m_pyramidLevelCount);
+		for (uint32_t level = 0; level < m_pyramidLevelCount; level++)
+		{
+			// level 0 reads depth attachment, the rest read the previous level
+			const VkDescriptorImageInfo sourceInfo = level == 0
+				? VkDescriptorImageInfo{
+					m_sampler,
+					m_depthAttachment->GetImageView(),
+					VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL
+				}
+				: VkDescriptorImageInfo{
+					m_sampler,
+					m_pyramidLevelViews[level - 1],
+					VK_IMAGE_LAYOUT_GENERAL
+				};
+			const VkDescriptorImageInfo destinationInfo = {
+				VK_NULL_HANDLE,
+				m_pyramidLevelViews[level],
+				VK_IMAGE_LAYOUT_GENERAL
+			};
+			const VkWriteDescriptorSet writes[] = {
+				{
+					VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+					nullptr,
+					m_downsampleSets[level],
+					0,
+					0,
+					1,
+					VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+					&sourceInfo,
+					nullptr,
+					nullptr
+				},
+				{
+					VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+					nullptr,
+					m_downsampleSets[level],
+					1,
+					0,
+					1,
+					VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+					&destinationInfo,
+					nullptr,
+					nullptr
+				}
+			};
+			vkUpdateDescriptorSets(JoyContext::Graphics->GetDevice(), 2, writes, 0, nullptr);
+		}
+
+		const auto imageCount = static_cast<uint32_t>(m_objects.size());
+		m_cullSets = JoyContext::DescriptorSet->Allocate(m_cullPass.setLayoutHash, imageCount);
+		for (uint32_t i = 0; i < imageCount; i++)
+		{
+			const VkDescriptorImageInfo pyramidInfo = {
+				m_sampler,
+				m_pyramidView,
+				VK_IMAGE_LAYOUT_GENERAL
+			};
+			const VkDescriptorBufferInfo bufferInfos[] = {
+				{m_objects[i]->GetBuffer(), 0, VK_WHOLE_SIZE},
+				{m_visibility->GetBuffer(), 0, VK_WHOLE_SIZE},
+				{m_commands->GetBuffer(), 0, VK_WHOLE_SIZE}
+			};
+			VkWriteDescriptorSet writes[4];
+			writes[0] = {
+				VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+				nullptr,
+				m_cullSets[i],
+				0,
+				0,
+				1,
+				VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+				&pyramidInfo,
+				nullptr,
+				nullptr
+			};
+			for (uint32_t binding = 1; binding < 4; binding++)
+			{
+				writes[binding] = {
+					VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+					nullptr,
+					m_cullSets[i],
+					binding,
+					0,
+					1,
+					VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+					nullptr,
+					&bufferInfos[binding - 1],
+					nullptr
+				};
+			}
+			vkUpdateDescriptorSets(JoyContext::Graphics->GetDevice(), 4, writes, 0, nullptr);
+		}
+	}
+
+	bool HiZCulling::Prepare(uint32_t imageIndex, const RenderSnapshot& snapshot)
+	{
+		const auto count = static_cast<uint32_t>(snapshot.draws.size());
+		if (count > MAX_DRAW_COUNT)
+		{
+			return false;
+		}
+		m_objectCounts[imageIndex] = count;
+		m_viewProjs[imageIndex] = snapshot.proj * snapshot.view;
+		if (count == 0)
+		{
+			return true;
+		}
+
+		const std::unique_ptr<BufferMappedPtr> ptr = m_objects[imageIndex]->GetMappedPtr(0, count * sizeof(CullObject));
+		const auto objects = static_cast<CullObject*>(ptr->GetMappedPtr());
+		for (uint32_t i = 0; i < count; i++)
+		{
+			const RenderDraw& draw = snapshot.draws[i];
+			objects[i] = {
+				draw.bounds.GetCenter(),
+				draw.indexCount,
+				draw.bounds.GetExtents(),
+				draw.visibilityIndex,
+				draw.firstInstance,
+				draw.instanceCount,
+				draw.firstIndex,
+				draw.vertexOffset
+			};
+		}
+		return true;
+	}
+
+	void HiZCulling::RecordFirstPhase(VkCommandBuffer commandBuffer, uint32_t imageIndex)
+	{
+		if (!m_isInitialized)
+		{
+			// nothing was visible, the first frame is drawn by the second phase
+			vkCmdFillBuffer(commandBuffer, m_visibility->GetBuffer(), 0, VK_WHOLE_SIZE, 0);
+			const VkImageMemoryBarrier pyramidBarrier = {
+				VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+				nullptr,
+				0,
+				VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+				VK_IMAGE_LAYOUT_UNDEFINED,
+				VK_IMAGE_LAYOUT_GENERAL,
+				VK_QUEUE_FAMILY_IGNORED,
+				VK_QUEUE_FAMILY_IGNORED,
+				m_pyramid,
+				{VK_IMAGE_ASPECT_COLOR_BIT, 0, m_pyramidLevelCount, 0, 1}
+			};
+			const VkMemoryBarrier fillBarrier = {
+				VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+				nullptr,
+				VK_ACCESS_TRANSFER_WRITE_BIT,
+				VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT
+			};
+			vkCmdPipelineBarrier(commandBuffer,
+			                     VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+			                     VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			                     0,
+			                     1, &fillBarrier,
+			                     0, nullptr,
+			                     1, &pyramidBarrier);
+			m_isInitialized = true;
+		}
+
+		// previous frame has finished reading the commands and writing visibility
+		const VkMemoryBarrier barrier = {
+			VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+			nullptr,
+			VK_ACCESS_SHADER_WRITE_BIT,
+			VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT
+		};
+		vkCmdPipelineBarrier(commandBuffer,
+		                     VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		                     VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		                     0,
+		                     1, &barrier,
+		                     0, nullptr,
+		                     0, nullptr);
+
+		DispatchCull(commandBuffer, imageIndex, First);
+
+		const VkMemoryBarrier commandsBarrier = {
+			VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+			nullptr,
+			VK_ACCESS_SHADER_WRITE_BIT,
+			VK_ACCESS_INDIRECT_COMMAND_READ_BIT
+		};
+		vkCmdPipelineBarrier(commandBuffer,
+		                     VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		                     VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+		                     0,
+		                     1, &commandsBarrier,
+		                     0, nullptr,
+		                     0, nullptr);
+	}
+
+	void HiZCulling::RecordSecondPhase(VkCommandBuffer commandBuffer, uint32_t imageIndex)
+	{
+		const VkImageSubresourceRange depthRange = {m_depthAspect, 0, 1, 0, 1};
+		const VkImageMemoryBarrier depthReadBarrier = {
+			VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+			nullptr,
+			VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+			VK_ACCESS_SHADER_READ_BIT,
+			VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+			VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL,
+			VK_QUEUE_FAMILY_IGNORED,
+			VK_QUEUE_FAMILY_IGNORED,
+			m_depthAttachment->GetImage(),
+			depthRange
+		};
+		vkCmdPipelineBarrier(commandBuffer,
+		                     VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+		                     VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		                     0,
+		                     0, nullptr,
+		                     0, nullptr,
+		                     1, &depthReadBarrier);
+
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_downsamplePass.pipeline);
+		uint32_t sourceWidth = m_depthWidth;
+		uint32_t sourceHeight = m_depthHeight;
+		for (uint32_t level = 0; level < m_pyramidLevelCount; level++)
+		{
+			const uint32_t width = std::max(m_pyramidWidth >> level, 1u);
+			const uint32_t height = std::max(m_pyramidHeight >> level, 1u);
+			if (level > 0)
+			{
+				// previous level is written
+				const VkMemoryBarrier levelBarrier = {
+					VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+					nullptr,
+					VK_ACCESS_SHADER_WRITE_BIT,
+					VK_ACCESS_SHADER_READ_BIT
+				};
+				vkCmdPipelineBarrier(commandBuffer,
+				                     VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+				                     VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+				                     0,
+				                     1, &levelBarrier,
+				                     0, nullptr,
+				                     0, nullptr);
+			}
+
+			const DownsampleConstants constants = {
+				glm::ivec2(sourceWidth, sourceHeight),
+				glm::ivec2(width, height)
+			};
+			vkCmdBindDescriptorSets(commandBuffer,
+			                        VK_PIPELINE_BIND_POINT_COMPUTE,
+			                        m_downsamplePass.pipelineLayout,
+			                        0,
+			                        1,
+			                        &m_downsampleSets[level],
+			                        0, nullptr);
+			vkCmdPushConstants(commandBuffer,
+			                   m_downsamplePass.pipelineLayout,
+			                   VK_SHADER_STAGE_COMPUTE_BIT,
+			                   0,
+			                   sizeof(DownsampleConstants),
+			                   &constants);
+			vkCmdDispatch(commandBuffer,
+			              (width + DOWNSAMPLE_GROUP_SIZE - 1) / DOWNSAMPLE_GROUP_SIZE,
+			              (height + DOWNSAMPLE_GROUP_SIZE - 1) / DOWNSAMPLE_GROUP_SIZE,
+			              1);
+			sourceWidth = width;
+			sourceHeight = height;
+		}
+
+		const VkMemoryBarrier pyramidBarrier = {
+			VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+			nullptr,
+			VK_ACCESS_SHADER_WRITE_BIT,
+			VK_ACCESS_SHADER_READ_BIT
+		};
+		vkCmdPipelineBarrier(commandBuffer,
+		                     VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		                     VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		                     0,
+		                     1, &pyramidBarrier,
+		                     0, nullptr,
+		                     0, nullptr);
+
+		DispatchCull(commandBuffer, imageIndex, Second);
+
+		// the second phase render pass loads depth, first phase commands may still be read by indirect draws
+		const VkMemoryBarrier commandsBarrier = {
+			VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+			nullptr,
+			VK_ACCESS_SHADER_WRITE_BIT,
+			VK_ACCESS_INDIRECT_COMMAND_READ_BIT
+		};
+		const VkImageMemoryBarrier depthWriteBarrier = {
+			VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+			nullptr,
+			0,
+			VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+			VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL,
+			VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+			VK_QUEUE_FAMILY_IGNORED,
+			VK_QUEUE_FAMILY_IGNORED,
+			m_depthAttachment->GetImage(),
+			depthRange
+		};
+		vkCmdPipelineBarrier(commandBuffer,
+		                     VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		                     VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT |
+		                     VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT |
+		                     VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+		                     0,
+		                     1, &commandsBarrier,
+		                     0, nullptr,
+		                     1, &depthWriteBarrier);
+	}
+
+	void HiZCulling::DispatchCull(VkCommandBuffer commandBuffer, uint32_t imageIndex, Phase phase) const
+	{
+		const uint32_t count = m_objectCounts[imageIndex];
+		if (count == 0)
+		{
+			return;
+		}
+		const CullConstants constants = {
+			m_viewProjs[imageIndex],
+			glm::vec2(m_pyramidWidth, m_pyramidHeight),
+			count,
+			MAX_DRAW_COUNT,
+			MAX_VISIBILITY_COUNT,
+			static_cast<uint32_t>(phase)
+		};
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_cullPass.pipeline);
+		vkCmdBindDescriptorSets(commandBuffer,
+		                        VK_PIPELINE_BIND_POINT_COMPUTE,
+		                        m_cullPass.pipelineLayout,
+		                        0,
+		                        1,
+		                        &m_cullSets[imageIndex],
+		                        0, nullptr);
+		vkCmdPushConstants(commandBuffer,
+		                   m_cullPass.pipelineLayout,
+		                   VK_SHADER_STAGE_COMPUTE_BIT,
+		                   0,
+		                   sizeof(CullConstants),
+		                   &constants);
+		vkCmdDispatch(commandBuffer, (count + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE, 1, 1);
+	}
+}
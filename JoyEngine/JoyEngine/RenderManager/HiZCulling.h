@@ -0,0 +1,160 @@
+#ifndef HIZ_CULLING_H
+#define HIZ_CULLING_H
+
+#include <vector>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+
+#include <vulkan/vulkan.h>
+#include <glm/glm.hpp>
+
+#include "RenderSnapshot.h"
+#include "ResourceManager/Buffer.h"
+#include "ResourceManager/Texture.h"
+#include "Utils/GUID.h"
+
+namespace JoyEngine
+{
+	// GPU occlusion culling of snapshot draws against a max depth pyramid, in two phases.
+	// First phase draws what was visible in the previous frame, its depth is reduced into the pyramid,
+	// second phase tests every draw against it and draws what became visible, so disocclusions show up in the same frame.
+	// Compute writes an indirect command per draw and phase, culled draws have zero instances.
+	// Instances of a draw are culled together by their common bounds.
+	// Draws own their vertex and index buffers, so commands are not compacted and every draw is its own indirect call.
+	// Render thread only
+	class HiZCulling
+	{
+	public:
+		enum Phase
+		{
+			First = 0,
+			Second,
+			// draws visible in either phase, for the material subpass
+			Final,
+			PhaseCount
+		};
+
+		HiZCulling(Texture* depthAttachment, VkFormat depthFormat, uint32_t width, uint32_t height, uint32_t imageCount);
+
+		~HiZCulling();
+
+		HiZCulling(const HiZCulling&) = delete;
+
+		HiZCulling& operator=(const HiZCulling&) = delete;
+
+		// uploads bounds of the draws, false if there are too many of them and the frame is drawn without culling
+		bool Prepare(uint32_t imageIndex, const RenderSnapshot& snapshot);
+
+		// before the first phase render pass
+		void RecordFirstPhase(VkCommandBuffer commandBuffer, uint32_t imageIndex);
+
+		// after the first phase render pass, leaves depth attachment in DEPTH_STENCIL_ATTACHMENT_OPTIMAL
+		void RecordSecondPhase(VkCommandBuffer commandBuffer, uint32_t imageIndex);
+
+		[[nodiscard]] VkBuffer GetCommandBuffer() const noexcept { return m_commands->GetBuffer(); }
+
+		[[nodiscard]] static VkDeviceSize GetCommandOffset(uint32_t draw, Phase phase) noexcept
+		{
+			return (static_cast<VkDeviceSize>(phase) * MAX_DRAW_COUNT + draw) * sizeof(VkDrawIndexedIndirectCommand);
+		}
+
+	private:
+		struct CullObject
+		{
+			glm::vec3 center;
+			uint32_t indexCount;
+			glm::vec3 extents;
+			uint32_t visibilityIndex;
+			uint32_t firstInstance;
+			uint32_t instanceCount;
+			uint32_t firstIndex;
+			int32_t vertexOffset;
+		};
+
+		struct DownsampleConstants
+		{
+			glm::ivec2 sourceSize;
+			glm::ivec2 destinationSize;
+		};
+
+		struct CullConstants
+		{
+			glm::mat4 viewProj;
+			glm::vec2 pyramidSize;
+			uint32_t objectCount;
+			uint32_t maxObjectCount;
+			uint32_t visibilityCount;
+			uint32_t phase;
+		};
+
+		// must match std430 layouts and push constants of hiz_cull.comp
+		static_assert(sizeof(CullObject) == 48 && offsetof(CullObject, extents) == 16
+			&& offsetof(CullObject, firstInstance) == 32);
+		static_assert(offsetof(CullConstants, pyramidSize) == 64 && offsetof(CullConstants, phase) == 84);
+		// guaranteed push constant space
+		static_assert(sizeof(CullConstants) <= 128);
+
+		struct ComputePass
+		{
+			uint64_t setLayoutHash = 0;
+			VkDescriptorSetLayout setLayout = VK_NULL_HANDLE;
+			VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+			VkPipeline pipeline = VK_NULL_HANDLE;
+		};
+
+	private:
+		void CreatePyramid();
+
+		void CreatePass(ComputePass& pass, GUID shaderGuid, const std::vector<VkDescriptorType>& types,
+		                uint32_t pushConstantSize) const;
+
+		void DestroyPass(ComputePass& pass) const;
+
+		void CreateDescriptorSets();
+
+		void DispatchCull(VkCommandBuffer commandBuffer, uint32_t imageIndex, Phase phase) const;
+
+	private:
+		static constexpr uint32_t MAX_DRAW_COUNT = 16384;
+		// visibility of the previous frame is kept by renderer tree proxy
+		static constexpr uint32_t MAX_VISIBILITY_COUNT = 65536;
+		static constexpr uint32_t DOWNSAMPLE_GROUP_SIZE = 8;
+		static constexpr uint32_t CULL_GROUP_SIZE = 64;
+
+		Texture* m_depthAttachment;
+		// layout transitions of depth stencil formats have to include stencil
+		VkImageAspectFlags m_depthAspect;
+		uint32_t m_depthWidth;
+		uint32_t m_depthHeight;
+
+		// largest power of two below the depth attachment
+		uint32_t m_pyramidWidth = 0;
+		uint32_t m_pyramidHeight = 0;
+		uint32_t m_pyramidLevelCount = 0;
+		VkImage m_pyramid = VK_NULL_HANDLE;
+		VkDeviceMemory m_pyramidMemory = VK_NULL_HANDLE;
+		VkImageView m_pyramidView = VK_NULL_HANDLE;
+		std::vector<VkImageView> m_pyramidLevelViews;
+		VkSampler m_sampler = VK_NULL_HANDLE;
+
+		ComputePass m_downsamplePass;
+		ComputePass m_cullPass;
+		// set per pyramid level
+		std::vector<VkDescriptorSet> m_downsampleSets;
+		// set per swapchain image
+		std::vector<VkDescriptorSet> m_cullSets;
+
+		std::vector<std::unique_ptr<Buffer>> m_objects;
+		std::unique_ptr<Buffer> m_visibility;
+		std::unique_ptr<Buffer> m_commands;
+
+		// per swapchain image, written by Prepare
+		std::vector<uint32_t> m_objectCounts;
+		std::vector<glm::mat4> m_viewProjs;
+		// visibility and pyramid are initialized by the first recorded frame
+		bool m_isInitialized = false;
+	};
+}
+
+#endif //HIZ_CULLING_H
@@ -0,0 +1,263 @@
+#include "OcclusionBuffer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cfloat>
+
+#include <emmintrin.h>
+
+#include "JoyContext.h"
+#include "Common/JobSystem.h"
+
+namespace JoyEngine
+{
+	OcclusionBuffer::OcclusionBuffer() :
+		m_viewProj(1.0f),
+		m_depth(WIDTH * HEIGHT, FLT_MAX),
+		m_tileMaxDepth(TILE_COUNT_X * TILE_COUNT_Y, FLT_MAX)
+	{
+	}
+
+	void OcclusionBuffer::Begin(const glm::mat4& viewProj)
+	{
+		m_viewProj = viewProj;
+		m_triangles.clear();
+		for (auto& triangles : m_bandTriangles)
+		{
+			triangles.clear();
+		}
+	}
+
+	void OcclusionBuffer::AddOccluder(const glm::mat4& model, const std::vector<glm::vec3>& vertices,
+	                                  const std::vector<uint32_t>& indices)
+	{
+		const glm::mat4 modelViewProj = m_viewProj * model;
+		m_clipVertices.resize(vertices.size());
+		for (size_t i = 0; i < vertices.size(); i++)
+		{
+			m_clipVertices[i] = modelViewProj * glm::vec4(vertices[i], 1.0f);
+		}
+		for (size_t i = 0; i + 2 < indices.size(); i += 3)
+		{
+			AddTriangle(m_clipVertices[indices[i]], m_clipVertices[indices[i + 1]], m_clipVertices[indices[i + 2]]);
+		}
+	}
+
+	void OcclusionBuffer::AddTriangle(const glm::vec4& v0, const glm::vec4& v1, const glm::vec4& v2)
+	{
+		// clipping would only add occlusion, skipping is still conservative
+		if (v0.z < -v0.w || v1.z < -v1.w || v2.z < -v2.w)
+		{
+			return;
+		}
+
+		float x[3];
+		float y[3];
+		float z[3];
+		const glm::vec4* clip[3] = {&v0, &v1, &v2};
+		for (int i = 0; i < 3; i++)
+		{
+			const float invW = 1.0f / clip[i]->w;
+			x[i] = (clip[i]->x * invW * 0.5f + 0.5f) * WIDTH;
+			y[i] = (clip[i]->y * invW * 0.5f + 0.5f) * HEIGHT;
+			z[i] = clip[i]->z * invW;
+		}
+
+		float area = (x[1] - x[0]) * (y[2] - y[0]) - (y[1] - y[0]) * (x[2] - x[0]);
+		// occluders are not closed meshes, so both sides are drawn
+		if (area < 0)
+		{
+			std::swap(x[1], x[2]);
+			std::swap(y[1], y[2]);
+			std::swap(z[1], z[2]);
+			area = -area;
+		}
+		// thinner than a pixel covers no pixel completely
+		if (area < 1.0f)
+		{
+			return;
+		}
+
+		Triangle triangle;
+		triangle.minX = std::max(0, static_cast<int32_t>(std::floor(std::min({x[0], x[1], x[2]}))));
+		triangle.maxX = std::min(static_cast<int32_t>(WIDTH) - 1,
+		                         static_cast<int32_t>(std::floor(std::max({x[0], x[1], x[2]}))));
+		triangle.minY = std::max(0, static_cast<int32_t>(std::floor(std::min({y[0], y[1], y[2]}))));
+		triangle.maxY = std::min(static_cast<int32_t>(HEIGHT) - 1,
+		                         static_cast<int32_t>(std::floor(std::max({y[0], y[1], y[2]}))));
+		if (triangle.minX > triangle.maxX || triangle.minY > triangle.maxY)
+		{
+			return;
+		}
+
+		for (int i = 0; i < 3; i++)
+		{
+			const int j = (i + 1) % 3;
+			const float a = y[i] - y[j];
+			const float b = x[j] - x[i];
+			triangle.edgeA[i] = a;
+			triangle.edgeB[i] = b;
+			triangle.edgeC[i] = -a * x[i] - b * y[i] - 0.5f * (std::abs(a) + std::abs(b));
+		}
+
+		triangle.depthA = ((z[1] - z[0]) * (y[2] - y[0]) - (z[2] - z[0]) * (y[1] - y[0])) / area;
+		triangle.depthB = ((z[2] - z[0]) * (x[1] - x[0]) - (z[1] - z[0]) * (x[2] - x[0])) / area;
+		triangle.depthC = z[0] - triangle.depthA * x[0] - triangle.depthB * y[0] +
+			0.5f * (std::abs(triangle.depthA) + std::abs(triangle.depthB));
+		triangle.depthMax = std::max({z[0], z[1], z[2]});
+
+		const auto index = static_cast<uint32_t>(m_triangles.size());
+		m_triangles.push_back(triangle);
+		for (uint32_t band = triangle.minY / BAND_HEIGHT; band <= triangle.maxY / BAND_HEIGHT; band++)
+		{
+			m_bandTriangles[band].push_back(index);
+		}
+	}
+
+	void OcclusionBuffer::Rasterize()
+	{
+		JoyContext::Jobs->ParallelFor(BAND_COUNT, [this](uint32_t begin, uint32_t end)
+		{
+			for (uint32_t band = begin; band < end; band++)
+			{
+				RasterizeBand(band);
+			}
+		}, 1);
+	}
+
+	void OcclusionBuffer::RasterizeBand(uint32_t band)
+	{
+		const uint32_t bandMinY = band * BAND_HEIGHT;
+		const uint32_t bandMaxY = bandMinY + BAND_HEIGHT - 1;
+		std::fill(m_depth.begin() + GetIndex(0, bandMinY), m_depth.begin() + GetIndex(0, bandMaxY + 1), FLT_MAX);
+
+		const __m128 pixelOffsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+		const __m128 zero = _mm_setzero_ps();
+		for (const uint32_t triangleIndex : m_bandTriangles[band])
+		{
+			const Triangle& t = m_triangles[triangleIndex];
+			const __m128 depthA = _mm_set1_ps(t.depthA);
+			const __m128 depthMax = _mm_set1_ps(t.depthMax);
+			__m128 edgeA[3];
+			for (int i = 0; i < 3; i++)
+			{
+				edgeA[i] = _mm_set1_ps(t.edgeA[i]);
+			}
+
+			const uint32_t minY = std::max(bandMinY, static_cast<uint32_t>(t.minY));
+			const uint32_t maxY = std::min(bandMaxY, static_cast<uint32_t>(t.maxY));
+			// 4 pixel groups never cross tile rows
+			const uint32_t minX = static_cast<uint32_t>(t.minX) & ~3u;
+			const auto maxX = static_cast<uint32_t>(t.maxX);
+			for (uint32_t y = minY; y <= maxY; y++)
+			{
+				const float centerY = static_cast<float>(y) + 0.5f;
+				__m128 rowEdge[3];
+				for (int i = 0; i < 3; i++)
+				{
+					rowEdge[i] = _mm_set1_ps(t.edgeB[i] * centerY + t.edgeC[i]);
+				}
+				const __m128 rowDepth = _mm_set1_ps(t.depthB * centerY + t.depthC);
+
+				for (uint32_t x = minX; x <= maxX; x += 4)
+				{
+					const __m128 pixelX = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), pixelOffsets);
+					__m128 isInside = _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(edgeA[0], pixelX), rowEdge[0]), zero);
+					isInside = _mm_and_ps(isInside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(edgeA[1], pixelX), rowEdge[1]), zero));
+					isInside = _mm_and_ps(isInside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(edgeA[2], pixelX), rowEdge[2]), zero));
+					if (_mm_movemask_ps(isInside) == 0)
+					{
+						continue;
+					}
+					const __m128 depth = _mm_min_ps(_mm_add_ps(_mm_mul_ps(depthA, pixelX), rowDepth), depthMax);
+					float* target = &m_depth[GetIndex(x, y)];
+					const __m128 current = _mm_loadu_ps(target);
+					const __m128 nearest = _mm_min_ps(current, depth);
+					_mm_storeu_ps(target, _mm_or_ps(_mm_and_ps(isInside, nearest), _mm_andnot_ps(isInside, current)));
+				}
+			}
+		}
+
+		for (uint32_t tileY = bandMinY / TILE_HEIGHT; tileY <= bandMaxY / TILE_HEIGHT; tileY++)
+		{
+			for (uint32_t tileX = 0; tileX < TILE_COUNT_X; tileX++)
+			{
+				const float* tile = &m_depth[GetIndex(tileX * TILE_WIDTH, tileY * TILE_HEIGHT)];
+				__m128 maxDepth = _mm_loadu_ps(tile);
+				for (uint32_t i = 4; i < TILE_WIDTH * TILE_HEIGHT; i += 4)
+				{
+					maxDepth = _mm_max_ps(maxDepth, _mm_loadu_ps(tile + i));
+				}
+				maxDepth = _mm_max_ps(maxDepth, _mm_shuffle_ps(maxDepth, maxDepth, _MM_SHUFFLE(1, 0, 3, 2)));
+				maxDepth = _mm_max_ps(maxDepth, _mm_shuffle_ps(maxDepth, maxDepth, _MM_SHUFFLE(2, 3, 0, 1)));
+				m_tileMaxDepth[tileY * TILE_COUNT_X + tileX] = _mm_cvtss_f32(maxDepth);
+			}
+		}
+	}
+
+	bool OcclusionBuffer::IsVisible(const AABB& bounds) const
+	{
+		float minX = FLT_MAX;
+		float maxX = -FLT_MAX;
+		float minY = FLT_MAX;
+		float maxY = -FLT_MAX;
+		float minZ = FLT_MAX;
+		for (int i = 0; i < 8; i++)
+		{
+			const glm::vec3 corner(
+				(i & 1) ? bounds.max.x : bounds.min.x,
+				(i & 2) ? bounds.max.y : bounds.min.y,
+				(i & 4) ? bounds.max.z : bounds.min.z);
+			const glm::vec4 clip = m_viewProj * glm::vec4(corner, 1.0f);
+			if (clip.z < -clip.w)
+			{
+				return true;
+			}
+			const float invW = 1.0f / clip.w;
+			const float x = (clip.x * invW * 0.5f + 0.5f) * WIDTH;
+			const float y = (clip.y * invW * 0.5f + 0.5f) * HEIGHT;
+			minX = std::min(minX, x);
+			maxX = std::max(maxX, x);
+			minY = std::min(minY, y);
+			maxY = std::max(maxY, y);
+			minZ = std::min(minZ, clip.z * invW);
+		}
+
+		const int32_t x0 = std::max(0, static_cast<int32_t>(std::floor(minX)));
+		const int32_t x1 = std::min(static_cast<int32_t>(WIDTH) - 1, static_cast<int32_t>(std::floor(maxX)));
+		const int32_t y0 = std::max(0, static_cast<int32_t>(std::floor(minY)));
+		const int32_t y1 = std::min(static_cast<int32_t>(HEIGHT) - 1, static_cast<int32_t>(std::floor(maxY)));
+		// frustum culling has already decided about boxes off the screen
+		if (x0 > x1 || y0 > y1)
+		{
+			return true;
+		}
+
+		for (int32_t tileY = y0 / static_cast<int32_t>(TILE_HEIGHT); tileY <= y1 / static_cast<int32_t>(TILE_HEIGHT); tileY++)
+		{
+			for (int32_t tileX = x0 / static_cast<int32_t>(TILE_WIDTH); tileX <= x1 / static_cast<int32_t>(TILE_WIDTH); tileX++)
+			{
+				// every pixel of the tile is nearer than the box
+				if (m_tileMaxDepth[tileY * TILE_COUNT_X + tileX] < minZ)
+				{
+					continue;
+				}
+				const int32_t pixelMinY = std::max(y0, tileY * static_cast<int32_t>(TILE_HEIGHT));
+				const int32_t pixelMaxY = std::min(y1, (tileY + 1) * static_cast<int32_t>(TILE_HEIGHT) - 1);
+				const int32_t pixelMinX = std::max(x0, tileX * static_cast<int32_t>(TILE_WIDTH));
+				const int32_t pixelMaxX = std::min(x1, (tileX + 1) * static_cast<int32_t>(TILE_WIDTH) - 1);
+				for (int32_t y = pixelMinY; y <= pixelMaxY; y++)
+				{
+					for (int32_t x = pixelMinX; x <= pixelMaxX; x++)
+					{
+						if (m_depth[GetIndex(x, y)] >= minZ)
+						{
+							return true;
+						}
+					}
+				}
+			}
+		}
+		return false;
+	}
+}
@@ -0,0 +1,98 @@
+#ifndef OCCLUSION_BUFFER_H
+#define OCCLUSION_BUFFER_H
+
+#include <vector>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+#include "Common/Bounds.h"
+
+namespace JoyEngine
+{
+	// Low resolution software depth buffer of occluder triangles.
+	// Both sides are conservative, so nothing visible is ever culled: a triangle covers only pixels
+	// it covers completely, with the farthest depth it has inside the pixel,
+	// and a box is hidden only if every pixel of its screen rect has something nearer than the box's nearest point.
+	// Depth is stored in 8x4 tiles, so a tile row is two SSE registers,
+	// and screen is split into bands of tile rows rasterized by different workers.
+	// Add occluders on one thread, then Rasterize, then IsVisible may be called from any thread
+	class OcclusionBuffer
+	{
+	public:
+		static constexpr uint32_t WIDTH = 256;
+		static constexpr uint32_t HEIGHT = 128;
+		static constexpr uint32_t TILE_WIDTH = 8;
+		static constexpr uint32_t TILE_HEIGHT = 4;
+
+		OcclusionBuffer();
+
+		// clears the buffer, viewProj maps world to clip space with -w <= z <= w
+		void Begin(const glm::mat4& viewProj);
+
+		// Triangles crossing the near plane are skipped
+		void AddOccluder(const glm::mat4& model, const std::vector<glm::vec3>& vertices,
+		                 const std::vector<uint32_t>& indices);
+
+		void Rasterize();
+
+		// false if box is hidden by occluders. Boxes crossing the near plane are visible
+		[[nodiscard]] bool IsVisible(const AABB& bounds) const;
+
+		[[nodiscard]] uint32_t GetTriangleCount() const noexcept { return static_cast<uint32_t>(m_triangles.size()); }
+
+	private:
+		// everything is in buffer pixels with pixel (x, y) covering [x, x + 1) x [y, y + 1)
+		struct Triangle
+		{
+			// e(x, y) = a * x + b * y + c at pixel centers, shifted so e >= 0 means the whole pixel is inside
+			float edgeA[3];
+			float edgeB[3];
+			float edgeC[3];
+			// depth plane at pixel centers, shifted to the farthest depth inside the pixel
+			float depthA;
+			float depthB;
+			float depthC;
+			float depthMax;
+			// inclusive pixel range
+			int32_t minX;
+			int32_t maxX;
+			int32_t minY;
+			int32_t maxY;
+		};
+
+	private:
+		void AddTriangle(const glm::vec4& v0, const glm::vec4& v1, const glm::vec4& v2);
+
+		void RasterizeBand(uint32_t band);
+
+		[[nodiscard]] static uint32_t GetIndex(uint32_t x, uint32_t y) noexcept
+		{
+			return ((y / TILE_HEIGHT) * TILE_COUNT_X + x / TILE_WIDTH) * TILE_WIDTH * TILE_HEIGHT +
+				(y % TILE_HEIGHT) * TILE_WIDTH + x % TILE_WIDTH;
+		}
+
+	private:
+		static constexpr uint32_t TILE_COUNT_X = WIDTH / TILE_WIDTH;
+		static constexpr uint32_t TILE_COUNT_Y = HEIGHT / TILE_HEIGHT;
+		static constexpr uint32_t BAND_TILE_ROWS = 4;
+		static constexpr uint32_t BAND_HEIGHT = BAND_TILE_ROWS * TILE_HEIGHT;
+		static constexpr uint32_t BAND_COUNT = TILE_COUNT_Y / BAND_TILE_ROWS;
+		static_assert(WIDTH % TILE_WIDTH == 0 && TILE_COUNT_Y % BAND_TILE_ROWS == 0);
+		static_assert(TILE_WIDTH % 4 == 0, "rasterizer writes 4 pixels of a tile row at once");
+
+		glm::mat4 m_viewProj;
+		// nearest depth in every pixel, FLT_MAX where nothing is drawn
+		std::vector<float> m_depth;
+		// farthest depth of every tile
+		std::vector<float> m_tileMaxDepth;
+
+		std::vector<Triangle> m_triangles;
+		// triangle indices overlapping every band
+		std::vector<uint32_t> m_bandTriangles[BAND_COUNT];
+		// scratch of AddOccluder
+		std::vector<glm::vec4> m_clipVertices;
+	};
+}
+
+#endif //OCCLUSION_BUFFER_H
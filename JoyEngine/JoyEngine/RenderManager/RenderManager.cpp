@@ -1,12 +1,20 @@
 #include "RenderManager.h"
 
 #include <memory>
+#include <algorithm>
+#include <cstring>
+#include <functional>
 
 #include "JoyContext.h"
 
 #include "MemoryManager/MemoryManager.h"
 #include "RenderManager/VulkanUtils.h"
+#include "RenderManager/CullingKernels.h"
+#include "RenderManager/HiZCulling.h"
+#include "RenderManager/DrawSortKey.h"
 #include "ResourceManager/ResourceManager.h"
+#include "Common/Time.h"
+#include "SceneManager/TransformSystem.h"
 
 #define GLM_FORCE_RADIANS
 #define STB_IMAGE_IMPLEMENTATION
@@ -14,19 +22,70 @@
 
 namespace JoyEngine
 {
+	static constexpr uint64_t FNV_OFFSET = 14695981039346656037ull;
+	static constexpr uint64_t FNV_PRIME = 1099511628211ull;
+
+	// FNV-1a over 64 bit words, keys of recorded chunks are built from thousands of values.
+	// High bits are folded back, so they reach the whole key
+	static uint64_t HashValue(uint64_t hash, uint64_t value)
+	{
+		hash = (hash ^ value) * FNV_PRIME;
+		return hash ^ hash >> 32;
+	}
+
+	template <typename T>
+	static uint64_t HashHandle(uint64_t hash, T handle)
+	{
+		static_assert(sizeof(T) <= sizeof(uint64_t));
+		uint64_t value = 0;
+		memcpy(&value, &handle, sizeof(handle));
+		return HashValue(hash, value);
+	}
+
+	static uint64_t HashMatrix(uint64_t hash, const glm::mat4& matrix)
+	{
+		uint64_t words[sizeof(glm::mat4) / sizeof(uint64_t)];
+		memcpy(words, &matrix, sizeof(words));
+		for (const uint64_t word : words)
+		{
+			hash = HashValue(hash, word);
+		}
+		return hash;
+	}
+
 	RenderManager::RenderManager()
 	{
 	}
 
+	void RenderManager::Start()
+	{
+		ASSERT(!m_renderThread.joinable());
+		m_renderThread = std::thread(&RenderManager::RenderThreadLoop, this);
+	}
+
 	void RenderManager::Stop()
 	{
-		vkQueueWaitIdle(JoyContext::Graphics->GetPresentQueue());
+		if (m_renderThread.joinable())
+		{
+			m_snapshotQueue.Stop();
+			m_renderThread.join();
+		}
+		m_rendererTree.WaitForRebuild();
+		{
+			std::lock_guard<std::mutex> lock(JoyContext::Graphics->GetQueueMutex());
+			vkQueueWaitIdle(JoyContext::Graphics->GetPresentQueue());
+		}
 		vkDeviceWaitIdle(JoyContext::Graphics->GetDevice());
+		// everything submitted is finished
+		m_completedFrameCount.store(m_queuedFrameCount, std::memory_order_release);
 		m_gBufferWriteSharedMaterial.Clear();
 	}
 
 	RenderManager::~RenderManager()
 	{
+		m_hiZCulling = nullptr;
+		m_secondaryCommandBuffers = nullptr;
+		m_instanceBuffers.clear();
 		m_depthAttachment = nullptr;
 		m_normalAttachment = nullptr;
 		m_positionAttachment = nullptr;
@@ -38,11 +97,16 @@ namespace JoyEngine
 		}
 
 		vkFreeCommandBuffers(JoyContext::Graphics->GetDevice(),
-		                     JoyContext::Graphics->GetCommandPool(),
+		                     m_commandPool,
 		                     static_cast<uint32_t>(commandBuffers.size()),
 		                     commandBuffers.data());
+		vkDestroyCommandPool(JoyContext::Graphics->GetDevice(),
+		                     m_commandPool,
+		                     JoyContext::Graphics->GetAllocationCallbacks());
 
 		m_renderPass = nullptr;
+		m_firstPhaseRenderPass = nullptr;
+		m_secondPhaseRenderPass = nullptr;
 
 		m_swapchain = nullptr;
 
@@ -65,6 +129,47 @@ namespace JoyEngine
 		CreateFramebuffers();
 		CreateCommandBuffers();
 		CreateSyncObjects();
+
+		m_secondaryCommandBuffers = std::make_unique<SecondaryCommandBuffers>(m_swapchain->GetSwapchainImageCount());
+
+		m_hiZCulling = std::make_unique<HiZCulling>(
+			m_depthAttachment.get(),
+			findDepthFormat(JoyContext::Graphics->GetPhysicalDevice()),
+			m_swapchain->GetWidth(),
+			m_swapchain->GetHeight(),
+			m_swapchain->GetSwapchainImageCount());
+
+		m_instanceBuffers.resize(m_swapchain->GetSwapchainImageCount());
+		m_instanceCapacities.resize(m_swapchain->GetSwapchainImageCount(), 0);
+	}
+
+	void RenderManager::UploadInstances(uint32_t imageIndex, const RenderSnapshot& snapshot)
+	{
+		const auto count = static_cast<uint32_t>(snapshot.instances.size());
+		// previous frame of the image is finished, so its buffer can be replaced
+		if (count > m_instanceCapacities[imageIndex])
+		{
+			uint32_t capacity = std::max(m_instanceCapacities[imageIndex], MIN_INSTANCE_CAPACITY);
+			while (capacity < count)
+			{
+				capacity *= 2;
+			}
+			m_instanceBuffers[imageIndex] = std::make_unique<Buffer>(
+				capacity * sizeof(InstanceData),
+				VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+			m_instanceCapacities[imageIndex] = capacity;
+			// recorded chunks bind the old buffer
+			m_secondaryCommandBuffers->Invalidate(imageIndex);
+		}
+		if (count == 0)
+		{
+			return;
+		}
+
+		const std::unique_ptr<BufferMappedPtr> ptr = m_instanceBuffers[imageIndex]->GetMappedPtr(
+			0, count * sizeof(InstanceData));
+		memcpy(ptr->GetMappedPtr(), snapshot.instances.data(), count * sizeof(InstanceData));
 	}
 
 	void RenderManager::CreateRenderPass()
@@ -79,7 +184,8 @@ namespace JoyEngine
 			m_swapchain->GetHeight(),
 			depthFormat,
 			VK_IMAGE_TILING_OPTIMAL,
-			VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
+			// sampled by depth pyramid
+			VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
 			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
 			VK_IMAGE_ASPECT_DEPTH_BIT
 		);
@@ -226,12 +332,16 @@ namespace JoyEngine
 		VkSubpassDependency dependencies[] =
 		{
 			{
+				// also makes G-buffer of the first phase render pass visible to the second one
 				VK_SUBPASS_EXTERNAL,
 				0,
+				VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT |
+				VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
 				VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT,
-				VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT,
-				VK_ACCESS_MEMORY_READ_BIT,
-				VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+				VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+				VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+				VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+				VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
 				VK_DEPENDENCY_BY_REGION_BIT
 			},
 			{
@@ -263,6 +373,55 @@ namespace JoyEngine
 			3,
 			dependencies);
 
+		// Render passes of GPU occlusion culling differ only in load and store operations and layouts,
+		// so they are compatible with pipelines and framebuffers of the main one.
+		// First phase keeps G-buffer and depth, second phase loads them and draws the rest
+		VkAttachmentDescription firstPhaseAttachments[] = {
+			colorAttachmentDescription,
+			positionGBufferAttachmentDescription,
+			normalGBufferAttachmentDescription,
+			depthAttachmentDescription
+		};
+		firstPhaseAttachments[0].loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+		firstPhaseAttachments[0].storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		firstPhaseAttachments[0].finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+		for (uint32_t i = 1; i <= 2; i++)
+		{
+			firstPhaseAttachments[i].storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+			firstPhaseAttachments[i].finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		}
+		firstPhaseAttachments[3].storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+
+		m_firstPhaseRenderPass = std::make_unique<RenderPass>(
+			4,
+			firstPhaseAttachments,
+			2,
+			subpasses,
+			3,
+			dependencies);
+
+		VkAttachmentDescription secondPhaseAttachments[] = {
+			colorAttachmentDescription,
+			positionGBufferAttachmentDescription,
+			normalGBufferAttachmentDescription,
+			depthAttachmentDescription
+		};
+		for (uint32_t i = 1; i <= 2; i++)
+		{
+			secondPhaseAttachments[i].loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+			secondPhaseAttachments[i].initialLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		}
+		secondPhaseAttachments[3].loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+		secondPhaseAttachments[3].initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+		m_secondPhaseRenderPass = std::make_unique<RenderPass>(
+			4,
+			secondPhaseAttachments,
+			2,
+			subpasses,
+			3,
+			dependencies);
+
 		m_gBufferWriteSharedMaterial = GUID::StringToGuid("869fa59b-d775-41fb-9650-d3f9e8f72269");
 		m_commonDescriptorSetProvider = std::make_unique<CommonDescriptorSetProvider>();
 	}
@@ -303,22 +462,34 @@ namespace JoyEngine
 
 	void RenderManager::RegisterSharedMaterial(SharedMaterial* meshRenderer)
 	{
-		m_sharedMaterials.insert(meshRenderer);
+		uint32_t sortId;
+		if (m_freeSharedMaterialIds.empty())
+		{
+			sortId = static_cast<uint32_t>(m_sharedMaterials.size());
+			ASSERT_DESC(sortId <= DrawSortKey::PIPELINE_MASK, "Too many shared materials for draw sort key");
+		}
+		else
+		{
+			sortId = m_freeSharedMaterialIds.back();
+			m_freeSharedMaterialIds.pop_back();
+		}
+		m_sharedMaterials.insert({meshRenderer, sortId});
 	}
 
 	void RenderManager::UnregisterSharedMaterial(SharedMaterial* meshRenderer)
 	{
-		if (m_sharedMaterials.find(meshRenderer) == m_sharedMaterials.end())
+		const auto it = m_sharedMaterials.find(meshRenderer);
+		if (it == m_sharedMaterials.end())
 		{
 			ASSERT(false);
 		}
-		m_sharedMaterials.erase(meshRenderer);
+		m_freeSharedMaterialIds.push_back(it->second);
+		m_sharedMaterials.erase(it);
 	}
 
 	void RenderManager::RegisterCamera(Camera* camera)
 	{
 		m_currentCamera = camera;
-		m_commonDescriptorSetProvider->SetCamera(camera);
 	}
 
 	void RenderManager::UnregisterCamera(Camera* camera)
@@ -327,14 +498,68 @@ namespace JoyEngine
 		m_currentCamera = nullptr;
 	}
 
+	void RenderManager::RegisterMeshRenderer(MeshRenderer* meshRenderer)
+	{
+		ASSERT(meshRenderer->m_proxy == BoundingVolumeHierarchy::INVALID_HANDLE);
+		const uint32_t proxy = m_rendererTree.Insert(meshRenderer->GetWorldBounds(), meshRenderer);
+		const uint32_t transform = meshRenderer->GetTransform()->GetHandle();
+		if (transform >= m_transformProxies.size())
+		{
+			m_transformProxies.resize(transform + 1, BoundingVolumeHierarchy::INVALID_HANDLE);
+		}
+		if (proxy >= m_nextProxies.size())
+		{
+			m_nextProxies.resize(proxy + 1, BoundingVolumeHierarchy::INVALID_HANDLE);
+		}
+		m_nextProxies[proxy] = m_transformProxies[transform];
+		m_transformProxies[transform] = proxy;
+		meshRenderer->m_proxy = proxy;
+	}
+
+	void RenderManager::UnregisterMeshRenderer(MeshRenderer* meshRenderer)
+	{
+		const uint32_t proxy = meshRenderer->m_proxy;
+		ASSERT(proxy != BoundingVolumeHierarchy::INVALID_HANDLE);
+		uint32_t* link = &m_transformProxies[meshRenderer->GetTransform()->GetHandle()];
+		while (*link != proxy)
+		{
+			ASSERT(*link != BoundingVolumeHierarchy::INVALID_HANDLE);
+			link = &m_nextProxies[*link];
+		}
+		*link = m_nextProxies[proxy];
+		m_nextProxies[proxy] = BoundingVolumeHierarchy::INVALID_HANDLE;
+		m_rendererTree.Remove(proxy);
+		meshRenderer->m_proxy = BoundingVolumeHierarchy::INVALID_HANDLE;
+	}
+
+	Camera* RenderManager::GetCurrentCamera() const noexcept
+	{
+		return m_currentCamera;
+	}
+
 	void RenderManager::CreateCommandBuffers()
 	{
+		const VkCommandPoolCreateInfo poolInfo = {
+			VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+			nullptr,
+			VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
+			JoyContext::Graphics->GetGraphicsQueueFamily()
+		};
+
+		const VkResult poolRes = vkCreateCommandPool(
+			JoyContext::Graphics->GetDevice(),
+			&poolInfo,
+			JoyContext::Graphics->GetAllocationCallbacks(),
+			&m_commandPool);
+
+		ASSERT_DESC(poolRes == VK_SUCCESS, ParseVkResult(poolRes));
+
 		commandBuffers.resize(m_swapChainFramebuffers.size());
 
 		const VkCommandBufferAllocateInfo allocInfo = {
 			VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
 			0,
-			JoyContext::Graphics->GetCommandPool(),
+			m_commandPool,
 			VK_COMMAND_BUFFER_LEVEL_PRIMARY,
 			(uint32_t)commandBuffers.size()
 		};
@@ -347,7 +572,7 @@ namespace JoyEngine
 		ASSERT(res == VK_SUCCESS)
 	}
 
-	void RenderManager::WriteCommandBuffers(uint32_t imageIndex) const
+	void RenderManager::WriteCommandBuffers(uint32_t imageIndex, const RenderSnapshot& snapshot, bool isGpuCulled)
 	{
 		VkCommandBufferBeginInfo beginInfo{};
 		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
@@ -375,147 +600,415 @@ namespace JoyEngine
 			clearValues
 		};
 
-		vkCmdBeginRenderPass(commandBuffers[imageIndex], &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+		// Draw lists are split into chunks recorded on workers into secondary command buffers,
+		// primary command buffer only runs passes and executes the chunks in order
+		const auto gBufferCount = static_cast<uint32_t>(snapshot.gBufferOrder.size());
+		const auto drawCount = static_cast<uint32_t>(snapshot.draws.size());
+		const uint32_t gBufferChunkSize = GetRecordChunkSize(gBufferCount);
+		const uint32_t materialChunkSize = GetRecordChunkSize(drawCount);
+		m_recordChunks.clear();
+		if (isGpuCulled)
+		{
+			for (uint32_t begin = 0; begin < gBufferCount; begin += gBufferChunkSize)
+			{
+				m_recordChunks.push_back({
+					DrawSortKey::GBufferPass, HiZCulling::First, begin, std::min(begin + gBufferChunkSize, gBufferCount)
+				});
+			}
+		}
+		const auto firstPhaseChunkCount = static_cast<uint32_t>(m_recordChunks.size());
+		for (uint32_t begin = 0; begin < gBufferCount; begin += gBufferChunkSize)
+		{
+			m_recordChunks.push_back({
+				DrawSortKey::GBufferPass, HiZCulling::Second, begin, std::min(begin + gBufferChunkSize, gBufferCount)
+			});
+		}
+		const auto gBufferChunkEnd = static_cast<uint32_t>(m_recordChunks.size());
+		for (uint32_t begin = 0; begin < drawCount; begin += materialChunkSize)
+		{
+			m_recordChunks.push_back({
+				DrawSortKey::MaterialPass, HiZCulling::Final, begin, std::min(begin + materialChunkSize, drawCount)
+			});
+		}
+		const auto chunkCount = static_cast<uint32_t>(m_recordChunks.size());
+		m_recordCommandBuffers.resize(chunkCount);
+		m_secondaryCommandBuffers->Resize(imageIndex, chunkCount);
+
+		const VkRenderPass renderPass = isGpuCulled
+			                                ? m_secondPhaseRenderPass->GetRenderPass()
+			                                : m_renderPass->GetRenderPass();
+		JoyContext::Jobs->ParallelFor(chunkCount, [this, imageIndex, &snapshot, isGpuCulled, renderPass](uint32_t begin, uint32_t end)
+		{
+			for (uint32_t i = begin; i < end; i++)
+			{
+				const RecordChunk& chunk = m_recordChunks[i];
+				// chunk recorded for the image with the same draws, pipelines and sets is executed again
+				const uint64_t key = GetChunkKey(imageIndex, snapshot, isGpuCulled, chunk);
+				if (m_secondaryCommandBuffers->IsRecorded(imageIndex, i, key))
+				{
+					m_recordCommandBuffers[i] = m_secondaryCommandBuffers->Get(imageIndex, i);
+					continue;
+				}
+
+				const VkCommandBufferInheritanceInfo inheritanceInfo = {
+					VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO,
+					nullptr,
+					chunk.phase == HiZCulling::First ? m_firstPhaseRenderPass->GetRenderPass() : renderPass,
+					chunk.pass == DrawSortKey::GBufferPass ? 0u : 1u,
+					m_swapChainFramebuffers[imageIndex],
+					VK_FALSE,
+					0,
+					0
+				};
+				const VkCommandBufferBeginInfo secondaryBeginInfo = {
+					VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+					nullptr,
+					VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT,
+					&inheritanceInfo
+				};
+				const VkCommandBuffer commandBuffer = m_secondaryCommandBuffers->Reset(imageIndex, i, key);
+				VkResult res = vkBeginCommandBuffer(commandBuffer, &secondaryBeginInfo);
+				ASSERT_DESC(res == VK_SUCCESS, ParseVkResult(res));
+
+				// secondary command buffers don't inherit state, every chunk binds what it draws with
+				if (!snapshot.instances.empty())
+				{
+					VkBuffer instanceBuffer = m_instanceBuffers[imageIndex]->GetBuffer();
+					VkDeviceSize offset = 0;
+					vkCmdBindVertexBuffers(
+						commandBuffer,
+						InstanceData::BINDING,
+						1,
+						&instanceBuffer,
+						&offset);
+				}
+				if (chunk.pass == DrawSortKey::GBufferPass)
+				{
+					RecordGBufferDraws(commandBuffer, imageIndex, snapshot, isGpuCulled, chunk.phase, chunk.begin, chunk.end);
+				}
+				else
+				{
+					RecordMaterialDraws(commandBuffer, imageIndex, snapshot, isGpuCulled, chunk.begin, chunk.end);
+				}
+
+				res = vkEndCommandBuffer(commandBuffer);
+				ASSERT_DESC(res == VK_SUCCESS, ParseVkResult(res));
+				m_recordCommandBuffers[i] = commandBuffer;
+			}
+		}, 1);
+
+		const auto executeChunks = [this, imageIndex](uint32_t begin, uint32_t end)
+		{
+			if (begin != end)
+			{
+				vkCmdExecuteCommands(commandBuffers[imageIndex], end - begin, m_recordCommandBuffers.data() + begin);
+			}
+		};
+
+		if (isGpuCulled)
+		{
+			// draws visible in the previous frame, their depth is the occluder of the second phase
+			m_hiZCulling->RecordFirstPhase(commandBuffers[imageIndex], imageIndex);
+			renderPassInfo.renderPass = m_firstPhaseRenderPass->GetRenderPass();
+			vkCmdBeginRenderPass(commandBuffers[imageIndex], &renderPassInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+			executeChunks(0, firstPhaseChunkCount);
+			vkCmdNextSubpass(commandBuffers[imageIndex], VK_SUBPASS_CONTENTS_INLINE);
+			vkCmdEndRenderPass(commandBuffers[imageIndex]);
+
+			m_hiZCulling->RecordSecondPhase(commandBuffers[imageIndex], imageIndex);
+			renderPassInfo.renderPass = m_secondPhaseRenderPass->GetRenderPass();
+		}
 
-		ASSERT(m_currentCamera != nullptr);
-		glm::mat4 view = m_currentCamera->GetViewMatrix();
-		glm::mat4 proj = m_currentCamera->GetProjMatrix();
+		vkCmdBeginRenderPass(commandBuffers[imageIndex], &renderPassInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+		executeChunks(firstPhaseChunkCount, gBufferChunkEnd);
+		vkCmdNextSubpass(commandBuffers[imageIndex], VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+		executeChunks(gBufferChunkEnd, chunkCount);
+		vkCmdEndRenderPass(commandBuffers[imageIndex]);
+
+		if (vkEndCommandBuffer(commandBuffers[imageIndex]) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to record command buffer!");
+		}
+	}
 
+	void RenderManager::RecordDraw(VkCommandBuffer commandBuffer, const RenderSnapshot& snapshot, bool isGpuCulled,
+	                               uint32_t drawIndex, HiZCulling::Phase phase) const
+	{
+		// with GPU culling every draw is indirect, culled ones have zero instances
+		if (isGpuCulled)
+		{
+			vkCmdDrawIndexedIndirect(
+				commandBuffer,
+				m_hiZCulling->GetCommandBuffer(),
+				HiZCulling::GetCommandOffset(drawIndex, phase),
+				1,
+				sizeof(VkDrawIndexedIndirectCommand));
+		}
+		else
+		{
+			const RenderDraw& draw = snapshot.draws[drawIndex];
+			vkCmdDrawIndexed(
+				commandBuffer,
+				draw.indexCount,
+				draw.instanceCount,
+				draw.firstIndex,
+				draw.vertexOffset,
+				draw.firstInstance);
+		}
+	}
+
+	void RenderManager::BindDefines(VkCommandBuffer commandBuffer, uint32_t imageIndex, SharedMaterial* sharedMaterial) const
+	{
+		for (const auto& def : sharedMaterial->GetBindingDefines())
+		{
+			SharedBindingData* data = m_commonDescriptorSetProvider->GetBindingData(def);
+			vkCmdBindDescriptorSets(
+				commandBuffer,
+				VK_PIPELINE_BIND_POINT_GRAPHICS,
+				sharedMaterial->GetPipelineLayout(),
+				data->setIndex,
+				1,
+				&data->descriptorSets[imageIndex],
+				0, nullptr);
+		}
+	}
+
+	void RenderManager::PushModel(VkCommandBuffer commandBuffer, SharedMaterial* sharedMaterial,
+	                              const RenderSnapshot& snapshot, const glm::mat4& model) const
+	{
+		if (sharedMaterial->IsCameraFromJoyVariables())
+		{
+			vkCmdPushConstants(
+				commandBuffer,
+				sharedMaterial->GetPipelineLayout(),
+				sharedMaterial->GetPushConstantStageFlags(),
+				0,
+				sizeof(glm::mat4),
+				&model);
+			return;
+		}
+
+		const MVP mvp{
+			model,
+			snapshot.view,
+			snapshot.proj
+		};
+		vkCmdPushConstants(
+			commandBuffer,
+			sharedMaterial->GetPipelineLayout(),
+			sharedMaterial->GetPushConstantStageFlags(),
+			0,
+			sizeof(MVP),
+			&mvp);
+	}
+
+	void RenderManager::RecordGBufferDraws(VkCommandBuffer commandBuffer, uint32_t imageIndex,
+	                                       const RenderSnapshot& snapshot, bool isGpuCulled, HiZCulling::Phase phase,
+	                                       uint32_t begin, uint32_t end) const
+	{
+		SharedMaterial* sm = m_gBufferWriteSharedMaterial;
 		vkCmdBindPipeline(
-			commandBuffers[imageIndex],
+			commandBuffer,
 			VK_PIPELINE_BIND_POINT_GRAPHICS,
-			m_gBufferWriteSharedMaterial->GetPipeline());
+			sm->GetPipeline());
+		BindDefines(commandBuffer, imageIndex, sm);
 
-		for (auto const& sm : m_sharedMaterials)
+		// instanced pipelines take model matrices from instance data, so MVP is the same for every draw
+		const bool isInstanced = sm->IsInstanced();
+		if (isInstanced && !sm->IsCameraFromJoyVariables())
 		{
-			for (const auto& mr : sm->GetMeshRenderers())
-			{
-				if (!mr->IsReady()) continue;
+			PushModel(commandBuffer, sm, snapshot, glm::mat4(1.0f));
+		}
 
+		VkBuffer boundVertexBuffer = VK_NULL_HANDLE;
+		for (uint32_t orderIndex = begin; orderIndex < end; orderIndex++)
+		{
+			const uint32_t i = snapshot.gBufferOrder[orderIndex];
+			const RenderDraw& draw = snapshot.draws[i];
+
+			if (draw.vertexBuffer != boundVertexBuffer)
+			{
 				VkBuffer vertexBuffers[] = {
-					mr->GetMesh()->GetVertexBuffer()
+					draw.vertexBuffer
 				};
 				VkDeviceSize offsets[] = {0};
 				vkCmdBindVertexBuffers(
-					commandBuffers[imageIndex],
+					commandBuffer,
 					0,
 					1,
 					vertexBuffers,
 					offsets);
 
 				vkCmdBindIndexBuffer(
-					commandBuffers[imageIndex],
-					mr->GetMesh()->GetIndexBuffer(),
+					commandBuffer,
+					draw.indexBuffer,
 					0,
 					VK_INDEX_TYPE_UINT32);
+				boundVertexBuffer = draw.vertexBuffer;
+			}
 
-				MVP mvp{
-					mr->GetTransform()->GetModelMatrix(),
-					view,
-					proj
-				};
-
-				vkCmdPushConstants(
-					commandBuffers[imageIndex],
-					m_gBufferWriteSharedMaterial->GetPipelineLayout(),
-					VK_SHADER_STAGE_VERTEX_BIT,
-					0,
-					sizeof(MVP),
-					&mvp);
-
-				vkCmdDrawIndexed(
-					commandBuffers[imageIndex],
-					static_cast<uint32_t>(mr->GetMesh()->GetIndexSize()),
-					1,
-					0,
-					0,
-					0);
+			if (!isInstanced)
+			{
+				PushModel(commandBuffer, sm, snapshot, draw.model);
 			}
-		}
 
-		vkCmdNextSubpass(commandBuffers[imageIndex], VK_SUBPASS_CONTENTS_INLINE);
+			RecordDraw(commandBuffer, snapshot, isGpuCulled, i, phase);
+		}
+	}
 
-		for (auto const& sm : m_sharedMaterials)
+	void RenderManager::RecordMaterialDraws(VkCommandBuffer commandBuffer, uint32_t imageIndex,
+	                                        const RenderSnapshot& snapshot, bool isGpuCulled,
+	                                        uint32_t begin, uint32_t end) const
+	{
+		// binds are skipped the same way CountBinds counts them
+		VkBuffer boundVertexBuffer = VK_NULL_HANDLE;
+		for (const auto& batch : snapshot.batches)
 		{
+			const uint32_t batchBegin = std::max(batch.firstDraw, begin);
+			const uint32_t batchEnd = std::min(batch.firstDraw + batch.drawCount, end);
+			if (batchBegin >= batchEnd)
+			{
+				continue;
+			}
+
+			const Material* boundMaterial = nullptr;
+			SharedMaterial* sm = batch.sharedMaterial;
 			vkCmdBindPipeline(
-				commandBuffers[imageIndex],
+				commandBuffer,
 				VK_PIPELINE_BIND_POINT_GRAPHICS,
 				sm->GetPipeline());
+			BindDefines(commandBuffer, imageIndex, sm);
 
-			for (const auto& def : sm->GetBindingDefines())
+			const bool isInstanced = sm->IsInstanced();
+			if (isInstanced && !sm->IsCameraFromJoyVariables())
 			{
-				SharedBindingData* data = m_commonDescriptorSetProvider->GetBindingData(def);
-				vkCmdBindDescriptorSets(
-					commandBuffers[imageIndex],
-					VK_PIPELINE_BIND_POINT_GRAPHICS,
-					sm->GetPipelineLayout(),
-					data->setIndex,
-					1,
-					&data->descriptorSets[imageIndex],
-					0, nullptr);
+				PushModel(commandBuffer, sm, snapshot, glm::mat4(1.0f));
 			}
 
-			for (const auto& mr : sm->GetMeshRenderers())
+			for (uint32_t i = batchBegin; i < batchEnd; i++)
 			{
-				if (!mr->IsReady()) continue;
-
-				VkBuffer vertexBuffers[] = {
-					mr->GetMesh()->GetVertexBuffer()
-				};
-				VkDeviceSize offsets[] = {0};
-				vkCmdBindVertexBuffers(
-					commandBuffers[imageIndex],
-					0,
-					1,
-					vertexBuffers,
-					offsets);
-
-				vkCmdBindIndexBuffer(
-					commandBuffers[imageIndex],
-					mr->GetMesh()->GetIndexBuffer(),
-					0,
-					VK_INDEX_TYPE_UINT32);
-
-
-				std::vector<VkDescriptorSet> sets = mr->GetMaterial()->GetDescriptorSets();
-				vkCmdBindDescriptorSets(
-					commandBuffers[imageIndex],
-					VK_PIPELINE_BIND_POINT_GRAPHICS,
-					sm->GetPipelineLayout(),
-					0,
-					1,
-					&sets[imageIndex],
-					0, nullptr);
-
-				MVP mvp{
-					mr->GetTransform()->GetModelMatrix(),
-					view,
-					proj
-				};
+				const RenderDraw& draw = snapshot.draws[i];
+
+				if (draw.vertexBuffer != boundVertexBuffer)
+				{
+					VkBuffer vertexBuffers[] = {
+						draw.vertexBuffer
+					};
+					VkDeviceSize offsets[] = {0};
+					vkCmdBindVertexBuffers(
+						commandBuffer,
+						0,
+						1,
+						vertexBuffers,
+						offsets);
+
+					vkCmdBindIndexBuffer(
+						commandBuffer,
+						draw.indexBuffer,
+						0,
+						VK_INDEX_TYPE_UINT32);
+					boundVertexBuffer = draw.vertexBuffer;
+				}
+
+				if (!sm->IsBindless() && draw.material != boundMaterial)
+				{
+					const std::vector<VkDescriptorSet>& sets = draw.material->GetDescriptorSets();
+					vkCmdBindDescriptorSets(
+						commandBuffer,
+						VK_PIPELINE_BIND_POINT_GRAPHICS,
+						sm->GetPipelineLayout(),
+						0,
+						1,
+						&sets[imageIndex],
+						0, nullptr);
+					boundMaterial = draw.material;
+				}
+
+				if (!isInstanced)
+				{
+					PushModel(commandBuffer, sm, snapshot, draw.model);
+				}
+
+				RecordDraw(commandBuffer, snapshot, isGpuCulled, i, HiZCulling::Final);
+			}
+		}
+	}
 
-				vkCmdPushConstants(
-					commandBuffers[imageIndex],
-					sm->GetPipelineLayout(),
-					VK_SHADER_STAGE_VERTEX_BIT,
-					0,
-					sizeof(MVP),
-					&mvp);
+	uint64_t RenderManager::GetChunkKey(uint32_t imageIndex, const RenderSnapshot& snapshot, bool isGpuCulled,
+	                                    const RecordChunk& chunk) const
+	{
+		// everything the chunk records: draws with their places in indirect commands, pipelines and sets,
+		// models and camera where they are push constants
+		uint64_t key = HashValue(FNV_OFFSET, snapshot.resourceGeneration);
+		key = HashValue(key, chunk.pass);
+		key = HashValue(key, chunk.phase);
+		key = HashValue(key, chunk.end - chunk.begin);
+		key = HashValue(key, isGpuCulled);
+		const auto hashDraw = [&snapshot](uint64_t hash, uint32_t drawIndex)
+		{
+			const RenderDraw& draw = snapshot.draws[drawIndex];
+			hash = HashValue(hash, drawIndex);
+			hash = HashHandle(hash, draw.vertexBuffer);
+			hash = HashHandle(hash, draw.indexBuffer);
+			hash = HashValue(hash, draw.indexCount);
+			hash = HashValue(hash, draw.firstIndex);
+			hash = HashValue(hash, static_cast<uint32_t>(draw.vertexOffset));
+			hash = HashValue(hash, draw.firstInstance);
+			return HashValue(hash, draw.instanceCount);
+		};
+		const auto hashCamera = [&snapshot](uint64_t hash)
+		{
+			hash = HashMatrix(hash, snapshot.view);
+			return HashMatrix(hash, snapshot.proj);
+		};
 
-				vkCmdDrawIndexed(
-					commandBuffers[imageIndex],
-					static_cast<uint32_t>(mr->GetMesh()->GetIndexSize()),
-					1,
-					0,
-					0,
-					0);
+		if (chunk.pass == DrawSortKey::GBufferPass)
+		{
+			const SharedMaterial* sm = m_gBufferWriteSharedMaterial;
+			if (!sm->IsCameraFromJoyVariables())
+			{
+				key = hashCamera(key);
+			}
+			for (uint32_t orderIndex = chunk.begin; orderIndex < chunk.end; orderIndex++)
+			{
+				const uint32_t i = snapshot.gBufferOrder[orderIndex];
+				key = hashDraw(key, i);
+				if (!sm->IsInstanced())
+				{
+					key = HashMatrix(key, snapshot.draws[i].model);
+				}
 			}
+			return key;
 		}
-		vkCmdEndRenderPass(commandBuffers[imageIndex]);
 
-		if (vkEndCommandBuffer(commandBuffers[imageIndex]) != VK_SUCCESS)
+		for (const auto& batch : snapshot.batches)
 		{
-			throw std::runtime_error("failed to record command buffer!");
+			const uint32_t batchBegin = std::max(batch.firstDraw, chunk.begin);
+			const uint32_t batchEnd = std::min(batch.firstDraw + batch.drawCount, chunk.end);
+			if (batchBegin >= batchEnd)
+			{
+				continue;
+			}
+			const SharedMaterial* sm = batch.sharedMaterial;
+			key = HashHandle(key, sm->GetPipeline());
+			if (!sm->IsCameraFromJoyVariables())
+			{
+				key = hashCamera(key);
+			}
+			for (uint32_t i = batchBegin; i < batchEnd; i++)
+			{
+				key = hashDraw(key, i);
+				if (!sm->IsBindless())
+				{
+					key = HashHandle(key, snapshot.draws[i].material->GetDescriptorSets()[imageIndex]);
+				}
+				if (!sm->IsInstanced())
+				{
+					key = HashMatrix(key, snapshot.draws[i].model);
+				}
+			}
 		}
+		return key;
 	}
 
 	void RenderManager::ResetCommandBuffers(uint32_t imageIndex) const
@@ -528,6 +1021,7 @@ namespace JoyEngine
 		m_imageAvailableSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
 		m_renderFinishedSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
 		m_inFlightFences.resize(MAX_FRAMES_IN_FLIGHT);
+		m_inFlightFrameCounts.resize(MAX_FRAMES_IN_FLIGHT, 0);
 		m_imagesInFlight.resize(m_swapchain->GetSwapchainImageCount(), VK_NULL_HANDLE);
 
 		VkSemaphoreCreateInfo semaphoreInfo{};
@@ -555,12 +1049,384 @@ namespace JoyEngine
 
 	void RenderManager::Update()
 	{
-		DrawFrame();
+		ASSERT_DESC(m_renderThread.joinable(), "Render thread is not started");
+		UpdateRendererTree();
+		RenderSnapshot* snapshot = m_snapshotQueue.AcquireFree();
+		BuildSnapshot(*snapshot);
+		m_snapshotQueue.Push(snapshot);
+		m_queuedFrameCount++;
 	}
 
-	void RenderManager::DrawFrame()
+	void RenderManager::UpdateRendererTree()
+	{
+		for (const uint32_t transform : TransformSystem::GetInstance()->GetChangedHandles())
+		{
+			if (transform >= m_transformProxies.size())
+			{
+				continue;
+			}
+			for (uint32_t proxy = m_transformProxies[transform];
+			     proxy != BoundingVolumeHierarchy::INVALID_HANDLE;
+			     proxy = m_nextProxies[proxy])
+			{
+				const auto meshRenderer = static_cast<MeshRenderer*>(m_rendererTree.GetUserData(proxy));
+				m_rendererTree.Move(proxy, meshRenderer->GetWorldBounds());
+			}
+		}
+		m_rendererTree.Update();
+	}
+
+	void RenderManager::CullRenderers(const glm::mat4& viewProj)
+	{
+		const Frustum frustum = Frustum::FromMatrix(viewProj);
+		m_visibleRenderers.clear();
+		m_cullCandidates.clear();
+		for (auto& stream : m_cullCenters) stream.clear();
+		for (auto& stream : m_cullExtents) stream.clear();
+
+		m_rendererTree.QueryFrustumBroad(
+			frustum,
+			[this](uint32_t, void* userData)
+			{
+				const auto meshRenderer = static_cast<MeshRenderer*>(userData);
+				if (meshRenderer->IsReady())
+				{
+					m_visibleRenderers.push_back(meshRenderer);
+				}
+			},
+			[this](uint32_t proxy, void* userData)
+			{
+				const auto meshRenderer = static_cast<MeshRenderer*>(userData);
+				if (!meshRenderer->IsReady())
+				{
+					return;
+				}
+				const AABB& bounds = m_rendererTree.GetBounds(proxy);
+				const glm::vec3 center = bounds.GetCenter();
+				const glm::vec3 extents = bounds.GetExtents();
+				for (int i = 0; i < 3; i++)
+				{
+					m_cullCenters[i].push_back(center[i]);
+					m_cullExtents[i].push_back(extents[i]);
+				}
+				m_cullCandidates.push_back(meshRenderer);
+			});
+
+		const auto count = static_cast<uint32_t>(m_cullCandidates.size());
+		const BoundsStreams streams = {
+			{m_cullCenters[0].data(), m_cullCenters[1].data(), m_cullCenters[2].data()},
+			{m_cullExtents[0].data(), m_cullExtents[1].data(), m_cullExtents[2].data()}
+		};
+		const uint32_t grain = std::max(CULL_MIN_CHUNK_SIZE, (JoyContext::Jobs->GetGrainSize(count) + 7) & ~7u);
+		m_cullVisible.resize(count);
+		m_cullChunkCounts.assign((count + grain - 1) / grain, 0);
+		JoyContext::Jobs->ParallelFor(count, [this, &frustum, &streams, grain](uint32_t begin, uint32_t end)
+		{
+			m_cullChunkCounts[begin / grain] = CullingKernels::Cull(frustum, streams, begin, end, m_cullVisible.data() + begin);
+		}, grain);
+
+		m_cullingStats.objectCount = m_rendererTree.GetProxyCount();
+		m_cullingStats.testedCount = count;
+		for (uint32_t chunk = 0; chunk < m_cullChunkCounts.size(); chunk++)
+		{
+			const uint32_t* visible = m_cullVisible.data() + chunk * grain;
+			for (uint32_t i = 0; i < m_cullChunkCounts[chunk]; i++)
+			{
+				m_visibleRenderers.push_back(m_cullCandidates[visible[i]]);
+			}
+		}
+		m_cullingStats.visibleCount = static_cast<uint32_t>(m_visibleRenderers.size());
+	}
+
+	void RenderManager::CullOccludedRenderers(const glm::mat4& viewProj, glm::vec3 cameraPosition)
+	{
+		m_occluders.clear();
+		for (MeshRenderer* mr : m_visibleRenderers)
+		{
+			if (mr->GetMesh()->GetOccluderIndices().empty())
+			{
+				continue;
+			}
+			// roughly the screen area
+			const AABB& bounds = m_rendererTree.GetBounds(mr->m_proxy);
+			const glm::vec3 toCamera = bounds.GetCenter() - cameraPosition;
+			const float distanceSquared = std::max(glm::dot(toCamera, toCamera), 1.0f);
+			m_occluders.emplace_back(bounds.GetHalfArea() / distanceSquared, mr);
+		}
+		std::sort(m_occluders.begin(), m_occluders.end(), [](const auto& a, const auto& b)
+		{
+			return a.first > b.first;
+		});
+
+		m_occlusionBuffer.Begin(viewProj);
+		uint32_t occluderCount = 0;
+		uint32_t triangleCount = 0;
+		for (const auto& [importance, mr] : m_occluders)
+		{
+			const auto occluderTriangleCount = static_cast<uint32_t>(mr->GetMesh()->GetOccluderIndices().size() / 3);
+			if (triangleCount + occluderTriangleCount > MAX_OCCLUDER_TRIANGLES)
+			{
+				continue;
+			}
+			m_occlusionBuffer.AddOccluder(
+				mr->GetTransform()->GetModelMatrix(),
+				mr->GetMesh()->GetOccluderVertices(),
+				mr->GetMesh()->GetOccluderIndices());
+			occluderCount++;
+			triangleCount += occluderTriangleCount;
+		}
+		m_cullingStats.occluderCount = occluderCount;
+		m_cullingStats.occluderTriangleCount = triangleCount;
+		m_cullingStats.occludedCount = 0;
+		if (occluderCount == 0)
+		{
+			return;
+		}
+		m_occlusionBuffer.Rasterize();
+
+		const auto count = static_cast<uint32_t>(m_visibleRenderers.size());
+		m_isRendererVisible.resize(count);
+		JoyContext::Jobs->ParallelFor(count, [this](uint32_t begin, uint32_t end)
+		{
+			for (uint32_t i = begin; i < end; i++)
+			{
+				const AABB& bounds = m_rendererTree.GetBounds(m_visibleRenderers[i]->m_proxy);
+				m_isRendererVisible[i] = m_occlusionBuffer.IsVisible(bounds);
+			}
+		});
+		uint32_t visibleCount = 0;
+		for (uint32_t i = 0; i < count; i++)
+		{
+			if (m_isRendererVisible[i])
+			{
+				m_visibleRenderers[visibleCount++] = m_visibleRenderers[i];
+			}
+		}
+		m_visibleRenderers.resize(visibleCount);
+		m_cullingStats.occludedCount = count - visibleCount;
+		m_cullingStats.visibleCount = visibleCount;
+	}
+
+	void RenderManager::BuildSnapshot(RenderSnapshot& snapshot)
+	{
+		snapshot.Clear();
+		snapshot.frameIndex = m_queuedFrameCount;
+
+		ASSERT(m_currentCamera != nullptr);
+		snapshot.view = m_currentCamera->GetViewMatrix();
+		snapshot.proj = m_currentCamera->GetProjMatrix();
+		snapshot.cameraPosition = m_currentCamera->GetTransform()->GetPosition();
+		snapshot.time = Time::GetTime();
+		snapshot.deltaTime = Time::GetDeltaTime();
+		snapshot.isGpuCullingEnabled = m_isGpuOcclusionCullingEnabled;
+		snapshot.resourceGeneration = m_resourceGeneration;
+
+		const glm::mat4 viewProj = snapshot.proj * snapshot.view;
+		CullRenderers(viewProj);
+		if (m_isOcclusionCullingEnabled)
+		{
+			CullOccludedRenderers(viewProj, snapshot.cameraPosition);
+		}
+		else
+		{
+			m_cullingStats.occluderCount = 0;
+			m_cullingStats.occluderTriangleCount = 0;
+			m_cullingStats.occludedCount = 0;
+		}
+		// Every renderer is a packet of the G-buffer pass and a packet of the material pass,
+		// packets of a pass are sorted by state and then front to back
+		const auto count = static_cast<uint32_t>(m_visibleRenderers.size());
+		const float farPlane = m_currentCamera->GetFar();
+		m_sortItems.resize(count * 2);
+		for (uint32_t i = 0; i < count; i++)
+		{
+			const MeshRenderer* mr = m_visibleRenderers[i];
+			const Material* material = mr->GetMaterial();
+			const glm::vec3 center = m_rendererTree.GetBounds(mr->m_proxy).GetCenter();
+			const float depth = -(snapshot.view * glm::vec4(center, 1.0f)).z;
+			const auto quantizedDepth = static_cast<uint32_t>(
+				std::clamp(depth / farPlane, 0.0f, 1.0f) * static_cast<float>(DrawSortKey::DEPTH_MASK));
+			const uint32_t mesh = DrawSortKey::GetId(mr->GetMesh()->GetGuid());
+
+			m_sortItems[i] = {DrawSortKey::Make(DrawSortKey::GBufferPass, 0, 0, mesh, quantizedDepth), i};
+			m_sortItems[count + i] = {
+				DrawSortKey::Make(
+					DrawSortKey::MaterialPass,
+					m_sharedMaterials.at(material->GetSharedMaterial()),
+					DrawSortKey::GetId(material->GetGuid()),
+					mesh,
+					quantizedDepth),
+				i
+			};
+		}
+		m_radixSort.Sort(m_sortItems);
+
+		// Draws are in material pass order, G-buffer pass goes through them in its own order.
+		// Neighbours with the same mesh and material are instances of one draw if both pipelines allow it.
+		// With GPU culling instances are culled together, so their count is limited
+		const bool isGBufferInstanced = m_gBufferWriteSharedMaterial->IsInstanced();
+		const uint32_t maxInstanceCount = snapshot.isGpuCullingEnabled ? MAX_GPU_CULLED_INSTANCE_COUNT : UINT32_MAX;
+		m_rendererDraws.resize(count);
+		for (uint32_t i = count; i < count * 2; i++)
+		{
+			MeshRenderer* mr = m_visibleRenderers[m_sortItems[i].value];
+			const Mesh* mesh = mr->GetMesh();
+			Material* material = mr->GetMaterial();
+			SharedMaterial* sm = material->GetSharedMaterial();
+			const AABB& bounds = m_rendererTree.GetBounds(mr->m_proxy);
+			snapshot.instances.push_back({mr->GetTransform()->GetModelMatrix(), material->GetBindlessSlot()});
+
+			if (!snapshot.draws.empty())
+			{
+				RenderDraw& last = snapshot.draws.back();
+				if (isGBufferInstanced && sm->IsInstanced() &&
+					last.material == material &&
+					last.vertexBuffer == mesh->GetVertexBuffer() &&
+					last.firstIndex == mesh->GetFirstIndex() &&
+					last.vertexOffset == mesh->GetVertexOffset() &&
+					last.instanceCount < maxInstanceCount)
+				{
+					last.bounds = AABB::Union(last.bounds, bounds);
+					last.instanceCount++;
+					m_rendererDraws[m_sortItems[i].value] = static_cast<uint32_t>(snapshot.draws.size() - 1);
+					continue;
+				}
+			}
+
+			m_rendererDraws[m_sortItems[i].value] = static_cast<uint32_t>(snapshot.draws.size());
+			if (snapshot.batches.empty() || snapshot.batches.back().sharedMaterial != sm)
+			{
+				snapshot.batches.push_back({sm, static_cast<uint32_t>(snapshot.draws.size()), 0});
+			}
+			snapshot.draws.push_back({
+				snapshot.instances.back().model,
+				mesh->GetVertexBuffer(),
+				mesh->GetIndexBuffer(),
+				static_cast<uint32_t>(mesh->GetIndexSize()),
+				mesh->GetFirstIndex(),
+				mesh->GetVertexOffset(),
+				material,
+				bounds,
+				mr->m_proxy,
+				static_cast<uint32_t>(snapshot.instances.size() - 1),
+				1
+			});
+			snapshot.batches.back().drawCount++;
+		}
+		// a draw takes the place of its first instance in G-buffer pass order
+		m_isDrawOrdered.assign(snapshot.draws.size(), 0);
+		for (uint32_t i = 0; i < count; i++)
+		{
+			const uint32_t draw = m_rendererDraws[m_sortItems[i].value];
+			if (!m_isDrawOrdered[draw])
+			{
+				m_isDrawOrdered[draw] = 1;
+				snapshot.gBufferOrder.push_back(draw);
+			}
+		}
+
+		CountBinds(snapshot);
+	}
+
+	void RenderManager::CountBinds(const RenderSnapshot& snapshot)
+	{
+		m_drawStats = DrawStats();
+		// first phase of GPU culling records G-buffer pass once more
+		const uint32_t gBufferPassCount = snapshot.isGpuCullingEnabled ? 2 : 1;
+		m_drawStats.drawCount = static_cast<uint32_t>(snapshot.gBufferOrder.size() * gBufferPassCount + snapshot.draws.size());
+		m_drawStats.instanceCount = static_cast<uint32_t>(snapshot.instances.size());
+		if (snapshot.draws.empty())
+		{
+			return;
+		}
+
+		// every chunk recorded into a secondary command buffer binds its own state, see WriteCommandBuffers
+		const auto gBufferCount = static_cast<uint32_t>(snapshot.gBufferOrder.size());
+		const uint32_t gBufferChunkSize = GetRecordChunkSize(gBufferCount);
+		const auto gBufferDefineCount = static_cast<uint32_t>(m_gBufferWriteSharedMaterial->GetBindingDefines().size());
+		uint32_t gBufferPipelineBindCount = 0;
+		uint32_t gBufferVertexBufferBindCount = 0;
+		VkBuffer boundVertexBuffer = VK_NULL_HANDLE;
+		for (uint32_t i = 0; i < gBufferCount; i++)
+		{
+			if (i % gBufferChunkSize == 0)
+			{
+				gBufferPipelineBindCount++;
+				// instance buffer
+				gBufferVertexBufferBindCount++;
+				boundVertexBuffer = VK_NULL_HANDLE;
+			}
+			const RenderDraw& draw = snapshot.draws[snapshot.gBufferOrder[i]];
+			if (draw.vertexBuffer != boundVertexBuffer)
+			{
+				boundVertexBuffer = draw.vertexBuffer;
+				gBufferVertexBufferBindCount++;
+			}
+		}
+		m_drawStats.pipelineBindCount = gBufferPipelineBindCount * gBufferPassCount;
+		m_drawStats.descriptorSetBindCount = gBufferPipelineBindCount * gBufferDefineCount * gBufferPassCount;
+		m_drawStats.vertexBufferBindCount = gBufferVertexBufferBindCount * gBufferPassCount;
+
+		const auto drawCount = static_cast<uint32_t>(snapshot.draws.size());
+		const uint32_t materialChunkSize = GetRecordChunkSize(drawCount);
+		for (uint32_t begin = 0; begin < drawCount; begin += materialChunkSize)
+		{
+			const uint32_t end = std::min(begin + materialChunkSize, drawCount);
+			m_drawStats.vertexBufferBindCount++;
+			boundVertexBuffer = VK_NULL_HANDLE;
+			for (const auto& batch : snapshot.batches)
+			{
+				const uint32_t batchBegin = std::max(batch.firstDraw, begin);
+				const uint32_t batchEnd = std::min(batch.firstDraw + batch.drawCount, end);
+				if (batchBegin >= batchEnd)
+				{
+					continue;
+				}
+				m_drawStats.pipelineBindCount++;
+				m_drawStats.descriptorSetBindCount += static_cast<uint32_t>(batch.sharedMaterial->GetBindingDefines().size());
+				const Material* boundMaterial = nullptr;
+				for (uint32_t i = batchBegin; i < batchEnd; i++)
+				{
+					const RenderDraw& draw = snapshot.draws[i];
+					if (draw.vertexBuffer != boundVertexBuffer)
+					{
+						boundVertexBuffer = draw.vertexBuffer;
+						m_drawStats.vertexBufferBindCount++;
+					}
+					if (!batch.sharedMaterial->IsBindless() && draw.material != boundMaterial)
+					{
+						boundMaterial = draw.material;
+						m_drawStats.descriptorSetBindCount++;
+					}
+				}
+			}
+		}
+	}
+
+	uint32_t RenderManager::GetRecordChunkSize(uint32_t count) const noexcept
+	{
+		return std::max(MIN_RECORD_CHUNK_SIZE, JoyContext::Jobs->GetGrainSize(count));
+	}
+
+	void RenderManager::RenderThreadLoop()
+	{
+		// records chunks of frames with workers, see WriteCommandBuffers
+		JoyContext::Jobs->AttachThread();
+		while (RenderSnapshot* snapshot = m_snapshotQueue.Pop())
+		{
+			DrawFrame(*snapshot);
+			m_snapshotQueue.Release(snapshot);
+		}
+	}
+
+	void RenderManager::DrawFrame(const RenderSnapshot& snapshot)
 	{
 		vkWaitForFences(JoyContext::Graphics->GetDevice(), 1, &m_inFlightFences[currentFrame], VK_TRUE, UINT64_MAX);
+		// fences are signaled in submission order, so every frame up to this one is finished
+		if (m_inFlightFrameCounts[currentFrame] != 0)
+		{
+			m_completedFrameCount.store(m_inFlightFrameCounts[currentFrame], std::memory_order_release);
+		}
 
 		uint32_t imageIndex;
 		VkResult result = vkAcquireNextImageKHR(JoyContext::Graphics->GetDevice(),
@@ -574,11 +1440,9 @@ namespace JoyEngine
 		{
 			throw std::runtime_error("failed to acquire swap chain image!");
 		}
-		m_commonDescriptorSetProvider->UpdateDescriptorSetData(imageIndex);
-		ResetCommandBuffers(imageIndex);
-		WriteCommandBuffers(imageIndex);
 
-		// Check if a previous frame is using this image (i.e. there is its fence to wait on)
+		// Check if a previous frame is using this image (i.e. there is its fence to wait on).
+		// Waited before recording, command buffer and uniform buffer of the image are reused
 		if (m_imagesInFlight[imageIndex] != VK_NULL_HANDLE)
 		{
 			vkWaitForFences(JoyContext::Graphics->GetDevice(),
@@ -588,6 +1452,15 @@ namespace JoyEngine
 			                UINT64_MAX);
 		}
 
+		if (m_commonDescriptorSetProvider->UpdateDescriptorSetData(imageIndex, snapshot))
+		{
+			m_secondaryCommandBuffers->Invalidate(imageIndex);
+		}
+		UploadInstances(imageIndex, snapshot);
+		const bool isGpuCulled = snapshot.isGpuCullingEnabled && m_hiZCulling->Prepare(imageIndex, snapshot);
+		ResetCommandBuffers(imageIndex);
+		WriteCommandBuffers(imageIndex, snapshot, isGpuCulled);
+
 		// Mark the image as now being in use by this frame
 		m_imagesInFlight[imageIndex] = m_inFlightFences[currentFrame];
 		vkResetFences(JoyContext::Graphics->GetDevice(), 1, &m_inFlightFences[currentFrame]);
@@ -608,11 +1481,13 @@ namespace JoyEngine
 			signalSemaphores
 		};
 
+		std::unique_lock<std::mutex> queueLock(JoyContext::Graphics->GetQueueMutex());
 		if (vkQueueSubmit(JoyContext::Graphics->GetGraphicsQueue(), 1, &submitInfo,
 		                  m_inFlightFences[currentFrame]) != VK_SUCCESS)
 		{
 			throw std::runtime_error("failed to submit draw command buffer!");
 		}
+		m_inFlightFrameCounts[currentFrame] = snapshot.frameIndex + 1;
 
 		VkSwapchainKHR swapChains[] = {m_swapchain->GetSwapChain()};
 		VkPresentInfoKHR presentInfo{
@@ -626,6 +1501,7 @@ namespace JoyEngine
 			nullptr
 		};
 		result = vkQueuePresentKHR(JoyContext::Graphics->GetPresentQueue(), &presentInfo);
+		queueLock.unlock();
 		if (result != VK_SUCCESS)
 		{
 			throw std::runtime_error("failed to present swap chain image!");
@@ -659,4 +1535,9 @@ namespace JoyEngine
 	{
 		return m_commonDescriptorSetProvider->GetBindingData(defineHash);
 	}
+
+	BindlessRegistry* RenderManager::GetBindlessRegistry() const noexcept
+	{
+		return m_commonDescriptorSetProvider->GetBindlessRegistry();
+	}
 }
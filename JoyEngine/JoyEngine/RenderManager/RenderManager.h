@@ -9,6 +9,8 @@
 #include <chrono>
 #include <map>
 #include <memory>
+#include <thread>
+#include <atomic>
 
 #include <vulkan/vulkan.h>
 
@@ -17,14 +19,49 @@
 
 #include "Components/MeshRenderer.h"
 #include "Components/Camera.h"
+#include "SceneManager/BoundingVolumeHierarchy.h"
 #include "Swapchain.h"
 #include "RenderPass.h"
 #include "RenderManager/Attachment.h"
+#include "RenderSnapshot.h"
+#include "OcclusionBuffer.h"
+#include "HiZCulling.h"
+#include "SecondaryCommandBuffers.h"
+#include "DrawSortKey.h"
+#include "Common/RadixSort.h"
 
 namespace JoyEngine
 {
 	class RenderObject;
 
+	struct CullingStats
+	{
+		// enabled mesh renderers
+		uint32_t objectCount = 0;
+		// boxes tested one by one, the rest were accepted or rejected by the tree
+		uint32_t testedCount = 0;
+		// renderers drawn into occlusion buffer and their triangles
+		uint32_t occluderCount = 0;
+		uint32_t occluderTriangleCount = 0;
+		// inside the frustum, but hidden by occluders
+		uint32_t occludedCount = 0;
+		uint32_t visibleCount = 0;
+	};
+
+	// state changes recorded for the last queued frame, counted from its snapshot
+	struct DrawStats
+	{
+		uint32_t drawCount = 0;
+		// visible renderers, instanced ones share draws
+		uint32_t instanceCount = 0;
+		uint32_t pipelineBindCount = 0;
+		uint32_t descriptorSetBindCount = 0;
+		uint32_t vertexBufferBindCount = 0;
+	};
+
+	// Game thread registers cameras and materials and queues a snapshot of the scene every Update.
+	// Render thread records and submits frames from snapshots, so simulation of the next frame
+	// overlaps recording and submission of the previous one
 	class RenderManager
 	{
 	public:
@@ -34,16 +71,15 @@ namespace JoyEngine
 
 		void Init();
 
-		void Start()
-		{
-		}
+		// starts render thread
+		void Start();
 
+		// waits for queued frames and stops render thread
 		void Stop();
 
+		// game thread, waits if render thread is a frame behind
 		void Update();
 
-		void DrawFrame();
-
 		void RegisterSharedMaterial(SharedMaterial* sharedMaterial);
 
 		void UnregisterSharedMaterial(SharedMaterial* sharedMaterial);
@@ -52,6 +88,27 @@ namespace JoyEngine
 
 		void UnregisterCamera(Camera* camera);
 
+		// keeps world bounds of the renderer in the renderer tree up to date while it's enabled
+		void RegisterMeshRenderer(MeshRenderer* meshRenderer);
+
+		void UnregisterMeshRenderer(MeshRenderer* meshRenderer);
+
+		// world bounds of enabled mesh renderers as of the last Update, user data is MeshRenderer*.
+		// Game thread only
+		[[nodiscard]] const BoundingVolumeHierarchy& GetRendererTree() const noexcept { return m_rendererTree; }
+
+		// counters of the last queued frame
+		[[nodiscard]] const CullingStats& GetCullingStats() const noexcept { return m_cullingStats; }
+
+		[[nodiscard]] const DrawStats& GetDrawStats() const noexcept { return m_drawStats; }
+
+		void SetOcclusionCulling(bool isEnabled) noexcept { m_isOcclusionCullingEnabled = isEnabled; }
+
+		// draws from CPU culling are culled again on GPU against depth pyramid, from the next queued frame
+		void SetGpuOcclusionCulling(bool isEnabled) noexcept { m_isGpuOcclusionCullingEnabled = isEnabled; }
+
+		[[nodiscard]] Camera* GetCurrentCamera() const noexcept;
+
 		[[nodiscard]] Swapchain* GetSwapchain() const noexcept;
 
 		[[nodiscard]] VkRenderPass GetMainRenderPass() const noexcept;
@@ -60,15 +117,87 @@ namespace JoyEngine
 		[[nodiscard]] Texture* GetGBufferPositionTexture() const noexcept;
 		[[nodiscard]] Texture* GetGBufferNormalTexture() const noexcept;
 		SharedBindingData* GetBindingDataForDefine(uint32_t defineHash) const;
+		[[nodiscard]] BindlessRegistry* GetBindlessRegistry() const noexcept;
+
+		// snapshots queued by game thread since start
+		[[nodiscard]] uint64_t GetQueuedFrameCount() const noexcept { return m_queuedFrameCount; }
+
+		// frames finished by GPU, resources released before that many frames were queued are not used anymore
+		[[nodiscard]] uint64_t GetCompletedFrameCount() const noexcept
+		{
+			return m_completedFrameCount.load(std::memory_order_acquire);
+		}
+
+		// game thread, command buffers recorded before may reference the retired resource.
+		// They are recorded again from the next queued snapshot
+		void OnResourceRetired() noexcept { m_resourceGeneration++; }
 
 	private:
+		// moves proxies of renderers whose transforms changed in this frame
+		void UpdateRendererTree();
+
+		// Fills m_visibleRenderers. Renderer tree rejects and accepts whole subtrees,
+		// boxes of renderers on the frustum boundary are tested in SIMD batches on workers
+		void CullRenderers(const glm::mat4& viewProj);
+
+		// Removes renderers hidden by the nearest and biggest visible occluders from m_visibleRenderers
+		void CullOccludedRenderers(const glm::mat4& viewProj, glm::vec3 cameraPosition);
+
+		// draws of renderers visible from the current camera in sort key order, see DrawSortKey
+		void BuildSnapshot(RenderSnapshot& snapshot);
+
+		// binds WriteCommandBuffers will record for the snapshot, into m_drawStats
+		void CountBinds(const RenderSnapshot& snapshot);
+
+		void RenderThreadLoop();
+
+		void DrawFrame(const RenderSnapshot& snapshot);
+
+		// copies instance data of the snapshot into the instance buffer of the image, grows it if needed
+		void UploadInstances(uint32_t imageIndex, const RenderSnapshot& snapshot);
+
 		void CreateRenderPass();
 
 		void CreateFramebuffers();
 
 		void CreateCommandBuffers();
 
-		void WriteCommandBuffers(uint32_t imageIndex) const;
+		// Draws of the snapshot are recorded in chunks on workers into secondary command buffers.
+		// Chunks whose keys didn't change since the previous frame of the image are not recorded again
+		void WriteCommandBuffers(uint32_t imageIndex, const RenderSnapshot& snapshot, bool isGpuCulled);
+
+		void BindDefines(VkCommandBuffer commandBuffer, uint32_t imageIndex, SharedMaterial* sharedMaterial) const;
+
+		// with view and projection unless the pipeline reads them from JOY_VARIABLES
+		void PushModel(VkCommandBuffer commandBuffer, SharedMaterial* sharedMaterial, const RenderSnapshot& snapshot,
+		               const glm::mat4& model) const;
+
+		// range of G-buffer pass order
+		void RecordGBufferDraws(VkCommandBuffer commandBuffer, uint32_t imageIndex, const RenderSnapshot& snapshot,
+		                        bool isGpuCulled, HiZCulling::Phase phase, uint32_t begin, uint32_t end) const;
+
+		// range of draws, batches are clipped to it
+		void RecordMaterialDraws(VkCommandBuffer commandBuffer, uint32_t imageIndex, const RenderSnapshot& snapshot,
+		                         bool isGpuCulled, uint32_t begin, uint32_t end) const;
+
+		void RecordDraw(VkCommandBuffer commandBuffer, const RenderSnapshot& snapshot, bool isGpuCulled,
+		                uint32_t drawIndex, HiZCulling::Phase phase) const;
+
+		// draws or G-buffer packets recorded into one secondary command buffer
+		[[nodiscard]] uint32_t GetRecordChunkSize(uint32_t count) const noexcept;
+
+		// part of a pass recorded by one job, see WriteCommandBuffers
+		struct RecordChunk
+		{
+			DrawSortKey::Pass pass;
+			HiZCulling::Phase phase;
+			uint32_t begin;
+			uint32_t end;
+		};
+
+		// hash of everything the chunk records, values which are read from buffers are left out
+		[[nodiscard]] uint64_t GetChunkKey(uint32_t imageIndex, const RenderSnapshot& snapshot, bool isGpuCulled,
+		                                   const RecordChunk& chunk) const;
 
 		void ResetCommandBuffers(uint32_t imageIndex) const;
 
@@ -76,27 +205,91 @@ namespace JoyEngine
 
 	private:
 		const int MAX_FRAMES_IN_FLIGHT = 2;
+		// one snapshot is recorded while the next one is built
+		static constexpr uint32_t SNAPSHOT_COUNT = 2;
 		ResourceHandle<SharedMaterial> m_gBufferWriteSharedMaterial;
 		std::unique_ptr<CommonDescriptorSetProvider> m_commonDescriptorSetProvider;
 
 		std::unique_ptr<Swapchain> m_swapchain;
 		std::unique_ptr<RenderPass> m_renderPass;
+		// compatible with m_renderPass, G-buffer is drawn in two phases around GPU occlusion culling
+		std::unique_ptr<RenderPass> m_firstPhaseRenderPass;
+		std::unique_ptr<RenderPass> m_secondPhaseRenderPass;
 		std::unique_ptr<Texture> m_depthAttachment;
 		std::unique_ptr<Texture> m_positionAttachment;
 		std::unique_ptr<Texture> m_normalAttachment;
 
 
-		std::set<SharedMaterial*> m_sharedMaterials;
-		Camera* m_currentCamera;
+		// pipeline id in draw sort keys by shared material, ids of unregistered materials are reused
+		std::map<SharedMaterial*, uint32_t> m_sharedMaterials;
+		std::vector<uint32_t> m_freeSharedMaterialIds;
+		Camera* m_currentCamera = nullptr;
+
+		BoundingVolumeHierarchy m_rendererTree;
+		// first proxy of renderers of every transform by transform handle, the rest are linked through m_nextProxies
+		std::vector<uint32_t> m_transformProxies;
+		std::vector<uint32_t> m_nextProxies;
+		// scratch of CullRenderers and BuildSnapshot
+		std::vector<MeshRenderer*> m_visibleRenderers;
+		std::vector<MeshRenderer*> m_cullCandidates;
+		std::vector<float> m_cullCenters[3];
+		std::vector<float> m_cullExtents[3];
+		// visible candidate indices, every chunk writes from its begin
+		std::vector<uint32_t> m_cullVisible;
+		std::vector<uint32_t> m_cullChunkCounts;
+		CullingStats m_cullingStats;
+		// scratch of BuildSnapshot, G-buffer pass packets of visible renderers followed by material pass ones
+		std::vector<SortItem> m_sortItems;
+		// draw index by visible renderer index
+		std::vector<uint32_t> m_rendererDraws;
+		std::vector<uint8_t> m_isDrawOrdered;
+		// bounds of a draw are the union of its instances, so GPU culled draws are kept small
+		static constexpr uint32_t MAX_GPU_CULLED_INSTANCE_COUNT = 64;
+		RadixSort m_radixSort;
+		DrawStats m_drawStats;
+
+		OcclusionBuffer m_occlusionBuffer;
+		bool m_isOcclusionCullingEnabled = true;
+		// scratch of CullOccludedRenderers
+		std::vector<std::pair<float, MeshRenderer*>> m_occluders;
+		std::vector<uint8_t> m_isRendererVisible;
+		std::unique_ptr<HiZCulling> m_hiZCulling;
+		bool m_isGpuOcclusionCullingEnabled = true;
+		// per swapchain image, written by render thread before recording
+		std::vector<std::unique_ptr<Buffer>> m_instanceBuffers;
+		std::vector<uint32_t> m_instanceCapacities;
+		static constexpr uint32_t MIN_INSTANCE_CAPACITY = 1024;
+		// occluders are drawn until the budget is spent, the most important first
+		static constexpr uint32_t MAX_OCCLUDER_TRIANGLES = 8192;
+		// multiple of 8, so every chunk but the last is whole AVX batches
+		static constexpr uint32_t CULL_MIN_CHUNK_SIZE = 256;
 
 		std::vector<VkFramebuffer> m_swapChainFramebuffers;
+		// render thread records from its own pool, pools are externally synchronized
+		VkCommandPool m_commandPool = VK_NULL_HANDLE;
 		std::vector<VkCommandBuffer> commandBuffers;
+		std::unique_ptr<SecondaryCommandBuffers> m_secondaryCommandBuffers;
+
+		// render thread only, secondary command buffer of every chunk in execution order
+		std::vector<RecordChunk> m_recordChunks;
+		std::vector<VkCommandBuffer> m_recordCommandBuffers;
+		// smaller chunks cost more in rebinding state than they save
+		static constexpr uint32_t MIN_RECORD_CHUNK_SIZE = 256;
 
 		std::vector<VkSemaphore> m_imageAvailableSemaphores;
 		std::vector<VkSemaphore> m_renderFinishedSemaphores;
 		std::vector<VkFence> m_inFlightFences;
 		std::vector<VkFence> m_imagesInFlight;
 		size_t currentFrame = 0;
+		// frame count of the snapshot submitted with each in flight fence, 0 if none
+		std::vector<uint64_t> m_inFlightFrameCounts;
+
+		RenderSnapshotQueue m_snapshotQueue{SNAPSHOT_COUNT};
+		std::thread m_renderThread;
+		uint64_t m_queuedFrameCount = 0;
+		// game thread, see OnResourceRetired
+		uint64_t m_resourceGeneration = 0;
+		std::atomic<uint64_t> m_completedFrameCount = 0;
 	};
 }
 
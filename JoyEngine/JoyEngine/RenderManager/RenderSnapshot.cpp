@@ -0,0 +1,66 @@
+#include "RenderSnapshot.h"
+
+#include "Utils/Assert.h"
+
+namespace JoyEngine
+{
+	RenderSnapshotQueue::RenderSnapshotQueue(uint32_t snapshotCount)
+	{
+		ASSERT(snapshotCount >= 2);
+		for (uint32_t i = 0; i < snapshotCount; i++)
+		{
+			m_snapshots.push_back(std::make_unique<RenderSnapshot>());
+			m_freeSnapshots.push_back(m_snapshots.back().get());
+		}
+	}
+
+	RenderSnapshot* RenderSnapshotQueue::AcquireFree()
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_condition.wait(lock, [this]() { return !m_freeSnapshots.empty(); });
+		RenderSnapshot* snapshot = m_freeSnapshots.back();
+		m_freeSnapshots.pop_back();
+		return snapshot;
+	}
+
+	void RenderSnapshotQueue::Push(RenderSnapshot* snapshot)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			ASSERT_DESC(!m_isStopped, "Snapshot is pushed after render thread was stopped");
+			m_queuedSnapshots.push_back(snapshot);
+		}
+		m_condition.notify_all();
+	}
+
+	RenderSnapshot* RenderSnapshotQueue::Pop()
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_condition.wait(lock, [this]() { return !m_queuedSnapshots.empty() || m_isStopped; });
+		if (m_queuedSnapshots.empty())
+		{
+			return nullptr;
+		}
+		RenderSnapshot* snapshot = m_queuedSnapshots.front();
+		m_queuedSnapshots.pop_front();
+		return snapshot;
+	}
+
+	void RenderSnapshotQueue::Release(RenderSnapshot* snapshot)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_freeSnapshots.push_back(snapshot);
+		}
+		m_condition.notify_all();
+	}
+
+	void RenderSnapshotQueue::Stop()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_isStopped = true;
+		}
+		m_condition.notify_all();
+	}
+}
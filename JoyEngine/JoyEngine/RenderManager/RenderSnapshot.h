@@ -0,0 +1,124 @@
+#ifndef RENDER_SNAPSHOT_H
+#define RENDER_SNAPSHOT_H
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+
+#include <vulkan/vulkan.h>
+#include <glm/glm.hpp>
+
+#include "Common/Bounds.h"
+#include "RenderManager/VulkanTypes.h"
+
+namespace JoyEngine
+{
+	class Material;
+
+	class SharedMaterial;
+
+	// Renderers with the same mesh and material are drawn as instances of one draw
+	// when pipelines of both passes are instanced
+	struct RenderDraw
+	{
+		// of the first instance, pipelines without instancing draw a single instance with it
+		glm::mat4 model;
+		// geometry pool page and the place of the mesh in it
+		VkBuffer vertexBuffer;
+		VkBuffer indexBuffer;
+		uint32_t indexCount;
+		uint32_t firstIndex;
+		int32_t vertexOffset;
+		// of the first instance, descriptor sets of the material are read by swapchain image index.
+		// Instances of bindless materials may have other materials of the same shared material
+		Material* material;
+		// world bounds of all instances for GPU culling
+		AABB bounds;
+		// stable while the first renderer is enabled, GPU culling remembers visibility by it
+		uint32_t visibilityIndex;
+		// range of RenderSnapshot::instances
+		uint32_t firstInstance;
+		uint32_t instanceCount;
+	};
+
+	// draws of one shared material are contiguous, in material pass sort key order
+	struct RenderBatch
+	{
+		SharedMaterial* sharedMaterial;
+		uint32_t firstDraw;
+		uint32_t drawCount;
+	};
+
+	// Everything render thread needs to record a frame, written by game thread and immutable after it's queued.
+	// References only resources, they are released after GPU has finished frames which could use them
+	struct RenderSnapshot
+	{
+		uint64_t frameIndex = 0;
+
+		glm::mat4 view;
+		glm::mat4 proj;
+		glm::vec3 cameraPosition;
+		float time = 0;
+		float deltaTime = 0;
+		bool isGpuCullingEnabled = false;
+		// changes when a resource is retired, command buffers recorded with older snapshots may reference it
+		uint64_t resourceGeneration = 0;
+
+		std::vector<RenderBatch> batches;
+		std::vector<RenderDraw> draws;
+		// draw indices in G-buffer pass sort key order
+		std::vector<uint32_t> gBufferOrder;
+		// instance per visible renderer, in draw order
+		std::vector<InstanceData> instances;
+
+		// keeps capacity, so steady state frames don't allocate
+		void Clear() noexcept
+		{
+			batches.clear();
+			draws.clear();
+			gBufferOrder.clear();
+			instances.clear();
+		}
+	};
+
+	// Bounded queue of snapshots between game and render threads.
+	// Game thread fills a free snapshot while render thread records the previous one
+	// and waits when all snapshots are queued, so it is never more than snapshotCount - 1 frames ahead
+	class RenderSnapshotQueue
+	{
+	public:
+		explicit RenderSnapshotQueue(uint32_t snapshotCount);
+
+		RenderSnapshotQueue(const RenderSnapshotQueue&) = delete;
+
+		RenderSnapshotQueue& operator=(const RenderSnapshotQueue&) = delete;
+
+		// game thread, waits until render thread releases a snapshot
+		[[nodiscard]] RenderSnapshot* AcquireFree();
+
+		// game thread
+		void Push(RenderSnapshot* snapshot);
+
+		// render thread, waits for a queued snapshot. nullptr after Stop when queue is drained
+		[[nodiscard]] RenderSnapshot* Pop();
+
+		// render thread, snapshot can be reused
+		void Release(RenderSnapshot* snapshot);
+
+		void Stop();
+
+	private:
+		std::vector<std::unique_ptr<RenderSnapshot>> m_snapshots;
+
+		std::mutex m_mutex;
+		std::condition_variable m_condition;
+		std::vector<RenderSnapshot*> m_freeSnapshots;
+		std::deque<RenderSnapshot*> m_queuedSnapshots;
+		bool m_isStopped = false;
+	};
+}
+
+#endif //RENDER_SNAPSHOT_H
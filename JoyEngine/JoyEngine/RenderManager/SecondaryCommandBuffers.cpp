@@ -0,0 +1,89 @@
+#include "SecondaryCommandBuffers.h"
+
+#include "JoyContext.h"
+#include "GraphicsManager/GraphicsManager.h"
+#include "Utils/Assert.h"
+
+namespace JoyEngine
+{
+	SecondaryCommandBuffers::SecondaryCommandBuffers(uint32_t imageCount) :
+		m_chunks(imageCount)
+	{
+	}
+
+	SecondaryCommandBuffers::~SecondaryCommandBuffers()
+	{
+		// command buffers are freed with their pools
+		for (const auto& chunks : m_chunks)
+		{
+			for (const auto& chunk : chunks)
+			{
+				vkDestroyCommandPool(
+					JoyContext::Graphics->GetDevice(),
+					chunk.pool,
+					JoyContext::Graphics->GetAllocationCallbacks());
+			}
+		}
+	}
+
+	void SecondaryCommandBuffers::Resize(uint32_t imageIndex, uint32_t chunkCount)
+	{
+		std::vector<Chunk>& chunks = m_chunks[imageIndex];
+		const auto oldCount = static_cast<uint32_t>(chunks.size());
+		if (chunkCount <= oldCount)
+		{
+			return;
+		}
+		chunks.resize(chunkCount);
+
+		const VkCommandPoolCreateInfo poolInfo = {
+			VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+			nullptr,
+			0,
+			JoyContext::Graphics->GetGraphicsQueueFamily()
+		};
+		for (uint32_t i = oldCount; i < chunkCount; i++)
+		{
+			VkResult res = vkCreateCommandPool(
+				JoyContext::Graphics->GetDevice(),
+				&poolInfo,
+				JoyContext::Graphics->GetAllocationCallbacks(),
+				&chunks[i].pool);
+			ASSERT(res == VK_SUCCESS);
+
+			const VkCommandBufferAllocateInfo allocInfo = {
+				VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+				nullptr,
+				chunks[i].pool,
+				VK_COMMAND_BUFFER_LEVEL_SECONDARY,
+				1
+			};
+			res = vkAllocateCommandBuffers(JoyContext::Graphics->GetDevice(), &allocInfo, &chunks[i].commandBuffer);
+			ASSERT(res == VK_SUCCESS);
+		}
+	}
+
+	void SecondaryCommandBuffers::Invalidate(uint32_t imageIndex)
+	{
+		for (auto& chunk : m_chunks[imageIndex])
+		{
+			chunk.isRecorded = false;
+		}
+	}
+
+	bool SecondaryCommandBuffers::IsRecorded(uint32_t imageIndex, uint32_t chunk, uint64_t key) const noexcept
+	{
+		const Chunk& c = m_chunks[imageIndex][chunk];
+		return c.isRecorded && c.key == key;
+	}
+
+	VkCommandBuffer SecondaryCommandBuffers::Reset(uint32_t imageIndex, uint32_t chunk, uint64_t key)
+	{
+		Chunk& c = m_chunks[imageIndex][chunk];
+		// previous frame of the image has finished, nothing executes the command buffer
+		vkResetCommandPool(JoyContext::Graphics->GetDevice(), c.pool, 0);
+		c.key = key;
+		c.isRecorded = true;
+		return c.commandBuffer;
+	}
+}
@@ -0,0 +1,57 @@
+#ifndef SECONDARY_COMMAND_BUFFERS_H
+#define SECONDARY_COMMAND_BUFFERS_H
+
+#include <vector>
+#include <cstdint>
+
+#include <vulkan/vulkan.h>
+
+namespace JoyEngine
+{
+	// Secondary command buffers of draw chunks per swapchain image. A chunk keeps its command buffer
+	// while the key of what it records stays the same, so only changed chunks are recorded again.
+	// Every chunk has its own pool, any worker can record it without synchronizing with others
+	class SecondaryCommandBuffers
+	{
+	public:
+		explicit SecondaryCommandBuffers(uint32_t imageCount);
+
+		~SecondaryCommandBuffers();
+
+		SecondaryCommandBuffers(const SecondaryCommandBuffers&) = delete;
+
+		SecondaryCommandBuffers& operator=(const SecondaryCommandBuffers&) = delete;
+
+		// render thread, before chunks of the image are recorded. Chunks past the count are kept for later frames
+		void Resize(uint32_t imageIndex, uint32_t chunkCount);
+
+		// render thread, descriptor sets or buffers which recorded chunks of the image use have changed
+		void Invalidate(uint32_t imageIndex);
+
+		// command buffer of the chunk was recorded with the key and can be executed again
+		[[nodiscard]] bool IsRecorded(uint32_t imageIndex, uint32_t chunk, uint64_t key) const noexcept;
+
+		// resets command buffer of the chunk for recording with the key, a chunk is recorded by one worker at a time
+		[[nodiscard]] VkCommandBuffer Reset(uint32_t imageIndex, uint32_t chunk, uint64_t key);
+
+		[[nodiscard]] VkCommandBuffer Get(uint32_t imageIndex, uint32_t chunk) const noexcept
+		{
+			return m_chunks[imageIndex][chunk].commandBuffer;
+		}
+
+	private:
+		// workers write their own chunks, they are kept on separate cache lines
+		struct alignas(64) Chunk
+		{
+			VkCommandPool pool = VK_NULL_HANDLE;
+			VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+			uint64_t key = 0;
+			bool isRecorded = false;
+		};
+
+		// by image
+		std::vector<std::vector<Chunk>> m_chunks;
+	};
+}
+
+#endif //SECONDARY_COMMAND_BUFFERS_H
@@ -2,13 +2,15 @@
 #define VULKAN_ALLOCATOR_H
 
 #include <iostream>
+#include <atomic>
 
 #include <vulkan/vulkan.h>
 #include <vulkan/vk_sdk_platform.h>
 
 class Allocator {
 private:
-    size_t amount = 0;
+    // callbacks are called from game and render threads
+    std::atomic<size_t> amount = 0;
     const VkAllocationCallbacks result = {
             (void *) this,
             Allocation,
@@ -76,6 +76,49 @@ namespace JoyEngine
 		}
 	};
 
+	// Per instance vertex data of shared materials with "isInstanced", bound after Vertex.
+	// Shaders read it through JOY_INSTANCE_DATA define
+	struct InstanceData
+	{
+		glm::mat4 model;
+		// parameters of bindless materials, see BindlessRegistry
+		uint32_t materialSlot;
+
+		static constexpr uint32_t BINDING = 1;
+		// mat4 takes a location per column
+		static constexpr uint32_t FIRST_LOCATION = 4;
+
+		static VkVertexInputBindingDescription getBindingDescription()
+		{
+			VkVertexInputBindingDescription bindingDescription{};
+			bindingDescription.binding = BINDING;
+			bindingDescription.stride = sizeof(InstanceData);
+			bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+
+			return bindingDescription;
+		}
+
+		static std::array<VkVertexInputAttributeDescription, 5> getAttributeDescriptions()
+		{
+			std::array<VkVertexInputAttributeDescription, 5> attributeDescriptions{};
+
+			for (uint32_t i = 0; i < 4; i++)
+			{
+				attributeDescriptions[i].binding = BINDING;
+				attributeDescriptions[i].location = FIRST_LOCATION + i;
+				attributeDescriptions[i].format = VK_FORMAT_R32G32B32A32_SFLOAT;
+				attributeDescriptions[i].offset = static_cast<uint32_t>(offsetof(InstanceData, model) + sizeof(glm::vec4) * i);
+			}
+
+			attributeDescriptions[4].binding = BINDING;
+			attributeDescriptions[4].location = FIRST_LOCATION + 4;
+			attributeDescriptions[4].format = VK_FORMAT_R32_UINT;
+			attributeDescriptions[4].offset = offsetof(InstanceData, materialSlot);
+
+			return attributeDescriptions;
+		}
+	};
+
 	struct MVP
 	{
 		glm::mat4 model;
@@ -83,12 +126,14 @@ namespace JoyEngine
 		glm::mat4 proj;
 	};
 
+	// JOY_VARIABLES uniform block, members are aligned as std140 lays them out
 	struct JoyData
 	{
-		glm::vec3 cameraWorldPos;
-		glm::mat4 cameraProjMatrix;
+		alignas(16) glm::vec3 cameraWorldPos;
+		alignas(16) glm::mat4 cameraProjMatrix;
 		float time;
 		float deltaTime;
+		alignas(16) glm::mat4 cameraViewMatrix;
 	};
 }
 
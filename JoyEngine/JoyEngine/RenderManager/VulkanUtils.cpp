@@ -178,7 +178,8 @@ namespace JoyEngine
 		VkPhysicalDeviceFeatures supportedFeatures;
 		vkGetPhysicalDeviceFeatures(device, &supportedFeatures);
 
-		return extensionsSupported && swapChainAdequate && supportedFeatures.samplerAnisotropy;
+		return extensionsSupported && swapChainAdequate && supportedFeatures.samplerAnisotropy &&
+			supportedFeatures.shaderSampledImageArrayDynamicIndexing;
 	}
 
 	VkFormat findSupportedFormat(VkPhysicalDevice physicalDevice, const std::vector<VkFormat>& candidates,
@@ -208,7 +209,7 @@ namespace JoyEngine
 		return findSupportedFormat(physicalDevice,
 		                           {VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT},
 		                           VK_IMAGE_TILING_OPTIMAL,
-		                           VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT
+		                           VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT
 		);
 	}
 
@@ -76,7 +76,7 @@ namespace JoyEngine
 	{
 		ASSERT(m_properties & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 		m_onLoadedExternalCallback = callback;
-		JoyContext::Memory->LoadDataToBufferAsync(stream, offset, m_size, m_buffer, m_onLoadedInternalCallback);
+		JoyContext::Memory->LoadDataToBufferAsync(stream, offset, m_size, m_buffer, 0, m_onLoadedInternalCallback);
 	}
 
 	Buffer::~Buffer()
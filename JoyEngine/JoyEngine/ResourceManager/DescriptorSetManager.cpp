@@ -14,14 +14,14 @@ namespace JoyEngine
 	}
 
 	void DescriptorSetManager::RegisterPool(uint64_t hash, VkDescriptorSetLayout setLayout,
-	                                        std::vector<VkDescriptorType> types)
+	                                        std::vector<VkDescriptorType> types, uint32_t setCount)
 	{
 		if (m_pools.find(hash) != m_pools.end())
 		{
 			m_pools[hash]->IncreaseRefCount();
 			return;
 		}
-		m_pools.insert({hash, std::make_unique<DescriptorPoolList>(setLayout, types)});
+		m_pools.insert({hash, std::make_unique<DescriptorPoolList>(setLayout, types, setCount)});
 		m_pools[hash]->IncreaseRefCount();
 	}
 
@@ -73,17 +73,24 @@ namespace JoyEngine
 
 	// =========== Descriptor Pool  =============
 
-	DescriptorPool::DescriptorPool(VkDescriptorSetLayout setLayout, std::vector<VkDescriptorType> types)
+	DescriptorPool::DescriptorPool(VkDescriptorSetLayout setLayout, const std::vector<VkDescriptorType>& types,
+	                               uint32_t setCount)
 	{
-		uint32_t poolSize = types.size();
-		std::vector<VkDescriptorPoolSize> poolSizes(poolSize);
-		for (uint32_t i = 0; i < poolSize; i++)
+		// arrays repeat their type for every element, they take one pool size
+		std::map<VkDescriptorType, uint32_t> typeCounts;
+		for (const auto& type : types)
+		{
+			typeCounts[type]++;
+		}
+		uint32_t poolSize = typeCounts.size();
+		std::vector<VkDescriptorPoolSize> poolSizes;
+		for (const auto& pair : typeCounts)
 		{
 			VkDescriptorPoolSize size = {
-				types[i],
-				DESCRIPTOR_POOL_SIZE
+				pair.first,
+				pair.second * setCount
 			};
-			poolSizes[i] = size;
+			poolSizes.push_back(size);
 		}
 
 		if (poolSize == 0)
@@ -95,7 +102,7 @@ namespace JoyEngine
 			VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
 			nullptr,
 			0,
-			DESCRIPTOR_POOL_SIZE,
+			setCount,
 			poolSize,
 			poolSizes.data()
 		};
@@ -108,21 +115,20 @@ namespace JoyEngine
 
 		ASSERT(res == VK_SUCCESS);
 
-		VkDescriptorSetLayout layouts[DESCRIPTOR_POOL_SIZE];
-		for (int i = 0; i < DESCRIPTOR_POOL_SIZE; i++) layouts[i] = setLayout;
+		std::vector<VkDescriptorSetLayout> layouts(setCount, setLayout);
 
 		VkDescriptorSetAllocateInfo allocInfo{
 			VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
 			nullptr,
 			m_pool,
-			DESCRIPTOR_POOL_SIZE,
-			layouts
+			setCount,
+			layouts.data()
 		};
 
-		VkDescriptorSet sets[DESCRIPTOR_POOL_SIZE];
-		res = vkAllocateDescriptorSets(JoyContext::Graphics->GetDevice(), &allocInfo, sets);
+		std::vector<VkDescriptorSet> sets(setCount);
+		res = vkAllocateDescriptorSets(JoyContext::Graphics->GetDevice(), &allocInfo, sets.data());
 		ASSERT(res == VK_SUCCESS);
-		for (int i = 0; i < DESCRIPTOR_POOL_SIZE; i++)
+		for (uint32_t i = 0; i < setCount; i++)
 		{
 			m_freeList.push_back(sets[i]);
 		}
@@ -155,12 +161,14 @@ namespace JoyEngine
 
 	// =========== Pool List =============
 
-	DescriptorPoolList::DescriptorPoolList(VkDescriptorSetLayout setLayout, std::vector<VkDescriptorType> types) :
+	DescriptorPoolList::DescriptorPoolList(VkDescriptorSetLayout setLayout, std::vector<VkDescriptorType> types,
+	                                       uint32_t setCount) :
 		m_setLayout(setLayout),
-		m_types(types)
+		m_types(types),
+		m_setCount(setCount)
 	{
 		ASSERT(!m_types.empty())
-		m_poolList.emplace_back(std::make_unique<DescriptorPool>(setLayout, types));
+		m_poolList.emplace_back(std::make_unique<DescriptorPool>(setLayout, m_types, m_setCount));
 	}
 
 	std::vector<VkDescriptorSet> DescriptorPoolList::Allocate(uint32_t count)
@@ -179,7 +187,7 @@ namespace JoyEngine
 		}
 		while (numAllocated < count)
 		{
-			std::unique_ptr<DescriptorPool> newPool = std::make_unique<DescriptorPool>(m_setLayout, m_types);
+			std::unique_ptr<DescriptorPool> newPool = std::make_unique<DescriptorPool>(m_setLayout, m_types, m_setCount);
 
 			while (newPool->GetSize() > 0 && numAllocated < count)
 			{
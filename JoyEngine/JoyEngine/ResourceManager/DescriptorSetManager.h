@@ -27,7 +27,7 @@ namespace JoyEngine
 	public :
 		DescriptorPool() = delete;
 
-		DescriptorPool(VkDescriptorSetLayout setLayout, std::vector<VkDescriptorType> types);
+		DescriptorPool(VkDescriptorSetLayout setLayout, const std::vector<VkDescriptorType>& types, uint32_t setCount);
 
 		~DescriptorPool();
 
@@ -45,7 +45,7 @@ namespace JoyEngine
 	class DescriptorPoolList
 	{
 	public:
-		DescriptorPoolList(VkDescriptorSetLayout setLayout, std::vector<VkDescriptorType> types);
+		DescriptorPoolList(VkDescriptorSetLayout setLayout, std::vector<VkDescriptorType> types, uint32_t setCount);
 
 		std::vector<VkDescriptorSet> Allocate(uint32_t count);
 
@@ -61,6 +61,7 @@ namespace JoyEngine
 		uint32_t m_refCount = 0;
 		VkDescriptorSetLayout m_setLayout;
 		std::vector<VkDescriptorType> m_types;
+		uint32_t m_setCount;
 
 		std::list<std::unique_ptr<DescriptorPool>> m_poolList;
 		std::map<VkDescriptorSet, DescriptorPool*> m_usedDescriptorSets;
@@ -73,7 +74,9 @@ namespace JoyEngine
 
 		void Init();
 
-		void RegisterPool(uint64_t hash, VkDescriptorSetLayout setLayout, std::vector<VkDescriptorType> types);
+		// types has an entry per descriptor, pools of the layout have room for setCount sets
+		void RegisterPool(uint64_t hash, VkDescriptorSetLayout setLayout, std::vector<VkDescriptorType> types,
+		                  uint32_t setCount = DESCRIPTOR_POOL_SIZE);
 
 		void UnregisterPool(uint64_t hash);
 
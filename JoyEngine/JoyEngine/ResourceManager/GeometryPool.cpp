@@ -0,0 +1,322 @@
+#include "GeometryPool.h"
+
+#include <algorithm>
+
+#include "JoyContext.h"
+#include "MemoryManager/MemoryManager.h"
+#include "RenderManager/RenderManager.h"
+#include "RenderManager/VulkanTypes.h"
+#include "Utils/Assert.h"
+
+namespace JoyEngine
+{
+	FreeRangeList::FreeRangeList(uint32_t capacity)
+	{
+		m_ranges.insert({0, capacity});
+	}
+
+	bool FreeRangeList::Allocate(uint32_t size, uint32_t& offset)
+	{
+		if (size == 0)
+		{
+			offset = 0;
+			return true;
+		}
+		for (auto it = m_ranges.begin(); it != m_ranges.end(); ++it)
+		{
+			if (it->second < size)
+			{
+				continue;
+			}
+			offset = it->first;
+			const uint32_t rest = it->second - size;
+			m_ranges.erase(it);
+			if (rest != 0)
+			{
+				m_ranges.insert({offset + size, rest});
+			}
+			return true;
+		}
+		return false;
+	}
+
+	void FreeRangeList::Free(uint32_t offset, uint32_t size)
+	{
+		if (size == 0)
+		{
+			return;
+		}
+		auto next = m_ranges.lower_bound(offset);
+		if (next != m_ranges.begin())
+		{
+			const auto previous = std::prev(next);
+			ASSERT(previous->first + previous->second <= offset);
+			if (previous->first + previous->second == offset)
+			{
+				offset = previous->first;
+				size += previous->second;
+				m_ranges.erase(previous);
+			}
+		}
+		if (next != m_ranges.end())
+		{
+			ASSERT(offset + size <= next->first);
+			if (offset + size == next->first)
+			{
+				size += next->second;
+				m_ranges.erase(next);
+			}
+		}
+		m_ranges.insert({offset, size});
+	}
+
+	uint32_t GeometryPool::Allocate(uint32_t vertexCount, uint32_t indexCount)
+	{
+		Allocation allocation = {0, 0, vertexCount, 0, indexCount, false, false};
+		bool isAllocated = false;
+		for (uint32_t i = 0; i < m_pages.size() && !isAllocated; i++)
+		{
+			Page* page = m_pages[i].get();
+			if (page == nullptr || !page->freeVertices.Allocate(vertexCount, allocation.firstVertex))
+			{
+				continue;
+			}
+			if (!page->freeIndices.Allocate(indexCount, allocation.firstIndex))
+			{
+				page->freeVertices.Free(allocation.firstVertex, vertexCount);
+				continue;
+			}
+			allocation.page = i;
+			isAllocated = true;
+		}
+		if (!isAllocated)
+		{
+			allocation.page = CreatePage(std::max(vertexCount, PAGE_VERTEX_COUNT), std::max(indexCount, PAGE_INDEX_COUNT));
+			Page* page = m_pages[allocation.page].get();
+			isAllocated = page->freeVertices.Allocate(vertexCount, allocation.firstVertex) &&
+				page->freeIndices.Allocate(indexCount, allocation.firstIndex);
+			ASSERT(isAllocated);
+		}
+		m_pages[allocation.page]->allocationCount++;
+		m_pages[allocation.page]->loadingCount++;
+
+		if (m_freeHandles.empty())
+		{
+			m_allocations.push_back(allocation);
+			return static_cast<uint32_t>(m_allocations.size() - 1);
+		}
+		const uint32_t handle = m_freeHandles.back();
+		m_freeHandles.pop_back();
+		m_allocations[handle] = allocation;
+		return handle;
+	}
+
+	void GeometryPool::Free(uint32_t handle)
+	{
+		Allocation& allocation = m_allocations[handle];
+		ASSERT(allocation.page != INVALID_HANDLE && !allocation.isFreed);
+		if (!allocation.isLoaded)
+		{
+			// the load still writes to the ranges, they can't be reused and the page can't be retired yet
+			allocation.isFreed = true;
+			return;
+		}
+		Release(handle);
+	}
+
+	void GeometryPool::Release(uint32_t handle)
+	{
+		Allocation& allocation = m_allocations[handle];
+		Page* page = m_pages[allocation.page].get();
+		page->freeVertices.Free(allocation.firstVertex, allocation.vertexCount);
+		page->freeIndices.Free(allocation.firstIndex, allocation.indexCount);
+		page->allocationCount--;
+		// the first page is kept for meshes loaded next
+		if (page->allocationCount == 0 && allocation.page != 0)
+		{
+			RetirePage(allocation.page);
+		}
+		else if (page->freeVertices.GetRangeCount() > MAX_FREE_RANGE_COUNT ||
+			page->freeIndices.GetRangeCount() > MAX_FREE_RANGE_COUNT)
+		{
+			page->isFragmented = true;
+		}
+		allocation.page = INVALID_HANDLE;
+		m_freeHandles.push_back(handle);
+	}
+
+	void GeometryPool::LoadAsync(uint32_t handle, std::ifstream& stream, uint32_t verticesOffset, uint32_t indicesOffset,
+	                             const std::function<void()>& onVerticesLoaded,
+	                             const std::function<void()>& onIndicesLoaded)
+	{
+		const Allocation& allocation = m_allocations[handle];
+		const Page* page = m_pages[allocation.page].get();
+		if (allocation.vertexCount == 0)
+		{
+			onVerticesLoaded();
+		}
+		else
+		{
+			JoyContext::Memory->LoadDataToBufferAsync(
+				stream,
+				verticesOffset,
+				allocation.vertexCount * sizeof(Vertex),
+				page->vertexBuffer->GetBuffer(),
+				allocation.firstVertex * sizeof(Vertex),
+				onVerticesLoaded);
+		}
+		if (allocation.indexCount == 0)
+		{
+			onIndicesLoaded();
+		}
+		else
+		{
+			JoyContext::Memory->LoadDataToBufferAsync(
+				stream,
+				indicesOffset,
+				allocation.indexCount * sizeof(uint32_t),
+				page->indexBuffer->GetBuffer(),
+				allocation.firstIndex * sizeof(uint32_t),
+				onIndicesLoaded);
+		}
+	}
+
+	void GeometryPool::SetLoaded(uint32_t handle)
+	{
+		Allocation& allocation = m_allocations[handle];
+		ASSERT(allocation.page != INVALID_HANDLE && !allocation.isLoaded);
+		allocation.isLoaded = true;
+		m_pages[allocation.page]->loadingCount--;
+		if (allocation.isFreed)
+		{
+			Release(handle);
+		}
+	}
+
+	void GeometryPool::Update(uint64_t completedFrameCount)
+	{
+		while (!m_retiredBuffers.empty() && m_retiredBuffers.front().frameCount <= completedFrameCount)
+		{
+			m_retiredBuffers.pop_front();
+		}
+
+		for (uint32_t i = 0; i < m_pages.size(); i++)
+		{
+			// loads in flight write to the current buffers, page waits for them
+			if (m_pages[i] != nullptr && m_pages[i]->isFragmented && m_pages[i]->loadingCount == 0)
+			{
+				CompactPage(i);
+			}
+		}
+	}
+
+	VkBuffer GeometryPool::GetVertexBuffer(uint32_t handle) const noexcept
+	{
+		return m_pages[m_allocations[handle].page]->vertexBuffer->GetBuffer();
+	}
+
+	VkBuffer GeometryPool::GetIndexBuffer(uint32_t handle) const noexcept
+	{
+		return m_pages[m_allocations[handle].page]->indexBuffer->GetBuffer();
+	}
+
+	uint32_t GeometryPool::CreatePage(uint32_t vertexCount, uint32_t indexCount)
+	{
+		auto page = std::make_unique<Page>();
+		page->vertexCapacity = vertexCount;
+		page->indexCapacity = indexCount;
+		page->vertexBuffer = std::make_unique<Buffer>(
+			vertexCount * sizeof(Vertex),
+			VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		page->indexBuffer = std::make_unique<Buffer>(
+			indexCount * sizeof(uint32_t),
+			VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		page->freeVertices = FreeRangeList(vertexCount);
+		page->freeIndices = FreeRangeList(indexCount);
+
+		const auto it = std::find(m_pages.begin(), m_pages.end(), nullptr);
+		if (it != m_pages.end())
+		{
+			*it = std::move(page);
+			return static_cast<uint32_t>(it - m_pages.begin());
+		}
+		m_pages.push_back(std::move(page));
+		return static_cast<uint32_t>(m_pages.size() - 1);
+	}
+
+	void GeometryPool::RetirePage(uint32_t pageIndex)
+	{
+		ASSERT(m_pages[pageIndex]->loadingCount == 0);
+		// frames already queued for render thread may still draw from the page
+		const uint64_t frameCount = JoyContext::Render->GetQueuedFrameCount();
+		m_retiredBuffers.push_back({std::move(m_pages[pageIndex]->vertexBuffer), frameCount});
+		m_retiredBuffers.push_back({std::move(m_pages[pageIndex]->indexBuffer), frameCount});
+		m_pages[pageIndex] = nullptr;
+		JoyContext::Render->OnResourceRetired();
+	}
+
+	void GeometryPool::CompactPage(uint32_t pageIndex)
+	{
+		Page* page = m_pages[pageIndex].get();
+		auto vertexBuffer = std::make_unique<Buffer>(
+			page->vertexCapacity * sizeof(Vertex),
+			VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		auto indexBuffer = std::make_unique<Buffer>(
+			page->indexCapacity * sizeof(uint32_t),
+			VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+		std::vector<VkBufferCopy> vertexRegions;
+		std::vector<VkBufferCopy> indexRegions;
+		uint32_t vertexCount = 0;
+		uint32_t indexCount = 0;
+		for (Allocation& allocation : m_allocations)
+		{
+			if (allocation.page != pageIndex)
+			{
+				continue;
+			}
+			if (allocation.vertexCount != 0)
+			{
+				vertexRegions.push_back({
+					allocation.firstVertex * sizeof(Vertex),
+					vertexCount * sizeof(Vertex),
+					allocation.vertexCount * sizeof(Vertex)
+				});
+			}
+			if (allocation.indexCount != 0)
+			{
+				indexRegions.push_back({
+					allocation.firstIndex * sizeof(uint32_t),
+					indexCount * sizeof(uint32_t),
+					allocation.indexCount * sizeof(uint32_t)
+				});
+			}
+			allocation.firstVertex = vertexCount;
+			allocation.firstIndex = indexCount;
+			vertexCount += allocation.vertexCount;
+			indexCount += allocation.indexCount;
+		}
+		JoyContext::Memory->CopyBufferRegions(page->vertexBuffer->GetBuffer(), vertexBuffer->GetBuffer(), vertexRegions);
+		JoyContext::Memory->CopyBufferRegions(page->indexBuffer->GetBuffer(), indexBuffer->GetBuffer(), indexRegions);
+
+		// snapshots queued before have old offsets and draw from old buffers
+		const uint64_t frameCount = JoyContext::Render->GetQueuedFrameCount();
+		m_retiredBuffers.push_back({std::move(page->vertexBuffer), frameCount});
+		m_retiredBuffers.push_back({std::move(page->indexBuffer), frameCount});
+		page->vertexBuffer = std::move(vertexBuffer);
+		page->indexBuffer = std::move(indexBuffer);
+		JoyContext::Render->OnResourceRetired();
+
+		uint32_t offset;
+		page->freeVertices = FreeRangeList(page->vertexCapacity);
+		page->freeIndices = FreeRangeList(page->indexCapacity);
+		const bool isAllocated = page->freeVertices.Allocate(vertexCount, offset) &&
+			page->freeIndices.Allocate(indexCount, offset);
+		ASSERT(isAllocated);
+		page->isFragmented = false;
+	}
+}
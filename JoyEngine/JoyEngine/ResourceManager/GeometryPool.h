@@ -0,0 +1,138 @@
+#ifndef GEOMETRY_POOL_H
+#define GEOMETRY_POOL_H
+
+#include <map>
+#include <deque>
+#include <vector>
+#include <memory>
+#include <fstream>
+#include <functional>
+#include <cstdint>
+
+#include <vulkan/vulkan.h>
+
+#include "ResourceManager/Buffer.h"
+
+namespace JoyEngine
+{
+	// First fit free ranges of a page, neighbouring free ranges are merged
+	class FreeRangeList
+	{
+	public:
+		FreeRangeList() = default;
+
+		explicit FreeRangeList(uint32_t capacity);
+
+		[[nodiscard]] bool Allocate(uint32_t size, uint32_t& offset);
+
+		void Free(uint32_t offset, uint32_t size);
+
+		[[nodiscard]] uint32_t GetRangeCount() const noexcept { return static_cast<uint32_t>(m_ranges.size()); }
+
+	private:
+		// size by offset
+		std::map<uint32_t, uint32_t> m_ranges;
+	};
+
+	// Vertices and indices of all meshes live in a few big device local buffers, pages.
+	// Mesh keeps a handle and draws with its base vertex and first index, so a pass binds geometry once per page.
+	// Pages fragmented by freed meshes are compacted into new buffers, old ones are destroyed
+	// when frames queued before have finished. Game thread only
+	class GeometryPool
+	{
+	public:
+		GeometryPool() = default;
+
+		GeometryPool(const GeometryPool&) = delete;
+
+		GeometryPool& operator=(const GeometryPool&) = delete;
+
+		[[nodiscard]] uint32_t Allocate(uint32_t vertexCount, uint32_t indexCount);
+
+		// geometry which is still loading is released when its load lands
+		void Free(uint32_t handle);
+
+		// copies vertices and indices from the stream, callbacks are called for each of them separately
+		// and have to outlive the load
+		void LoadAsync(uint32_t handle, std::ifstream& stream, uint32_t verticesOffset, uint32_t indicesOffset,
+		               const std::function<void()>& onVerticesLoaded, const std::function<void()>& onIndicesLoaded);
+
+		// both parts of the geometry have arrived, page can be compacted
+		void SetLoaded(uint32_t handle);
+
+		// destroys pages which aren't used anymore, compacts fragmented ones
+		void Update(uint64_t completedFrameCount);
+
+		[[nodiscard]] VkBuffer GetVertexBuffer(uint32_t handle) const noexcept;
+
+		[[nodiscard]] VkBuffer GetIndexBuffer(uint32_t handle) const noexcept;
+
+		[[nodiscard]] int32_t GetVertexOffset(uint32_t handle) const noexcept
+		{
+			return static_cast<int32_t>(m_allocations[handle].firstVertex);
+		}
+
+		[[nodiscard]] uint32_t GetFirstIndex(uint32_t handle) const noexcept { return m_allocations[handle].firstIndex; }
+
+		static constexpr uint32_t INVALID_HANDLE = UINT32_MAX;
+
+	private:
+		struct Page
+		{
+			std::unique_ptr<Buffer> vertexBuffer;
+			std::unique_ptr<Buffer> indexBuffer;
+			uint32_t vertexCapacity;
+			uint32_t indexCapacity;
+			FreeRangeList freeVertices;
+			FreeRangeList freeIndices;
+			uint32_t allocationCount = 0;
+			// allocations with loads in flight, they write to the current buffers
+			uint32_t loadingCount = 0;
+			bool isFragmented = false;
+		};
+
+		struct Allocation
+		{
+			uint32_t page;
+			uint32_t firstVertex;
+			uint32_t vertexCount;
+			uint32_t firstIndex;
+			uint32_t indexCount;
+			bool isLoaded;
+			// freed while loading
+			bool isFreed;
+		};
+
+		struct RetiredBuffer
+		{
+			std::unique_ptr<Buffer> buffer;
+			// destroyed when render manager has completed this many frames
+			uint64_t frameCount;
+		};
+
+	private:
+		[[nodiscard]] uint32_t CreatePage(uint32_t vertexCount, uint32_t indexCount);
+
+		void Release(uint32_t handle);
+
+		void RetirePage(uint32_t pageIndex);
+
+		// moves geometry of the page to the beginning of new buffers
+		void CompactPage(uint32_t pageIndex);
+
+	private:
+		// meshes bigger than a page get a page of their own size
+		static constexpr uint32_t PAGE_VERTEX_COUNT = 1 << 20;
+		static constexpr uint32_t PAGE_INDEX_COUNT = 1 << 22;
+		// free ranges a page can have before it's compacted
+		static constexpr uint32_t MAX_FREE_RANGE_COUNT = 16;
+
+		// released pages are nullptr, so page indices stay valid
+		std::vector<std::unique_ptr<Page>> m_pages;
+		std::vector<Allocation> m_allocations;
+		std::vector<uint32_t> m_freeHandles;
+		std::deque<RetiredBuffer> m_retiredBuffers;
+	};
+}
+
+#endif //GEOMETRY_POOL_H
@@ -1,5 +1,6 @@
 #include "Material.h"
 #include <vector>
+#include <cstring>
 #include "JoyContext.h"
 
 #include <rapidjson/document.h>
@@ -19,6 +20,12 @@ namespace JoyEngine
 		rapidjson::Document json = JoyContext::Data->GetSerializedData(guid, material);
 
 		m_sharedMaterial = GUID::StringToGuid(json["sharedMaterial"].GetString());
+		if (m_sharedMaterial->IsBindless())
+		{
+			RegisterBindlessData(json["bindings"]);
+			return;
+		}
+
 		std::vector<VulkanBindingDescription>& vbd = m_sharedMaterial->GetVulkanBindings();
 		m_bindings.resize(vbd.size());
 		for (int i = 0; i < vbd.size(); i++)
@@ -38,6 +45,7 @@ namespace JoyEngine
 			}
 		}
 
+		std::vector<char> staging;
 		for (auto& binding : json["bindings"].GetArray())
 		{
 			std::string nameStr = binding["name"].GetString();
@@ -59,15 +67,24 @@ namespace JoyEngine
 			}
 			else
 			{
+				// data is the same for every swapchain image, so it's deserialized once and copied
+				const uint32_t typeHash = strHash(info->type.c_str());
+				if (info->isStd140)
+				{
+					staging.resize(SerializationUtils::GetStd140Size(typeHash, info->count, info->stride));
+					SerializationUtils::DeserializeToStd140(typeHash, data, staging.data(), info->count, info->stride);
+				}
+				else
+				{
+					staging.resize(SerializationUtils::GetTypeSize(typeHash) * info->count);
+					SerializationUtils::DeserializeToPtr(typeHash, data, staging.data(), info->count);
+				}
+
 				for (uint32_t j = 0; j < JoyContext::Render->GetSwapchain()->GetSwapchainImageCount(); j++)
 				{
 					std::unique_ptr<BufferMappedPtr> ptr = m_bindings[info->bindingIndex].buffers[j]->
-						GetMappedPtr(info->offset, info->count * SerializationUtils::GetTypeSize(info->type));
-
-					SerializationUtils::DeserializeToPtr(
-						strHash(info->type.c_str()),
-						data, ptr->GetMappedPtr(),
-						info->count);
+						GetMappedPtr(info->offset, staging.size());
+					memcpy(ptr->GetMappedPtr(), staging.data(), staging.size());
 				}
 			}
 		}
@@ -78,6 +95,10 @@ namespace JoyEngine
 
 	Material::~Material()
 	{
+		if (m_bindlessSlot != BindlessRegistry::INVALID_SLOT)
+		{
+			JoyContext::Render->GetBindlessRegistry()->UnregisterMaterial(m_bindlessSlot);
+		}
 		JoyContext::DescriptorSet->Free(m_descriptorSets);
 		for (const auto& item : m_bindings)
 		{
@@ -103,6 +124,9 @@ namespace JoyEngine
 
 		for (int i = 0; i < m_bindings.size(); i++)
 		{
+			// unused binding index
+			if (m_bindings[i].type == VK_DESCRIPTOR_TYPE_MAX_ENUM) continue;
+
 			VkDescriptorImageInfo* imageInfoPtr = nullptr;
 			VkDescriptorBufferInfo* bufferInfoPtr = nullptr;
 			VkBufferView* texelBufferViewPtr = nullptr;
@@ -188,6 +212,43 @@ namespace JoyEngine
 		}
 	}
 
+	void Material::RegisterBindlessData(const rapidjson::Value& bindingsValue)
+	{
+		std::vector<char> data(m_sharedMaterial->GetBindlessDataSize(), 0);
+		for (auto& binding : bindingsValue.GetArray())
+		{
+			std::string nameStr = binding["name"].GetString();
+			const rapidjson::Value& value = binding["data"];
+			BindingInfo* info = m_sharedMaterial->GetBindingInfoByName(nameStr);
+			if (info == nullptr) continue;
+
+			if (info->type == "texture")
+			{
+				// a single slot, shared material rejects texture arrays
+				ASSERT(value.IsString());
+				std::string dataString = value.GetString();
+				uint32_t slot = BindlessRegistry::FALLBACK_TEXTURE_SLOT;
+				if (!dataString.empty())
+				{
+					// kept as a binding, so it's released and waited for like textures of other materials
+					MaterialBinding textureBinding;
+					textureBinding.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+					textureBinding.size = 0;
+					textureBinding.textureGuid = GUID::StringToGuid(dataString);
+					slot = JoyContext::Resource->LoadResource<Texture>(textureBinding.textureGuid)->GetBindlessSlot();
+					m_bindings.push_back(std::move(textureBinding));
+				}
+				memcpy(data.data() + info->offset, &slot, sizeof(slot));
+			}
+			else
+			{
+				SerializationUtils::DeserializeToPtr(strHash(info->type.c_str()), value, data.data() + info->offset,
+				                                     info->count);
+			}
+		}
+		m_bindlessSlot = JoyContext::Render->GetBindlessRegistry()->RegisterMaterial(data.data(), data.size());
+	}
+
 	SharedMaterial* Material::GetSharedMaterial() const noexcept
 	{
 		return m_sharedMaterial;
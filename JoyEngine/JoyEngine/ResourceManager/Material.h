@@ -5,6 +5,8 @@
 #include <string>
 #include <memory>
 
+#include <rapidjson/document.h>
+
 #include "Common/Resource.h"
 #include "SharedMaterial.h"
 #include "ResourceManager/Buffer.h"
@@ -38,13 +40,19 @@ namespace JoyEngine
 
 		[[nodiscard]] std::vector<VkDescriptorSet>& GetDescriptorSets() noexcept;
 
+		// index of material parameters in JOY_BINDLESS set, only materials of bindless shared materials have it
+		[[nodiscard]] uint32_t GetBindlessSlot() const noexcept { return m_bindlessSlot; }
+
 		[[nodiscard]] bool IsLoaded() const noexcept override;
 	private:
 		void CreateDescriptorSets();
+		// packs parameters and texture slots for bindless registry, instead of descriptor sets
+		void RegisterBindlessData(const rapidjson::Value& bindingsValue);
 	private :
 		ResourceHandle<SharedMaterial> m_sharedMaterial;
 		std::vector<MaterialBinding> m_bindings;
 		std::vector<VkDescriptorSet> m_descriptorSets;
+		uint32_t m_bindlessSlot = BindlessRegistry::INVALID_SLOT;
 	};
 }
 
@@ -3,13 +3,15 @@
 #include "JoyContext.h"
 
 #include <vector>
+#include <algorithm>
 #include "RenderManager/VulkanTypes.h"
 #include "DataManager/DataManager.h"
 #include "MemoryManager/MemoryManager.h"
+#include "ResourceManager/ResourceManager.h"
 
 namespace JoyEngine
 {
-	Mesh::Mesh(GUID guid) : Resource(guid)
+	Mesh::Mesh(GUID guid) : Resource(guid), m_geometryPool(JoyContext::Resource->GetGeometryPool())
 	{
 		m_modelStream = JoyContext::Data->GetFileStream(guid, true);
 
@@ -21,41 +23,68 @@ namespace JoyEngine
 		m_vertexSize = verticesDataSize / sizeof(Vertex);
 		m_indexSize = indicesDataSize / sizeof(uint32_t);
 
-		m_vertexBuffer = std::make_unique<Buffer>(
-			verticesDataSize,
-			VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
-			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-
-		m_indexBuffer = std::make_unique<Buffer>(
-			indicesDataSize,
-			VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
-			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-
-		m_vertexBuffer->LoadDataAsync(m_modelStream, sizeof(uint32_t) + sizeof(uint32_t), [this]()
+		// mesh files don't store bounds, positions are read once before the stream is handed to the loader
+		std::vector<Vertex> vertices(std::min(m_vertexSize, BOUNDS_READ_VERTEX_COUNT));
+		for (size_t read = 0; read < m_vertexSize; read += vertices.size())
 		{
-			if (m_indexBuffer->IsLoaded())
+			const size_t count = std::min(vertices.size(), m_vertexSize - read);
+			m_modelStream.read(reinterpret_cast<char*>(vertices.data()), static_cast<std::streamsize>(count * sizeof(Vertex)));
+			for (size_t i = 0; i < count; i++)
 			{
-				if (m_modelStream.is_open())
-				{
-					m_modelStream.close();
-				}
+				m_bounds.Add(vertices[i].pos);
 			}
-		});
-		m_indexBuffer->LoadDataAsync(m_modelStream, sizeof(uint32_t) + sizeof(uint32_t) + verticesDataSize, [this]()
+		}
+
+		m_modelStream.seekg(sizeof(uint32_t) + sizeof(uint32_t) + verticesDataSize + indicesDataSize);
+		MeshOccluderHeader occluderHeader = {0, 0};
+		m_modelStream.read(reinterpret_cast<char*>(&occluderHeader), sizeof(MeshOccluderHeader));
+		if (m_modelStream)
+		{
+			m_occluderVertices.resize(occluderHeader.vertexCount);
+			m_occluderIndices.resize(occluderHeader.indexCount);
+			m_modelStream.read(reinterpret_cast<char*>(m_occluderVertices.data()),
+			                   static_cast<std::streamsize>(occluderHeader.vertexCount * sizeof(glm::vec3)));
+			m_modelStream.read(reinterpret_cast<char*>(m_occluderIndices.data()),
+			                   static_cast<std::streamsize>(occluderHeader.indexCount * sizeof(uint32_t)));
+		}
+		// files cooked before occluders end after the indices
+		m_modelStream.clear();
+
+		m_geometry = m_geometryPool.Allocate(static_cast<uint32_t>(m_vertexSize), static_cast<uint32_t>(m_indexSize));
+
+		const auto onLoaded = [this]()
 		{
-			if (m_vertexBuffer->IsLoaded())
+			if (m_areVerticesLoaded && m_areIndicesLoaded)
 			{
+				m_geometryPool.SetLoaded(m_geometry);
 				if (m_modelStream.is_open())
 				{
 					m_modelStream.close();
 				}
 			}
-		});
+		};
+		m_onVerticesLoaded = [this, onLoaded]()
+		{
+			m_areVerticesLoaded = true;
+			onLoaded();
+		};
+		m_onIndicesLoaded = [this, onLoaded]()
+		{
+			m_areIndicesLoaded = true;
+			onLoaded();
+		};
+		m_geometryPool.LoadAsync(
+			m_geometry,
+			m_modelStream,
+			sizeof(uint32_t) + sizeof(uint32_t),
+			sizeof(uint32_t) + sizeof(uint32_t) + verticesDataSize,
+			m_onVerticesLoaded,
+			m_onIndicesLoaded);
 	}
 
 	Mesh::~Mesh()
 	{
-		//JoyContext::Memory->DestroyBuffer(m_vertexBuffer, m_vertexBufferMemory);
-		//JoyContext::Memory->DestroyBuffer(m_indexBuffer, m_indexBufferMemory);
+		// retired resources are destroyed after frames which could draw them
+		m_geometryPool.Free(m_geometry);
 	}
 }
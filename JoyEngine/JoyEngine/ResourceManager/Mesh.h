@@ -3,11 +3,15 @@
 
 #include <memory>
 #include <fstream>
+#include <vector>
+#include <functional>
 
 #include <vulkan/vulkan.h>
 
 #include "Common/Resource.h"
-#include "ResourceManager/Buffer.h"
+#include "Common/Bounds.h"
+#include "ResourceManager/MeshOccluder.h"
+#include "ResourceManager/GeometryPool.h"
 #include "Utils/GUID.h"
 
 namespace JoyEngine
@@ -25,21 +29,45 @@ namespace JoyEngine
 
 		[[nodiscard]] size_t GetVertexSize() const noexcept { return m_vertexSize; }
 
-		[[nodiscard]] VkBuffer GetIndexBuffer() const noexcept { return m_indexBuffer->GetBuffer(); }
+		// Geometry pool page, shared with other meshes. Pool may move the geometry when other meshes are unloaded,
+		// so buffers and offsets are read every frame
+		[[nodiscard]] VkBuffer GetIndexBuffer() const noexcept { return m_geometryPool.GetIndexBuffer(m_geometry); }
 
-		[[nodiscard]] VkBuffer GetVertexBuffer() const noexcept { return m_vertexBuffer->GetBuffer(); }
+		[[nodiscard]] VkBuffer GetVertexBuffer() const noexcept { return m_geometryPool.GetVertexBuffer(m_geometry); }
 
-		[[nodiscard]] bool IsLoaded() const noexcept override { return m_vertexBuffer->IsLoaded() && m_indexBuffer->IsLoaded(); }
+		[[nodiscard]] uint32_t GetFirstIndex() const noexcept { return m_geometryPool.GetFirstIndex(m_geometry); }
 
+		[[nodiscard]] int32_t GetVertexOffset() const noexcept { return m_geometryPool.GetVertexOffset(m_geometry); }
+
+		[[nodiscard]] bool IsLoaded() const noexcept override { return m_areVerticesLoaded && m_areIndicesLoaded; }
+
+		// object space, known right after construction
+		[[nodiscard]] const AABB& GetBounds() const noexcept { return m_bounds; }
+
+		// Object space triangles which hide whatever is behind them, empty if mesh is not an occluder.
+		// Known right after construction
+		[[nodiscard]] const std::vector<glm::vec3>& GetOccluderVertices() const noexcept { return m_occluderVertices; }
+
+		[[nodiscard]] const std::vector<uint32_t>& GetOccluderIndices() const noexcept { return m_occluderIndices; }
 
 	private:
 		size_t m_indexSize;
 		size_t m_vertexSize;
-
-		std::unique_ptr<Buffer> m_vertexBuffer;
-		std::unique_ptr<Buffer> m_indexBuffer;
+		AABB m_bounds;
+		std::vector<glm::vec3> m_occluderVertices;
+		std::vector<uint32_t> m_occluderIndices;
+
+		GeometryPool& m_geometryPool;
+		uint32_t m_geometry = GeometryPool::INVALID_HANDLE;
+		bool m_areVerticesLoaded = false;
+		bool m_areIndicesLoaded = false;
+		// async loader keeps references to them until the load is finished
+		std::function<void()> m_onVerticesLoaded;
+		std::function<void()> m_onIndicesLoaded;
 
 		std::ifstream m_modelStream;
+
+		static constexpr size_t BOUNDS_READ_VERTEX_COUNT = 4096;
 	};
 }
 
@@ -0,0 +1,25 @@
+#ifndef MESH_OCCLUDER_H
+#define MESH_OCCLUDER_H
+
+#include <cstdint>
+
+// Occluder section of a cooked mesh file, written by JoyDataBuilderLib after the index data.
+// Occluder is the welded triangle list of the mesh itself, so it never covers more than the mesh does.
+// Only big and simple meshes get one, for the rest and for files cooked without the section counts are zero.
+// Depends only on <cstdint>, so the asset builder includes it as is.
+
+namespace JoyEngine
+{
+	// half of the surface area of object space bounds
+	constexpr float MESH_OCCLUDER_MIN_HALF_AREA = 1.0f;
+	constexpr uint32_t MESH_OCCLUDER_MAX_TRIANGLES = 2048;
+
+	struct MeshOccluderHeader
+	{
+		uint32_t vertexCount;
+		uint32_t indexCount;
+		// followed by vertexCount float3 positions and indexCount uint32 indices
+	};
+}
+
+#endif //MESH_OCCLUDER_H
@@ -1,5 +1,33 @@
 #include "ResourceManager.h"
 
+#include "JoyContext.h"
+#include "RenderManager/RenderManager.h"
+
 namespace JoyEngine {
 
-}
\ No newline at end of file
+    ResourceManager::~ResourceManager() {
+        // render thread is stopped and device is idle here
+        while (!m_retiredResources.empty()) {
+            // destructor may release other resources, so it runs after the entry is removed
+            std::unique_ptr<Resource> resource = std::move(m_retiredResources.front().resource);
+            m_retiredResources.pop_front();
+        }
+    }
+
+    void ResourceManager::Update() {
+        const uint64_t completedFrameCount = JoyContext::Render->GetCompletedFrameCount();
+        while (!m_retiredResources.empty() && m_retiredResources.front().frameCount <= completedFrameCount) {
+            std::unique_ptr<Resource> resource = std::move(m_retiredResources.front().resource);
+            m_retiredResources.pop_front();
+        }
+        m_geometryPool.Update(completedFrameCount);
+    }
+
+    void ResourceManager::RetireResource(GUID guid) {
+        const auto it = m_isResourceInUse.find(guid);
+        it->second->OnRetired();
+        JoyContext::Render->OnResourceRetired();
+        m_retiredResources.push_back({std::move(it->second), JoyContext::Render->GetQueuedFrameCount()});
+        m_isResourceInUse.erase(it);
+    }
+}
@@ -3,10 +3,12 @@
 
 #include <map>
 #include <set>
+#include <deque>
 #include <Utils/Assert.h>
 #include <memory>
 
 #include "Common/Resource.h"
+#include "ResourceManager/GeometryPool.h"
 
 namespace JoyEngine {
 
@@ -15,10 +17,17 @@ namespace JoyEngine {
 
         ResourceManager() = default;
 
+        ~ResourceManager();
+
         void Init() {}
 
         void Start() {}
 
+        // destroys released resources which render thread and GPU don't use anymore
+        void Update();
+
+        [[nodiscard]] GeometryPool &GetGeometryPool() noexcept { return m_geometryPool; }
+
         void Stop() {}
 
         bool IsResourceLoaded(GUID guid) {
@@ -41,7 +50,7 @@ namespace JoyEngine {
                 ASSERT(false);
             }
             if (m_isResourceInUse[guid]->GetRefCount() == 0) {
-                m_isResourceInUse.erase(guid);
+                RetireResource(guid);
             }
         }
 
@@ -58,7 +67,20 @@ namespace JoyEngine {
         }
 
     private:
+        struct RetiredResource {
+            std::unique_ptr<Resource> resource;
+            // destroyed when render manager has completed this many frames
+            uint64_t frameCount;
+        };
+
+        // frames already queued for render thread may still reference the resource
+        void RetireResource(GUID guid);
+
+    private:
+        // outlives meshes, they free their geometry on destruction
+        GeometryPool m_geometryPool;
         std::map<GUID, std::unique_ptr<Resource>> m_isResourceInUse;
+        std::deque<RetiredResource> m_retiredResources;
     };
 }
 
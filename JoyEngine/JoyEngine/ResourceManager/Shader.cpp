@@ -49,6 +49,43 @@ namespace JoyEngine
 			JoyContext::Graphics->GetAllocationCallbacks(),
 			&m_fragmentModule);
 		ASSERT_DESC(res == VK_SUCCESS, ParseVkResult(res));
+
+		const size_t layoutOffset = sizeof(uint32_t) * 2 + vertexDataLength + fragmentDataLength;
+		if (shaderData.size() > layoutOffset)
+		{
+			ReadLayout(shaderData.data() + layoutOffset, shaderData.size() - layoutOffset);
+		}
+	}
+
+	void Shader::ReadLayout(const char* data, size_t size)
+	{
+		ShaderLayoutHeader header;
+		ASSERT(size >= sizeof(ShaderLayoutHeader));
+		memcpy(&header, data, sizeof(ShaderLayoutHeader));
+		if (header.magic != SHADER_LAYOUT_MAGIC || header.version != SHADER_LAYOUT_VERSION)
+		{
+			// Old blob, fall back to the bindings described in shared material json
+			return;
+		}
+
+		const size_t bindingsSize = header.bindingCount * sizeof(ShaderBindingDesc);
+		const size_t membersSize = header.memberCount * sizeof(ShaderMemberDesc);
+		const size_t pushConstantsSize = header.pushConstantCount * sizeof(ShaderPushConstantDesc);
+		ASSERT(size == sizeof(ShaderLayoutHeader) + bindingsSize + membersSize + pushConstantsSize + header.stringTableSize);
+
+		const char* ptr = data + sizeof(ShaderLayoutHeader);
+		m_layout.bindings.resize(header.bindingCount);
+		memcpy(m_layout.bindings.data(), ptr, bindingsSize);
+		ptr += bindingsSize;
+		m_layout.members.resize(header.memberCount);
+		memcpy(m_layout.members.data(), ptr, membersSize);
+		ptr += membersSize;
+		m_layout.pushConstants.resize(header.pushConstantCount);
+		memcpy(m_layout.pushConstants.data(), ptr, pushConstantsSize);
+		ptr += pushConstantsSize;
+		m_layout.strings.assign(ptr, ptr + header.stringTableSize);
+
+		m_hasLayout = true;
 	}
 
 	Shader::~Shader()
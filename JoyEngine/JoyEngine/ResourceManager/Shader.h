@@ -1,11 +1,23 @@
 #ifndef SHADER_H
 #define SHADER_H
 
+#include <vector>
+
 #include <vulkan/vulkan.h>
 
 #include "Common/Resource.h"
+#include "ResourceManager/ShaderLayout.h"
 
 namespace JoyEngine {
+    struct ShaderLayout {
+        std::vector<ShaderBindingDesc> bindings;
+        std::vector<ShaderMemberDesc> members;
+        std::vector<ShaderPushConstantDesc> pushConstants;
+        std::vector<char> strings;
+
+        [[nodiscard]] const char *GetName(uint32_t nameOffset) const noexcept { return strings.data() + nameOffset; }
+    };
+
     class Shader final: public Resource {
     public :
 
@@ -19,9 +31,18 @@ namespace JoyEngine {
         [[nodiscard]] VkShaderModule &GetFragmentShadeModule() noexcept { return m_fragmentModule; }
         [[nodiscard]] bool IsLoaded() const noexcept override { return true; }
 
+        // Reflected layout, nullptr for shaders cooked without one
+        [[nodiscard]] const ShaderLayout *GetLayout() const noexcept { return m_hasLayout ? &m_layout : nullptr; }
+
+    private :
+        void ReadLayout(const char *data, size_t size);
+
     private :
         VkShaderModule m_vertexModule = VK_NULL_HANDLE;
         VkShaderModule m_fragmentModule = VK_NULL_HANDLE;
+
+        bool m_hasLayout = false;
+        ShaderLayout m_layout;
     };
 }
 
@@ -0,0 +1,57 @@
+#ifndef SHADER_LAYOUT_H
+#define SHADER_LAYOUT_H
+
+#include <cstdint>
+
+// Binary description of shader resources reflected from SPIR-V by JoyShaderBuilderLib.
+// It's appended to the cooked shader data right after the fragment module:
+// [ShaderLayoutHeader][ShaderBindingDesc...][ShaderMemberDesc...][ShaderPushConstantDesc...][string table]
+// Depends only on <cstdint>, so the asset builder includes it as is.
+
+namespace JoyEngine
+{
+	constexpr uint32_t SHADER_LAYOUT_MAGIC = 0x594C534A; // "JSLY"
+	constexpr uint32_t SHADER_LAYOUT_VERSION = 1;
+
+	struct ShaderLayoutHeader
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint32_t bindingCount;
+		uint32_t memberCount;
+		uint32_t pushConstantCount;
+		uint32_t stringTableSize;
+	};
+
+	struct ShaderBindingDesc
+	{
+		uint32_t set;
+		uint32_t binding;
+		uint32_t descriptorType; // VkDescriptorType
+		uint32_t descriptorCount; // 0 for runtime arrays
+		uint32_t stageFlags; // VkShaderStageFlags
+		uint32_t blockSize; // std140 size of uniform and storage blocks, 0 otherwise
+		uint32_t firstMember;
+		uint32_t memberCount;
+		uint32_t nameOffset;
+	};
+
+	struct ShaderMemberDesc
+	{
+		uint32_t nameOffset;
+		uint32_t typeHash; // strHash of serializable type name ("float", "vec4", ...), 0 if it has none
+		uint32_t offset;
+		uint32_t size;
+		uint32_t arrayCount; // 1 for non-array members
+		uint32_t arrayStride;
+	};
+
+	struct ShaderPushConstantDesc
+	{
+		uint32_t offset;
+		uint32_t size;
+		uint32_t stageFlags;
+	};
+}
+
+#endif //SHADER_LAYOUT_H
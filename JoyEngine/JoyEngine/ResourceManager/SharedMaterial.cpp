@@ -1,6 +1,8 @@
 #include "SharedMaterial.h"
 
 #include <array>
+#include <algorithm>
+#include <stdexcept>
 
 #include <rapidjson/document.h>
 
@@ -11,6 +13,7 @@
 #include "ResourceManager/DescriptorSetManager.h"
 #include "RenderManager/VulkanTypes.h"
 #include "RenderManager/RenderManager.h"
+#include "RenderManager/BindlessRegistry.h"
 
 namespace JoyEngine
 {
@@ -29,6 +32,10 @@ namespace JoyEngine
 
 		m_hasVertexInput = json["hasVertexInput"].GetBool();
 		m_hasMVP = json["hasMVP"].GetBool();
+		m_isInstanced = json.HasMember("isInstanced") && json["isInstanced"].GetBool();
+		m_isBindless = json.HasMember("isBindless") && json["isBindless"].GetBool();
+		m_isCameraFromJoyVariables = json.HasMember("isCameraFromJoyVariables") &&
+			json["isCameraFromJoyVariables"].GetBool();
 		m_depthTest = json["depthTest"].GetBool();
 		m_depthWrite = json["depthWrite"].GetBool();
 
@@ -36,66 +43,44 @@ namespace JoyEngine
 		m_subpassIndex = json["subpassIndex"].GetUint();
 
 		{
-			const auto bindingsArray = json["bindings"].GetArray();
-			const uint32_t bindingsArraySize = bindingsArray.Size();
+			// binding index -> layout binding, descriptorCount == 0 marks an unused index
+			std::vector<VkDescriptorSetLayoutBinding> bindings;
+			std::vector<size_t> bindingSizes;
 
-			std::vector<VkDescriptorSetLayoutBinding> bindings(bindingsArraySize);
-			std::vector<VkDescriptorType> types(bindingsArraySize);
-			std::vector<size_t> bindingCurrentOffsets(bindingsArraySize, 0);
-
-			int32_t maxBindingIndex = -1;
-			for (uint32_t i = 0; i < bindingsArraySize; i++)
+			const ShaderLayout* layout = m_shader->GetLayout();
+			if (m_isBindless)
 			{
-				std::string typeStr = bindingsArray[i]["type"].GetString();
-				std::string nameStr = bindingsArray[i]["name"].GetString();
-				int32_t bindingIndex = bindingsArray[i]["index"].GetInt();
-				uint32_t count = bindingsArray[i]["count"].GetUint();
-
-				if (bindingIndex > maxBindingIndex)
-				{
-					maxBindingIndex = bindingIndex;
-				}
-
-				m_bindings.insert({
-					nameStr, {
-						static_cast<uint32_t>(bindingIndex),
-						typeStr,
-						count,
-						bindingCurrentOffsets[bindingIndex]
-					}
-				});
-				const VkDescriptorType type = GetTypeFromStr(typeStr);
-				if (type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER)
-				{
-					bindingCurrentOffsets[bindingIndex] += SerializationUtils::GetTypeSize(typeStr) * count;
-				}
-
-				types[bindingIndex] = type;
-				VkShaderStageFlags stageFlagBits = 0;
-				if (type == VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT)
-				{
-					stageFlagBits = VK_SHADER_STAGE_FRAGMENT_BIT;
-				}
-				else
+				ReadBindlessDataFromJson(json["bindings"]);
+				// push constants are still reflected
+				if (layout != nullptr)
 				{
-					stageFlagBits = VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_VERTEX_BIT;
+					ReadBindingsFromLayout(*layout, bindings, bindingSizes);
+					ASSERT_DESC(bindings.empty(), "Bindless material has bindings in material set");
 				}
-				const uint32_t descriptorCount = 1;
-				bindings[bindingIndex] = {
-					static_cast<uint32_t>(bindingIndex),
-					type,
-					descriptorCount,
-					stageFlagBits,
-					nullptr
-				};
+			}
+			else if (layout != nullptr)
+			{
+				ReadBindingsFromLayout(*layout, bindings, bindingSizes);
+			}
+			else
+			{
+				ReadBindingsFromJson(json["bindings"], bindings, bindingSizes);
 			}
 
 			uint64_t hash = 0;
-			int bindingsCount = maxBindingIndex + 1;
+			const uint32_t bindingsCount = static_cast<uint32_t>(bindings.size());
 
+			std::vector<VkDescriptorSetLayoutBinding> usedBindings;
+			std::vector<VkDescriptorType> types;
 			m_vulkanBindings.resize(bindingsCount);
 			for (uint32_t i = 0; i < bindingsCount; i++)
 			{
+				if (bindings[i].descriptorCount == 0)
+				{
+					m_vulkanBindings[i] = {VK_DESCRIPTOR_TYPE_MAX_ENUM, 0};
+					continue;
+				}
+
 				uint64_t binding_hash = i
 					| bindings[i].descriptorType << 8
 					| bindings[i].descriptorCount << 16
@@ -104,16 +89,18 @@ namespace JoyEngine
 
 				m_vulkanBindings[i] = {
 					bindings[i].descriptorType,
-					bindingCurrentOffsets[i]
+					bindingSizes[i]
 				};
+				usedBindings.push_back(bindings[i]);
+				types.insert(types.end(), bindings[i].descriptorCount, bindings[i].descriptorType);
 			}
 
 			VkDescriptorSetLayoutCreateInfo layoutInfo{
 				VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
 				nullptr,
 				0,
-				static_cast<uint32_t>(maxBindingIndex + 1),
-				bindings.data()
+				static_cast<uint32_t>(usedBindings.size()),
+				usedBindings.data()
 			};
 
 			VkResult res = vkCreateDescriptorSetLayout(
@@ -122,7 +109,7 @@ namespace JoyEngine
 				JoyContext::Graphics->GetAllocationCallbacks(),
 				&m_setLayout);
 			ASSERT(res == VK_SUCCESS);
-			if (bindingsCount > 0)
+			if (!usedBindings.empty())
 			{
 				JoyContext::DescriptorSet->RegisterPool(hash, m_setLayout, types);
 			}
@@ -141,6 +128,166 @@ namespace JoyEngine
 			std::string define = bindingsDefinesArray[i].GetString();
 			m_bindingDefines.push_back(strHash(define.c_str()));
 		}
+		ASSERT_DESC(!m_isBindless ||
+		            std::find(m_bindingDefines.begin(), m_bindingDefines.end(), strHash("JOY_BINDLESS")) !=
+		            m_bindingDefines.end(),
+		            "Bindless material needs JOY_BINDLESS binding define");
+		ASSERT_DESC(!m_isCameraFromJoyVariables ||
+		            std::find(m_bindingDefines.begin(), m_bindingDefines.end(), strHash("JOY_VARIABLES")) !=
+		            m_bindingDefines.end(),
+		            "Camera from JOY_VARIABLES needs JOY_VARIABLES binding define");
+	}
+
+	void SharedMaterial::ReadBindlessDataFromJson(const rapidjson::Value& bindingsValue)
+	{
+		for (const auto& binding : bindingsValue.GetArray())
+		{
+			std::string typeStr = binding["type"].GetString();
+			std::string nameStr = binding["name"].GetString();
+			uint32_t count = binding["count"].GetUint();
+			// a texture is a single slot in the packed data
+			if (typeStr == "texture" && count != 1)
+			{
+				throw std::runtime_error("bindless texture arrays are not supported: " + nameStr);
+			}
+
+			m_bindings.insert({
+				nameStr, {
+					0,
+					typeStr,
+					count,
+					m_bindlessDataSize,
+					0,
+					false
+				}
+			});
+			m_bindlessDataSize += typeStr == "texture"
+				                      ? sizeof(uint32_t)
+				                      : SerializationUtils::GetTypeSize(typeStr) * count;
+		}
+		ASSERT_DESC(m_bindlessDataSize <= BindlessRegistry::MATERIAL_DATA_SIZE, "Bindless material data is too big");
+	}
+
+	void SharedMaterial::ReadBindingsFromJson(const rapidjson::Value& bindingsValue,
+	                                          std::vector<VkDescriptorSetLayoutBinding>& bindings,
+	                                          std::vector<size_t>& bindingSizes)
+	{
+		const auto bindingsArray = bindingsValue.GetArray();
+		const uint32_t bindingsArraySize = bindingsArray.Size();
+
+		for (uint32_t i = 0; i < bindingsArraySize; i++)
+		{
+			std::string typeStr = bindingsArray[i]["type"].GetString();
+			std::string nameStr = bindingsArray[i]["name"].GetString();
+			uint32_t bindingIndex = bindingsArray[i]["index"].GetUint();
+			uint32_t count = bindingsArray[i]["count"].GetUint();
+
+			if (bindingIndex >= bindings.size())
+			{
+				bindings.resize(bindingIndex + 1, {});
+				bindingSizes.resize(bindingIndex + 1, 0);
+			}
+
+			m_bindings.insert({
+				nameStr, {
+					bindingIndex,
+					typeStr,
+					count,
+					bindingSizes[bindingIndex],
+					0,
+					false
+				}
+			});
+			const VkDescriptorType type = GetTypeFromStr(typeStr);
+			if (type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER)
+			{
+				bindingSizes[bindingIndex] += SerializationUtils::GetTypeSize(typeStr) * count;
+			}
+
+			VkShaderStageFlags stageFlagBits = 0;
+			if (type == VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT)
+			{
+				stageFlagBits = VK_SHADER_STAGE_FRAGMENT_BIT;
+			}
+			else
+			{
+				stageFlagBits = VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_VERTEX_BIT;
+			}
+			const uint32_t descriptorCount = 1;
+			bindings[bindingIndex] = {
+				bindingIndex,
+				type,
+				descriptorCount,
+				stageFlagBits,
+				nullptr
+			};
+		}
+	}
+
+	void SharedMaterial::ReadBindingsFromLayout(const ShaderLayout& layout,
+	                                            std::vector<VkDescriptorSetLayoutBinding>& bindings,
+	                                            std::vector<size_t>& bindingSizes)
+	{
+		for (const auto& binding : layout.bindings)
+		{
+			// set 0 is the material set, the rest are provided by binding defines
+			if (binding.set != 0) continue;
+			// zero count would mark the index unused, see Initialize
+			ASSERT_DESC(binding.descriptorCount != 0, "Runtime descriptor arrays are not supported in material set");
+
+			if (binding.binding >= bindings.size())
+			{
+				bindings.resize(binding.binding + 1, {});
+				bindingSizes.resize(binding.binding + 1, 0);
+			}
+
+			const auto type = static_cast<VkDescriptorType>(binding.descriptorType);
+			bindings[binding.binding] = {
+				binding.binding,
+				type,
+				binding.descriptorCount,
+				binding.stageFlags,
+				nullptr
+			};
+			bindingSizes[binding.binding] = binding.blockSize;
+
+			switch (type)
+			{
+			case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
+				m_bindings.insert({layout.GetName(binding.nameOffset), {binding.binding, "texture", 1, 0, 0, false}});
+				break;
+			case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT:
+				m_bindings.insert({layout.GetName(binding.nameOffset), {binding.binding, "attachment", 1, 0, 0, false}});
+				break;
+			case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+				for (uint32_t i = 0; i < binding.memberCount; i++)
+				{
+					const ShaderMemberDesc& member = layout.members[binding.firstMember + i];
+					const char* typeStr = GetStrFromTypeHash(member.typeHash);
+					// members without serializable type (nested structs etc.) can't be set from material data
+					if (typeStr == nullptr) continue;
+					m_bindings.insert({
+						layout.GetName(member.nameOffset), {
+							binding.binding,
+							typeStr,
+							member.arrayCount,
+							member.offset,
+							member.arrayStride,
+							true
+						}
+					});
+				}
+				break;
+			default:
+				ASSERT_DESC(false, "Unsupported descriptor type in material set");
+				break;
+			}
+		}
+
+		for (const auto& range : layout.pushConstants)
+		{
+			m_pushConstantRanges.push_back({range.stageFlags, range.offset, range.size});
+		}
 	}
 
 	void SharedMaterial::CreateGraphicsPipeline()
@@ -157,16 +304,29 @@ namespace JoyEngine
 		fragShaderStageInfo.module = m_shader->GetFragmentShadeModule();
 		fragShaderStageInfo.pName = "main";
 
-		auto bindingDescription = Vertex::getBindingDescription();
-		auto attributeDescriptions = Vertex::getAttributeDescriptions();
+		std::vector<VkVertexInputBindingDescription> bindingDescriptions = {Vertex::getBindingDescription()};
+		std::vector<VkVertexInputAttributeDescription> attributeDescriptions;
+		for (const auto& attribute : Vertex::getAttributeDescriptions())
+		{
+			attributeDescriptions.push_back(attribute);
+		}
+		// material slot of bindless materials is instance data too
+		if (m_isInstanced || m_isBindless)
+		{
+			bindingDescriptions.push_back(InstanceData::getBindingDescription());
+			for (const auto& attribute : InstanceData::getAttributeDescriptions())
+			{
+				attributeDescriptions.push_back(attribute);
+			}
+		}
 
 		VkPipelineShaderStageCreateInfo shaderStages[] = {vertShaderStageInfo, fragShaderStageInfo};
 
 		VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
 		vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-		vertexInputInfo.vertexBindingDescriptionCount = 1;
+		vertexInputInfo.vertexBindingDescriptionCount = static_cast<uint32_t>(bindingDescriptions.size());
 		vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
-		vertexInputInfo.pVertexBindingDescriptions = &bindingDescription;
+		vertexInputInfo.pVertexBindingDescriptions = bindingDescriptions.data();
 		vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions.data();
 
 		VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
@@ -266,14 +426,18 @@ namespace JoyEngine
 		colorBlending.blendConstants[2] = 0.0f; // Optional
 		colorBlending.blendConstants[3] = 0.0f; // Optional
 
-		VkPushConstantRange pushConstantRange{
-			VK_SHADER_STAGE_VERTEX_BIT,
-			0,
-			sizeof(MVP)
-		};
+		if (m_shader->GetLayout() == nullptr)
+		{
+			m_pushConstantRanges.push_back({
+				VK_SHADER_STAGE_VERTEX_BIT,
+				0,
+				m_isCameraFromJoyVariables ? sizeof(glm::mat4) : sizeof(MVP)
+			});
+		}
 
+		// set indices no define uses get the material layout, shaders don't access them
 		std::array<VkDescriptorSetLayout, 4> layouts;
-		layouts[0] = m_setLayout;
+		layouts.fill(m_setLayout);
 		uint32_t maxLayoutIndex = 0;
 		for (const auto& def : m_bindingDefines)
 		{
@@ -291,8 +455,8 @@ namespace JoyEngine
 			0,
 			maxLayoutIndex+1,
 			layouts.data(),
-			1,
-			&pushConstantRange
+			static_cast<uint32_t>(m_pushConstantRanges.size()),
+			m_pushConstantRanges.data()
 		};
 
 		VkResult res = vkCreatePipelineLayout(JoyContext::Graphics->GetDevice(),
@@ -380,6 +544,31 @@ namespace JoyEngine
 		}
 	}
 
+	const char* SharedMaterial::GetStrFromTypeHash(uint32_t typeHash) noexcept
+	{
+		switch (typeHash)
+		{
+		case strHash("int"):
+			return "int";
+		case strHash("uint"):
+			return "uint";
+		case strHash("float"):
+			return "float";
+		case strHash("vec2"):
+			return "vec2";
+		case strHash("vec3"):
+			return "vec3";
+		case strHash("vec4"):
+			return "vec4";
+		case strHash("mat3"):
+			return "mat3";
+		case strHash("mat4"):
+			return "mat4";
+		default:
+			return nullptr;
+		}
+	}
+
 	bool SharedMaterial::IsLoaded() const noexcept
 	{
 		return m_shader->IsLoaded();
@@ -423,6 +612,16 @@ namespace JoyEngine
 		return m_setLayoutHash;
 	}
 
+	VkShaderStageFlags SharedMaterial::GetPushConstantStageFlags() const noexcept
+	{
+		VkShaderStageFlags flags = 0;
+		for (const auto& range : m_pushConstantRanges)
+		{
+			flags |= range.stageFlags;
+		}
+		return flags;
+	}
+
 	std::vector<VulkanBindingDescription>& SharedMaterial::GetVulkanBindings()
 	{
 		return m_vulkanBindings;
@@ -6,6 +6,7 @@
 #include <string>
 
 #include <vulkan/vulkan.h>
+#include <rapidjson/document.h>
 
 #include "Buffer.h"
 #include "Common/Resource.h"
@@ -36,6 +37,10 @@ namespace JoyEngine
 		std::string type;
 		uint32_t count;
 		size_t offset;
+		// distance between array elements in the uniform block, 0 if they are tightly packed
+		uint32_t stride;
+		// reflected from shader, otherwise data is tightly packed as described in shared material json
+		bool isStd140;
 	};
 
 	struct BindingBase
@@ -65,8 +70,19 @@ namespace JoyEngine
 		[[nodiscard]] BindingInfo* GetBindingInfoByName(const std::string& name) noexcept;
 		[[nodiscard]] uint64_t GetSetLayoutHash() const noexcept;
 		[[nodiscard]] std::vector<VulkanBindingDescription>& GetVulkanBindings();
+		[[nodiscard]] VkShaderStageFlags GetPushConstantStageFlags() const noexcept;
+		// model matrices come from per instance vertex data, MVP push constant has identity model
+		[[nodiscard]] bool IsInstanced() const noexcept { return m_isInstanced; }
+		// Parameters of materials are in JOY_BINDLESS set, which shaders index by per instance material slot.
+		// Material set is empty, bindings describe parameters tightly packed in 32 bit words, textures are slots
+		[[nodiscard]] bool IsBindless() const noexcept { return m_isBindless; }
+		[[nodiscard]] size_t GetBindlessDataSize() const noexcept { return m_bindlessDataSize; }
+		// View and projection are read from JOY_VARIABLES, push constant is only the model matrix.
+		// Command buffers of such pipelines don't change with the camera and are reused
+		[[nodiscard]] bool IsCameraFromJoyVariables() const noexcept { return m_isCameraFromJoyVariables; }
 
 		static VkDescriptorType GetTypeFromStr(const std::string& type) noexcept;
+		static const char* GetStrFromTypeHash(uint32_t typeHash) noexcept;
 
 		[[nodiscard]] bool IsLoaded() const noexcept override;
 
@@ -84,6 +100,10 @@ namespace JoyEngine
 
 		bool m_hasVertexInput = false;
 		bool m_hasMVP = false;
+		bool m_isInstanced = false;
+		bool m_isBindless = false;
+		size_t m_bindlessDataSize = 0;
+		bool m_isCameraFromJoyVariables = false;
 		bool m_depthTest = false;
 		bool m_depthWrite = false;
 		uint32_t m_colorAttachmentsCount;
@@ -93,6 +113,7 @@ namespace JoyEngine
 		uint64_t m_setLayoutHash;
 		std::map<std::string, BindingInfo> m_bindings;
 		std::vector<VulkanBindingDescription> m_vulkanBindings;
+		std::vector<VkPushConstantRange> m_pushConstantRanges;
 
 		std::vector<uint32_t> m_bindingDefines;
 
@@ -102,6 +123,16 @@ namespace JoyEngine
 	private:
 		void Initialize();
 
+		void ReadBindingsFromJson(const rapidjson::Value& bindingsValue,
+		                          std::vector<VkDescriptorSetLayoutBinding>& bindings,
+		                          std::vector<size_t>& bindingSizes);
+
+		void ReadBindlessDataFromJson(const rapidjson::Value& bindingsValue);
+
+		void ReadBindingsFromLayout(const ShaderLayout& layout,
+		                            std::vector<VkDescriptorSetLayoutBinding>& bindings,
+		                            std::vector<size_t>& bindingSizes);
+
 		void CreateGraphicsPipeline();
 	};
 }
@@ -9,6 +9,7 @@
 #include "DataManager/DataManager.h"
 #include "MemoryManager/MemoryManager.h"
 #include "GraphicsManager/GraphicsManager.h"
+#include "RenderManager/RenderManager.h"
 
 
 namespace JoyEngine
@@ -47,10 +48,34 @@ namespace JoyEngine
 		m_width = width;
 		m_height = height;
 
+		m_bindlessSlot = JoyContext::Render->GetBindlessRegistry()->RegisterTexture();
 
 		InitializeTexture(m_textureStream, sizeof(uint32_t) + sizeof(uint32_t));
 	}
 
+	void Texture::OnLoaded()
+	{
+		if (m_textureStream.is_open())
+		{
+			m_textureStream.close();
+		}
+		m_isLoaded = true;
+		// a texture retired while loading has no slot anymore
+		if (m_bindlessSlot != BindlessRegistry::INVALID_SLOT)
+		{
+			JoyContext::Render->GetBindlessRegistry()->SetTexture(m_bindlessSlot, this);
+		}
+	}
+
+	void Texture::OnRetired()
+	{
+		if (m_bindlessSlot != BindlessRegistry::INVALID_SLOT)
+		{
+			JoyContext::Render->GetBindlessRegistry()->UnregisterTexture(m_bindlessSlot);
+			m_bindlessSlot = BindlessRegistry::INVALID_SLOT;
+		}
+	}
+
 	void Texture::InitializeTexture(const unsigned char* data)
 	{
 		CreateImage();
@@ -200,6 +225,8 @@ namespace JoyEngine
 
 	Texture::~Texture()
 	{
+		// resources destroyed with resource manager aren't retired
+		OnRetired();
 		if (m_textureSampler != VK_NULL_HANDLE)
 		{
 			vkDestroySampler(JoyContext::Graphics->GetDevice(), m_textureSampler,
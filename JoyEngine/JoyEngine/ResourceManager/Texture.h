@@ -6,6 +6,7 @@
 #include <vulkan/vulkan.h>
 
 #include "Common/Resource.h"
+#include "RenderManager/BindlessRegistry.h"
 #include "Utils/GUID.h"
 
 namespace JoyEngine
@@ -45,22 +46,25 @@ namespace JoyEngine
 
 		[[nodiscard]] bool IsLoaded() const noexcept override { return m_isLoaded; }
 
+		void OnRetired() override;
+
+		// index in JOY_BINDLESS texture array, only textures loaded from data have it
+		[[nodiscard]] uint32_t GetBindlessSlot() const noexcept { return m_bindlessSlot; }
+
 		[[nodiscard]] VkImageSubresourceRange* GetSubresourceRange() noexcept { return &m_subresourceRange; }
 	private:
 		void CreateImage();
 		void CreateImageView();
 		void CreateImageSampler();
+		void OnLoaded();
 
 	private :
 		bool m_isLoaded = false;
+		uint32_t m_bindlessSlot = BindlessRegistry::INVALID_SLOT;
 		std::ifstream m_textureStream;
 		std::function<void()> m_onLoadedCallback = [this]()
 		{
-			if (m_textureStream.is_open())
-			{
-				m_textureStream.close();
-			}
-			m_isLoaded = true;
+			OnLoaded();
 		};
 
 		uint32_t m_width = 0;
@@ -0,0 +1,482 @@
+#include "BoundingVolumeHierarchy.h"
+
+#include <algorithm>
+
+#include "JoyContext.h"
+#include "Utils/Assert.h"
+
+namespace JoyEngine
+{
+	BoundingVolumeHierarchy::~BoundingVolumeHierarchy()
+	{
+		ASSERT_DESC(!m_isBuilding, "Tree is destroyed while it's rebuilt");
+	}
+
+	uint32_t BoundingVolumeHierarchy::Insert(const AABB& bounds, void* userData)
+	{
+		uint32_t proxy;
+		if (!m_freeProxies.empty())
+		{
+			proxy = m_freeProxies.back();
+			m_freeProxies.pop_back();
+		}
+		else
+		{
+			proxy = static_cast<uint32_t>(m_proxies.size());
+			m_proxies.emplace_back();
+		}
+
+		const uint32_t leaf = AllocateNode();
+		m_nodes[leaf].bounds = bounds;
+		m_nodes[leaf].proxy = proxy;
+
+		Proxy& p = m_proxies[proxy];
+		p.bounds = bounds;
+		p.userData = userData;
+		p.leaf = leaf;
+		p.isAlive = true;
+		p.isMoved = false;
+
+		InsertLeaf(leaf);
+		m_proxyCount++;
+		m_changeCount++;
+		return proxy;
+	}
+
+	void BoundingVolumeHierarchy::Remove(uint32_t proxy)
+	{
+		Proxy& p = m_proxies[proxy];
+		ASSERT(p.isAlive);
+		RemoveLeaf(p.leaf);
+		FreeNode(p.leaf);
+		p.leaf = INVALID_HANDLE;
+		p.userData = nullptr;
+		p.generation++;
+		p.isAlive = false;
+		p.isMoved = false;
+		m_freeProxies.push_back(proxy);
+		m_proxyCount--;
+		m_changeCount++;
+	}
+
+	void BoundingVolumeHierarchy::Move(uint32_t proxy, const AABB& bounds)
+	{
+		Proxy& p = m_proxies[proxy];
+		ASSERT(p.isAlive);
+		p.bounds = bounds;
+		if (!p.isMoved)
+		{
+			p.isMoved = true;
+			m_movedProxies.push_back(proxy);
+			m_changeCount++;
+		}
+	}
+
+	float BoundingVolumeHierarchy::GetCost() const noexcept
+	{
+		if (m_root == INVALID_HANDLE || m_nodes[m_root].IsLeaf())
+		{
+			return 0;
+		}
+		float area = 0;
+		std::vector<uint32_t> stack = {m_root};
+		while (!stack.empty())
+		{
+			const Node& node = m_nodes[stack.back()];
+			stack.pop_back();
+			if (!node.IsLeaf())
+			{
+				area += node.bounds.GetHalfArea();
+				stack.push_back(node.left);
+				stack.push_back(node.right);
+			}
+		}
+		return area / m_nodes[m_root].bounds.GetHalfArea();
+	}
+
+	void BoundingVolumeHierarchy::Update()
+	{
+		if (m_isBuilding && m_buildJob.IsDone())
+		{
+			FinishRebuild();
+		}
+
+		for (const uint32_t proxy : m_movedProxies)
+		{
+			Proxy& p = m_proxies[proxy];
+			// removed or already applied by rebuild
+			if (!p.isMoved)
+			{
+				continue;
+			}
+			p.isMoved = false;
+			Node& leaf = m_nodes[p.leaf];
+			// refit would stretch every ancestor between the old and new place, teleported proxies are reinserted
+			if (!leaf.bounds.Intersects(p.bounds))
+			{
+				RemoveLeaf(p.leaf);
+				m_nodes[p.leaf].bounds = p.bounds;
+				InsertLeaf(p.leaf);
+				continue;
+			}
+			leaf.bounds = p.bounds;
+			RefitFrom(leaf.parent);
+		}
+		m_movedProxies.clear();
+
+		if (!m_isBuilding &&
+			m_proxyCount >= MIN_REBUILD_PROXY_COUNT &&
+			static_cast<float>(m_changeCount) >= static_cast<float>(m_proxyCount) * REBUILD_CHANGE_RATIO)
+		{
+			StartRebuild();
+		}
+	}
+
+	void BoundingVolumeHierarchy::Rebuild()
+	{
+		WaitForRebuild();
+		CollectBuildItems(m_buildItems);
+		m_buildRoot = Build(m_buildItems, m_buildNodes);
+		m_changeCount = 0;
+		FinishRebuild();
+	}
+
+	void BoundingVolumeHierarchy::WaitForRebuild()
+	{
+		if (m_isBuilding)
+		{
+			JoyContext::Jobs->Wait(m_buildJob);
+			FinishRebuild();
+		}
+	}
+
+	uint32_t BoundingVolumeHierarchy::AllocateNode()
+	{
+		if (!m_freeNodes.empty())
+		{
+			const uint32_t node = m_freeNodes.back();
+			m_freeNodes.pop_back();
+			m_nodes[node] = Node();
+			return node;
+		}
+		m_nodes.emplace_back();
+		return static_cast<uint32_t>(m_nodes.size() - 1);
+	}
+
+	void BoundingVolumeHierarchy::FreeNode(uint32_t node)
+	{
+		m_freeNodes.push_back(node);
+	}
+
+	void BoundingVolumeHierarchy::InsertLeaf(uint32_t leaf)
+	{
+		if (m_root == INVALID_HANDLE)
+		{
+			m_root = leaf;
+			m_nodes[leaf].parent = INVALID_HANDLE;
+			return;
+		}
+
+		// descend while pushing the leaf down is cheaper than pairing it with the current node
+		const AABB leafBounds = m_nodes[leaf].bounds;
+		uint32_t sibling = m_root;
+		while (!m_nodes[sibling].IsLeaf())
+		{
+			const Node& node = m_nodes[sibling];
+			const float area = node.bounds.GetHalfArea();
+			const float combinedArea = AABB::Union(node.bounds, leafBounds).GetHalfArea();
+			// new parent of node and leaf
+			const float cost = 2 * combinedArea;
+			// every ancestor of the leaf grows if it goes down
+			const float inheritanceCost = 2 * (combinedArea - area);
+
+			auto getChildCost = [this, &leafBounds, inheritanceCost](uint32_t child)
+			{
+				const Node& childNode = m_nodes[child];
+				const float childArea = AABB::Union(childNode.bounds, leafBounds).GetHalfArea();
+				return childNode.IsLeaf()
+					       ? childArea + inheritanceCost
+					       : childArea - childNode.bounds.GetHalfArea() + inheritanceCost;
+			};
+			const float leftCost = getChildCost(node.left);
+			const float rightCost = getChildCost(node.right);
+			if (cost < leftCost && cost < rightCost)
+			{
+				break;
+			}
+			sibling = leftCost < rightCost ? node.left : node.right;
+		}
+
+		const uint32_t oldParent = m_nodes[sibling].parent;
+		const uint32_t newParent = AllocateNode();
+		Node& parent = m_nodes[newParent];
+		parent.parent = oldParent;
+		parent.bounds = AABB::Union(leafBounds, m_nodes[sibling].bounds);
+		parent.left = sibling;
+		parent.right = leaf;
+		m_nodes[sibling].parent = newParent;
+		m_nodes[leaf].parent = newParent;
+
+		if (oldParent == INVALID_HANDLE)
+		{
+			m_root = newParent;
+			return;
+		}
+		if (m_nodes[oldParent].left == sibling)
+		{
+			m_nodes[oldParent].left = newParent;
+		}
+		else
+		{
+			m_nodes[oldParent].right = newParent;
+		}
+		RefitFrom(oldParent);
+	}
+
+	void BoundingVolumeHierarchy::RemoveLeaf(uint32_t leaf)
+	{
+		if (leaf == m_root)
+		{
+			m_root = INVALID_HANDLE;
+			return;
+		}
+
+		const uint32_t parent = m_nodes[leaf].parent;
+		const uint32_t grandParent = m_nodes[parent].parent;
+		const uint32_t sibling = m_nodes[parent].left == leaf ? m_nodes[parent].right : m_nodes[parent].left;
+		m_nodes[leaf].parent = INVALID_HANDLE;
+		FreeNode(parent);
+
+		m_nodes[sibling].parent = grandParent;
+		if (grandParent == INVALID_HANDLE)
+		{
+			m_root = sibling;
+			return;
+		}
+		if (m_nodes[grandParent].left == parent)
+		{
+			m_nodes[grandParent].left = sibling;
+		}
+		else
+		{
+			m_nodes[grandParent].right = sibling;
+		}
+		RefitFrom(grandParent);
+	}
+
+	void BoundingVolumeHierarchy::RefitFrom(uint32_t node)
+	{
+		while (node != INVALID_HANDLE)
+		{
+			Node& n = m_nodes[node];
+			const AABB bounds = AABB::Union(m_nodes[n.left].bounds, m_nodes[n.right].bounds);
+			if (bounds == n.bounds)
+			{
+				break;
+			}
+			n.bounds = bounds;
+			node = n.parent;
+		}
+	}
+
+	void BoundingVolumeHierarchy::CollectBuildItems(std::vector<BuildItem>& items) const
+	{
+		items.clear();
+		items.reserve(m_proxyCount);
+		for (uint32_t i = 0; i < m_proxies.size(); i++)
+		{
+			const Proxy& p = m_proxies[i];
+			if (p.isAlive)
+			{
+				items.push_back({p.bounds, p.bounds.GetCenter(), i, p.generation, INVALID_HANDLE});
+			}
+		}
+	}
+
+	uint32_t BoundingVolumeHierarchy::Build(std::vector<BuildItem>& items, std::vector<Node>& nodes)
+	{
+		nodes.clear();
+		if (items.empty())
+		{
+			return INVALID_HANDLE;
+		}
+		nodes.reserve(items.size() * 2 - 1);
+
+		struct Task
+		{
+			uint32_t node;
+			uint32_t begin;
+			uint32_t end;
+		};
+		std::vector<Task> stack;
+		nodes.emplace_back();
+		stack.push_back({0, 0, static_cast<uint32_t>(items.size())});
+
+		while (!stack.empty())
+		{
+			const Task task = stack.back();
+			stack.pop_back();
+
+			if (task.end - task.begin == 1)
+			{
+				BuildItem& item = items[task.begin];
+				nodes[task.node].bounds = item.bounds;
+				nodes[task.node].proxy = item.proxy;
+				item.leaf = task.node;
+				continue;
+			}
+
+			AABB centroidBounds;
+			for (uint32_t i = task.begin; i < task.end; i++)
+			{
+				centroidBounds.Add(items[i].center);
+			}
+			const glm::vec3 centroidExtents = centroidBounds.max - centroidBounds.min;
+			const int axis = centroidExtents.x > centroidExtents.y
+				                 ? (centroidExtents.x > centroidExtents.z ? 0 : 2)
+				                 : (centroidExtents.y > centroidExtents.z ? 1 : 2);
+			const float extent = centroidExtents[axis];
+
+			uint32_t mid = (task.begin + task.end) / 2;
+			if (extent > 0)
+			{
+				const float scale = static_cast<float>(SAH_BIN_COUNT) / extent;
+				const float origin = centroidBounds.min[axis];
+				auto getBin = [scale, origin, axis](const BuildItem& item)
+				{
+					return std::min(SAH_BIN_COUNT - 1, static_cast<uint32_t>((item.center[axis] - origin) * scale));
+				};
+
+				AABB binBounds[SAH_BIN_COUNT];
+				uint32_t binCounts[SAH_BIN_COUNT] = {};
+				for (uint32_t i = task.begin; i < task.end; i++)
+				{
+					const uint32_t bin = getBin(items[i]);
+					binBounds[bin].Add(items[i].bounds);
+					binCounts[bin]++;
+				}
+
+				// cost of splitting after bin i is leftCount * leftArea + rightCount * rightArea
+				float leftCosts[SAH_BIN_COUNT - 1];
+				AABB leftBounds;
+				uint32_t leftCount = 0;
+				for (uint32_t i = 0; i < SAH_BIN_COUNT - 1; i++)
+				{
+					leftBounds.Add(binBounds[i]);
+					leftCount += binCounts[i];
+					// splits with an empty side are never taken
+					leftCosts[i] = leftCount == 0 ? FLT_MAX : static_cast<float>(leftCount) * leftBounds.GetHalfArea();
+				}
+				AABB rightBounds;
+				uint32_t rightCount = 0;
+				float bestCost = FLT_MAX;
+				uint32_t bestSplit = 0;
+				for (uint32_t i = SAH_BIN_COUNT - 1; i > 0; i--)
+				{
+					rightBounds.Add(binBounds[i]);
+					rightCount += binCounts[i];
+					if (rightCount == 0 || leftCosts[i - 1] == FLT_MAX)
+					{
+						continue;
+					}
+					const float cost = leftCosts[i - 1] + static_cast<float>(rightCount) * rightBounds.GetHalfArea();
+					if (cost < bestCost)
+					{
+						bestCost = cost;
+						bestSplit = i - 1;
+					}
+				}
+
+				const auto it = std::partition(
+					items.begin() + task.begin,
+					items.begin() + task.end,
+					[&getBin, bestSplit](const BuildItem& item) { return getBin(item) <= bestSplit; });
+				const auto partitionMid = static_cast<uint32_t>(it - items.begin());
+				if (partitionMid != task.begin && partitionMid != task.end)
+				{
+					mid = partitionMid;
+				}
+			}
+
+			const auto left = static_cast<uint32_t>(nodes.size());
+			const uint32_t right = left + 1;
+			nodes.emplace_back();
+			nodes.emplace_back();
+			nodes[task.node].left = left;
+			nodes[task.node].right = right;
+			nodes[left].parent = task.node;
+			nodes[right].parent = task.node;
+			stack.push_back({right, mid, task.end});
+			stack.push_back({left, task.begin, mid});
+		}
+		// bounds of internal nodes are computed when the tree is swapped in, from bounds at that moment
+		return 0;
+	}
+
+	void BoundingVolumeHierarchy::StartRebuild()
+	{
+		CollectBuildItems(m_buildItems);
+		m_changeCount = 0;
+		m_isBuilding = true;
+		JoyContext::Jobs->Run([this]()
+		{
+			m_buildRoot = Build(m_buildItems, m_buildNodes);
+		}, &m_buildJob);
+	}
+
+	void BoundingVolumeHierarchy::FinishRebuild()
+	{
+		m_isBuilding = false;
+		m_nodes.swap(m_buildNodes);
+		m_root = m_buildRoot;
+		m_freeNodes.clear();
+
+		// leaves of proxies which are still alive take their current bounds
+		std::vector<bool> isBuilt(m_proxies.size(), false);
+		std::vector<uint32_t> staleLeaves;
+		for (const BuildItem& item : m_buildItems)
+		{
+			Proxy& p = m_proxies[item.proxy];
+			if (p.isAlive && p.generation == item.generation)
+			{
+				p.leaf = item.leaf;
+				m_nodes[item.leaf].bounds = p.bounds;
+				isBuilt[item.proxy] = true;
+			}
+			else
+			{
+				staleLeaves.push_back(item.leaf);
+			}
+		}
+		// parents go before children in a built tree
+		for (uint32_t i = static_cast<uint32_t>(m_nodes.size()); i-- > 0;)
+		{
+			Node& node = m_nodes[i];
+			if (!node.IsLeaf())
+			{
+				node.bounds = AABB::Union(m_nodes[node.left].bounds, m_nodes[node.right].bounds);
+			}
+		}
+
+		// proxies removed and inserted during the build
+		for (const uint32_t leaf : staleLeaves)
+		{
+			RemoveLeaf(leaf);
+			FreeNode(leaf);
+		}
+		for (uint32_t i = 0; i < m_proxies.size(); i++)
+		{
+			Proxy& p = m_proxies[i];
+			if (p.isAlive && !isBuilt[i])
+			{
+				p.leaf = AllocateNode();
+				m_nodes[p.leaf].bounds = p.bounds;
+				m_nodes[p.leaf].proxy = i;
+				InsertLeaf(p.leaf);
+			}
+		}
+
+		m_buildItems.clear();
+		m_buildNodes.clear();
+	}
+}
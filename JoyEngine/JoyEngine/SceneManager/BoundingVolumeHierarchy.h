@@ -0,0 +1,328 @@
+#ifndef BOUNDING_VOLUME_HIERARCHY_H
+#define BOUNDING_VOLUME_HIERARCHY_H
+
+#include <vector>
+#include <cstdint>
+
+#include "Common/Bounds.h"
+#include "Common/JobSystem.h"
+
+namespace JoyEngine
+{
+	// Dynamic binary tree of world space boxes, one leaf per proxy.
+	// Proxies are inserted incrementally with SAH cost heuristic, moved proxies only refit their ancestors in Update.
+	// Refit degrades the tree, so after enough changes it's rebuilt with binned SAH on a worker
+	// and swapped in by a later Update, changes made during the build are applied after the swap.
+	// Queries see bounds as of the last Update. Main thread only, except for queries between updates
+	class BoundingVolumeHierarchy
+	{
+	public:
+		static constexpr uint32_t INVALID_HANDLE = 0xFFFFFFFF;
+
+		BoundingVolumeHierarchy() = default;
+
+		~BoundingVolumeHierarchy();
+
+		BoundingVolumeHierarchy(const BoundingVolumeHierarchy&) = delete;
+
+		BoundingVolumeHierarchy& operator=(const BoundingVolumeHierarchy&) = delete;
+
+		uint32_t Insert(const AABB& bounds, void* userData);
+
+		void Remove(uint32_t proxy);
+
+		// tree is refit in the next Update
+		void Move(uint32_t proxy, const AABB& bounds);
+
+		[[nodiscard]] void* GetUserData(uint32_t proxy) const noexcept { return m_proxies[proxy].userData; }
+
+		[[nodiscard]] const AABB& GetBounds(uint32_t proxy) const noexcept { return m_proxies[proxy].bounds; }
+
+		[[nodiscard]] uint32_t GetProxyCount() const noexcept { return m_proxyCount; }
+
+		// sum of node areas relative to the root, lower is better
+		[[nodiscard]] float GetCost() const noexcept;
+
+		// refits moved proxies, swaps in finished rebuild and starts a new one if tree has changed enough
+		void Update();
+
+		// builds the tree from scratch on the calling thread
+		void Rebuild();
+
+		// waits for the running rebuild and swaps it in, has to be called before job system is destroyed
+		void WaitForRebuild();
+
+		// f(proxy, userData) for proxies intersecting the frustum
+		template <typename F>
+		void QueryFrustum(const Frustum& frustum, F&& f) const;
+
+		// Tests internal nodes only: inside(proxy, userData) for proxies of subtrees inside the frustum,
+		// intersecting(proxy, userData) for proxies whose parent crosses the frustum, their bounds are left to the caller
+		template <typename FInside, typename FIntersecting>
+		void QueryFrustumBroad(const Frustum& frustum, FInside&& inside, FIntersecting&& intersecting) const;
+
+		// f(proxy, userData) for proxies intersecting the sphere
+		template <typename F>
+		void QuerySphere(glm::vec3 center, float radius, F&& f) const;
+
+		// f(proxy, userData) for proxies whose bounds are hit closer than maxDistance, nearest nodes first.
+		// f returns distance to the hit, or maxDistance if proxy isn't hit, further boxes are skipped
+		template <typename F>
+		void QueryRay(const Ray& ray, float maxDistance, F&& f) const;
+
+	private:
+		struct Node
+		{
+			AABB bounds;
+			uint32_t parent = INVALID_HANDLE;
+			// both are INVALID_HANDLE for leaves
+			uint32_t left = INVALID_HANDLE;
+			uint32_t right = INVALID_HANDLE;
+			uint32_t proxy = INVALID_HANDLE;
+
+			[[nodiscard]] bool IsLeaf() const noexcept { return left == INVALID_HANDLE; }
+		};
+
+		struct Proxy
+		{
+			AABB bounds;
+			void* userData = nullptr;
+			uint32_t leaf = INVALID_HANDLE;
+			// incremented on removal, so rebuild doesn't confuse reused handles
+			uint32_t generation = 0;
+			bool isAlive = false;
+			bool isMoved = false;
+		};
+
+		struct BuildItem
+		{
+			AABB bounds;
+			glm::vec3 center;
+			uint32_t proxy;
+			uint32_t generation;
+			uint32_t leaf;
+		};
+
+	private:
+		uint32_t AllocateNode();
+
+		void FreeNode(uint32_t node);
+
+		void InsertLeaf(uint32_t leaf);
+
+		void RemoveLeaf(uint32_t leaf);
+
+		// recomputes bounds from node up to the root, stops when bounds don't change
+		void RefitFrom(uint32_t node);
+
+		void CollectBuildItems(std::vector<BuildItem>& items) const;
+
+		// binned SAH, parents go before children in nodes
+		static uint32_t Build(std::vector<BuildItem>& items, std::vector<Node>& nodes);
+
+		void StartRebuild();
+
+		void FinishRebuild();
+
+	private:
+		// changes since the last build which trigger rebuild, relative to proxy count
+		static constexpr float REBUILD_CHANGE_RATIO = 0.25f;
+		// smaller trees stay incremental
+		static constexpr uint32_t MIN_REBUILD_PROXY_COUNT = 256;
+		static constexpr uint32_t SAH_BIN_COUNT = 16;
+
+		std::vector<Node> m_nodes;
+		std::vector<uint32_t> m_freeNodes;
+		uint32_t m_root = INVALID_HANDLE;
+
+		std::vector<Proxy> m_proxies;
+		std::vector<uint32_t> m_freeProxies;
+		std::vector<uint32_t> m_movedProxies;
+		uint32_t m_proxyCount = 0;
+		uint32_t m_changeCount = 0;
+
+		// owned by the build job while it runs
+		std::vector<BuildItem> m_buildItems;
+		std::vector<Node> m_buildNodes;
+		uint32_t m_buildRoot = INVALID_HANDLE;
+		bool m_isBuilding = false;
+		JobCounter m_buildJob;
+	};
+
+	template <typename F>
+	void BoundingVolumeHierarchy::QueryFrustum(const Frustum& frustum, F&& f) const
+	{
+		if (m_root == INVALID_HANDLE)
+		{
+			return;
+		}
+		struct Entry
+		{
+			uint32_t node;
+			bool isInside;
+		};
+		std::vector<Entry> stack;
+		stack.reserve(64);
+		stack.push_back({m_root, false});
+		while (!stack.empty())
+		{
+			const Entry entry = stack.back();
+			stack.pop_back();
+			const Node& node = m_nodes[entry.node];
+			bool isInside = entry.isInside;
+			if (!isInside)
+			{
+				const FrustumTest test = frustum.Test(node.bounds);
+				if (test == FrustumTest::Outside)
+				{
+					continue;
+				}
+				// subtree of a node inside the frustum is not tested anymore
+				isInside = test == FrustumTest::Inside;
+			}
+			if (node.IsLeaf())
+			{
+				f(node.proxy, m_proxies[node.proxy].userData);
+			}
+			else
+			{
+				stack.push_back({node.right, isInside});
+				stack.push_back({node.left, isInside});
+			}
+		}
+	}
+
+	template <typename FInside, typename FIntersecting>
+	void BoundingVolumeHierarchy::QueryFrustumBroad(const Frustum& frustum, FInside&& inside,
+	                                                FIntersecting&& intersecting) const
+	{
+		if (m_root == INVALID_HANDLE)
+		{
+			return;
+		}
+		struct Entry
+		{
+			uint32_t node;
+			bool isInside;
+		};
+		std::vector<Entry> stack;
+		stack.reserve(64);
+		stack.push_back({m_root, false});
+		while (!stack.empty())
+		{
+			const Entry entry = stack.back();
+			stack.pop_back();
+			const Node& node = m_nodes[entry.node];
+			if (node.IsLeaf())
+			{
+				if (entry.isInside)
+				{
+					inside(node.proxy, m_proxies[node.proxy].userData);
+				}
+				else
+				{
+					intersecting(node.proxy, m_proxies[node.proxy].userData);
+				}
+				continue;
+			}
+			bool isInside = entry.isInside;
+			if (!isInside)
+			{
+				const FrustumTest test = frustum.Test(node.bounds);
+				if (test == FrustumTest::Outside)
+				{
+					continue;
+				}
+				isInside = test == FrustumTest::Inside;
+			}
+			stack.push_back({node.right, isInside});
+			stack.push_back({node.left, isInside});
+		}
+	}
+
+	template <typename F>
+	void BoundingVolumeHierarchy::QuerySphere(glm::vec3 center, float radius, F&& f) const
+	{
+		if (m_root == INVALID_HANDLE)
+		{
+			return;
+		}
+		std::vector<uint32_t> stack;
+		stack.reserve(64);
+		stack.push_back(m_root);
+		while (!stack.empty())
+		{
+			const Node& node = m_nodes[stack.back()];
+			stack.pop_back();
+			if (!node.bounds.IntersectsSphere(center, radius))
+			{
+				continue;
+			}
+			if (node.IsLeaf())
+			{
+				f(node.proxy, m_proxies[node.proxy].userData);
+			}
+			else
+			{
+				stack.push_back(node.right);
+				stack.push_back(node.left);
+			}
+		}
+	}
+
+	template <typename F>
+	void BoundingVolumeHierarchy::QueryRay(const Ray& ray, float maxDistance, F&& f) const
+	{
+		if (m_root == INVALID_HANDLE)
+		{
+			return;
+		}
+		const glm::vec3 inverseDirection = 1.0f / ray.direction;
+		struct Entry
+		{
+			uint32_t node;
+			float distance;
+		};
+		std::vector<Entry> stack;
+		stack.reserve(64);
+		float distance;
+		if (!ray.Intersects(m_nodes[m_root].bounds, inverseDirection, maxDistance, distance))
+		{
+			return;
+		}
+		stack.push_back({m_root, distance});
+		while (!stack.empty())
+		{
+			const Entry entry = stack.back();
+			stack.pop_back();
+			// hit found after the node was pushed may be closer
+			if (entry.distance > maxDistance)
+			{
+				continue;
+			}
+			const Node& node = m_nodes[entry.node];
+			if (node.IsLeaf())
+			{
+				maxDistance = std::min(maxDistance, f(node.proxy, m_proxies[node.proxy].userData));
+				continue;
+			}
+			float leftDistance;
+			float rightDistance;
+			const bool isLeftHit = ray.Intersects(m_nodes[node.left].bounds, inverseDirection, maxDistance, leftDistance);
+			const bool isRightHit = ray.Intersects(m_nodes[node.right].bounds, inverseDirection, maxDistance, rightDistance);
+			// the nearer child is popped first
+			if (isLeftHit && isRightHit && leftDistance < rightDistance)
+			{
+				stack.push_back({node.right, rightDistance});
+				stack.push_back({node.left, leftDistance});
+			}
+			else
+			{
+				if (isLeftHit) stack.push_back({node.left, leftDistance});
+				if (isRightHit) stack.push_back({node.right, rightDistance});
+			}
+		}
+	}
+}
+
+#endif //BOUNDING_VOLUME_HIERARCHY_H
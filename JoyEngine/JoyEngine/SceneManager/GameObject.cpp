@@ -1,18 +1,25 @@
 #include "GameObject.h"
 
 namespace JoyEngine {
-    
-    void GameObject::Update()
-    {
-        for (const auto& c : m_components)
-        {
-            c->Update();
+
+    GameObject::~GameObject() {
+        DisableComponents();
+        for (Component *component: m_components) {
+            ComponentStorage::GetInstance()->Destroy(component);
+        }
+    }
+
+    void GameObject::DisableComponents() {
+        for (Component *component: m_components) {
+            if (component->IsEnabled()) {
+                component->Disable();
+            }
         }
     }
 
-    void GameObject::AddComponent(std::unique_ptr<Component> component) {
+    void GameObject::AddComponent(ComponentPtr<> component) {
         component->SetTransform(&m_transform);
         component->Enable();
-        m_components.push_back(std::move(component));
+        m_components.push_back(component.release());
     }
 }
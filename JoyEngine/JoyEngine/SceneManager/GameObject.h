@@ -7,7 +7,7 @@
 
 #include "Transform.h"
 #include "Components/Component.h"
-#include "Components/MeshRenderer.h"
+#include "Components/ComponentStorage.h"
 #include "Utils/GUID.h"
 
 namespace JoyEngine {
@@ -17,25 +17,28 @@ namespace JoyEngine {
 
         explicit GameObject(const char *name) {
             m_name = name;
-            m_transform = Transform();
         }
 
-        ~GameObject() {
-            for (auto &component: m_components) {
-                component->Disable();
-            }
-        }
-
-        void Update();
+        ~GameObject();
 
         Transform *GetTransform() { return &m_transform; }
 
-        void AddComponent(std::unique_ptr<Component> component);
+        [[nodiscard]] const std::string &GetName() const noexcept { return m_name; }
+
+        [[nodiscard]] const std::vector<Component *> &GetComponents() const noexcept {
+            return m_components;
+        }
+
+        void AddComponent(ComponentPtr<> component);
+
+        // components stop updating and drawing, the object can be destroyed later
+        void DisableComponents();
 
     private:
         Transform m_transform;
         std::string m_name;
-        std::vector<std::unique_ptr<Component>> m_components;
+        // owned by ComponentStorage, destroyed with game object
+        std::vector<Component *> m_components;
     };
 }
 
@@ -1,72 +1,68 @@
 #include "Scene.h"
 
-#include "rapidjson/document.h"
-
 #include "JoyContext.h"
-#include "Common/Serialization.h"
-#include "Common/SerializationUtils.h"
-#include "Components/Component.h"
-#include "Components/MeshRenderer.h"
-#include "Components/Camera.h"
 #include "DataManager/DataManager.h"
+#include "SceneJsonReader.h"
+#include "TransformSystem.h"
+#include "Components/ComponentStorage.h"
 
 namespace JoyEngine
 {
 	Scene::Scene(const GUID& guid)
 	{
-		rapidjson::Document json = JoyContext::Data->GetSerializedData(guid, scene);
-		m_name = json["name"].GetString();
+		if (JoyContext::Data->HasRawData(guid))
+		{
+			m_blob = JoyContext::Data->GetData(guid, true);
+			if (LoadFromBlob())
+			{
+				return;
+			}
+			m_blob.clear();
+		}
+		LoadFromJson(guid);
+	}
 
-		rapidjson::Value& val = json["objects"];
-		for (auto& obj : val.GetArray())
+	bool Scene::LoadFromBlob()
+	{
+		if (!m_blobView.Map(m_blob.data(), m_blob.size()))
 		{
-			std::unique_ptr<GameObject> go = std::make_unique<GameObject>(obj["name"].GetString());
+			return false;
+		}
 
-			rapidjson::Value& transformValue = obj["transform"];
-			glm::vec3 vec;
-			SerializationUtils::DeserializeToPtr(strHash("vec3"), transformValue["localPosition"], &vec, 1);
-			go->GetTransform()->SetPosition(vec);
-			SerializationUtils::DeserializeToPtr(strHash("vec3"), transformValue["localRotation"], &vec, 1);
-			go->GetTransform()->SetRotation(vec);
-			SerializationUtils::DeserializeToPtr(strHash("vec3"), transformValue["localScale"], &vec, 1);
-			go->GetTransform()->SetScale(vec);
+		m_name = m_blobView.GetString(m_blobView.header->nameOffset);
+		m_streamer = std::make_unique<SceneStreamer>(m_blobView);
+		return true;
+	}
 
-			for (auto& component : obj["components"].GetArray())
-			{
-				std::string type = std::string(component["type"].GetString());
-				if (type == "renderer")
-				{
-					std::unique_ptr<MeshRenderer> mr = std::make_unique<MeshRenderer>();
-					mr->SetMesh(GUID::StringToGuid(component["model"].GetString()));
-					mr->SetMaterial(GUID::StringToGuid(component["material"].GetString()));
-					go->AddComponent(std::move(mr));
-				}
-				else if (type == "component")
-				{
-					ASSERT(component.HasMember("component"));
-					auto type = component["component"].GetString();
-					ASSERT(SerializableClassFactory::GetInstance() != nullptr);
-					std::unique_ptr<Serializable> s = SerializableClassFactory::GetInstance()->Deserialize(
-						component["fields"], component["component"].GetString());
-					auto* c_ptr = dynamic_cast<Component*>(s.release());
-					ASSERT(c_ptr != nullptr);
-					std::unique_ptr<Component> c(c_ptr);
-					go->AddComponent(std::move(c));
-				}
-				else if (type == "camera")
-				{
-					go->AddComponent(std::move(std::make_unique<Camera>()));
-				}
-			}
-			m_objects.push_back(std::move(go));
+	void Scene::LoadFromJson(const GUID& guid)
+	{
+		std::vector<char> data = JoyContext::Data->GetData(guid);
+		data.push_back('\0');
+		SceneJsonReader::Read(data.data(), m_name, m_objects);
+	}
+
+	void Scene::GetObjects(std::vector<GameObject*>& objects) const
+	{
+		objects.clear();
+		for (const auto& o : m_objects)
+		{
+			objects.push_back(o.get());
+		}
+		if (m_streamer != nullptr)
+		{
+			m_streamer->GetObjects(objects);
 		}
 	}
 
 	void Scene::Update()
 	{
-		for (const auto& o : m_objects)
+		if (m_streamer != nullptr)
 		{
-			o->Update();
+			m_streamer->Update();
 		}
+		// components of all loaded objects, type by type
+		ComponentStorage::GetInstance()->Update();
+		// world matrices of everything components have moved
+		TransformSystem::GetInstance()->Update();
 	}
 }
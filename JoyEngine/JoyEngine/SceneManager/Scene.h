@@ -6,6 +6,8 @@
 #include <memory>
 
 #include "GameObject.h"
+#include "SceneBlob.h"
+#include "SceneStreamer.h"
 #include "Utils/GUID.h"
 
 namespace JoyEngine {
@@ -15,9 +17,23 @@ namespace JoyEngine {
 
         void Update();
 
+        // loaded objects in stable order
+        void GetObjects(std::vector<GameObject *> &objects) const;
+
+    private:
+        void LoadFromJson(const GUID &guid);
+
+        // Maps m_blob, returns false if it is broken or has other version
+        bool LoadFromBlob();
+
     private:
         std::string m_name;
+        // objects of json scene, cooked scenes are streamed by cells
         std::vector<std::unique_ptr<GameObject>> m_objects;
+
+        std::vector<char> m_blob;
+        SceneBlobView m_blobView;
+        std::unique_ptr<SceneStreamer> m_streamer;
     };
 }
 
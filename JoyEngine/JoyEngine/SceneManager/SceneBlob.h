@@ -0,0 +1,155 @@
+#ifndef SCENE_BLOB_H
+#define SCENE_BLOB_H
+
+#include <cstdint>
+
+// Cooked scene format, written by JoyDataBuilderLib next to the scene json as <scene>.json.data
+// All sections are flat arrays addressed by byte offsets from the beginning of the blob,
+// so the engine reads the file in one go and only turns offsets into pointers.
+// Objects are partitioned into cells of a uniform XZ grid and sorted by cell,
+// so every cell is a contiguous range of objects which is streamed in and out as a whole.
+// Hierarchy goes to the cell of its root, inside the cell parents go before their children.
+// Depends only on <cstdint>, so the asset builder includes it as is.
+
+namespace JoyEngine
+{
+	constexpr uint32_t SCENE_BLOB_MAGIC = 0x4E43534A; // "JSCN"
+	constexpr uint32_t SCENE_BLOB_VERSION = 3;
+	constexpr uint32_t SCENE_BLOB_ALIGNMENT = 8;
+	constexpr uint32_t SCENE_BLOB_NO_PARENT = 0xFFFFFFFF;
+
+	enum SceneBlobComponentType : uint32_t
+	{
+		SceneBlobRenderer = 0,
+		SceneBlobCamera = 1,
+		// serializable gameplay component, created by class name through SerializableClassFactory
+		SceneBlobComponent = 2
+	};
+
+	struct SceneBlobHeader
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint64_t totalSize;
+
+		uint32_t nameOffset; // scene name in string table
+
+		float cellSize;
+		float streamingRadius; // cells closer to the camera than this are loaded
+
+		uint32_t cellCount;
+		uint32_t objectCount;
+		uint32_t componentCount;
+		uint32_t fieldCount;
+		uint32_t valueCount;
+		uint32_t stringTableSize;
+
+		uint64_t cellsOffset;
+		uint64_t objectsOffset;
+		uint64_t transformsOffset;
+		uint64_t componentsOffset;
+		uint64_t fieldsOffset;
+		uint64_t valuesOffset;
+		uint64_t stringsOffset;
+	};
+
+	enum SceneBlobCellFlags : uint32_t
+	{
+		// loaded with the scene and never unloaded, e.g. holds cameras
+		SceneBlobCellGlobal = 1 << 0
+	};
+
+	struct SceneBlobCell
+	{
+		int32_t x; // grid coordinates, cell covers [x * cellSize, (x + 1) * cellSize) on X axis
+		int32_t z;
+		uint32_t firstObject;
+		uint32_t objectCount;
+		uint32_t flags; // SceneBlobCellFlags
+		uint32_t reserved;
+	};
+
+	// Same memory layout as JoyEngine::GUID
+	struct SceneBlobGuid
+	{
+		uint32_t data1;
+		uint16_t data2;
+		uint16_t data3;
+		uint8_t data4[8];
+	};
+
+	struct SceneBlobTransform
+	{
+		float localPosition[3];
+		float localRotation[3];
+		float localScale[3];
+	};
+
+	// transform of object i is transforms[i]
+	struct SceneBlobObject
+	{
+		uint32_t nameOffset;
+		uint32_t firstComponent;
+		uint32_t componentCount;
+		uint32_t parent; // index of an object of the same cell or SCENE_BLOB_NO_PARENT
+	};
+
+	struct SceneBlobComponentData
+	{
+		uint32_t type; // SceneBlobComponentType
+		uint32_t classNameOffset; // SceneBlobComponent only
+		uint32_t firstField;
+		uint32_t fieldCount;
+		SceneBlobGuid mesh; // SceneBlobRenderer only
+		SceneBlobGuid material; // SceneBlobRenderer only
+	};
+
+	// Field values are stored as flattened numbers, e.g. "m_color": [0.4, 0.5, 0.8, 1.0] -> 4 values
+	struct SceneBlobField
+	{
+		uint32_t nameOffset;
+		uint32_t nameHash; // strHash of field name
+		uint32_t firstValue;
+		uint32_t valueCount;
+	};
+
+	// Typed view over a loaded blob
+	struct SceneBlobView
+	{
+		const SceneBlobHeader* header = nullptr;
+		const SceneBlobCell* cells = nullptr;
+		const SceneBlobObject* objects = nullptr;
+		const SceneBlobTransform* transforms = nullptr;
+		const SceneBlobComponentData* components = nullptr;
+		const SceneBlobField* fields = nullptr;
+		const double* values = nullptr;
+		const char* strings = nullptr;
+
+		// Returns false if data is not a scene blob of the current version
+		bool Map(const char* data, uint64_t size)
+		{
+			if (size < sizeof(SceneBlobHeader)) return false;
+			header = reinterpret_cast<const SceneBlobHeader*>(data);
+			if (header->magic != SCENE_BLOB_MAGIC ||
+				header->version != SCENE_BLOB_VERSION ||
+				header->totalSize != size ||
+				header->stringsOffset + header->stringTableSize > size)
+			{
+				header = nullptr;
+				return false;
+			}
+			cells = reinterpret_cast<const SceneBlobCell*>(data + header->cellsOffset);
+			objects = reinterpret_cast<const SceneBlobObject*>(data + header->objectsOffset);
+			transforms = reinterpret_cast<const SceneBlobTransform*>(data + header->transformsOffset);
+			components = reinterpret_cast<const SceneBlobComponentData*>(data + header->componentsOffset);
+			fields = reinterpret_cast<const SceneBlobField*>(data + header->fieldsOffset);
+			values = reinterpret_cast<const double*>(data + header->valuesOffset);
+			strings = data + header->stringsOffset;
+			return true;
+		}
+
+		[[nodiscard]] const char* GetString(uint32_t offset) const noexcept { return strings + offset; }
+	};
+}
+
+#endif //SCENE_BLOB_H
@@ -0,0 +1,281 @@
+#include "SceneJsonReader.h"
+
+#include <cstring>
+
+#include "Common/HashDefs.h"
+#include "Components/MeshRenderer.h"
+#include "Components/Camera.h"
+#include "Utils/Assert.h"
+#include "Utils/GUID.h"
+
+namespace JoyEngine
+{
+	SceneJsonReader::SceneJsonReader(std::string& name, std::vector<std::unique_ptr<GameObject>>& objects) :
+		m_name(name),
+		m_objects(objects)
+	{
+	}
+
+	void SceneJsonReader::Read(char* data, std::string& name, std::vector<std::unique_ptr<GameObject>>& objects)
+	{
+		SceneJsonReader handler(name, objects);
+		rapidjson::Reader reader;
+		rapidjson::InsituStringStream stream(data);
+		const rapidjson::ParseResult result = reader.Parse<rapidjson::kParseInsituFlag>(stream, handler);
+		ASSERT_DESC(!result.IsError(), "Cannot parse scene json");
+		ASSERT_DESC(handler.m_isScene, "Json is not a scene");
+		handler.SetParents();
+	}
+
+	bool SceneJsonReader::Default()
+	{
+		// bools and nulls are not used in scenes
+		return true;
+	}
+
+	bool SceneJsonReader::Push(Context context)
+	{
+		m_contextStack.push_back(context);
+		return true;
+	}
+
+	bool SceneJsonReader::Key(const char* str, rapidjson::SizeType length, bool copy)
+	{
+		m_key = strHash(str);
+		switch (m_contextStack.back())
+		{
+		case Context::Transform:
+			switch (m_key)
+			{
+			case strHash("localPosition"):
+				m_transformIndex = 0;
+				break;
+			case strHash("localRotation"):
+				m_transformIndex = 1;
+				break;
+			case strHash("localScale"):
+				m_transformIndex = 2;
+				break;
+			default:
+				m_transformIndex = 3;
+			}
+			break;
+		case Context::Fields:
+			m_component.fieldNameHashes.push_back(m_key);
+			m_component.firstValues.push_back(static_cast<uint32_t>(m_component.values.size()));
+			break;
+		default:
+			break;
+		}
+		return true;
+	}
+
+	bool SceneJsonReader::String(const char* str, rapidjson::SizeType length, bool copy)
+	{
+		switch (m_contextStack.back())
+		{
+		case Context::Scene:
+			if (m_key == strHash("name"))
+			{
+				m_name = str;
+			}
+			else if (m_key == strHash("type"))
+			{
+				m_isScene = strcmp(str, "scene") == 0;
+			}
+			break;
+		case Context::Object:
+			if (m_key == strHash("name"))
+			{
+				m_object.name = str;
+			}
+			break;
+		case Context::Component:
+			switch (m_key)
+			{
+			case strHash("type"):
+				m_component.type = str;
+				break;
+			case strHash("model"):
+				m_component.model = str;
+				break;
+			case strHash("material"):
+				m_component.material = str;
+				break;
+			case strHash("component"):
+				m_component.className = str;
+				break;
+			default:
+				break;
+			}
+			break;
+		default:
+			break;
+		}
+		return true;
+	}
+
+	bool SceneJsonReader::Number(double d)
+	{
+		switch (m_contextStack.back())
+		{
+		case Context::Object:
+			if (m_key == strHash("parent"))
+			{
+				m_object.parent = static_cast<int64_t>(d);
+			}
+			break;
+		case Context::TransformVector:
+			if (m_transformIndex < 3 && m_transformComponent < 3)
+			{
+				m_object.transform[m_transformIndex][m_transformComponent] = static_cast<float>(d);
+			}
+			m_transformComponent++;
+			break;
+		case Context::Fields:
+		case Context::FieldValue:
+			m_component.values.push_back(d);
+			break;
+		default:
+			break;
+		}
+		return true;
+	}
+
+	bool SceneJsonReader::StartObject()
+	{
+		switch (m_contextStack.back())
+		{
+		case Context::Root:
+			return Push(Context::Scene);
+		case Context::Objects:
+			m_object = PendingObject();
+			return Push(Context::Object);
+		case Context::Object:
+			return Push(m_key == strHash("transform") ? Context::Transform : Context::Skip);
+		case Context::Components:
+			m_component = PendingComponent();
+			return Push(Context::Component);
+		case Context::Component:
+			return Push(m_key == strHash("fields") ? Context::Fields : Context::Skip);
+		default:
+			return Push(Context::Skip);
+		}
+	}
+
+	bool SceneJsonReader::EndObject(rapidjson::SizeType memberCount)
+	{
+		const Context context = m_contextStack.back();
+		m_contextStack.pop_back();
+		if (context == Context::Component)
+		{
+			CreateComponent();
+		}
+		else if (context == Context::Object)
+		{
+			CreateGameObject();
+		}
+		return true;
+	}
+
+	bool SceneJsonReader::StartArray()
+	{
+		switch (m_contextStack.back())
+		{
+		case Context::Scene:
+			return Push(m_key == strHash("objects") ? Context::Objects : Context::Skip);
+		case Context::Object:
+			return Push(m_key == strHash("components") ? Context::Components : Context::Skip);
+		case Context::Transform:
+			m_transformComponent = 0;
+			return Push(Context::TransformVector);
+		case Context::Fields:
+		case Context::FieldValue:
+			// vectors and arrays of vectors are flattened
+			return Push(Context::FieldValue);
+		default:
+			return Push(Context::Skip);
+		}
+	}
+
+	bool SceneJsonReader::EndArray(rapidjson::SizeType elementCount)
+	{
+		m_contextStack.pop_back();
+		return true;
+	}
+
+	void SceneJsonReader::CreateComponent()
+	{
+		ASSERT(m_component.type != nullptr);
+		switch (strHash(m_component.type))
+		{
+		case strHash("renderer"):
+			{
+				ASSERT(m_component.model != nullptr && m_component.material != nullptr);
+				ComponentPtr<MeshRenderer> mr = ComponentStorage::GetInstance()->Create<MeshRenderer>();
+				mr->SetMesh(GUID::StringToGuid(m_component.model));
+				mr->SetMaterial(GUID::StringToGuid(m_component.material));
+				m_object.components.push_back(std::move(mr));
+				break;
+			}
+		case strHash("camera"):
+			m_object.components.push_back(ComponentStorage::GetInstance()->Create<Camera>());
+			break;
+		case strHash("component"):
+			{
+				ASSERT(m_component.className != nullptr);
+				const auto fieldCount = static_cast<uint32_t>(m_component.fieldNameHashes.size());
+				m_fields.clear();
+				for (uint32_t i = 0; i < fieldCount; i++)
+				{
+					const uint32_t firstValue = m_component.firstValues[i];
+					const uint32_t endValue = i + 1 < fieldCount
+						                          ? m_component.firstValues[i + 1]
+						                          : static_cast<uint32_t>(m_component.values.size());
+					m_fields.push_back({
+						m_component.fieldNameHashes[i],
+						m_component.values.data() + firstValue,
+						endValue - firstValue
+					});
+				}
+				ASSERT(SerializableClassFactory::GetInstance() != nullptr);
+				m_object.components.push_back(SerializableClassFactory::GetInstance()->Deserialize(
+					m_fields.data(), fieldCount, m_component.className));
+				break;
+			}
+		default:
+			ASSERT(false);
+		}
+	}
+
+	void SceneJsonReader::CreateGameObject()
+	{
+		std::unique_ptr<GameObject> go = m_object.name != nullptr
+			                                 ? std::make_unique<GameObject>(m_object.name)
+			                                 : std::make_unique<GameObject>();
+		go->GetTransform()->SetPosition(m_object.transform[0]);
+		go->GetTransform()->SetRotation(m_object.transform[1]);
+		go->GetTransform()->SetScale(m_object.transform[2]);
+		for (auto& component : m_object.components)
+		{
+			go->AddComponent(std::move(component));
+		}
+		m_object.components.clear();
+		m_objects.push_back(std::move(go));
+		m_parents.push_back(m_object.parent);
+	}
+
+	void SceneJsonReader::SetParents() const
+	{
+		ASSERT(m_parents.size() == m_objects.size());
+		for (size_t i = 0; i < m_objects.size(); i++)
+		{
+			if (m_parents[i] < 0)
+			{
+				continue;
+			}
+			ASSERT_DESC(m_parents[i] < static_cast<int64_t>(m_objects.size()), "Wrong parent index");
+			m_objects[i]->GetTransform()->SetParent(m_objects[m_parents[i]]->GetTransform());
+		}
+	}
+}
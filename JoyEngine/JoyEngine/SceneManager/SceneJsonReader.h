@@ -0,0 +1,107 @@
+#ifndef SCENE_JSON_READER_H
+#define SCENE_JSON_READER_H
+
+#include <vector>
+#include <string>
+#include <memory>
+
+#include <rapidjson/reader.h>
+
+#include "GameObject.h"
+#include "Common/Serialization.h"
+#include "Components/Component.h"
+
+namespace JoyEngine
+{
+	// SAX handler for scene json.
+	// Game objects and components are created as soon as their json objects end, without building a DOM.
+	// Strings point into the parsed buffer, so it has to be parsed in situ.
+	class SceneJsonReader : public rapidjson::BaseReaderHandler<rapidjson::UTF8<>, SceneJsonReader>
+	{
+	public:
+		SceneJsonReader(std::string& name, std::vector<std::unique_ptr<GameObject>>& objects);
+
+		// data is modified by parser and must be null terminated
+		static void Read(char* data, std::string& name, std::vector<std::unique_ptr<GameObject>>& objects);
+
+		bool Default();
+		bool Int(int i) { return Number(i); }
+		bool Uint(unsigned u) { return Number(u); }
+		bool Int64(int64_t i) { return Number(static_cast<double>(i)); }
+		bool Uint64(uint64_t u) { return Number(static_cast<double>(u)); }
+		bool Double(double d) { return Number(d); }
+		bool String(const char* str, rapidjson::SizeType length, bool copy);
+		bool StartObject();
+		bool Key(const char* str, rapidjson::SizeType length, bool copy);
+		bool EndObject(rapidjson::SizeType memberCount);
+		bool StartArray();
+		bool EndArray(rapidjson::SizeType elementCount);
+
+	private:
+		enum class Context
+		{
+			Root,
+			Scene,
+			Objects,
+			Object,
+			Transform,
+			TransformVector,
+			Components,
+			Component,
+			Fields,
+			FieldValue,
+			Skip
+		};
+
+		struct PendingComponent
+		{
+			const char* type = nullptr;
+			const char* model = nullptr;
+			const char* material = nullptr;
+			const char* className = nullptr;
+			std::vector<uint32_t> fieldNameHashes;
+			// field i owns values [firstValues[i], firstValues[i + 1])
+			std::vector<uint32_t> firstValues;
+			std::vector<double> values;
+		};
+
+		struct PendingObject
+		{
+			const char* name = nullptr;
+			glm::vec3 transform[3] = {glm::vec3(0), glm::vec3(0), glm::vec3(1)};
+			int64_t parent = -1; // index in objects array
+			std::vector<ComponentPtr<>> components;
+		};
+
+	private:
+		bool Number(double d);
+
+		bool Push(Context context);
+
+		void CreateComponent();
+
+		void CreateGameObject();
+
+		// parents may go after children in json, so they are set when all objects are created
+		void SetParents() const;
+
+	private:
+		std::string& m_name;
+		std::vector<std::unique_ptr<GameObject>>& m_objects;
+
+		std::vector<Context> m_contextStack = {Context::Root};
+		// strHash of the last key, defines where next value goes
+		uint32_t m_key = 0;
+		bool m_isScene = false;
+
+		// which vector of transform and which its component is being read
+		uint32_t m_transformIndex = 0;
+		uint32_t m_transformComponent = 0;
+		PendingObject m_object;
+		PendingComponent m_component;
+		std::vector<SerializedFieldData> m_fields;
+		std::vector<int64_t> m_parents;
+	};
+}
+
+#endif //SCENE_JSON_READER_H
@@ -0,0 +1,166 @@
+#include "SceneSnapshot.h"
+
+#include <cstring>
+
+#include "Scene.h"
+#include "GameObject.h"
+#include "Common/Serialization.h"
+#include "Common/HashDefs.h"
+#include "Utils/Assert.h"
+
+namespace JoyEngine
+{
+	static constexpr uint64_t FNV_OFFSET = 14695981039346656037ull;
+	static constexpr uint64_t FNV_PRIME = 1099511628211ull;
+
+	static uint64_t HashValue(uint64_t hash, uint64_t value)
+	{
+		for (uint32_t i = 0; i < 8; i++)
+		{
+			hash ^= (value >> (i * 8)) & 0xff;
+			hash *= FNV_PRIME;
+		}
+		return hash;
+	}
+
+	struct TransformData
+	{
+		glm::vec3 position;
+		glm::quat rotation;
+		glm::vec3 scale;
+	};
+
+	static_assert(sizeof(TransformData) % sizeof(uint32_t) == 0);
+
+	static const FieldInfo* GetReflectedFields(const Component* component, uint32_t& fieldCount)
+	{
+		fieldCount = 0;
+		if (component->GetClassHash() == 0)
+		{
+			return nullptr;
+		}
+		return SerializableClassFactory::GetInstance()->GetFields(component->GetClassHash(), fieldCount);
+	}
+
+	uint64_t SceneSnapshot::GetLayoutHash(const std::vector<GameObject*>& objects, uint32_t& componentCount,
+	                                      uint64_t& dataSize)
+	{
+		uint64_t hash = HashValue(FNV_OFFSET, VERSION);
+		componentCount = 0;
+		dataSize = 0;
+		for (const GameObject* o : objects)
+		{
+			hash = HashValue(hash, strHash(o->GetName().c_str()));
+			dataSize += sizeof(TransformData);
+			for (Component* component : o->GetComponents())
+			{
+				uint32_t fieldCount;
+				const FieldInfo* fields = GetReflectedFields(component, fieldCount);
+				if (fields == nullptr)
+				{
+					continue;
+				}
+				componentCount++;
+				hash = HashValue(hash, component->GetClassHash());
+				for (uint32_t i = 0; i < fieldCount; i++)
+				{
+					ASSERT(fields[i].size % sizeof(uint32_t) == 0);
+					hash = HashValue(hash, fields[i].nameHash);
+					hash = HashValue(hash, fields[i].typeHash);
+					hash = HashValue(hash, i);
+					hash = HashValue(hash, fields[i].size);
+					dataSize += fields[i].size;
+				}
+			}
+		}
+		return hash;
+	}
+
+	void SceneSnapshot::Capture(const Scene& scene, std::vector<char>& snapshot)
+	{
+		std::vector<GameObject*> objects;
+		scene.GetObjects(objects);
+
+		Header header = {};
+		header.magic = SNAPSHOT_MAGIC;
+		header.version = VERSION;
+		header.objectCount = static_cast<uint32_t>(objects.size());
+		header.layoutHash = GetLayoutHash(objects, header.componentCount, header.dataSize);
+
+		snapshot.resize(sizeof(Header) + header.dataSize);
+		memcpy(snapshot.data(), &header, sizeof(Header));
+		char* ptr = snapshot.data() + sizeof(Header);
+		for (GameObject* o : objects)
+		{
+			const TransformData transform = {
+				o->GetTransform()->GetPosition(),
+				o->GetTransform()->GetRotation(),
+				o->GetTransform()->GetScale()
+			};
+			memcpy(ptr, &transform, sizeof(TransformData));
+			ptr += sizeof(TransformData);
+
+			for (Component* component : o->GetComponents())
+			{
+				uint32_t fieldCount;
+				const FieldInfo* fields = GetReflectedFields(component, fieldCount);
+				void* fieldsBase = component->GetFieldsBase();
+				for (uint32_t i = 0; i < fieldCount; i++)
+				{
+					memcpy(ptr, fields[i].GetPtr(fieldsBase), fields[i].size);
+					ptr += fields[i].size;
+				}
+			}
+		}
+		ASSERT(ptr == snapshot.data() + snapshot.size());
+	}
+
+	bool SceneSnapshot::Restore(const Scene& scene, const std::vector<char>& snapshot)
+	{
+		if (snapshot.size() < sizeof(Header))
+		{
+			return false;
+		}
+		Header header;
+		memcpy(&header, snapshot.data(), sizeof(Header));
+
+		std::vector<GameObject*> objects;
+		scene.GetObjects(objects);
+		uint32_t componentCount;
+		uint64_t dataSize;
+		if (header.magic != SNAPSHOT_MAGIC ||
+			header.version != VERSION ||
+			header.objectCount != objects.size() ||
+			header.layoutHash != GetLayoutHash(objects, componentCount, dataSize) ||
+			header.componentCount != componentCount ||
+			header.dataSize != dataSize ||
+			snapshot.size() != sizeof(Header) + dataSize)
+		{
+			return false;
+		}
+
+		const char* ptr = snapshot.data() + sizeof(Header);
+		for (GameObject* o : objects)
+		{
+			TransformData transform;
+			memcpy(&transform, ptr, sizeof(TransformData));
+			ptr += sizeof(TransformData);
+			o->GetTransform()->SetPosition(transform.position);
+			o->GetTransform()->SetRotation(transform.rotation);
+			o->GetTransform()->SetScale(transform.scale);
+
+			for (Component* component : o->GetComponents())
+			{
+				uint32_t fieldCount;
+				const FieldInfo* fields = GetReflectedFields(component, fieldCount);
+				void* fieldsBase = component->GetFieldsBase();
+				for (uint32_t i = 0; i < fieldCount; i++)
+				{
+					memcpy(fields[i].GetPtr(fieldsBase), ptr, fields[i].size);
+					ptr += fields[i].size;
+				}
+			}
+		}
+		return true;
+	}
+}
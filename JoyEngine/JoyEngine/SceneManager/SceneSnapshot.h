@@ -0,0 +1,70 @@
+#ifndef SCENE_SNAPSHOT_H
+#define SCENE_SNAPSHOT_H
+
+#include <cstdint>
+#include <vector>
+
+namespace JoyEngine
+{
+	class Scene;
+	class GameObject;
+
+	// Binary state of loaded game objects: transforms and fields of reflected components.
+	// Snapshot is a header followed by raw field bytes, so capture and restore are plain copies.
+	// Layout hash covers objects, component classes and their field tables,
+	// so snapshot can be restored only into the scene with the same set of objects and the same code.
+	//
+	// Delta stores 4-byte words which differ from the baseline snapshot.
+	class SceneSnapshot
+	{
+	public:
+		static constexpr uint32_t SNAPSHOT_MAGIC = 0x504E534A; // "JSNP"
+		static constexpr uint32_t DELTA_MAGIC = 0x4C44534A; // "JSDL"
+		static constexpr uint32_t VERSION = 1;
+
+		struct Header
+		{
+			uint32_t magic;
+			uint32_t version;
+			uint64_t layoutHash;
+			uint32_t objectCount;
+			uint32_t componentCount;
+			uint64_t dataSize;
+		};
+
+		struct DeltaHeader
+		{
+			uint32_t magic;
+			uint32_t version;
+			uint64_t layoutHash;
+			uint64_t snapshotSize;
+			uint32_t runCount;
+			uint32_t wordCount;
+		};
+
+		// range of changed words, followed by wordCount words in delta data
+		struct DeltaRun
+		{
+			uint32_t firstWord;
+			uint32_t wordCount;
+		};
+
+		static void Capture(const Scene& scene, std::vector<char>& snapshot);
+
+		// Returns false if snapshot was taken from different objects or code
+		static bool Restore(const Scene& scene, const std::vector<char>& snapshot);
+
+		static void CaptureDelta(const std::vector<char>& baseline, const std::vector<char>& current,
+		                         std::vector<char>& delta);
+
+		// Rebuilds snapshot from baseline and delta, returns false if delta was taken against other baseline
+		static bool ApplyDelta(const std::vector<char>& baseline, const std::vector<char>& delta,
+		                       std::vector<char>& snapshot);
+
+	private:
+		static uint64_t GetLayoutHash(const std::vector<GameObject*>& objects, uint32_t& componentCount,
+		                              uint64_t& dataSize);
+	};
+}
+
+#endif //SCENE_SNAPSHOT_H
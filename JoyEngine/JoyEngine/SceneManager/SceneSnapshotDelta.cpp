@@ -0,0 +1,111 @@
+#include "SceneSnapshot.h"
+
+#include <cstring>
+
+#include "Utils/Assert.h"
+
+// Delta encoding works on snapshot bytes only, it doesn't need the scene
+namespace JoyEngine
+{
+	void SceneSnapshot::CaptureDelta(const std::vector<char>& baseline, const std::vector<char>& current,
+	                                 std::vector<char>& delta)
+	{
+		ASSERT(baseline.size() >= sizeof(Header) && current.size() >= sizeof(Header));
+		Header baselineHeader;
+		Header currentHeader;
+		memcpy(&baselineHeader, baseline.data(), sizeof(Header));
+		memcpy(&currentHeader, current.data(), sizeof(Header));
+		ASSERT_DESC(baselineHeader.layoutHash == currentHeader.layoutHash && baseline.size() == current.size(),
+		            "Delta can be taken only between snapshots of the same layout");
+		ASSERT(current.size() % sizeof(uint32_t) == 0);
+
+		const auto wordCount = static_cast<uint32_t>(current.size() / sizeof(uint32_t));
+		std::vector<DeltaRun> runs;
+		std::vector<uint32_t> words;
+		for (uint32_t i = 0; i < wordCount; i++)
+		{
+			uint32_t baselineWord;
+			uint32_t currentWord;
+			memcpy(&baselineWord, baseline.data() + i * sizeof(uint32_t), sizeof(uint32_t));
+			memcpy(&currentWord, current.data() + i * sizeof(uint32_t), sizeof(uint32_t));
+			if (baselineWord == currentWord)
+			{
+				continue;
+			}
+			if (runs.empty() || runs.back().firstWord + runs.back().wordCount != i)
+			{
+				runs.push_back({i, 0});
+			}
+			runs.back().wordCount++;
+			words.push_back(currentWord);
+		}
+
+		DeltaHeader header = {};
+		header.magic = DELTA_MAGIC;
+		header.version = VERSION;
+		header.layoutHash = currentHeader.layoutHash;
+		header.snapshotSize = current.size();
+		header.runCount = static_cast<uint32_t>(runs.size());
+		header.wordCount = static_cast<uint32_t>(words.size());
+
+		delta.resize(sizeof(DeltaHeader) + runs.size() * sizeof(DeltaRun) + words.size() * sizeof(uint32_t));
+		char* ptr = delta.data();
+		memcpy(ptr, &header, sizeof(DeltaHeader));
+		ptr += sizeof(DeltaHeader);
+		memcpy(ptr, runs.data(), runs.size() * sizeof(DeltaRun));
+		ptr += runs.size() * sizeof(DeltaRun);
+		memcpy(ptr, words.data(), words.size() * sizeof(uint32_t));
+	}
+
+	bool SceneSnapshot::ApplyDelta(const std::vector<char>& baseline, const std::vector<char>& delta,
+	                               std::vector<char>& snapshot)
+	{
+		if (delta.size() < sizeof(DeltaHeader) || baseline.size() < sizeof(Header))
+		{
+			return false;
+		}
+		DeltaHeader header;
+		Header baselineHeader;
+		memcpy(&header, delta.data(), sizeof(DeltaHeader));
+		memcpy(&baselineHeader, baseline.data(), sizeof(Header));
+		if (header.magic != DELTA_MAGIC ||
+			header.version != VERSION ||
+			header.layoutHash != baselineHeader.layoutHash ||
+			header.snapshotSize != baseline.size() ||
+			delta.size() != sizeof(DeltaHeader) + header.runCount * sizeof(DeltaRun) +
+			header.wordCount * sizeof(uint32_t))
+		{
+			return false;
+		}
+
+		// runs are validated before anything is copied, they must stay inside the snapshot
+		// and their word counts must add up to the words stored in delta
+		const char* runPtr = delta.data() + sizeof(DeltaHeader);
+		uint64_t runWordCount = 0;
+		for (uint32_t i = 0; i < header.runCount; i++)
+		{
+			DeltaRun run;
+			memcpy(&run, runPtr + i * sizeof(DeltaRun), sizeof(DeltaRun));
+			if ((static_cast<uint64_t>(run.firstWord) + run.wordCount) * sizeof(uint32_t) > baseline.size())
+			{
+				return false;
+			}
+			runWordCount += run.wordCount;
+		}
+		if (runWordCount != header.wordCount)
+		{
+			return false;
+		}
+
+		snapshot = baseline;
+		const char* wordPtr = runPtr + header.runCount * sizeof(DeltaRun);
+		for (uint32_t i = 0; i < header.runCount; i++)
+		{
+			DeltaRun run;
+			memcpy(&run, runPtr + i * sizeof(DeltaRun), sizeof(DeltaRun));
+			memcpy(snapshot.data() + run.firstWord * sizeof(uint32_t), wordPtr, run.wordCount * sizeof(uint32_t));
+			wordPtr += run.wordCount * sizeof(uint32_t);
+		}
+		return true;
+	}
+}
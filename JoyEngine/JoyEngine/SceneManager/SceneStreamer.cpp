@@ -0,0 +1,286 @@
+#include "SceneStreamer.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+#include "JoyContext.h"
+#include "Common/Serialization.h"
+#include "Components/MeshRenderer.h"
+#include "Components/Camera.h"
+#include "RenderManager/RenderManager.h"
+
+namespace JoyEngine
+{
+	static GUID ToGuid(const SceneBlobGuid& blobGuid)
+	{
+		static_assert(sizeof(SceneBlobGuid) == sizeof(GUID));
+		GUID guid;
+		memcpy(&guid, &blobGuid, sizeof(GUID));
+		return guid;
+	}
+
+	SceneStreamer::SceneStreamer(const SceneBlobView& view) : m_view(view)
+	{
+		m_cells.resize(view.header->cellCount);
+		for (uint32_t i = 0; i < view.header->cellCount; i++)
+		{
+			m_cells[i].data = &view.cells[i];
+		}
+
+		// global cells hold the camera, which is needed to stream everything else
+		for (auto& cell : m_cells)
+		{
+			if (cell.data->flags & SceneBlobCellGlobal)
+			{
+				cell.isWanted = true;
+				PrepareCell(cell);
+				while (cell.activatedObjectCount < cell.preparedObjects.size())
+				{
+					ActivateObject(cell);
+				}
+				cell.preparedObjects.clear();
+				cell.state = CellState::Active;
+			}
+		}
+	}
+
+	SceneStreamer::~SceneStreamer()
+	{
+		// jobs reference cells
+		JoyContext::Jobs->Wait(m_prepareJobs);
+	}
+
+	void SceneStreamer::Update()
+	{
+		CollectPreparedCells();
+		SelectCells();
+		ProcessQueues();
+	}
+
+	void SceneStreamer::GetObjects(std::vector<GameObject*>& objects) const
+	{
+		for (const auto& cell : m_cells)
+		{
+			for (const auto& o : cell.objects)
+			{
+				objects.push_back(o.get());
+			}
+		}
+	}
+
+	void SceneStreamer::PrepareCell(Cell& cell) const
+	{
+		const SceneBlobCell& cellData = *cell.data;
+		cell.preparedObjects.resize(cellData.objectCount);
+
+		for (uint32_t i = 0; i < cellData.objectCount; i++)
+		{
+			const uint32_t objectIndex = cellData.firstObject + i;
+			const SceneBlobObject& obj = m_view.objects[objectIndex];
+			PreparedObject& prepared = cell.preparedObjects[i];
+
+			std::vector<SerializedFieldData> fields;
+			for (uint32_t j = obj.firstComponent; j < obj.firstComponent + obj.componentCount; j++)
+			{
+				const SceneBlobComponentData& component = m_view.components[j];
+				switch (component.type)
+				{
+				case SceneBlobRenderer:
+					// resources are loaded on activation, ResourceManager is not thread safe
+					prepared.renderers.push_back({ToGuid(component.mesh), ToGuid(component.material)});
+					break;
+				case SceneBlobCamera:
+					prepared.components.push_back(ComponentStorage::GetInstance()->Create<Camera>());
+					break;
+				case SceneBlobComponent:
+					{
+						fields.clear();
+						for (uint32_t k = component.firstField; k < component.firstField + component.fieldCount; k++)
+						{
+							const SceneBlobField& field = m_view.fields[k];
+							fields.push_back({
+								field.nameHash,
+								m_view.values + field.firstValue,
+								field.valueCount
+							});
+						}
+						ASSERT(SerializableClassFactory::GetInstance() != nullptr);
+						prepared.components.push_back(SerializableClassFactory::GetInstance()->Deserialize(
+							fields.data(), static_cast<uint32_t>(fields.size()),
+							m_view.GetString(component.classNameOffset)));
+						break;
+					}
+				default:
+					ASSERT(false);
+				}
+			}
+		}
+	}
+
+	void SceneStreamer::ActivateObject(Cell& cell) const
+	{
+		const uint32_t objectIndex = cell.data->firstObject + cell.activatedObjectCount;
+		const SceneBlobObject& obj = m_view.objects[objectIndex];
+		PreparedObject& prepared = cell.preparedObjects[cell.activatedObjectCount];
+
+		auto gameObject = std::make_unique<GameObject>(m_view.GetString(obj.nameOffset));
+		const SceneBlobTransform& transform = m_view.transforms[objectIndex];
+		Transform* t = gameObject->GetTransform();
+		t->SetPosition(glm::vec3(
+			transform.localPosition[0], transform.localPosition[1], transform.localPosition[2]));
+		t->SetRotation(glm::vec3(
+			transform.localRotation[0], transform.localRotation[1], transform.localRotation[2]));
+		t->SetScale(glm::vec3(
+			transform.localScale[0], transform.localScale[1], transform.localScale[2]));
+		if (obj.parent != SCENE_BLOB_NO_PARENT)
+		{
+			// parents go first in the cell, so the parent is already activated
+			ASSERT(obj.parent >= cell.data->firstObject && obj.parent < objectIndex);
+			t->SetParent(cell.objects[obj.parent - cell.data->firstObject]->GetTransform());
+		}
+
+		for (const auto& renderer : prepared.renderers)
+		{
+			ComponentPtr<MeshRenderer> mr = ComponentStorage::GetInstance()->Create<MeshRenderer>();
+			mr->SetMesh(renderer.mesh);
+			mr->SetMaterial(renderer.material);
+			gameObject->AddComponent(std::move(mr));
+		}
+		for (auto& component : prepared.components)
+		{
+			gameObject->AddComponent(std::move(component));
+		}
+		cell.objects.push_back(std::move(gameObject));
+		cell.activatedObjectCount++;
+	}
+
+	void SceneStreamer::UnloadCell(Cell& cell)
+	{
+		ASSERT(cell.state == CellState::Prepared || cell.state == CellState::Active);
+		if (cell.state == CellState::Prepared)
+		{
+			m_activationQueue.erase(std::find(m_activationQueue.begin(), m_activationQueue.end(), &cell));
+		}
+		// objects leave the scene now, only their destruction is spread over frames.
+		// Resources are released when the last object referencing them is destroyed
+		for (auto& o : cell.objects)
+		{
+			o->DisableComponents();
+			m_destroyQueue.push_back(std::move(o));
+		}
+		cell.objects.clear();
+		cell.preparedObjects.clear();
+		cell.activatedObjectCount = 0;
+		cell.state = CellState::Unloaded;
+	}
+
+	void SceneStreamer::CollectPreparedCells()
+	{
+		std::vector<Cell*> preparedCells;
+		{
+			std::lock_guard<std::mutex> lock(m_preparedMutex);
+			preparedCells.swap(m_preparedCells);
+		}
+		for (Cell* cell : preparedCells)
+		{
+			ASSERT(cell->state == CellState::Preparing);
+			if (cell->isWanted)
+			{
+				cell->state = CellState::Prepared;
+				m_activationQueue.push_back(cell);
+			}
+			else
+			{
+				cell->preparedObjects.clear();
+				cell->state = CellState::Unloaded;
+			}
+		}
+	}
+
+	void SceneStreamer::SelectCells()
+	{
+		const Camera* camera = JoyContext::Render->GetCurrentCamera();
+		if (camera == nullptr)
+		{
+			return;
+		}
+		const glm::vec3 position = camera->GetTransform()->GetPosition();
+		const float loadRadius = m_view.header->streamingRadius;
+		// cells between load and unload radius keep their state, so moving along a cell border doesn't thrash
+		const float unloadRadius = loadRadius + m_view.header->cellSize;
+
+		for (auto& cell : m_cells)
+		{
+			if (cell.data->flags & SceneBlobCellGlobal)
+			{
+				continue;
+			}
+			const float distance = GetDistanceToCell(cell, position.x, position.z);
+			if (distance < loadRadius)
+			{
+				cell.isWanted = true;
+			}
+			else if (distance >= unloadRadius)
+			{
+				cell.isWanted = false;
+			}
+
+			if (cell.isWanted && cell.state == CellState::Unloaded)
+			{
+				cell.state = CellState::Preparing;
+				Cell* cellPtr = &cell;
+				JoyContext::Jobs->Run([this, cellPtr]()
+				{
+					PrepareCell(*cellPtr);
+					std::lock_guard<std::mutex> lock(m_preparedMutex);
+					m_preparedCells.push_back(cellPtr);
+				}, &m_prepareJobs);
+			}
+			else if (!cell.isWanted && (cell.state == CellState::Prepared || cell.state == CellState::Active))
+			{
+				UnloadCell(cell);
+			}
+		}
+	}
+
+	void SceneStreamer::ProcessQueues()
+	{
+		const auto startTime = std::chrono::high_resolution_clock::now();
+		auto isOutOfBudget = [startTime]()
+		{
+			const auto currentTime = std::chrono::high_resolution_clock::now();
+			return std::chrono::duration<float, std::chrono::milliseconds::period>(currentTime - startTime).count() >
+				FRAME_BUDGET_MS;
+		};
+
+		// destroy first to free memory for the new cells
+		while (!m_destroyQueue.empty() && !isOutOfBudget())
+		{
+			m_destroyQueue.pop_front();
+		}
+
+		while (!m_activationQueue.empty() && !isOutOfBudget())
+		{
+			Cell* cell = m_activationQueue.front();
+			ActivateObject(*cell);
+			if (cell->activatedObjectCount == cell->preparedObjects.size())
+			{
+				cell->preparedObjects.clear();
+				cell->state = CellState::Active;
+				m_activationQueue.pop_front();
+			}
+		}
+	}
+
+	float SceneStreamer::GetDistanceToCell(const Cell& cell, float x, float z) const noexcept
+	{
+		const float cellSize = m_view.header->cellSize;
+		const float minX = static_cast<float>(cell.data->x) * cellSize;
+		const float minZ = static_cast<float>(cell.data->z) * cellSize;
+		const float dx = std::max(std::max(minX - x, 0.0f), x - (minX + cellSize));
+		const float dz = std::max(std::max(minZ - z, 0.0f), z - (minZ + cellSize));
+		return std::sqrt(dx * dx + dz * dz);
+	}
+}
@@ -0,0 +1,102 @@
+#ifndef SCENE_STREAMER_H
+#define SCENE_STREAMER_H
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+
+#include "GameObject.h"
+#include "SceneBlob.h"
+#include "Common/JobSystem.h"
+#include "Components/Component.h"
+#include "Components/ComponentStorage.h"
+#include "Utils/GUID.h"
+
+namespace JoyEngine
+{
+	// Loads and unloads cells of a cooked scene around the current camera.
+	// Components of a cell are created by a job on worker threads, but game objects with their transforms are created,
+	// components are enabled and resources are loaded on the main thread, a few objects per frame within the time budget.
+	class SceneStreamer
+	{
+	public:
+		SceneStreamer() = delete;
+
+		// view must outlive the streamer
+		explicit SceneStreamer(const SceneBlobView& view);
+
+		~SceneStreamer();
+
+		void Update();
+
+		// appends active objects in cell order
+		void GetObjects(std::vector<GameObject*>& objects) const;
+
+	private:
+		enum class CellState
+		{
+			Unloaded,
+			Preparing, // owned by the prepare job
+			Prepared, // waiting in activation queue
+			Active
+		};
+
+		struct PreparedRenderer
+		{
+			GUID mesh;
+			GUID material;
+		};
+
+		// Components of game object which is not created yet
+		struct PreparedObject
+		{
+			std::vector<PreparedRenderer> renderers;
+			std::vector<ComponentPtr<>> components;
+		};
+
+		struct Cell
+		{
+			const SceneBlobCell* data = nullptr;
+			CellState state = CellState::Unloaded;
+			// false if cell went out of range while being prepared
+			bool isWanted = false;
+			std::vector<PreparedObject> preparedObjects;
+			uint32_t activatedObjectCount = 0;
+			std::vector<std::unique_ptr<GameObject>> objects;
+		};
+
+	private:
+		void PrepareCell(Cell& cell) const;
+
+		void ActivateObject(Cell& cell) const;
+
+		void UnloadCell(Cell& cell);
+
+		void CollectPreparedCells();
+
+		void SelectCells();
+
+		void ProcessQueues();
+
+		[[nodiscard]] float GetDistanceToCell(const Cell& cell, float x, float z) const noexcept;
+
+	private:
+		// time per frame for activating and destroying objects
+		static constexpr float FRAME_BUDGET_MS = 2.0f;
+
+		const SceneBlobView& m_view;
+		std::vector<Cell> m_cells;
+
+		std::deque<Cell*> m_activationQueue;
+		std::deque<std::unique_ptr<GameObject>> m_destroyQueue;
+
+		std::mutex m_preparedMutex;
+		std::vector<Cell*> m_preparedCells;
+
+		// cells being prepared by jobs
+		JobCounter m_prepareJobs;
+	};
+}
+
+#endif //SCENE_STREAMER_H
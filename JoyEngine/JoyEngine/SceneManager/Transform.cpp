@@ -1,5 +1,7 @@
 #include "Transform.h"
 
+#include "TransformSystem.h"
+
 namespace JoyEngine
 {
 	Transform::Transform() : Transform(glm::vec3(0, 0, 0), glm::vec3(0, 0, 0), glm::vec3(1, 1, 1))
@@ -8,57 +10,63 @@ namespace JoyEngine
 
 	Transform::Transform(glm::vec3 pos, glm::vec3 rot, glm::vec3 scale)
 	{
-		SetPosition(pos);
-		SetRotation(rot);
-		SetScale(scale);
+		m_handle = TransformSystem::GetInstance()->Create(pos, glm::quat(glm::radians(rot)), scale);
+	}
+
+	Transform::~Transform()
+	{
+		TransformSystem::GetInstance()->Destroy(m_handle);
+	}
+
+	void Transform::SetParent(const Transform* parent)
+	{
+		TransformSystem::GetInstance()->SetParent(
+			m_handle,
+			parent != nullptr ? parent->m_handle : TransformSystem::INVALID_HANDLE);
 	}
 
 	void Transform::SetPosition(glm::vec3 pos) noexcept
 	{
-		m_localPosition = pos;
-		UpdateModelMatrix();
+		TransformSystem::GetInstance()->SetLocalPosition(m_handle, pos);
 	}
 
 
 	void Transform::SetRotation(glm::vec3 rot) noexcept
 	{
-		m_localRotation = glm::quat(glm::vec3(
+		TransformSystem::GetInstance()->SetLocalRotation(m_handle, glm::quat(glm::vec3(
 			glm::radians(rot.x),
 			glm::radians(rot.y),
 			glm::radians(rot.z)
-		));
-		UpdateModelMatrix();
+		)));
 	}
 
 	void Transform::SetRotation(glm::quat rot) noexcept
 	{
-		m_localRotation = rot;
-		UpdateModelMatrix();
+		TransformSystem::GetInstance()->SetLocalRotation(m_handle, rot);
 	}
 
 	void Transform::SetScale(glm::vec3 scale) noexcept
 	{
-		m_localScale = scale;
-		UpdateModelMatrix();
+		TransformSystem::GetInstance()->SetLocalScale(m_handle, scale);
 	}
 
-	void Transform::UpdateModelMatrix()
+	glm::vec3 Transform::GetPosition() const noexcept
 	{
-		const glm::mat4 translationMatrix = glm::translate(glm::mat4(1.0f), m_localPosition);
-		const glm::mat4 rotationMatrix = glm::toMat4(m_localRotation);
-		const glm::mat4 scaleMatrix = glm::scale(glm::mat4(1.0f), m_localScale);
-
-		m_modelMatrix = translationMatrix * rotationMatrix * scaleMatrix;
+		return TransformSystem::GetInstance()->GetLocalPosition(m_handle);
 	}
 
-	glm::vec3 Transform::GetPosition() const noexcept { return m_localPosition; }
-
-	glm::quat Transform::GetRotation() const noexcept { return m_localRotation; }
+	glm::quat Transform::GetRotation() const noexcept
+	{
+		return TransformSystem::GetInstance()->GetLocalRotation(m_handle);
+	}
 
-	glm::vec3 Transform::GetScale() const noexcept { return m_localScale; }
+	glm::vec3 Transform::GetScale() const noexcept
+	{
+		return TransformSystem::GetInstance()->GetLocalScale(m_handle);
+	}
 
 	glm::mat4 Transform::GetModelMatrix() const
 	{
-		return m_modelMatrix;
+		return TransformSystem::GetInstance()->GetWorldMatrix(m_handle);
 	}
 }
@@ -8,13 +8,23 @@
 
 namespace JoyEngine
 {
-
+	// Handle to the data in TransformSystem. Position, rotation and scale are local to the parent
 	class Transform {
 	public:
 		Transform();
 
 		Transform(glm::vec3 pos, glm::vec3 rot, glm::vec3 scale);
 
+		~Transform();
+
+		Transform(const Transform&) = delete;
+
+		Transform& operator=(const Transform&) = delete;
+
+		// nullptr makes transform a root, local data is kept as is.
+		// Children of destroyed transform become roots
+		void SetParent(const Transform* parent);
+
 		void SetPosition(glm::vec3 pos) noexcept;
 
 		[[nodiscard]] glm::vec3 GetPosition() const noexcept;
@@ -28,16 +38,13 @@ namespace JoyEngine
 
 		[[nodiscard]] glm::vec3 GetScale() const noexcept;
 
+		// world matrix
 		[[nodiscard]] glm::mat4 GetModelMatrix() const;
 
-	private:
-		void UpdateModelMatrix();
-	private:
-		glm::vec3 m_localPosition;
-		glm::quat m_localRotation;
-		glm::vec3 m_localScale;
+		[[nodiscard]] uint32_t GetHandle() const noexcept { return m_handle; }
 
-		glm::mat4 m_modelMatrix;
+	private:
+		uint32_t m_handle;
 	};
 }
 
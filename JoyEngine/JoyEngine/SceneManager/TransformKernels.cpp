@@ -0,0 +1,135 @@
+#include "TransformKernels.h"
+
+#include <immintrin.h>
+
+#include "Utils/CpuFeatures.h"
+
+namespace JoyEngine
+{
+	TransformKernels::ComposeFunc TransformKernels::m_compose =
+		IsAvxSupported() ? ComposeAvx : IsSse2Supported() ? ComposeSse : ComposeScalar;
+
+	const char* TransformKernels::m_composeName =
+		IsAvxSupported() ? "avx" : IsSse2Supported() ? "sse" : "scalar";
+
+	static void ComposeOne(const TransformStreams& in, const AffineStreams& out, uint32_t i)
+	{
+		const float x = in.rotation[0][i];
+		const float y = in.rotation[1][i];
+		const float z = in.rotation[2][i];
+		const float w = in.rotation[3][i];
+		const float sx = in.scale[0][i];
+		const float sy = in.scale[1][i];
+		const float sz = in.scale[2][i];
+
+		const float xx = x * x, yy = y * y, zz = z * z;
+		const float xy = x * y, xz = x * z, yz = y * z;
+		const float wx = w * x, wy = w * y, wz = w * z;
+
+		out.m[0][i] = (1 - 2 * (yy + zz)) * sx;
+		out.m[1][i] = 2 * (xy - wz) * sy;
+		out.m[2][i] = 2 * (xz + wy) * sz;
+		out.m[3][i] = in.position[0][i];
+		out.m[4][i] = 2 * (xy + wz) * sx;
+		out.m[5][i] = (1 - 2 * (xx + zz)) * sy;
+		out.m[6][i] = 2 * (yz - wx) * sz;
+		out.m[7][i] = in.position[1][i];
+		out.m[8][i] = 2 * (xz - wy) * sx;
+		out.m[9][i] = 2 * (yz + wx) * sy;
+		out.m[10][i] = (1 - 2 * (xx + yy)) * sz;
+		out.m[11][i] = in.position[2][i];
+	}
+
+	void TransformKernels::ComposeScalar(const TransformStreams& in, const AffineStreams& out, uint32_t count)
+	{
+		for (uint32_t i = 0; i < count; i++)
+		{
+			ComposeOne(in, out, i);
+		}
+	}
+
+	void TransformKernels::ComposeSse(const TransformStreams& in, const AffineStreams& out, uint32_t count)
+	{
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 two = _mm_set1_ps(2.0f);
+		uint32_t i = 0;
+		for (; i + 4 <= count; i += 4)
+		{
+			const __m128 x = _mm_loadu_ps(in.rotation[0] + i);
+			const __m128 y = _mm_loadu_ps(in.rotation[1] + i);
+			const __m128 z = _mm_loadu_ps(in.rotation[2] + i);
+			const __m128 w = _mm_loadu_ps(in.rotation[3] + i);
+			const __m128 sx = _mm_loadu_ps(in.scale[0] + i);
+			const __m128 sy = _mm_loadu_ps(in.scale[1] + i);
+			const __m128 sz = _mm_loadu_ps(in.scale[2] + i);
+
+			// doubled products, so every element is a single add or sub
+			const __m128 x2 = _mm_mul_ps(x, two);
+			const __m128 y2 = _mm_mul_ps(y, two);
+			const __m128 z2 = _mm_mul_ps(z, two);
+			const __m128 xx = _mm_mul_ps(x, x2), yy = _mm_mul_ps(y, y2), zz = _mm_mul_ps(z, z2);
+			const __m128 xy = _mm_mul_ps(x, y2), xz = _mm_mul_ps(x, z2), yz = _mm_mul_ps(y, z2);
+			const __m128 wx = _mm_mul_ps(w, x2), wy = _mm_mul_ps(w, y2), wz = _mm_mul_ps(w, z2);
+
+			_mm_storeu_ps(out.m[0] + i, _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(yy, zz)), sx));
+			_mm_storeu_ps(out.m[1] + i, _mm_mul_ps(_mm_sub_ps(xy, wz), sy));
+			_mm_storeu_ps(out.m[2] + i, _mm_mul_ps(_mm_add_ps(xz, wy), sz));
+			_mm_storeu_ps(out.m[3] + i, _mm_loadu_ps(in.position[0] + i));
+			_mm_storeu_ps(out.m[4] + i, _mm_mul_ps(_mm_add_ps(xy, wz), sx));
+			_mm_storeu_ps(out.m[5] + i, _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(xx, zz)), sy));
+			_mm_storeu_ps(out.m[6] + i, _mm_mul_ps(_mm_sub_ps(yz, wx), sz));
+			_mm_storeu_ps(out.m[7] + i, _mm_loadu_ps(in.position[1] + i));
+			_mm_storeu_ps(out.m[8] + i, _mm_mul_ps(_mm_sub_ps(xz, wy), sx));
+			_mm_storeu_ps(out.m[9] + i, _mm_mul_ps(_mm_add_ps(yz, wx), sy));
+			_mm_storeu_ps(out.m[10] + i, _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(xx, yy)), sz));
+			_mm_storeu_ps(out.m[11] + i, _mm_loadu_ps(in.position[2] + i));
+		}
+		for (; i < count; i++)
+		{
+			ComposeOne(in, out, i);
+		}
+	}
+
+	void TransformKernels::ComposeAvx(const TransformStreams& in, const AffineStreams& out, uint32_t count)
+	{
+		const __m256 one = _mm256_set1_ps(1.0f);
+		const __m256 two = _mm256_set1_ps(2.0f);
+		uint32_t i = 0;
+		for (; i + 8 <= count; i += 8)
+		{
+			const __m256 x = _mm256_loadu_ps(in.rotation[0] + i);
+			const __m256 y = _mm256_loadu_ps(in.rotation[1] + i);
+			const __m256 z = _mm256_loadu_ps(in.rotation[2] + i);
+			const __m256 w = _mm256_loadu_ps(in.rotation[3] + i);
+			const __m256 sx = _mm256_loadu_ps(in.scale[0] + i);
+			const __m256 sy = _mm256_loadu_ps(in.scale[1] + i);
+			const __m256 sz = _mm256_loadu_ps(in.scale[2] + i);
+
+			const __m256 x2 = _mm256_mul_ps(x, two);
+			const __m256 y2 = _mm256_mul_ps(y, two);
+			const __m256 z2 = _mm256_mul_ps(z, two);
+			const __m256 xx = _mm256_mul_ps(x, x2), yy = _mm256_mul_ps(y, y2), zz = _mm256_mul_ps(z, z2);
+			const __m256 xy = _mm256_mul_ps(x, y2), xz = _mm256_mul_ps(x, z2), yz = _mm256_mul_ps(y, z2);
+			const __m256 wx = _mm256_mul_ps(w, x2), wy = _mm256_mul_ps(w, y2), wz = _mm256_mul_ps(w, z2);
+
+			_mm256_storeu_ps(out.m[0] + i, _mm256_mul_ps(_mm256_sub_ps(one, _mm256_add_ps(yy, zz)), sx));
+			_mm256_storeu_ps(out.m[1] + i, _mm256_mul_ps(_mm256_sub_ps(xy, wz), sy));
+			_mm256_storeu_ps(out.m[2] + i, _mm256_mul_ps(_mm256_add_ps(xz, wy), sz));
+			_mm256_storeu_ps(out.m[3] + i, _mm256_loadu_ps(in.position[0] + i));
+			_mm256_storeu_ps(out.m[4] + i, _mm256_mul_ps(_mm256_add_ps(xy, wz), sx));
+			_mm256_storeu_ps(out.m[5] + i, _mm256_mul_ps(_mm256_sub_ps(one, _mm256_add_ps(xx, zz)), sy));
+			_mm256_storeu_ps(out.m[6] + i, _mm256_mul_ps(_mm256_sub_ps(yz, wx), sz));
+			_mm256_storeu_ps(out.m[7] + i, _mm256_loadu_ps(in.position[1] + i));
+			_mm256_storeu_ps(out.m[8] + i, _mm256_mul_ps(_mm256_sub_ps(xz, wy), sx));
+			_mm256_storeu_ps(out.m[9] + i, _mm256_mul_ps(_mm256_add_ps(yz, wx), sy));
+			_mm256_storeu_ps(out.m[10] + i, _mm256_mul_ps(_mm256_sub_ps(one, _mm256_add_ps(xx, yy)), sz));
+			_mm256_storeu_ps(out.m[11] + i, _mm256_loadu_ps(in.position[2] + i));
+		}
+		// upper halves of ymm registers are dirty, avoid SSE transition penalty in the tail and after return
+		_mm256_zeroupper();
+		for (; i < count; i++)
+		{
+			ComposeOne(in, out, i);
+		}
+	}
+}
@@ -0,0 +1,49 @@
+#ifndef TRANSFORM_KERNELS_H
+#define TRANSFORM_KERNELS_H
+
+#include <cstdint>
+
+namespace JoyEngine
+{
+	// Position, rotation (x, y, z, w) and scale of transforms in structure-of-arrays layout
+	struct TransformStreams
+	{
+		const float* position[3];
+		const float* rotation[4];
+		const float* scale[3];
+	};
+
+	// 3x4 affine matrices, element (row, column) goes to m[row * 4 + column].
+	// Fourth column is translation, last row of the full matrix is (0, 0, 0, 1)
+	struct AffineStreams
+	{
+		float* m[12];
+	};
+
+	// Batch conversion of translation * rotation * scale to affine matrices.
+	// Rotations must be normalized. The fastest kernel supported by CPU is selected once at startup
+	class TransformKernels
+	{
+	public:
+		using ComposeFunc = void(*)(const TransformStreams& in, const AffineStreams& out, uint32_t count);
+
+		static void ComposeScalar(const TransformStreams& in, const AffineStreams& out, uint32_t count);
+
+		static void ComposeSse(const TransformStreams& in, const AffineStreams& out, uint32_t count);
+
+		static void ComposeAvx(const TransformStreams& in, const AffineStreams& out, uint32_t count);
+
+		static void Compose(const TransformStreams& in, const AffineStreams& out, uint32_t count)
+		{
+			m_compose(in, out, count);
+		}
+
+		[[nodiscard]] static const char* GetComposeName() noexcept { return m_composeName; }
+
+	private:
+		static ComposeFunc m_compose;
+		static const char* m_composeName;
+	};
+}
+
+#endif //TRANSFORM_KERNELS_H
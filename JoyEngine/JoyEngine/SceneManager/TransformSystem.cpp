@@ -0,0 +1,435 @@
+#include "TransformSystem.h"
+
+#include "Utils/Assert.h"
+
+namespace JoyEngine
+{
+	TransformSystem* TransformSystem::m_instance = nullptr;
+
+	template <typename F>
+	void TransformSystem::ForEachStream(F f)
+	{
+		for (auto& stream : m_positions) f(stream);
+		for (auto& stream : m_rotations) f(stream);
+		for (auto& stream : m_scales) f(stream);
+		for (auto& stream : m_localMatrices) f(stream);
+		for (auto& stream : m_worldMatrices) f(stream);
+	}
+
+	uint32_t TransformSystem::Create(glm::vec3 position, glm::quat rotation, glm::vec3 scale)
+	{
+		uint32_t handle;
+		if (!m_freeHandles.empty())
+		{
+			handle = m_freeHandles.back();
+			m_freeHandles.pop_back();
+		}
+		else
+		{
+			handle = static_cast<uint32_t>(m_nodes.size());
+			m_nodes.emplace_back();
+		}
+
+		// new root goes last, order stays valid
+		const auto index = static_cast<uint32_t>(m_handles.size());
+		m_nodes[handle] = Node();
+		m_nodes[handle].index = index;
+		ForEachStream([](std::vector<float>& stream) { stream.emplace_back(); });
+		for (uint32_t i = 0; i < 3; i++)
+		{
+			m_positions[i][index] = position[i];
+			m_scales[i][index] = scale[i];
+		}
+		m_rotations[0][index] = rotation.x;
+		m_rotations[1][index] = rotation.y;
+		m_rotations[2][index] = rotation.z;
+		m_rotations[3][index] = rotation.w;
+		m_parents.push_back(INVALID_HANDLE);
+		m_flags.push_back(LocalDirty);
+		m_handles.push_back(handle);
+		m_hasDirty.store(true, std::memory_order_relaxed);
+		return handle;
+	}
+
+	void TransformSystem::Destroy(uint32_t handle)
+	{
+		Unlink(handle);
+		for (uint32_t child = m_nodes[handle].firstChild; child != INVALID_HANDLE;)
+		{
+			const uint32_t next = m_nodes[child].nextSibling;
+			m_nodes[child].parent = INVALID_HANDLE;
+			m_nodes[child].nextSibling = INVALID_HANDLE;
+			m_parents[m_nodes[child].index] = INVALID_HANDLE;
+			MarkDirty(m_nodes[child].index);
+			child = next;
+		}
+
+		// swap with the last one, order is restored in Update
+		const uint32_t index = m_nodes[handle].index;
+		const auto lastIndex = static_cast<uint32_t>(m_handles.size() - 1);
+		if (index != lastIndex)
+		{
+			const uint32_t lastHandle = m_handles[lastIndex];
+			ForEachStream([index, lastIndex](std::vector<float>& stream) { stream[index] = stream[lastIndex]; });
+			m_parents[index] = m_parents[lastIndex];
+			m_flags[index] = m_flags[lastIndex];
+			m_handles[index] = lastHandle;
+			m_nodes[lastHandle].index = index;
+			uint32_t child = m_nodes[lastHandle].firstChild;
+			while (child != INVALID_HANDLE)
+			{
+				m_parents[m_nodes[child].index] = index;
+				child = m_nodes[child].nextSibling;
+			}
+			m_isOrderDirty = true;
+		}
+		ForEachStream([](std::vector<float>& stream) { stream.pop_back(); });
+		m_parents.pop_back();
+		m_flags.pop_back();
+		m_handles.pop_back();
+
+		m_nodes[handle] = Node();
+		m_freeHandles.push_back(handle);
+	}
+
+	void TransformSystem::SetParent(uint32_t handle, uint32_t parentHandle)
+	{
+		if (m_nodes[handle].parent == parentHandle)
+		{
+			return;
+		}
+		for (uint32_t p = parentHandle; p != INVALID_HANDLE; p = m_nodes[p].parent)
+		{
+			ASSERT_DESC(p != handle, "Transform cannot be parented to its own child");
+		}
+
+		Unlink(handle);
+		Node& node = m_nodes[handle];
+		node.parent = parentHandle;
+		if (parentHandle == INVALID_HANDLE)
+		{
+			m_parents[node.index] = INVALID_HANDLE;
+		}
+		else
+		{
+			Node& parent = m_nodes[parentHandle];
+			node.nextSibling = parent.firstChild;
+			parent.firstChild = handle;
+			m_parents[node.index] = parent.index;
+			if (parent.index > node.index)
+			{
+				m_isOrderDirty = true;
+			}
+		}
+		MarkDirty(node.index);
+	}
+
+	void TransformSystem::SetLocalPosition(uint32_t handle, glm::vec3 position) noexcept
+	{
+		const uint32_t index = m_nodes[handle].index;
+		m_positions[0][index] = position.x;
+		m_positions[1][index] = position.y;
+		m_positions[2][index] = position.z;
+		MarkDirty(index);
+	}
+
+	void TransformSystem::SetLocalRotation(uint32_t handle, glm::quat rotation) noexcept
+	{
+		const uint32_t index = m_nodes[handle].index;
+		m_rotations[0][index] = rotation.x;
+		m_rotations[1][index] = rotation.y;
+		m_rotations[2][index] = rotation.z;
+		m_rotations[3][index] = rotation.w;
+		MarkDirty(index);
+	}
+
+	void TransformSystem::SetLocalScale(uint32_t handle, glm::vec3 scale) noexcept
+	{
+		const uint32_t index = m_nodes[handle].index;
+		m_scales[0][index] = scale.x;
+		m_scales[1][index] = scale.y;
+		m_scales[2][index] = scale.z;
+		MarkDirty(index);
+	}
+
+	glm::vec3 TransformSystem::GetLocalPosition(uint32_t handle) const noexcept
+	{
+		const uint32_t index = m_nodes[handle].index;
+		return glm::vec3(m_positions[0][index], m_positions[1][index], m_positions[2][index]);
+	}
+
+	glm::quat TransformSystem::GetLocalRotation(uint32_t handle) const noexcept
+	{
+		const uint32_t index = m_nodes[handle].index;
+		return glm::quat(m_rotations[3][index], m_rotations[0][index], m_rotations[1][index], m_rotations[2][index]);
+	}
+
+	glm::vec3 TransformSystem::GetLocalScale(uint32_t handle) const noexcept
+	{
+		const uint32_t index = m_nodes[handle].index;
+		return glm::vec3(m_scales[0][index], m_scales[1][index], m_scales[2][index]);
+	}
+
+	glm::mat4 TransformSystem::GetWorldMatrix(uint32_t handle) const
+	{
+		const uint32_t index = m_nodes[handle].index;
+		if (!m_hasDirty.load(std::memory_order_relaxed))
+		{
+			return GetCachedWorldMatrix(index);
+		}
+		uint32_t topIndex = INVALID_HANDLE;
+		for (uint32_t i = index; i != INVALID_HANDLE; i = m_parents[i])
+		{
+			if (m_flags[i] & LocalDirty)
+			{
+				topIndex = i;
+			}
+		}
+		if (topIndex == INVALID_HANDLE)
+		{
+			return GetCachedWorldMatrix(index);
+		}
+		return ComputeWorldMatrix(index, topIndex);
+	}
+
+	void TransformSystem::Update()
+	{
+		if (m_isOrderDirty)
+		{
+			Rebuild();
+		}
+		m_changedHandles.clear();
+		// changed flags of the previous pass have to be cleared even if nothing is dirty
+		if (!m_hasDirty.load(std::memory_order_relaxed) && !m_hasChanged)
+		{
+			return;
+		}
+
+		const auto count = static_cast<uint32_t>(m_handles.size());
+		// local matrices of runs of dirty transforms, all of them when the whole scene moves
+		for (uint32_t i = 0; i < count;)
+		{
+			if (!(m_flags[i] & LocalDirty))
+			{
+				i++;
+				continue;
+			}
+			uint32_t end = i + 1;
+			while (end < count && (m_flags[end] & LocalDirty))
+			{
+				end++;
+			}
+			ComposeLocalMatrices(i, end - i);
+			i = end;
+		}
+
+		bool hasChanged = false;
+		for (uint32_t i = 0; i < count; i++)
+		{
+			const uint32_t parent = m_parents[i];
+			ASSERT(parent == INVALID_HANDLE || parent < i);
+			const bool isParentChanged = parent != INVALID_HANDLE && (m_flags[parent] & WorldChanged);
+			if ((m_flags[i] & LocalDirty) || isParentChanged)
+			{
+				MultiplyWorldMatrix(i, parent);
+				m_flags[i] = WorldChanged;
+				m_changedHandles.push_back(m_handles[i]);
+				hasChanged = true;
+			}
+			else
+			{
+				m_flags[i] = 0;
+			}
+		}
+		m_hasDirty.store(false, std::memory_order_relaxed);
+		m_hasChanged = hasChanged;
+	}
+
+	void TransformSystem::MarkDirty(uint32_t index) noexcept
+	{
+		m_flags[index] |= LocalDirty;
+		// checked first, so concurrent setters don't fight for the cache line
+		if (!m_hasDirty.load(std::memory_order_relaxed))
+		{
+			m_hasDirty.store(true, std::memory_order_relaxed);
+		}
+	}
+
+	TransformStreams TransformSystem::GetTransformStreams(uint32_t first) const noexcept
+	{
+		TransformStreams streams = {};
+		for (uint32_t i = 0; i < 3; i++)
+		{
+			streams.position[i] = m_positions[i].data() + first;
+			streams.scale[i] = m_scales[i].data() + first;
+		}
+		for (uint32_t i = 0; i < 4; i++)
+		{
+			streams.rotation[i] = m_rotations[i].data() + first;
+		}
+		return streams;
+	}
+
+	void TransformSystem::ComposeLocalMatrices(uint32_t first, uint32_t count)
+	{
+		AffineStreams out = {};
+		for (uint32_t i = 0; i < 12; i++)
+		{
+			out.m[i] = m_localMatrices[i].data() + first;
+		}
+		TransformKernels::Compose(GetTransformStreams(first), out, count);
+	}
+
+	void TransformSystem::MultiplyWorldMatrix(uint32_t index, uint32_t parent)
+	{
+		if (parent == INVALID_HANDLE)
+		{
+			for (uint32_t i = 0; i < 12; i++)
+			{
+				m_worldMatrices[i][index] = m_localMatrices[i][index];
+			}
+			return;
+		}
+		float p[12];
+		float l[12];
+		for (uint32_t i = 0; i < 12; i++)
+		{
+			p[i] = m_worldMatrices[i][parent];
+			l[i] = m_localMatrices[i][index];
+		}
+		for (uint32_t row = 0; row < 3; row++)
+		{
+			for (uint32_t column = 0; column < 4; column++)
+			{
+				float value = p[row * 4] * l[column] +
+					p[row * 4 + 1] * l[4 + column] +
+					p[row * 4 + 2] * l[8 + column];
+				if (column == 3)
+				{
+					value += p[row * 4 + 3];
+				}
+				m_worldMatrices[row * 4 + column][index] = value;
+			}
+		}
+	}
+
+	void TransformSystem::Unlink(uint32_t handle)
+	{
+		Node& node = m_nodes[handle];
+		if (node.parent == INVALID_HANDLE)
+		{
+			return;
+		}
+		uint32_t* link = &m_nodes[node.parent].firstChild;
+		while (*link != handle)
+		{
+			ASSERT(*link != INVALID_HANDLE);
+			link = &m_nodes[*link].nextSibling;
+		}
+		*link = node.nextSibling;
+		node.nextSibling = INVALID_HANDLE;
+		node.parent = INVALID_HANDLE;
+	}
+
+	void TransformSystem::Rebuild()
+	{
+		const auto count = static_cast<uint32_t>(m_handles.size());
+		// order[newIndex] = oldIndex
+		std::vector<uint32_t> order;
+		order.reserve(count);
+		std::vector<uint32_t> stack;
+		for (uint32_t i = 0; i < count; i++)
+		{
+			if (m_nodes[m_handles[i]].parent != INVALID_HANDLE)
+			{
+				continue;
+			}
+			stack.push_back(m_handles[i]);
+			while (!stack.empty())
+			{
+				const uint32_t handle = stack.back();
+				stack.pop_back();
+				order.push_back(m_nodes[handle].index);
+				uint32_t child = m_nodes[handle].firstChild;
+				while (child != INVALID_HANDLE)
+				{
+					stack.push_back(child);
+					child = m_nodes[child].nextSibling;
+				}
+			}
+		}
+		ASSERT(order.size() == count);
+
+		ForEachStream([&order](std::vector<float>& stream) { Permute(stream, order); });
+		Permute(m_flags, order);
+		Permute(m_handles, order);
+		for (uint32_t i = 0; i < count; i++)
+		{
+			m_nodes[m_handles[i]].index = i;
+		}
+		for (uint32_t i = 0; i < count; i++)
+		{
+			const uint32_t parent = m_nodes[m_handles[i]].parent;
+			m_parents[i] = parent == INVALID_HANDLE ? INVALID_HANDLE : m_nodes[parent].index;
+		}
+		m_isOrderDirty = false;
+	}
+
+	template <typename T>
+	void TransformSystem::Permute(std::vector<T>& data, const std::vector<uint32_t>& order)
+	{
+		std::vector<T> permuted;
+		permuted.reserve(data.size());
+		for (const uint32_t oldIndex : order)
+		{
+			permuted.push_back(data[oldIndex]);
+		}
+		data.swap(permuted);
+	}
+
+	static glm::mat4 AffineToMat4(const float* m) noexcept
+	{
+		glm::mat4 result(1.0f);
+		for (uint32_t row = 0; row < 3; row++)
+		{
+			for (uint32_t column = 0; column < 4; column++)
+			{
+				result[column][row] = m[row * 4 + column];
+			}
+		}
+		return result;
+	}
+
+	glm::mat4 TransformSystem::ComputeLocalMatrix(uint32_t index) const
+	{
+		float m[12];
+		AffineStreams out = {};
+		for (uint32_t i = 0; i < 12; i++)
+		{
+			out.m[i] = &m[i];
+		}
+		TransformKernels::ComposeScalar(GetTransformStreams(index), out, 1);
+		return AffineToMat4(m);
+	}
+
+	glm::mat4 TransformSystem::GetCachedWorldMatrix(uint32_t index) const noexcept
+	{
+		float m[12];
+		for (uint32_t i = 0; i < 12; i++)
+		{
+			m[i] = m_worldMatrices[i][index];
+		}
+		return AffineToMat4(m);
+	}
+
+	glm::mat4 TransformSystem::ComputeWorldMatrix(uint32_t index, uint32_t topIndex) const
+	{
+		const glm::mat4 local = ComputeLocalMatrix(index);
+		if (index == topIndex)
+		{
+			const uint32_t parent = m_parents[index];
+			return parent == INVALID_HANDLE ? local : GetCachedWorldMatrix(parent) * local;
+		}
+		return ComputeWorldMatrix(m_parents[index], topIndex) * local;
+	}
+}
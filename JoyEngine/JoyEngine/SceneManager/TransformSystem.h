@@ -0,0 +1,143 @@
+#ifndef TRANSFORM_SYSTEM_H
+#define TRANSFORM_SYSTEM_H
+
+#include <vector>
+#include <atomic>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include "TransformKernels.h"
+
+namespace JoyEngine
+{
+	// Local and world data of all transforms in contiguous arrays, component by component,
+	// so local matrices of all changed transforms are composed by SIMD kernels in one batch.
+	// Transforms are addressed by stable handles, dense index of a transform changes when hierarchy changes.
+	// Arrays are kept in depth-first order, so parent always goes before its children
+	// and world matrices are propagated in a single linear pass.
+	// Setters only mark transform dirty, world matrices of dirty transforms and their subtrees
+	// are recomputed once per frame in Update.
+	// Transforms are created, destroyed and reparented on the main thread.
+	// Local setters of different transforms may be called concurrently by component update jobs.
+	class TransformSystem
+	{
+	public:
+		static constexpr uint32_t INVALID_HANDLE = 0xFFFFFFFF;
+
+		uint32_t Create(glm::vec3 position, glm::quat rotation, glm::vec3 scale);
+
+		// children of destroyed transform become roots and keep their local data
+		void Destroy(uint32_t handle);
+
+		// INVALID_HANDLE makes transform a root
+		void SetParent(uint32_t handle, uint32_t parentHandle);
+
+		[[nodiscard]] uint32_t GetParent(uint32_t handle) const noexcept { return m_nodes[handle].parent; }
+
+		void SetLocalPosition(uint32_t handle, glm::vec3 position) noexcept;
+
+		void SetLocalRotation(uint32_t handle, glm::quat rotation) noexcept;
+
+		void SetLocalScale(uint32_t handle, glm::vec3 scale) noexcept;
+
+		[[nodiscard]] glm::vec3 GetLocalPosition(uint32_t handle) const noexcept;
+
+		[[nodiscard]] glm::quat GetLocalRotation(uint32_t handle) const noexcept;
+
+		[[nodiscard]] glm::vec3 GetLocalScale(uint32_t handle) const noexcept;
+
+		// Up to date even if transform or its parents were changed after the last Update,
+		// in that case the matrix is computed from dirty ancestors down without touching the cache
+		[[nodiscard]] glm::mat4 GetWorldMatrix(uint32_t handle) const;
+
+		// restores depth-first order if hierarchy changed and propagates dirty transforms
+		void Update();
+
+		// handles of transforms whose world matrix was recomputed by the last Update, in depth-first order
+		[[nodiscard]] const std::vector<uint32_t>& GetChangedHandles() const noexcept { return m_changedHandles; }
+
+		// don't want to make systems static because of exceptions before main()
+		static TransformSystem* GetInstance()
+		{
+			if (m_instance == nullptr)
+			{
+				m_instance = new TransformSystem();
+			}
+			return m_instance;
+		}
+
+	private:
+		enum TransformFlags : uint8_t
+		{
+			LocalDirty = 1 << 0,
+			// world matrix was recomputed in the current pass, children have to follow
+			WorldChanged = 1 << 1
+		};
+
+		// hierarchy links, indexed by handle
+		struct Node
+		{
+			uint32_t index = 0;
+			uint32_t parent = INVALID_HANDLE;
+			uint32_t firstChild = INVALID_HANDLE;
+			uint32_t nextSibling = INVALID_HANDLE;
+		};
+
+	private:
+		void MarkDirty(uint32_t index) noexcept;
+
+		// calls f for every float stream, they are resized and permuted together
+		template <typename F>
+		void ForEachStream(F f);
+
+		[[nodiscard]] TransformStreams GetTransformStreams(uint32_t first) const noexcept;
+
+		// composes local matrices of [first, first + count)
+		void ComposeLocalMatrices(uint32_t first, uint32_t count);
+
+		// world = parent world * local, all matrices are affine
+		void MultiplyWorldMatrix(uint32_t index, uint32_t parent);
+
+		void Unlink(uint32_t handle);
+
+		// restores depth-first order, roots keep their relative order
+		void Rebuild();
+
+		template <typename T>
+		static void Permute(std::vector<T>& data, const std::vector<uint32_t>& order);
+
+		[[nodiscard]] glm::mat4 ComputeLocalMatrix(uint32_t index) const;
+
+		[[nodiscard]] glm::mat4 GetCachedWorldMatrix(uint32_t index) const noexcept;
+
+		// world matrix of index computed from world matrix of topIndex's parent, which is up to date
+		[[nodiscard]] glm::mat4 ComputeWorldMatrix(uint32_t index, uint32_t topIndex) const;
+
+	private:
+		static TransformSystem* m_instance;
+
+		// dense, in depth-first order after Update
+		std::vector<float> m_positions[3];
+		std::vector<float> m_rotations[4]; // x, y, z, w
+		std::vector<float> m_scales[3];
+		// 3x4 affine matrices, see AffineStreams
+		std::vector<float> m_localMatrices[12]; // valid if not LocalDirty
+		std::vector<float> m_worldMatrices[12];
+		std::vector<uint32_t> m_parents; // dense index of parent or INVALID_HANDLE
+		std::vector<uint8_t> m_flags; // TransformFlags
+		std::vector<uint32_t> m_handles;
+
+		std::vector<Node> m_nodes;
+		std::vector<uint32_t> m_freeHandles;
+		std::vector<uint32_t> m_changedHandles;
+
+		bool m_isOrderDirty = false;
+		// relaxed, set concurrently by setters and read on the main thread after their jobs are waited for
+		std::atomic<bool> m_hasDirty = false;
+		bool m_hasChanged = false;
+	};
+}
+
+#endif //TRANSFORM_SYSTEM_H
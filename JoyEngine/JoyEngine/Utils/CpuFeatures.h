@@ -0,0 +1,26 @@
+#ifndef CPU_FEATURES_H
+#define CPU_FEATURES_H
+
+#include <intrin.h>
+
+namespace JoyEngine
+{
+	inline bool IsSse2Supported()
+	{
+		int info[4];
+		__cpuid(info, 1);
+		return (info[3] & (1 << 26)) != 0;
+	}
+
+	inline bool IsAvxSupported()
+	{
+		int info[4];
+		__cpuid(info, 1);
+		const bool isOsXSaveSupported = (info[2] & (1 << 27)) != 0;
+		const bool isAvxSupported = (info[2] & (1 << 28)) != 0;
+		// OS has to save ymm registers on context switch
+		return isOsXSaveSupported && isAvxSupported && (_xgetbv(0) & 0x6) == 0x6;
+	}
+}
+
+#endif //CPU_FEATURES_H
@@ -0,0 +1,79 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <chrono>
+#include <cstdint>
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+namespace JoyEngine
+{
+	// Timing helpers shared by benches. Numbers are meaningful in Release builds only
+	class Bench
+	{
+	public:
+		// best of repeatCount runs in seconds, the best run is the least disturbed by the rest of the system
+		template <typename F>
+		static double Measure(uint32_t repeatCount, const F& function)
+		{
+			double best = std::numeric_limits<double>::max();
+			for (uint32_t i = 0; i < repeatCount; i++)
+			{
+				const auto startTime = std::chrono::high_resolution_clock::now();
+				function();
+				const auto endTime = std::chrono::high_resolution_clock::now();
+				best = std::min(best, std::chrono::duration<double>(endTime - startTime).count());
+			}
+			return best;
+		}
+
+		// keeps a result alive so the measured code is not thrown away by the optimizer
+		template <typename T>
+		static void Consume(const T& value)
+		{
+			m_sink = m_sink + static_cast<uint64_t>(value);
+		}
+
+		// xorshift, benches see the same data on every run
+		static uint32_t NextRandom(uint32_t& state)
+		{
+			state ^= state << 13;
+			state ^= state >> 17;
+			state ^= state << 5;
+			return state;
+		}
+
+		static float NextRandom(uint32_t& state, float min, float max)
+		{
+			return min + (max - min) * static_cast<float>(NextRandom(state) >> 8) / static_cast<float>(1 << 24);
+		}
+
+		// thread counts of scaling benches, from one to the 64 threads of the largest target machines
+		static std::vector<uint32_t> GetThreadCounts()
+		{
+			return {1, 2, 4, 8, 16, 32, 64};
+		}
+
+	private:
+		static volatile uint64_t m_sink;
+	};
+
+	void RunJobSystemBench();
+
+	void RunBoundingVolumeHierarchyBench();
+
+	void RunRadixSortBench();
+
+	void RunTransformKernelsBench();
+
+	void RunOcclusionBufferBench();
+
+	void RunFrameScalingBench();
+
+	void RunReflectionBench();
+
+	void RunSceneJsonBench();
+}
+
+#endif //BENCH_H
@@ -0,0 +1,165 @@
+#include "Bench.h"
+
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "JoyContext.h"
+#include "Common/Bounds.h"
+#include "Common/JobSystem.h"
+#include "SceneManager/BoundingVolumeHierarchy.h"
+
+namespace JoyEngine
+{
+	// Synthetic scene of boxes scattered over a square at constant density, so a camera sees about
+	// the same number of them at any scene size. Tree queries are compared with testing every box
+	void RunBoundingVolumeHierarchyBench()
+	{
+		constexpr uint32_t QUERY_COUNT = 64;
+		constexpr uint32_t REFIT_FRAME_COUNT = 16;
+		// share of proxies moved every frame
+		constexpr uint32_t MOVE_DIVIDER = 100;
+		constexpr float SPACING = 4.0f;
+		constexpr float FAR_PLANE = 500.0f;
+
+		JobSystem jobs;
+		JoyContext::Jobs = &jobs;
+
+		for (const uint32_t objectCount : {10'000u, 100'000u, 1'000'000u})
+		{
+			const float halfSide = std::sqrt(static_cast<float>(objectCount)) * SPACING * 0.5f;
+			uint32_t state = 0x9E3779B9;
+			std::vector<AABB> boxes(objectCount);
+			for (AABB& box : boxes)
+			{
+				const glm::vec3 center(Bench::NextRandom(state, -halfSide, halfSide), Bench::NextRandom(state, 0, 20),
+				                       Bench::NextRandom(state, -halfSide, halfSide));
+				const glm::vec3 extents(Bench::NextRandom(state, 0.25f, 2), Bench::NextRandom(state, 0.25f, 2),
+				                        Bench::NextRandom(state, 0.25f, 2));
+				box = AABB(center - extents, center + extents);
+			}
+
+			std::vector<Frustum> frustums;
+			std::vector<glm::vec3> origins;
+			std::vector<glm::vec3> directions;
+			const glm::mat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, FAR_PLANE);
+			for (uint32_t i = 0; i < QUERY_COUNT; i++)
+			{
+				const glm::vec3 eye(Bench::NextRandom(state, -halfSide, halfSide), 10,
+				                    Bench::NextRandom(state, -halfSide, halfSide));
+				const float angle = Bench::NextRandom(state, 0, 6.2831853f);
+				const glm::vec3 direction(std::cos(angle), -0.05f, std::sin(angle));
+				frustums.push_back(Frustum::FromMatrix(projection * glm::lookAt(eye, eye + direction, glm::vec3(0, 1, 0))));
+				origins.push_back(eye);
+				directions.push_back(glm::normalize(direction));
+			}
+
+			BoundingVolumeHierarchy tree;
+			const double insertTime = Bench::Measure(1, [&tree, &boxes]()
+			{
+				for (const AABB& box : boxes)
+				{
+					tree.Insert(box, nullptr);
+				}
+			});
+			const float insertCost = tree.GetCost();
+			const double rebuildTime = Bench::Measure(1, [&tree]()
+			{
+				tree.Rebuild();
+			});
+			const float rebuildCost = tree.GetCost();
+
+			uint32_t visibleCount = 0;
+			const double frustumTime = Bench::Measure(3, [&tree, &frustums, &visibleCount]()
+			{
+				visibleCount = 0;
+				for (const Frustum& frustum : frustums)
+				{
+					tree.QueryFrustum(frustum, [&visibleCount](uint32_t, void*)
+					{
+						visibleCount++;
+					});
+				}
+			});
+			uint32_t bruteForceCount = 0;
+			const double bruteForceTime = Bench::Measure(1, [&boxes, &frustums, &bruteForceCount]()
+			{
+				for (const Frustum& frustum : frustums)
+				{
+					for (const AABB& box : boxes)
+					{
+						bruteForceCount += frustum.Test(box) != FrustumTest::Outside;
+					}
+				}
+			});
+			Bench::Consume(bruteForceCount);
+
+			uint32_t sphereCount = 0;
+			const double sphereTime = Bench::Measure(3, [&tree, &origins, &sphereCount]()
+			{
+				for (const glm::vec3& center : origins)
+				{
+					tree.QuerySphere(center, 20.0f, [&sphereCount](uint32_t, void*)
+					{
+						sphereCount++;
+					});
+				}
+			});
+			Bench::Consume(sphereCount);
+
+			float hitDistance = 0;
+			const double rayTime = Bench::Measure(3, [&tree, &boxes, &origins, &directions, &hitDistance]()
+			{
+				for (uint32_t i = 0; i < QUERY_COUNT; i++)
+				{
+					const Ray ray(origins[i], directions[i]);
+					const glm::vec3 inverseDirection = 1.0f / ray.direction;
+					float nearest = FAR_PLANE;
+					tree.QueryRay(ray, FAR_PLANE, [&boxes, &ray, inverseDirection, &nearest](uint32_t proxy, void*)
+					{
+						float distance;
+						if (ray.Intersects(boxes[proxy], inverseDirection, nearest, distance))
+						{
+							nearest = distance;
+						}
+						return nearest;
+					});
+					hitDistance += nearest;
+				}
+			});
+			Bench::Consume(hitDistance);
+
+			// small moves of a share of proxies per frame, as animated objects do, Update only refits
+			const double refitTime = Bench::Measure(1, [&tree, &boxes, &state, objectCount]()
+			{
+				for (uint32_t frame = 0; frame < REFIT_FRAME_COUNT; frame++)
+				{
+					for (uint32_t i = 0; i < objectCount / MOVE_DIVIDER; i++)
+					{
+						const uint32_t proxy = Bench::NextRandom(state) % objectCount;
+						const glm::vec3 offset(Bench::NextRandom(state, -0.5f, 0.5f), 0, Bench::NextRandom(state, -0.5f, 0.5f));
+						boxes[proxy] = AABB(boxes[proxy].min + offset, boxes[proxy].max + offset);
+						tree.Move(proxy, boxes[proxy]);
+					}
+					tree.Update();
+				}
+			});
+			tree.WaitForRebuild();
+
+			std::cout << std::fixed << std::setprecision(2)
+				<< objectCount << " objects" << std::endl
+				<< "  insert " << insertTime * 1e9 / objectCount << " ns per object, SAH cost " << insertCost << std::endl
+				<< "  rebuild " << rebuildTime * 1e3 << " ms, SAH cost " << rebuildCost << std::endl
+				<< "  frustum " << frustumTime * 1e6 / QUERY_COUNT << " us, " << visibleCount / QUERY_COUNT
+				<< " visible, every box tested " << bruteForceTime * 1e6 / QUERY_COUNT << " us" << std::endl
+				<< "  sphere " << sphereTime * 1e6 / QUERY_COUNT << " us, ray " << rayTime * 1e6 / QUERY_COUNT << " us" << std::endl
+				<< "  refit of " << objectCount / MOVE_DIVIDER << " moved " << refitTime * 1e3 / REFIT_FRAME_COUNT
+				<< " ms per frame" << std::endl;
+		}
+
+		JoyContext::Jobs = nullptr;
+	}
+}
@@ -0,0 +1,307 @@
+#include "Bench.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "JoyContext.h"
+#include "Common/Bounds.h"
+#include "Common/JobSystem.h"
+#include "Common/RadixSort.h"
+#include "DataManager/DataManager.h"
+#include "RenderManager/CullingKernels.h"
+#include "RenderManager/DrawSortKey.h"
+#include "Utils/GUID.h"
+
+namespace JoyEngine
+{
+	namespace
+	{
+		struct KitchenRenderer
+		{
+			uint32_t mesh;
+			uint32_t material;
+			uint32_t pipeline;
+		};
+
+		struct FrameDraw
+		{
+			glm::mat4 model;
+			uint32_t mesh;
+			uint32_t material;
+			uint32_t pipeline;
+			uint32_t firstInstance;
+		};
+
+		struct FrameChunk
+		{
+			DrawSortKey::Pass pass;
+			uint32_t begin;
+			uint32_t end;
+		};
+	}
+
+	// as RenderManager::HashValue, chunk keys are FNV-1a over 64 bit words
+	static uint64_t HashValue(uint64_t hash, uint64_t value)
+	{
+		hash = (hash ^ value) * 1099511628211ull;
+		return hash ^ hash >> 32;
+	}
+
+	// Renderers of the kitchen scene with ids the renderer sorts by, pipeline is the index of the shared material
+	static std::vector<KitchenRenderer> ReadKitchenRenderers()
+	{
+		DataManager dataManager;
+		// the scene SceneManager loads
+		const rapidjson::Document sceneJson = dataManager.GetSerializedData(
+			GUID::StringToGuid("11dcfeba-c2b6-4c2e-a3c7-51054ff06f1d"), DataType::scene);
+		std::map<GUID, uint32_t> pipelines;
+		std::vector<KitchenRenderer> renderers;
+		for (const auto& object : sceneJson["objects"].GetArray())
+		{
+			for (const auto& component : object["components"].GetArray())
+			{
+				if (component["type"].GetString() != std::string("renderer"))
+				{
+					continue;
+				}
+				const GUID materialGuid = GUID::StringToGuid(component["material"].GetString());
+				const rapidjson::Document materialJson = dataManager.GetSerializedData(materialGuid, DataType::material);
+				const GUID sharedMaterialGuid = GUID::StringToGuid(materialJson["sharedMaterial"].GetString());
+				const uint32_t pipeline = pipelines.emplace(sharedMaterialGuid, static_cast<uint32_t>(pipelines.size())).first->second;
+				renderers.push_back({
+					DrawSortKey::GetId(GUID::StringToGuid(component["model"].GetString())),
+					DrawSortKey::GetId(materialGuid),
+					pipeline
+				});
+			}
+		}
+		return renderers;
+	}
+
+	// CPU time of a frame of the kitchen scene replicated on a grid up to 100k renderers, against worker count.
+	// Stages follow RenderManager::BuildSnapshot and WriteCommandBuffers: culling of renderer bounds, sort keys
+	// and radix sort, draw list, then chunks of both passes prepared in parallel with their keys.
+	// Recording itself needs a device, so every chunk writes its bind and draw commands to a plain array
+	// in place of vkCmd calls, which append about as much to command buffer memory.
+	// Every renderer is a draw, as pipelines of the kitchen materials are not instanced
+	void RunFrameScalingBench()
+	{
+		constexpr uint32_t RENDERER_COUNT = 100'000;
+		constexpr float KITCHEN_SPACING = 10.0f;
+		// as RenderManager
+		constexpr uint32_t CULL_MIN_CHUNK_SIZE = 256;
+		constexpr uint32_t MIN_RECORD_CHUNK_SIZE = 256;
+		constexpr uint32_t REPEAT_COUNT = 5;
+
+		const std::vector<KitchenRenderer> kitchen = ReadKitchenRenderers();
+		const auto kitchenSize = static_cast<uint32_t>(kitchen.size());
+		const auto gridSide = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<float>(RENDERER_COUNT / kitchenSize + 1))));
+		const float halfGrid = gridSide * KITCHEN_SPACING * 0.5f;
+
+		// meshes of the kitchen have their positions baked and their bounds are known only after loading,
+		// so every renderer gets a box of furniture size inside its room
+		uint32_t state = 0x9E3779B9;
+		std::vector<float> centers[3];
+		std::vector<float> extents[3];
+		std::vector<glm::mat4> models(RENDERER_COUNT);
+		for (uint32_t i = 0; i < RENDERER_COUNT; i++)
+		{
+			const uint32_t copy = i / kitchenSize;
+			const glm::vec3 offset(static_cast<float>(copy % gridSide) * KITCHEN_SPACING - halfGrid, 0,
+			                       static_cast<float>(copy / gridSide) * KITCHEN_SPACING - halfGrid);
+			const glm::vec3 center = offset + glm::vec3(Bench::NextRandom(state, -3, 3), Bench::NextRandom(state, 0, 3),
+			                                             Bench::NextRandom(state, -3, 3));
+			for (int c = 0; c < 3; c++)
+			{
+				centers[c].push_back(center[c]);
+				extents[c].push_back(Bench::NextRandom(state, 0.05f, 0.5f));
+			}
+			models[i] = glm::translate(glm::mat4(1.0f), offset);
+		}
+		const BoundsStreams streams = {
+			{centers[0].data(), centers[1].data(), centers[2].data()},
+			{extents[0].data(), extents[1].data(), extents[2].data()}
+		};
+
+		// top down view of the whole grid, every renderer is drawn
+		const glm::mat4 viewProj = glm::perspective(glm::radians(90.0f), 16.0f / 9.0f, 1.0f, 1000.0f) *
+			glm::lookAt(glm::vec3(0, halfGrid * 1.5f, 0), glm::vec3(0), glm::vec3(0, 0, 1));
+		const Frustum frustum = Frustum::FromMatrix(viewProj);
+
+		std::vector<uint32_t> cullVisible(RENDERER_COUNT);
+		std::vector<uint32_t> cullChunkCounts;
+		std::vector<uint32_t> visible;
+		std::vector<SortItem> sortItems;
+		RadixSort radixSort;
+		std::vector<FrameDraw> draws;
+		std::vector<glm::mat4> instances;
+		std::vector<uint32_t> gBufferOrder;
+		std::vector<FrameChunk> chunks;
+		std::vector<std::vector<uint32_t>> commands;
+		std::vector<uint64_t> chunkKeys;
+
+		std::cout << kitchenSize << " kitchen renderers on a " << gridSide << "x" << gridSide << " grid, "
+			<< RENDERER_COUNT << " draws, ms per frame" << std::endl
+			<< std::setw(8) << "threads"
+			<< std::setw(10) << "cull"
+			<< std::setw(10) << "sort"
+			<< std::setw(10) << "draws"
+			<< std::setw(10) << "record"
+			<< std::setw(10) << "total"
+			<< std::setw(10) << "speedup" << std::endl;
+
+		double singleThreadTime = 0;
+		uint32_t visibleCount = 0;
+		for (const uint32_t threadCount : Bench::GetThreadCounts())
+		{
+			JobSystem jobs(threadCount);
+			JoyContext::Jobs = &jobs;
+
+			const double cullTime = Bench::Measure(REPEAT_COUNT, [&]()
+			{
+				const uint32_t grain = std::max(CULL_MIN_CHUNK_SIZE, (jobs.GetGrainSize(RENDERER_COUNT) + 7) & ~7u);
+				cullChunkCounts.assign((RENDERER_COUNT + grain - 1) / grain, 0);
+				jobs.ParallelFor(RENDERER_COUNT, [&](uint32_t begin, uint32_t end)
+				{
+					cullChunkCounts[begin / grain] = CullingKernels::Cull(frustum, streams, begin, end, cullVisible.data() + begin);
+				}, grain);
+				visible.clear();
+				for (uint32_t chunk = 0; chunk < cullChunkCounts.size(); chunk++)
+				{
+					visible.insert(visible.end(), cullVisible.data() + chunk * grain,
+					               cullVisible.data() + chunk * grain + cullChunkCounts[chunk]);
+				}
+			});
+			visibleCount = static_cast<uint32_t>(visible.size());
+
+			const double sortTime = Bench::Measure(REPEAT_COUNT, [&]()
+			{
+				sortItems.resize(visibleCount * 2);
+				for (uint32_t i = 0; i < visibleCount; i++)
+				{
+					const uint32_t renderer = visible[i];
+					const KitchenRenderer& kitchenRenderer = kitchen[renderer % kitchenSize];
+					const glm::vec4 center(centers[0][renderer], centers[1][renderer], centers[2][renderer], 1.0f);
+					const glm::vec4 clip = viewProj * center;
+					const auto depth = static_cast<uint32_t>(
+						std::clamp(clip.w / 1000.0f, 0.0f, 1.0f) * static_cast<float>(DrawSortKey::DEPTH_MASK));
+					sortItems[i] = {DrawSortKey::Make(DrawSortKey::GBufferPass, 0, 0, kitchenRenderer.mesh, depth), i};
+					sortItems[visibleCount + i] = {
+						DrawSortKey::Make(DrawSortKey::MaterialPass, kitchenRenderer.pipeline, kitchenRenderer.material,
+						                  kitchenRenderer.mesh, depth),
+						i
+					};
+				}
+				radixSort.Sort(sortItems);
+			});
+
+			std::vector<uint32_t> rendererDraws(visibleCount);
+			const double drawsTime = Bench::Measure(REPEAT_COUNT, [&]()
+			{
+				draws.clear();
+				instances.clear();
+				gBufferOrder.clear();
+				for (uint32_t i = visibleCount; i < visibleCount * 2; i++)
+				{
+					const uint32_t renderer = visible[sortItems[i].value];
+					const KitchenRenderer& kitchenRenderer = kitchen[renderer % kitchenSize];
+					rendererDraws[sortItems[i].value] = static_cast<uint32_t>(draws.size());
+					instances.push_back(models[renderer]);
+					draws.push_back({
+						models[renderer], kitchenRenderer.mesh, kitchenRenderer.material, kitchenRenderer.pipeline,
+						static_cast<uint32_t>(instances.size() - 1)
+					});
+				}
+				for (uint32_t i = 0; i < visibleCount; i++)
+				{
+					gBufferOrder.push_back(rendererDraws[sortItems[i].value]);
+				}
+			});
+
+			const double recordTime = Bench::Measure(REPEAT_COUNT, [&]()
+			{
+				const auto drawCount = static_cast<uint32_t>(draws.size());
+				const uint32_t chunkSize = std::max(MIN_RECORD_CHUNK_SIZE, jobs.GetGrainSize(drawCount));
+				chunks.clear();
+				for (uint32_t begin = 0; begin < drawCount; begin += chunkSize)
+				{
+					chunks.push_back({DrawSortKey::GBufferPass, begin, std::min(begin + chunkSize, drawCount)});
+				}
+				for (uint32_t begin = 0; begin < drawCount; begin += chunkSize)
+				{
+					chunks.push_back({DrawSortKey::MaterialPass, begin, std::min(begin + chunkSize, drawCount)});
+				}
+				commands.resize(chunks.size());
+				chunkKeys.resize(chunks.size());
+				jobs.ParallelFor(static_cast<uint32_t>(chunks.size()), [&](uint32_t begin, uint32_t end)
+				{
+					for (uint32_t c = begin; c < end; c++)
+					{
+						const FrameChunk& chunk = chunks[c];
+						std::vector<uint32_t>& chunkCommands = commands[c];
+						chunkCommands.clear();
+						uint64_t key = HashValue(14695981039346656037ull, chunk.pass);
+						uint32_t boundPipeline = UINT32_MAX;
+						uint32_t boundMaterial = UINT32_MAX;
+						uint32_t boundMesh = UINT32_MAX;
+						for (uint32_t i = chunk.begin; i < chunk.end; i++)
+						{
+							const uint32_t drawIndex = chunk.pass == DrawSortKey::GBufferPass ? gBufferOrder[i] : i;
+							const FrameDraw& draw = draws[drawIndex];
+							key = HashValue(HashValue(HashValue(key, drawIndex), draw.mesh), draw.firstInstance);
+							const uint32_t pipeline = chunk.pass == DrawSortKey::GBufferPass ? 0 : draw.pipeline;
+							if (pipeline != boundPipeline)
+							{
+								chunkCommands.insert(chunkCommands.end(), {0u, pipeline});
+								boundPipeline = pipeline;
+							}
+							if (chunk.pass == DrawSortKey::MaterialPass && draw.material != boundMaterial)
+							{
+								chunkCommands.insert(chunkCommands.end(), {1u, draw.material});
+								boundMaterial = draw.material;
+							}
+							if (draw.mesh != boundMesh)
+							{
+								chunkCommands.insert(chunkCommands.end(), {2u, draw.mesh});
+								boundMesh = draw.mesh;
+							}
+							// push constant model and an indexed draw
+							chunkCommands.push_back(3u);
+							const size_t modelOffset = chunkCommands.size();
+							chunkCommands.resize(modelOffset + sizeof(glm::mat4) / sizeof(uint32_t));
+							memcpy(&chunkCommands[modelOffset], &draw.model, sizeof(glm::mat4));
+							chunkCommands.insert(chunkCommands.end(), {4u, drawIndex, draw.firstInstance});
+						}
+						chunkKeys[c] = key;
+					}
+				}, 1);
+			});
+			Bench::Consume(chunkKeys.front());
+			JoyContext::Jobs = nullptr;
+
+			const double frameTime = cullTime + sortTime + drawsTime + recordTime;
+			if (threadCount == 1)
+			{
+				singleThreadTime = frameTime;
+			}
+			std::cout << std::fixed << std::setprecision(2)
+				<< std::setw(8) << threadCount
+				<< std::setw(10) << cullTime * 1e3
+				<< std::setw(10) << sortTime * 1e3
+				<< std::setw(10) << drawsTime * 1e3
+				<< std::setw(10) << recordTime * 1e3
+				<< std::setw(10) << frameTime * 1e3
+				<< std::setw(10) << singleThreadTime / frameTime << std::endl;
+		}
+		std::cout << visibleCount << " renderers passed culling" << std::endl;
+	}
+}
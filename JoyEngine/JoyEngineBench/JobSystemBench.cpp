@@ -0,0 +1,105 @@
+#include "Bench.h"
+
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "Common/JobSystem.h"
+
+namespace JoyEngine
+{
+	// xorshift rounds, a fixed amount of work which doesn't touch memory
+	static uint32_t Work(uint32_t seed, uint32_t roundCount)
+	{
+		for (uint32_t i = 0; i < roundCount; i++)
+		{
+			seed ^= seed << 13;
+			seed ^= seed >> 17;
+			seed ^= seed << 5;
+		}
+		return seed;
+	}
+
+	// Scheduling overhead and scaling of the job system, a new system of every thread count
+	void RunJobSystemBench()
+	{
+		// below the ring of a worker, so Run never falls back to calling jobs in place
+		constexpr uint32_t BATCH_SIZE = 1024;
+		constexpr uint32_t BATCH_COUNT = 64;
+		constexpr uint32_t EMPTY_FOR_COUNT = 1024;
+		constexpr uint32_t ITEM_COUNT = 1 << 20;
+		constexpr uint32_t ITEM_ROUND_COUNT = 64;
+		constexpr uint32_t REPEAT_COUNT = 5;
+
+		const uint32_t hardwareThreadCount = std::thread::hardware_concurrency();
+		std::vector<uint32_t> results(ITEM_COUNT);
+		double singleThreadTime = 0;
+
+		std::cout << std::setw(8) << "threads"
+			<< std::setw(16) << "empty job, ns"
+			<< std::setw(20) << "empty for, us"
+			<< std::setw(16) << "for, ms"
+			<< std::setw(10) << "speedup"
+			<< std::setw(12) << "efficiency" << std::endl;
+
+		for (const uint32_t threadCount : Bench::GetThreadCounts())
+		{
+			JobSystem jobs(threadCount);
+
+			// empty jobs from worker 0, only Run, stealing and Wait are measured
+			const double emptyJobTime = Bench::Measure(REPEAT_COUNT, [&jobs]()
+			{
+				for (uint32_t batch = 0; batch < BATCH_COUNT; batch++)
+				{
+					JobCounter counter;
+					for (uint32_t i = 0; i < BATCH_SIZE; i++)
+					{
+						jobs.Run([]()
+						{
+						}, &counter);
+					}
+					jobs.Wait(counter);
+				}
+			});
+
+			// cost of a ParallelFor call with nothing to do, systems run a few of them per frame
+			const double emptyForTime = Bench::Measure(REPEAT_COUNT, [&jobs]()
+			{
+				for (uint32_t i = 0; i < EMPTY_FOR_COUNT; i++)
+				{
+					jobs.ParallelFor(jobs.GetThreadCount() * 4, [](uint32_t, uint32_t)
+					{
+					});
+				}
+			});
+
+			const double forTime = Bench::Measure(REPEAT_COUNT, [&jobs, &results]()
+			{
+				jobs.ParallelFor(ITEM_COUNT, [&results](uint32_t begin, uint32_t end)
+				{
+					for (uint32_t i = begin; i < end; i++)
+					{
+						results[i] = Work(i + 1, ITEM_ROUND_COUNT);
+					}
+				});
+			});
+			Bench::Consume(results[ITEM_COUNT / 2]);
+
+			if (threadCount == 1)
+			{
+				singleThreadTime = forTime;
+			}
+			const double speedup = singleThreadTime / forTime;
+
+			std::cout << std::fixed << std::setprecision(2)
+				<< std::setw(7) << threadCount << (threadCount > hardwareThreadCount ? "*" : " ")
+				<< std::setw(16) << emptyJobTime * 1e9 / (BATCH_COUNT * BATCH_SIZE)
+				<< std::setw(20) << emptyForTime * 1e6 / EMPTY_FOR_COUNT
+				<< std::setw(16) << forTime * 1e3
+				<< std::setw(10) << speedup
+				<< std::setw(12) << speedup / threadCount << std::endl;
+		}
+		std::cout << "* more threads than the hardware has" << std::endl;
+	}
+}
@@ -0,0 +1,244 @@
+#include "Bench.h"
+
+#include <cfloat>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "JoyContext.h"
+#include "Common/Bounds.h"
+#include "Common/JobSystem.h"
+#include "RenderManager/OcclusionBuffer.h"
+
+namespace JoyEngine
+{
+	// reference samples per buffer pixel along each axis
+	static constexpr uint32_t SAMPLES_PER_PIXEL = 4;
+	static constexpr uint32_t REFERENCE_WIDTH = OcclusionBuffer::WIDTH * SAMPLES_PER_PIXEL;
+	static constexpr uint32_t REFERENCE_HEIGHT = OcclusionBuffer::HEIGHT * SAMPLES_PER_PIXEL;
+
+	// Plain point sampled rasterization: f(sample, depth) for samples whose centers are inside the triangle.
+	// Returns false for triangles crossing the near plane, the occlusion buffer skips them too
+	template <typename F>
+	static bool ForEachSample(const glm::vec4& v0, const glm::vec4& v1, const glm::vec4& v2, F&& f)
+	{
+		const glm::vec4* clip[3] = {&v0, &v1, &v2};
+		float x[3];
+		float y[3];
+		float z[3];
+		for (int i = 0; i < 3; i++)
+		{
+			if (clip[i]->z < -clip[i]->w)
+			{
+				return false;
+			}
+			const float invW = 1.0f / clip[i]->w;
+			x[i] = (clip[i]->x * invW * 0.5f + 0.5f) * REFERENCE_WIDTH;
+			y[i] = (clip[i]->y * invW * 0.5f + 0.5f) * REFERENCE_HEIGHT;
+			z[i] = clip[i]->z * invW;
+		}
+		float area = (x[1] - x[0]) * (y[2] - y[0]) - (y[1] - y[0]) * (x[2] - x[0]);
+		if (area < 0)
+		{
+			std::swap(x[1], x[2]);
+			std::swap(y[1], y[2]);
+			std::swap(z[1], z[2]);
+			area = -area;
+		}
+		if (area == 0)
+		{
+			return true;
+		}
+
+		const int32_t minX = std::max(0, static_cast<int32_t>(std::ceil(std::min({x[0], x[1], x[2]}) - 0.5f)));
+		const int32_t maxX = std::min(static_cast<int32_t>(REFERENCE_WIDTH) - 1,
+		                              static_cast<int32_t>(std::floor(std::max({x[0], x[1], x[2]}) - 0.5f)));
+		const int32_t minY = std::max(0, static_cast<int32_t>(std::ceil(std::min({y[0], y[1], y[2]}) - 0.5f)));
+		const int32_t maxY = std::min(static_cast<int32_t>(REFERENCE_HEIGHT) - 1,
+		                              static_cast<int32_t>(std::floor(std::max({y[0], y[1], y[2]}) - 0.5f)));
+		for (int32_t sampleY = minY; sampleY <= maxY; sampleY++)
+		{
+			for (int32_t sampleX = minX; sampleX <= maxX; sampleX++)
+			{
+				const float px = static_cast<float>(sampleX) + 0.5f;
+				const float py = static_cast<float>(sampleY) + 0.5f;
+				float edge[3];
+				for (int i = 0; i < 3; i++)
+				{
+					const int j = (i + 1) % 3;
+					edge[i] = (y[i] - y[j]) * (px - x[i]) + (x[j] - x[i]) * (py - y[i]);
+				}
+				if (edge[0] < 0 || edge[1] < 0 || edge[2] < 0)
+				{
+					continue;
+				}
+				// edge i is opposite to vertex (i + 2) % 3
+				const float depth = (edge[1] * z[0] + edge[2] * z[1] + edge[0] * z[2]) / area;
+				f(sampleY * REFERENCE_WIDTH + sampleX, depth);
+			}
+		}
+		return true;
+	}
+
+	// Culling results of the occlusion buffer against a point sampled depth buffer of the same occluders
+	// at 16 samples per pixel, and timing of its stages. A box is visible in the reference if a sample of
+	// one of its faces is not behind the occluders. The buffer is conservative, so it must never cull such a box,
+	// boxes hidden in the reference and still reported visible are the price of conservative rasterization
+	void RunOcclusionBufferBench()
+	{
+		constexpr uint32_t VIEW_COUNT = 16;
+		constexpr uint32_t BUILDING_COUNT = 64;
+		constexpr uint32_t BOX_COUNT = 8192;
+		constexpr float AREA_HALF_SIDE = 150.0f;
+
+		// corner i of the unit cube is chosen by bits of i the same way IsVisible does
+		std::vector<glm::vec3> cubeVertices;
+		for (int i = 0; i < 8; i++)
+		{
+			cubeVertices.emplace_back((i & 1) ? 0.5f : -0.5f, (i & 2) ? 0.5f : -0.5f, (i & 4) ? 0.5f : -0.5f);
+		}
+		const std::vector<uint32_t> cubeIndices = {
+			0, 2, 6, 0, 6, 4,
+			1, 5, 7, 1, 7, 3,
+			0, 4, 5, 0, 5, 1,
+			2, 3, 7, 2, 7, 6,
+			0, 1, 3, 0, 3, 2,
+			4, 6, 7, 4, 7, 5,
+		};
+
+		JobSystem jobs;
+		JoyContext::Jobs = &jobs;
+
+		OcclusionBuffer buffer;
+		std::vector<float> referenceDepth(REFERENCE_WIDTH * REFERENCE_HEIGHT);
+		std::vector<glm::mat4> buildings(BUILDING_COUNT);
+		std::vector<AABB> boxes(BOX_COUNT);
+		std::vector<bool> isVisible(BOX_COUNT);
+
+		double addTime = 0;
+		double rasterizeTime = 0;
+		double testTime = 0;
+		uint32_t testedCount = 0;
+		uint32_t hiddenCount = 0;
+		uint32_t culledCount = 0;
+		uint32_t errorCount = 0;
+
+		uint32_t state = 0x9E3779B9;
+		for (uint32_t view = 0; view < VIEW_COUNT; view++)
+		{
+			const float angle = Bench::NextRandom(state, 0, 6.2831853f);
+			const glm::vec3 eye(Bench::NextRandom(state, -50, 50), 2, Bench::NextRandom(state, -50, 50));
+			const glm::mat4 viewProj =
+				glm::perspective(glm::radians(60.0f), static_cast<float>(OcclusionBuffer::WIDTH) / OcclusionBuffer::HEIGHT,
+				                 0.1f, 300.0f) *
+				glm::lookAt(eye, eye + glm::vec3(std::cos(angle), 0, std::sin(angle)), glm::vec3(0, 1, 0));
+
+			for (glm::mat4& building : buildings)
+			{
+				const glm::vec3 size(Bench::NextRandom(state, 4, 20), Bench::NextRandom(state, 5, 40), Bench::NextRandom(state, 4, 20));
+				const glm::vec3 center(Bench::NextRandom(state, -AREA_HALF_SIDE, AREA_HALF_SIDE), size.y * 0.5f,
+				                       Bench::NextRandom(state, -AREA_HALF_SIDE, AREA_HALF_SIDE));
+				building = glm::scale(glm::translate(glm::mat4(1.0f), center), size);
+			}
+			for (AABB& box : boxes)
+			{
+				const glm::vec3 extents(Bench::NextRandom(state, 0.5f, 3), Bench::NextRandom(state, 0.5f, 3),
+				                        Bench::NextRandom(state, 0.5f, 3));
+				const glm::vec3 center(Bench::NextRandom(state, -AREA_HALF_SIDE, AREA_HALF_SIDE), extents.y,
+				                       Bench::NextRandom(state, -AREA_HALF_SIDE, AREA_HALF_SIDE));
+				box = AABB(center - extents, center + extents);
+			}
+
+			addTime += Bench::Measure(1, [&buffer, &buildings, &cubeVertices, &cubeIndices, &viewProj]()
+			{
+				buffer.Begin(viewProj);
+				for (const glm::mat4& building : buildings)
+				{
+					buffer.AddOccluder(building, cubeVertices, cubeIndices);
+				}
+			});
+			rasterizeTime += Bench::Measure(1, [&buffer]()
+			{
+				buffer.Rasterize();
+			});
+			testTime += Bench::Measure(1, [&buffer, &boxes, &isVisible]()
+			{
+				for (uint32_t i = 0; i < BOX_COUNT; i++)
+				{
+					isVisible[i] = buffer.IsVisible(boxes[i]);
+				}
+			});
+
+			std::fill(referenceDepth.begin(), referenceDepth.end(), FLT_MAX);
+			for (const glm::mat4& building : buildings)
+			{
+				const glm::mat4 modelViewProj = viewProj * building;
+				for (size_t i = 0; i < cubeIndices.size(); i += 3)
+				{
+					ForEachSample(modelViewProj * glm::vec4(cubeVertices[cubeIndices[i]], 1.0f),
+					              modelViewProj * glm::vec4(cubeVertices[cubeIndices[i + 1]], 1.0f),
+					              modelViewProj * glm::vec4(cubeVertices[cubeIndices[i + 2]], 1.0f),
+					              [&referenceDepth](uint32_t sample, float depth)
+					              {
+						              referenceDepth[sample] = std::min(referenceDepth[sample], depth);
+					              });
+				}
+			}
+
+			for (uint32_t box = 0; box < BOX_COUNT; box++)
+			{
+				glm::vec4 corners[8];
+				for (int i = 0; i < 8; i++)
+				{
+					corners[i] = viewProj * glm::vec4(boxes[box].GetCenter() + cubeVertices[i] * boxes[box].GetExtents() * 2.0f, 1.0f);
+				}
+				bool isInFront = true;
+				bool isCovering = false;
+				bool isReferenceVisible = false;
+				for (size_t i = 0; i < cubeIndices.size() && isInFront; i += 3)
+				{
+					isInFront = ForEachSample(corners[cubeIndices[i]], corners[cubeIndices[i + 1]], corners[cubeIndices[i + 2]],
+					                          [&referenceDepth, &isCovering, &isReferenceVisible](uint32_t sample, float depth)
+					                          {
+						                          isCovering = true;
+						                          isReferenceVisible |= depth <= referenceDepth[sample];
+					                          });
+				}
+				// boxes off the screen or crossing the near plane are visible without a test
+				if (!isInFront || !isCovering)
+				{
+					continue;
+				}
+				testedCount++;
+				hiddenCount += !isReferenceVisible;
+				if (!isVisible[box])
+				{
+					if (isReferenceVisible)
+					{
+						errorCount++;
+					}
+					else
+					{
+						culledCount++;
+					}
+				}
+			}
+		}
+		JoyContext::Jobs = nullptr;
+
+		std::cout << std::fixed << std::setprecision(2)
+			<< VIEW_COUNT << " views of " << BUILDING_COUNT << " buildings, " << buffer.GetTriangleCount()
+			<< " occluder triangles in the last one" << std::endl
+			<< "  add occluders " << addTime * 1e3 / VIEW_COUNT << " ms, rasterize " << rasterizeTime * 1e3 / VIEW_COUNT
+			<< " ms, test " << testTime * 1e9 / (VIEW_COUNT * BOX_COUNT) << " ns per box" << std::endl
+			<< "  " << testedCount << " boxes on the screen, " << hiddenCount << " hidden in the reference, "
+			<< culledCount << " of them culled (" << (hiddenCount != 0 ? 100.0 * culledCount / hiddenCount : 0.0) << "%)"
+			<< std::endl
+			<< "  " << errorCount << " visible boxes culled" << (errorCount != 0 ? ", the buffer is not conservative" : "")
+			<< std::endl;
+	}
+}
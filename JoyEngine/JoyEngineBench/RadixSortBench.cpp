@@ -0,0 +1,127 @@
+#include "Bench.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include "JoyContext.h"
+#include "Common/JobSystem.h"
+#include "Common/RadixSort.h"
+#include "RenderManager/DrawSortKey.h"
+
+namespace JoyEngine
+{
+	static bool IsKeyLess(const SortItem& a, const SortItem& b)
+	{
+		return a.key < b.key;
+	}
+
+	static void FillRandomKeys(std::vector<SortItem>& items, uint32_t& state)
+	{
+		for (uint32_t i = 0; i < items.size(); i++)
+		{
+			const uint64_t high = Bench::NextRandom(state);
+			items[i] = {high << 32 | Bench::NextRandom(state), i};
+		}
+	}
+
+	// keys as the renderer makes them, most of the bytes are the same in every key
+	static void FillDrawKeys(std::vector<SortItem>& items, uint32_t& state)
+	{
+		for (uint32_t i = 0; i < items.size(); i++)
+		{
+			const uint32_t pass = Bench::NextRandom(state) % 2;
+			items[i] = {
+				DrawSortKey::Make(pass, pass * (Bench::NextRandom(state) % 16), Bench::NextRandom(state) % 256,
+				                  Bench::NextRandom(state) % 128, Bench::NextRandom(state)),
+				i
+			};
+		}
+	}
+
+	// Throughput of RadixSort on one worker and on every hardware thread against std::sort and std::stable_sort.
+	// Radix sort is stable, so std::stable_sort gives the same order. Every time includes copying the input
+	void RunRadixSortBench()
+	{
+		constexpr uint32_t REPEAT_COUNT = 5;
+
+		struct Distribution
+		{
+			const char* name;
+			void (*fill)(std::vector<SortItem>&, uint32_t&);
+		};
+		const Distribution distributions[] = {
+			{"random keys", &FillRandomKeys},
+			{"draw keys", &FillDrawKeys},
+		};
+
+		RadixSort radixSort;
+
+		for (const Distribution& distribution : distributions)
+		{
+			std::cout << distribution.name << ", million items per second" << std::endl
+				<< std::setw(10) << "items"
+				<< std::setw(12) << "std::sort"
+				<< std::setw(14) << "stable_sort"
+				<< std::setw(14) << "radix, 1"
+				<< std::setw(14) << "radix, all" << std::endl;
+
+			for (const uint32_t count : {1024u, 4096u, 16384u, 65536u, 262144u, 1048576u})
+			{
+				uint32_t state = 0x9E3779B9;
+				std::vector<SortItem> source(count);
+				distribution.fill(source, state);
+				std::vector<SortItem> items;
+
+				const double sortTime = Bench::Measure(REPEAT_COUNT, [&source, &items]()
+				{
+					items = source;
+					std::sort(items.begin(), items.end(), &IsKeyLess);
+				});
+				const double stableSortTime = Bench::Measure(REPEAT_COUNT, [&source, &items]()
+				{
+					items = source;
+					std::stable_sort(items.begin(), items.end(), &IsKeyLess);
+				});
+				const std::vector<SortItem> expected = items;
+
+				// job systems live one after another, each makes the calling thread its worker 0
+				double radixTime;
+				{
+					JobSystem jobs(1);
+					JoyContext::Jobs = &jobs;
+					radixTime = Bench::Measure(REPEAT_COUNT, [&source, &items, &radixSort]()
+					{
+						items = source;
+						radixSort.Sort(items);
+					});
+				}
+				double parallelRadixTime;
+				{
+					JobSystem jobs;
+					JoyContext::Jobs = &jobs;
+					parallelRadixTime = Bench::Measure(REPEAT_COUNT, [&source, &items, &radixSort]()
+					{
+						items = source;
+						radixSort.Sort(items);
+					});
+				}
+				JoyContext::Jobs = nullptr;
+
+				const bool isSame = std::equal(items.begin(), items.end(), expected.begin(), [](const SortItem& a, const SortItem& b)
+				{
+					return a.key == b.key && a.value == b.value;
+				});
+
+				std::cout << std::fixed << std::setprecision(1)
+					<< std::setw(10) << count
+					<< std::setw(12) << count / sortTime * 1e-6
+					<< std::setw(14) << count / stableSortTime * 1e-6
+					<< std::setw(14) << count / radixTime * 1e-6
+					<< std::setw(14) << count / parallelRadixTime * 1e-6
+					<< (isSame ? "" : "  order differs from std::stable_sort") << std::endl;
+			}
+		}
+	}
+}
@@ -0,0 +1,126 @@
+#include "Bench.h"
+
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include <rapidjson/document.h>
+
+#include "Common/HashDefs.h"
+#include "Common/Serialization.h"
+#include "Components/ComponentStorage.h"
+#include "GameplayComponents/CameraBehaviour.h"
+#include "GameplayComponents/RoomBehaviour.h"
+
+namespace JoyEngine
+{
+	// true if every reflected field of a and b holds the same bytes
+	static bool HasSameFields(Component* a, Component* b)
+	{
+		if (a->GetClassHash() != b->GetClassHash()) return false;
+		uint32_t fieldCount = 0;
+		const FieldInfo* fields = SerializableClassFactory::GetInstance()->GetFields(a->GetClassHash(), fieldCount);
+		for (uint32_t i = 0; i < fieldCount; i++)
+		{
+			if (memcmp(fields[i].GetPtr(a->GetFieldsBase()), fields[i].GetPtr(b->GetFieldsBase()), fields[i].size) != 0)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// Deserialization of 100k gameplay components, half CameraBehaviour and half RoomBehaviour,
+	// from json values as DOM scenes give them and from flattened fields as SceneJsonReader and cooked scenes give them.
+	// Creation without fields is the floor both paths are compared to. Destruction is not timed
+	void RunReflectionBench()
+	{
+		constexpr uint32_t REPEAT_COUNT = 5;
+		constexpr uint32_t COMPONENT_COUNT = 100000;
+
+		const std::string cameraClassName = "CameraBehaviour";
+		const std::string roomClassName = "RoomBehaviour";
+
+		rapidjson::Document cameraJson;
+		cameraJson.Parse(R"({"m_speed": 2.0})");
+		rapidjson::Document roomJson;
+		roomJson.Parse(R"({"m_speed": 0.05, "m_color": [0.4, 0.5, 0.8, 1.0]})");
+
+		const double cameraSpeed[] = {2.0};
+		const double roomSpeed[] = {0.05};
+		const double roomColor[] = {0.4, 0.5, 0.8, 1.0};
+		const SerializedFieldData cameraFields[] = {
+			{strHash("m_speed"), cameraSpeed, 1},
+		};
+		const SerializedFieldData roomFields[] = {
+			{strHash("m_speed"), roomSpeed, 1},
+			{strHash("m_color"), roomColor, 4},
+		};
+
+		ComponentStorage* storage = ComponentStorage::GetInstance();
+		std::vector<ComponentPtr<>> components;
+		components.reserve(COMPONENT_COUNT);
+
+		const auto measure = [&components](const auto& create)
+		{
+			double best = std::numeric_limits<double>::max();
+			for (uint32_t i = 0; i < REPEAT_COUNT; i++)
+			{
+				components.clear();
+				best = std::min(best, Bench::Measure(1, [&components, &create]()
+				{
+					for (uint32_t j = 0; j < COMPONENT_COUNT; j++)
+					{
+						components.push_back(create(j % 2 == 0));
+					}
+				}));
+			}
+			return best;
+		};
+
+		const double createTime = measure([storage](bool isCamera) -> ComponentPtr<>
+		{
+			if (isCamera)
+			{
+				return storage->Create<CameraBehaviour>();
+			}
+			return storage->Create<RoomBehaviour>();
+		});
+		const double jsonTime = measure([&](bool isCamera)
+		{
+			return isCamera
+				       ? SerializableClassFactory::GetInstance()->Deserialize(cameraJson, cameraClassName)
+				       : SerializableClassFactory::GetInstance()->Deserialize(roomJson, roomClassName);
+		});
+		std::vector<ComponentPtr<>> jsonComponents = std::move(components);
+		components = std::vector<ComponentPtr<>>();
+		components.reserve(COMPONENT_COUNT);
+		const double fieldsTime = measure([&](bool isCamera)
+		{
+			return isCamera
+				       ? SerializableClassFactory::GetInstance()->Deserialize(cameraFields, 1, cameraClassName)
+				       : SerializableClassFactory::GetInstance()->Deserialize(roomFields, 2, roomClassName);
+		});
+
+		bool isSame = true;
+		for (uint32_t i = 0; i < COMPONENT_COUNT; i++)
+		{
+			isSame &= HasSameFields(jsonComponents[i].get(), components[i].get());
+		}
+		jsonComponents.clear();
+		components.clear();
+
+		std::cout << COMPONENT_COUNT << " components, million components per second" << std::endl
+			<< std::setw(12) << "create"
+			<< std::setw(12) << "json"
+			<< std::setw(12) << "fields" << std::endl
+			<< std::fixed << std::setprecision(2)
+			<< std::setw(12) << COMPONENT_COUNT / createTime * 1e-6
+			<< std::setw(12) << COMPONENT_COUNT / jsonTime * 1e-6
+			<< std::setw(12) << COMPONENT_COUNT / fieldsTime * 1e-6
+			<< (isSame ? "" : "  json and fields give different components") << std::endl;
+	}
+}
@@ -0,0 +1,169 @@
+#include "Bench.h"
+
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include <windows.h>
+#include <psapi.h>
+
+#include <rapidjson/document.h>
+#include <rapidjson/reader.h>
+
+#include "DataManager/DataManager.h"
+#include "Utils/GUID.h"
+
+namespace JoyEngine
+{
+	namespace
+	{
+		// Counts tokens and keeps nothing, so only the parser is measured
+		class CountingHandler : public rapidjson::BaseReaderHandler<rapidjson::UTF8<>, CountingHandler>
+		{
+		public:
+			bool Default()
+			{
+				m_tokenCount++;
+				return true;
+			}
+
+			bool Key(const char* str, rapidjson::SizeType length, bool copy)
+			{
+				return Default();
+			}
+
+			[[nodiscard]] uint64_t GetTokenCount() const noexcept { return m_tokenCount; }
+
+		private:
+			uint64_t m_tokenCount = 0;
+		};
+	}
+
+	// Pages are evicted from the working set and come back as soon as they are touched,
+	// so working set right after a parse is what the parse touched, the file it reads included
+	static void TrimWorkingSet()
+	{
+		SetProcessWorkingSetSize(GetCurrentProcess(), static_cast<SIZE_T>(-1), static_cast<SIZE_T>(-1));
+	}
+
+	static size_t GetWorkingSet()
+	{
+		PROCESS_MEMORY_COUNTERS counters = {};
+		GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+		return counters.WorkingSetSize;
+	}
+
+	// Kitchen scene with its objects repeated copyCount times
+	static std::vector<char> MakeScene(const std::vector<char>& kitchen, uint32_t copyCount)
+	{
+		const std::string json(kitchen.begin(), kitchen.end());
+		const size_t objectsBegin = json.find('[', json.find("\"objects\"")) + 1;
+		const size_t objectsEnd = json.rfind(']');
+		const std::string objects = json.substr(objectsBegin, objectsEnd - objectsBegin);
+
+		std::vector<char> scene;
+		scene.reserve(objectsBegin + (objects.size() + 2) * copyCount + json.size() - objectsEnd + 1);
+		scene.insert(scene.end(), json.begin(), json.begin() + objectsBegin);
+		for (uint32_t i = 0; i < copyCount; i++)
+		{
+			if (i != 0)
+			{
+				scene.push_back(',');
+				scene.push_back(' ');
+			}
+			scene.insert(scene.end(), objects.begin(), objects.end());
+		}
+		scene.insert(scene.end(), json.begin() + objectsEnd, json.end());
+		scene.push_back('\0');
+		return scene;
+	}
+
+	static uint64_t ParseSax(char* data)
+	{
+		CountingHandler handler;
+		rapidjson::Reader reader;
+		rapidjson::InsituStringStream stream(data);
+		const rapidjson::ParseResult result = reader.Parse<rapidjson::kParseInsituFlag>(stream, handler);
+		return result.IsError() ? 0 : handler.GetTokenCount();
+	}
+
+	// object count, 0 on error
+	static rapidjson::SizeType ParseDom(rapidjson::Document& json, const char* data)
+	{
+		json.Parse<rapidjson::kParseStopWhenDoneFlag>(data);
+		return json.HasParseError() ? 0 : json["objects"].Size();
+	}
+
+	// Parse time and peak working set of the kitchen scene repeated up to 100k objects,
+	// read in situ with a SAX handler as SceneJsonReader does, and into a DOM as DataManager::GetSerializedData does.
+	// Objects and components are not created: SceneJsonReader makes mesh renderers which need the render manager,
+	// and the DOM path created the same objects while walking the document.
+	// Working set is measured on a separate run from a trimmed process, with the DOM still alive
+	void RunSceneJsonBench()
+	{
+		constexpr uint32_t REPEAT_COUNT = 5;
+		constexpr uint32_t KITCHEN_OBJECT_COUNT = 296;
+		constexpr double MEGABYTE = 1024.0 * 1024.0;
+
+		DataManager dataManager;
+		const std::vector<char> kitchen = dataManager.GetData(GUID::StringToGuid("11dcfeba-c2b6-4c2e-a3c7-51054ff06f1d"));
+
+		std::cout << "parse time in ms, peak working set of the parse in MB" << std::endl
+			<< std::setw(10) << "objects"
+			<< std::setw(10) << "file MB"
+			<< std::setw(10) << "sax ms"
+			<< std::setw(10) << "dom ms"
+			<< std::setw(10) << "sax MB"
+			<< std::setw(10) << "dom MB" << std::endl;
+
+		for (const uint32_t copyCount : {1u, 8u, 64u, 338u})
+		{
+			const std::vector<char> scene = MakeScene(kitchen, copyCount);
+			// in situ parsing writes into the buffer, so every run gets a fresh copy made before the clock starts
+			std::vector<char> buffer(scene.size());
+
+			memcpy(buffer.data(), scene.data(), scene.size());
+			TrimWorkingSet();
+			size_t workingSet = GetWorkingSet();
+			const uint64_t saxTokenCount = ParseSax(buffer.data());
+			const size_t saxWorkingSet = GetWorkingSet() - workingSet;
+
+			rapidjson::SizeType domObjectCount;
+			size_t domWorkingSet;
+			{
+				rapidjson::Document json;
+				TrimWorkingSet();
+				workingSet = GetWorkingSet();
+				domObjectCount = ParseDom(json, scene.data());
+				domWorkingSet = GetWorkingSet() - workingSet;
+			}
+
+			double saxTime = std::numeric_limits<double>::max();
+			for (uint32_t i = 0; i < REPEAT_COUNT; i++)
+			{
+				memcpy(buffer.data(), scene.data(), scene.size());
+				saxTime = std::min(saxTime, Bench::Measure(1, [&buffer]()
+				{
+					Bench::Consume(ParseSax(buffer.data()));
+				}));
+			}
+			const double domTime = Bench::Measure(REPEAT_COUNT, [&scene]()
+			{
+				rapidjson::Document json;
+				Bench::Consume(ParseDom(json, scene.data()));
+			});
+
+			std::cout << std::fixed << std::setprecision(2)
+				<< std::setw(10) << copyCount * KITCHEN_OBJECT_COUNT
+				<< std::setw(10) << scene.size() / MEGABYTE
+				<< std::setw(10) << saxTime * 1e3
+				<< std::setw(10) << domTime * 1e3
+				<< std::setw(10) << saxWorkingSet / MEGABYTE
+				<< std::setw(10) << domWorkingSet / MEGABYTE
+				<< (saxTokenCount != 0 && domObjectCount == copyCount * KITCHEN_OBJECT_COUNT ? "" : "  parse error") << std::endl;
+		}
+	}
+}
@@ -0,0 +1,145 @@
+#include "Bench.h"
+
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <glm/gtx/quaternion.hpp>
+
+#include "SceneManager/TransformKernels.h"
+#include "Utils/CpuFeatures.h"
+
+namespace JoyEngine
+{
+	// Matrices per second of every compose kernel the CPU supports, against the three glm::mat4 products
+	// Transform used to make per setter call. Sizes go from L1 resident streams to ones bound by memory
+	void RunTransformKernelsBench()
+	{
+		constexpr uint32_t REPEAT_COUNT = 5;
+		// matrices composed per measured run, small batches are repeated to take about the same time
+		constexpr uint32_t MATRICES_PER_RUN = 1 << 22;
+
+		struct Kernel
+		{
+			const char* name;
+			TransformKernels::ComposeFunc compose;
+			bool isSupported;
+		};
+		const Kernel kernels[] = {
+			{"scalar", &TransformKernels::ComposeScalar, true},
+			{"sse", &TransformKernels::ComposeSse, IsSse2Supported()},
+			{"avx", &TransformKernels::ComposeAvx, IsAvxSupported()},
+		};
+
+		std::cout << "Selected kernel: " << TransformKernels::GetComposeName() << ", million matrices per second" << std::endl
+			<< std::setw(10) << "count" << std::setw(10) << "glm";
+		for (const Kernel& kernel : kernels)
+		{
+			std::cout << std::setw(10) << kernel.name;
+		}
+		std::cout << std::endl;
+
+		for (const uint32_t count : {1024u, 16384u, 262144u, 1048576u})
+		{
+			uint32_t state = 0x9E3779B9;
+			std::vector<float> position[3];
+			std::vector<float> rotation[4];
+			std::vector<float> scale[3];
+			std::vector<float> matrices[12];
+			std::vector<float> expected[12];
+			for (auto& stream : position) stream.resize(count);
+			for (auto& stream : rotation) stream.resize(count);
+			for (auto& stream : scale) stream.resize(count);
+			for (auto& stream : matrices) stream.resize(count);
+			for (auto& stream : expected) stream.resize(count);
+
+			for (uint32_t i = 0; i < count; i++)
+			{
+				glm::vec4 q(Bench::NextRandom(state, -1, 1), Bench::NextRandom(state, -1, 1),
+				            Bench::NextRandom(state, -1, 1), Bench::NextRandom(state, -1, 1));
+				q = glm::length(q) > 0.01f ? glm::normalize(q) : glm::vec4(0, 0, 0, 1);
+				for (int c = 0; c < 3; c++)
+				{
+					position[c][i] = Bench::NextRandom(state, -100, 100);
+					scale[c][i] = Bench::NextRandom(state, 0.5f, 2);
+				}
+				for (int c = 0; c < 4; c++)
+				{
+					rotation[c][i] = q[c];
+				}
+			}
+
+			TransformStreams in;
+			AffineStreams out;
+			AffineStreams reference;
+			for (int c = 0; c < 3; c++)
+			{
+				in.position[c] = position[c].data();
+				in.scale[c] = scale[c].data();
+			}
+			for (int c = 0; c < 4; c++)
+			{
+				in.rotation[c] = rotation[c].data();
+			}
+			for (int c = 0; c < 12; c++)
+			{
+				out.m[c] = matrices[c].data();
+				reference.m[c] = expected[c].data();
+			}
+			TransformKernels::ComposeScalar(in, reference, count);
+
+			const uint32_t runCount = std::max(1u, MATRICES_PER_RUN / count);
+			const double matrixCount = static_cast<double>(runCount) * count;
+
+			std::vector<glm::mat4> glmMatrices(count);
+			const double glmTime = Bench::Measure(REPEAT_COUNT, [&]()
+			{
+				for (uint32_t run = 0; run < runCount; run++)
+				{
+					for (uint32_t i = 0; i < count; i++)
+					{
+						const glm::vec3 p(position[0][i], position[1][i], position[2][i]);
+						const glm::quat r(rotation[3][i], rotation[0][i], rotation[1][i], rotation[2][i]);
+						const glm::vec3 s(scale[0][i], scale[1][i], scale[2][i]);
+						glmMatrices[i] = glm::translate(glm::mat4(1.0f), p) * glm::toMat4(r) * glm::scale(glm::mat4(1.0f), s);
+					}
+				}
+			});
+			Bench::Consume(glmMatrices[count / 2][3][0]);
+
+			std::cout << std::fixed << std::setprecision(1)
+				<< std::setw(10) << count << std::setw(10) << matrixCount / glmTime * 1e-6;
+			for (const Kernel& kernel : kernels)
+			{
+				if (!kernel.isSupported)
+				{
+					std::cout << std::setw(10) << "-";
+					continue;
+				}
+				const double time = Bench::Measure(REPEAT_COUNT, [&kernel, &in, &out, count, runCount]()
+				{
+					for (uint32_t run = 0; run < runCount; run++)
+					{
+						kernel.compose(in, out, count);
+					}
+				});
+
+				float maxError = 0;
+				for (int c = 0; c < 12; c++)
+				{
+					for (uint32_t i = 0; i < count; i++)
+					{
+						maxError = std::max(maxError, std::abs(matrices[c][i] - expected[c][i]));
+					}
+				}
+				std::cout << std::setw(10) << matrixCount / time * 1e-6 << (maxError > 1e-4f ? "!" : "");
+			}
+			std::cout << std::endl;
+		}
+		std::cout << "! differs from the scalar kernel" << std::endl;
+	}
+}
@@ -0,0 +1,71 @@
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <iostream>
+#include <thread>
+
+#include "Bench.h"
+
+namespace JoyEngine
+{
+	volatile uint64_t Bench::m_sink = 0;
+}
+
+struct BenchEntry
+{
+	const char* name;
+	void (*run)();
+};
+
+static const BenchEntry g_benches[] = {
+	{"jobs", &JoyEngine::RunJobSystemBench},
+	{"bvh", &JoyEngine::RunBoundingVolumeHierarchyBench},
+	{"sort", &JoyEngine::RunRadixSortBench},
+	{"transforms", &JoyEngine::RunTransformKernelsBench},
+	{"occlusion", &JoyEngine::RunOcclusionBufferBench},
+	{"frame", &JoyEngine::RunFrameScalingBench},
+	{"reflection", &JoyEngine::RunReflectionBench},
+	{"scenejson", &JoyEngine::RunSceneJsonBench},
+};
+
+// Runs benches given by name, all of them without arguments
+int main(int argc, char** argv)
+{
+#ifdef DEBUG
+	std::cout << "Debug build, numbers are not representative" << std::endl;
+#endif
+	for (int i = 1; i < argc; i++)
+	{
+		const bool isKnown = std::any_of(std::begin(g_benches), std::end(g_benches), [name = argv[i]](const BenchEntry& bench)
+		{
+			return strcmp(name, bench.name) == 0;
+		});
+		if (!isKnown)
+		{
+			std::cerr << "Unknown bench " << argv[i] << ", available:";
+			for (const BenchEntry& bench : g_benches)
+			{
+				std::cerr << " " << bench.name;
+			}
+			std::cerr << std::endl;
+			return 1;
+		}
+	}
+
+	std::cout << "Hardware threads: " << std::thread::hardware_concurrency() << std::endl;
+
+	for (const BenchEntry& bench : g_benches)
+	{
+		bool isSelected = argc == 1;
+		for (int i = 1; i < argc; i++)
+		{
+			isSelected |= strcmp(argv[i], bench.name) == 0;
+		}
+		if (isSelected)
+		{
+			std::cout << std::endl << "[" << bench.name << "]" << std::endl;
+			bench.run();
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,536 @@
+#include "SelfChecks.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include "JoyContext.h"
+#include "Common/Bounds.h"
+#include "Common/JobSystem.h"
+#include "Common/RadixSort.h"
+#include "RenderManager/CullingKernels.h"
+#include "SceneManager/BoundingVolumeHierarchy.h"
+#include "SceneManager/SceneSnapshot.h"
+#include "Utils/CpuFeatures.h"
+
+// active in every configuration, a failed check is printed and the rest still run
+#define CHECK(expr) if (expr) {} else { std::cerr << #expr << " " << __FILE__ << ":" << __LINE__ << std::endl; m_failureCount++; }
+
+namespace JoyEngine
+{
+	std::atomic<uint32_t> SelfChecks::m_failureCount = 0;
+
+	// xorshift, the same sequence on every run
+	static uint32_t NextRandom(uint32_t& state)
+	{
+		state ^= state << 13;
+		state ^= state >> 17;
+		state ^= state << 5;
+		return state;
+	}
+
+	static float NextRandom(uint32_t& state, float min, float max)
+	{
+		return min + (max - min) * static_cast<float>(NextRandom(state) >> 8) / static_cast<float>(1 << 24);
+	}
+
+	static AABB RandomBox(uint32_t& state)
+	{
+		const glm::vec3 center(NextRandom(state, -100, 100), NextRandom(state, -20, 20), NextRandom(state, -100, 100));
+		const glm::vec3 extents(NextRandom(state, 0.1f, 4), NextRandom(state, 0.1f, 4), NextRandom(state, 0.1f, 4));
+		return AABB(center - extents, center + extents);
+	}
+
+	// planes face a random point inside, so the volume is convex and not empty
+	static Frustum RandomFrustum(uint32_t& state)
+	{
+		const glm::vec3 inside(NextRandom(state, -50, 50), 0, NextRandom(state, -50, 50));
+		Frustum frustum;
+		for (auto& plane : frustum.planes)
+		{
+			glm::vec3 normal;
+			do
+			{
+				normal = glm::vec3(NextRandom(state, -1, 1), NextRandom(state, -1, 1), NextRandom(state, -1, 1));
+			}
+			while (glm::dot(normal, normal) < 0.01f);
+			normal = glm::normalize(normal);
+			plane = glm::vec4(normal, NextRandom(state, 10, 80) - glm::dot(normal, inside));
+		}
+		return frustum;
+	}
+
+	uint32_t SelfChecks::Run()
+	{
+		m_failureCount = 0;
+		CheckSnapshotDelta();
+		CheckJobSystem();
+		CheckBoundingVolumeHierarchy();
+		CheckCullingKernels();
+		CheckRadixSort();
+		return m_failureCount;
+	}
+
+	void SelfChecks::CheckSnapshotDelta()
+	{
+		constexpr uint32_t DATA_WORDS = 1024;
+
+		SceneSnapshot::Header header = {};
+		header.magic = SceneSnapshot::SNAPSHOT_MAGIC;
+		header.version = SceneSnapshot::VERSION;
+		header.layoutHash = 0x0123456789abcdefull;
+		header.dataSize = DATA_WORDS * sizeof(uint32_t);
+
+		uint32_t state = 0x9e3779b9;
+		std::vector<uint32_t> words(DATA_WORDS);
+		for (uint32_t& word : words)
+		{
+			word = NextRandom(state);
+		}
+
+		auto makeSnapshot = [&header](const std::vector<uint32_t>& data)
+		{
+			std::vector<char> snapshot(sizeof(header) + data.size() * sizeof(uint32_t));
+			memcpy(snapshot.data(), &header, sizeof(header));
+			memcpy(snapshot.data() + sizeof(header), data.data(), data.size() * sizeof(uint32_t));
+			return snapshot;
+		};
+		const std::vector<char> baseline = makeSnapshot(words);
+
+		std::vector<char> delta;
+		std::vector<char> restored;
+
+		// no changes, no runs
+		SceneSnapshot::CaptureDelta(baseline, baseline, delta);
+		CHECK(delta.size() == sizeof(SceneSnapshot::DeltaHeader));
+		CHECK(SceneSnapshot::ApplyDelta(baseline, delta, restored) && restored == baseline);
+
+		// first and last words, a single word, adjacent and random runs
+		words.front()++;
+		words.back()++;
+		words[100]++;
+		for (uint32_t i = 200; i < 260; i++)
+		{
+			words[i] = ~words[i];
+		}
+		for (uint32_t i = 0; i < 64; i++)
+		{
+			words[NextRandom(state) % DATA_WORDS] = NextRandom(state);
+		}
+		const std::vector<char> current = makeSnapshot(words);
+
+		SceneSnapshot::CaptureDelta(baseline, current, delta);
+		CHECK(delta.size() < current.size());
+		CHECK(SceneSnapshot::ApplyDelta(baseline, delta, restored) && restored == current);
+
+		SceneSnapshot::DeltaHeader deltaHeader;
+		memcpy(&deltaHeader, delta.data(), sizeof(deltaHeader));
+		CHECK(deltaHeader.runCount > 1);
+		SceneSnapshot::DeltaRun firstRun;
+		char* firstRunPtr = delta.data() + sizeof(deltaHeader);
+		memcpy(&firstRun, firstRunPtr, sizeof(firstRun));
+
+		// run words don't add up to the stored words
+		std::vector<char> broken = delta;
+		SceneSnapshot::DeltaRun run = {firstRun.firstWord, firstRun.wordCount + 1};
+		memcpy(broken.data() + sizeof(deltaHeader), &run, sizeof(run));
+		CHECK(!SceneSnapshot::ApplyDelta(baseline, broken, restored));
+
+		// run past the end of snapshot
+		broken = delta;
+		run = {static_cast<uint32_t>(baseline.size() / sizeof(uint32_t)), firstRun.wordCount};
+		memcpy(broken.data() + sizeof(deltaHeader), &run, sizeof(run));
+		CHECK(!SceneSnapshot::ApplyDelta(baseline, broken, restored));
+
+		// truncated delta
+		broken.assign(delta.begin(), delta.end() - sizeof(uint32_t));
+		CHECK(!SceneSnapshot::ApplyDelta(baseline, broken, restored));
+
+		// baseline of other layout
+		header.layoutHash++;
+		CHECK(!SceneSnapshot::ApplyDelta(makeSnapshot(words), delta, restored));
+	}
+
+	void SelfChecks::CheckJobSystem()
+	{
+		JobSystem* jobs = JoyContext::Jobs;
+
+		// every index is visited exactly once, whatever the grain
+		constexpr uint32_t COUNT = 10007;
+		std::unique_ptr<std::atomic<uint32_t>[]> visits(new std::atomic<uint32_t>[COUNT]);
+		for (const uint32_t grain : {0u, 1u, 7u, 64u, COUNT, COUNT * 2})
+		{
+			for (uint32_t i = 0; i < COUNT; i++)
+			{
+				visits[i] = 0;
+			}
+			jobs->ParallelFor(COUNT, [&visits](uint32_t begin, uint32_t end)
+			{
+				CHECK(begin < end && end <= COUNT);
+				for (uint32_t i = begin; i < end; i++)
+				{
+					visits[i].fetch_add(1, std::memory_order_relaxed);
+				}
+			}, grain);
+			for (uint32_t i = 0; i < COUNT; i++)
+			{
+				CHECK(visits[i] == 1);
+			}
+		}
+
+		// more jobs than a worker ring holds, each of them schedules nested jobs and waits for them
+		constexpr uint32_t JOB_COUNT = 5000;
+		constexpr uint32_t NESTED_COUNT = 4;
+		std::atomic<uint32_t> sum = 0;
+		JobCounter counter;
+		for (uint32_t i = 0; i < JOB_COUNT; i++)
+		{
+			jobs->Run([jobs, &sum, i]()
+			{
+				JobCounter nestedCounter;
+				for (uint32_t k = 0; k < NESTED_COUNT; k++)
+				{
+					jobs->Run([&sum, i]() { sum.fetch_add(i, std::memory_order_relaxed); }, &nestedCounter);
+				}
+				jobs->Wait(nestedCounter);
+			}, &counter);
+		}
+		jobs->Wait(counter);
+		CHECK(sum == NESTED_COUNT * (JOB_COUNT * (JOB_COUNT - 1) / 2));
+
+		// dependent jobs start only when all jobs of the dependency are finished
+		std::atomic<uint32_t> finished = 0;
+		std::atomic<uint32_t> startedEarly = 0;
+		JobCounter first;
+		JobCounter second;
+		for (uint32_t i = 0; i < 64; i++)
+		{
+			jobs->Run([&finished]() { finished.fetch_add(1, std::memory_order_release); }, &first);
+		}
+		for (uint32_t i = 0; i < 64; i++)
+		{
+			jobs->Run([&finished, &startedEarly]()
+			{
+				if (finished.load(std::memory_order_acquire) != 64)
+				{
+					startedEarly.fetch_add(1, std::memory_order_relaxed);
+				}
+			}, &second, &first);
+		}
+		jobs->Wait(second);
+		CHECK(first.IsDone() && startedEarly == 0);
+	}
+
+	void SelfChecks::CheckBoundingVolumeHierarchy()
+	{
+		constexpr uint32_t PROXY_COUNT = 1000;
+
+		uint32_t state = 0x2545f491;
+		BoundingVolumeHierarchy tree;
+		std::vector<uint32_t> alive;
+		// user data of a proxy points at its slot, so queries can check it
+		std::vector<uint32_t> slots(PROXY_COUNT * 2);
+
+		auto insert = [&tree, &alive, &slots, &state]()
+		{
+			const uint32_t proxy = tree.Insert(RandomBox(state), nullptr);
+			CHECK(proxy < slots.size());
+			tree.Remove(proxy);
+			// removed proxy handle is reused with the new user data
+			const uint32_t reused = tree.Insert(RandomBox(state), &slots[proxy]);
+			CHECK(reused == proxy);
+			alive.push_back(reused);
+		};
+
+		// every query is compared with a brute force loop over alive proxies
+		auto checkQueries = [&tree, &alive, &slots, &state]()
+		{
+			CHECK(tree.GetProxyCount() == alive.size());
+			// corners of a box are found only if all its ancestors contain it
+			for (const uint32_t proxy : alive)
+			{
+				const AABB& bounds = tree.GetBounds(proxy);
+				for (const glm::vec3 corner : {bounds.min, bounds.max})
+				{
+					bool isFound = false;
+					tree.QuerySphere(corner, 0.0f, [proxy, &isFound](uint32_t other, void*) { isFound |= other == proxy; });
+					CHECK(isFound);
+				}
+			}
+
+			std::vector<uint32_t> found;
+			std::vector<uint32_t> expected;
+			auto compare = [&found, &expected]()
+			{
+				std::sort(found.begin(), found.end());
+				std::sort(expected.begin(), expected.end());
+				CHECK(found == expected);
+				found.clear();
+				expected.clear();
+			};
+
+			for (uint32_t i = 0; i < 8; i++)
+			{
+				const Frustum frustum = RandomFrustum(state);
+				for (const uint32_t proxy : alive)
+				{
+					if (frustum.Test(tree.GetBounds(proxy)) != FrustumTest::Outside) expected.push_back(proxy);
+				}
+				tree.QueryFrustum(frustum, [&slots, &found](uint32_t proxy, void* userData)
+				{
+					CHECK(userData == &slots[proxy]);
+					found.push_back(proxy);
+				});
+				std::vector<uint32_t> visible = expected;
+				compare();
+
+				// broad query may report intersecting proxies which are outside, but never misses one
+				tree.QueryFrustumBroad(frustum, [&tree, &frustum, &found](uint32_t proxy, void*)
+				{
+					CHECK(frustum.Test(tree.GetBounds(proxy)) == FrustumTest::Inside);
+					found.push_back(proxy);
+				}, [&found](uint32_t proxy, void*)
+				{
+					found.push_back(proxy);
+				});
+				std::sort(found.begin(), found.end());
+				std::sort(visible.begin(), visible.end());
+				CHECK(std::includes(found.begin(), found.end(), visible.begin(), visible.end()));
+				found.clear();
+
+				const glm::vec3 center(NextRandom(state, -100, 100), 0, NextRandom(state, -100, 100));
+				const float radius = NextRandom(state, 1, 40);
+				for (const uint32_t proxy : alive)
+				{
+					if (tree.GetBounds(proxy).IntersectsSphere(center, radius)) expected.push_back(proxy);
+				}
+				tree.QuerySphere(center, radius, [&found](uint32_t proxy, void*) { found.push_back(proxy); });
+				compare();
+
+				// nearest hit, farther proxies may be skipped
+				constexpr float MAX_DISTANCE = 1000.0f;
+				const Ray ray(glm::vec3(NextRandom(state, -120, 120), NextRandom(state, -5, 5), -150),
+				              glm::normalize(glm::vec3(NextRandom(state, -1, 1), NextRandom(state, -0.1f, 0.1f), 1)));
+				const glm::vec3 inverseDirection = 1.0f / ray.direction;
+				float nearest = MAX_DISTANCE;
+				for (const uint32_t proxy : alive)
+				{
+					float distance;
+					if (ray.Intersects(tree.GetBounds(proxy), inverseDirection, MAX_DISTANCE, distance))
+					{
+						nearest = std::min(nearest, distance);
+					}
+				}
+				float hit = MAX_DISTANCE;
+				tree.QueryRay(ray, MAX_DISTANCE, [&tree, &ray, &inverseDirection, &hit](uint32_t proxy, void*)
+				{
+					float distance;
+					if (!ray.Intersects(tree.GetBounds(proxy), inverseDirection, MAX_DISTANCE, distance))
+					{
+						return MAX_DISTANCE;
+					}
+					hit = std::min(hit, distance);
+					return distance;
+				});
+				CHECK(hit == nearest);
+			}
+		};
+
+		// incremental inserts
+		for (uint32_t i = 0; i < PROXY_COUNT; i++)
+		{
+			insert();
+		}
+		tree.Update();
+		tree.WaitForRebuild();
+		checkQueries();
+
+		// too few changes for a rebuild, moved leaves are refit or reinserted in place
+		for (uint32_t i = 0; i < alive.size(); i += 10)
+		{
+			const AABB bounds = tree.GetBounds(alive[i]);
+			const glm::vec3 offset = i % 20 == 0
+				                         ? glm::vec3(NextRandom(state, -1, 1), 0, NextRandom(state, -1, 1))
+				                         : glm::vec3(NextRandom(state, -150, 150), 0, NextRandom(state, -150, 150));
+			tree.Move(alive[i], AABB(bounds.min + offset, bounds.max + offset));
+		}
+		tree.Update();
+		checkQueries();
+
+		// small moves are refit, far ones reinserted, enough changes start a rebuild on a worker
+		// and the changes made while it runs are applied after the swap
+		for (uint32_t round = 0; round < 3; round++)
+		{
+			for (uint32_t i = 0; i < alive.size(); i += 3)
+			{
+				const AABB bounds = tree.GetBounds(alive[i]);
+				const glm::vec3 offset = i % 2 == 0
+					                         ? glm::vec3(NextRandom(state, -1, 1), 0, NextRandom(state, -1, 1))
+					                         : glm::vec3(NextRandom(state, -150, 150), 0, NextRandom(state, -150, 150));
+				tree.Move(alive[i], AABB(bounds.min + offset, bounds.max + offset));
+			}
+			tree.Update();
+			for (uint32_t i = 0; i < 50; i++)
+			{
+				const uint32_t index = NextRandom(state) % alive.size();
+				tree.Remove(alive[index]);
+				alive[index] = alive.back();
+				alive.pop_back();
+				insert();
+			}
+			for (uint32_t i = 1; i < alive.size(); i += 7)
+			{
+				tree.Move(alive[i], RandomBox(state));
+			}
+			tree.Update();
+			tree.WaitForRebuild();
+			tree.Update();
+			checkQueries();
+		}
+
+		tree.Rebuild();
+		checkQueries();
+		tree.WaitForRebuild();
+	}
+
+	void SelfChecks::CheckCullingKernels()
+	{
+		// not a multiple of any vector width, so every kernel has a tail
+		constexpr uint32_t BOX_COUNT = 1003;
+
+		uint32_t state = 0x6c078965;
+		std::vector<float> streams[6];
+		for (auto& stream : streams)
+		{
+			stream.resize(BOX_COUNT);
+		}
+		for (uint32_t i = 0; i < BOX_COUNT; i++)
+		{
+			const AABB box = RandomBox(state);
+			for (int k = 0; k < 3; k++)
+			{
+				streams[k][i] = box.GetCenter()[k];
+				streams[k + 3][i] = box.GetExtents()[k];
+			}
+		}
+		const BoundsStreams in = {
+			{streams[0].data(), streams[1].data(), streams[2].data()},
+			{streams[3].data(), streams[4].data(), streams[5].data()}
+		};
+
+		struct Kernel
+		{
+			CullingKernels::CullFunc cull;
+			bool isSupported;
+		};
+		const Kernel kernels[] = {
+			{CullingKernels::CullScalar, true},
+			{CullingKernels::CullSse, IsSse2Supported()},
+			{CullingKernels::CullAvx, IsAvxSupported()},
+			{CullingKernels::Cull, true}
+		};
+		const uint32_t ranges[][2] = {{0, BOX_COUNT}, {3, BOX_COUNT - 5}, {7, 8}, {9, 9}, {1, 20}};
+
+		enum Expected : uint8_t { Culled, Visible, Either };
+		std::vector<Expected> expected(BOX_COUNT);
+		std::vector<uint32_t> visible(BOX_COUNT);
+		for (uint32_t f = 0; f < 8; f++)
+		{
+			// reference in double, boxes touching a plane within rounding error may go either way
+			const Frustum frustum = RandomFrustum(state);
+			for (uint32_t i = 0; i < BOX_COUNT; i++)
+			{
+				expected[i] = Visible;
+				for (const auto& plane : frustum.planes)
+				{
+					double distance = plane.w;
+					double radius = 0;
+					for (int k = 0; k < 3; k++)
+					{
+						distance += static_cast<double>(plane[k]) * streams[k][i];
+						radius += std::abs(static_cast<double>(plane[k])) * streams[k + 3][i];
+					}
+					if (std::abs(distance + radius) < 1e-3)
+					{
+						expected[i] = Either;
+					}
+					else if (distance < -radius)
+					{
+						expected[i] = Culled;
+						break;
+					}
+				}
+			}
+
+			for (const Kernel& kernel : kernels)
+			{
+				if (!kernel.isSupported)
+				{
+					continue;
+				}
+				for (const auto& range : ranges)
+				{
+					const uint32_t count = kernel.cull(frustum, in, range[0], range[1], visible.data());
+					CHECK(count <= range[1] - range[0]);
+					uint32_t next = range[0];
+					for (uint32_t k = 0; k < count; k++)
+					{
+						// ascending, inside the range, culled boxes are skipped only where expected
+						CHECK(visible[k] >= next && visible[k] < range[1]);
+						for (; next < visible[k]; next++)
+						{
+							CHECK(expected[next] != Visible);
+						}
+						CHECK(expected[next] != Culled);
+						next++;
+					}
+					for (; next < range[1]; next++)
+					{
+						CHECK(expected[next] != Visible);
+					}
+				}
+			}
+		}
+	}
+
+	void SelfChecks::CheckRadixSort()
+	{
+		// both sides of the parallel threshold, chunk sizes which don't divide the count
+		const uint32_t counts[] = {0, 1, 2, 100, 4095, 4096, 5000, 70001};
+		// full keys, keys with constant high bytes, constant bytes in between and a single key
+		const uint64_t masks[] = {~0ull, 0xfffull, 0xff00ff00ff00ff00ull, 0};
+
+		uint32_t state = 0x2545f491;
+		RadixSort sort;
+		std::vector<SortItem> items;
+		std::vector<SortItem> expected;
+		for (const uint32_t count : counts)
+		{
+			for (const uint64_t mask : masks)
+			{
+				items.resize(count);
+				for (uint32_t i = 0; i < count; i++)
+				{
+					// few distinct keys under the narrow mask, so equal keys are common
+					const uint64_t random = static_cast<uint64_t>(NextRandom(state)) << 32 | NextRandom(state);
+					items[i] = {(random & mask) | (0x5a5a5a5a5a5a5a5aull & ~mask), i};
+				}
+				expected = items;
+				std::stable_sort(expected.begin(), expected.end(), [](const SortItem& a, const SortItem& b)
+				{
+					return a.key < b.key;
+				});
+
+				sort.Sort(items);
+				// values are the original indices, so equal keys also check stability
+				for (uint32_t i = 0; i < count; i++)
+				{
+					CHECK(items[i].key == expected[i].key && items[i].value == expected[i].value);
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,33 @@
+#ifndef SELF_CHECKS_H
+#define SELF_CHECKS_H
+
+#include <atomic>
+#include <cstdint>
+
+namespace JoyEngine
+{
+	// Deterministic checks of engine algorithms against straightforward reference code.
+	// Run on the main thread, which is worker 0 of JoyContext::Jobs
+	class SelfChecks
+	{
+	public:
+		// returns the number of failed checks, each of them is printed to std::cerr
+		static uint32_t Run();
+
+	private:
+		static void CheckSnapshotDelta();
+
+		static void CheckJobSystem();
+
+		static void CheckBoundingVolumeHierarchy();
+
+		static void CheckCullingKernels();
+
+		static void CheckRadixSort();
+
+	private:
+		static std::atomic<uint32_t> m_failureCount;
+	};
+}
+
+#endif //SELF_CHECKS_H
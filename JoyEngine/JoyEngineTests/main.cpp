@@ -0,0 +1,25 @@
+#include <iostream>
+
+#include "JoyContext.h"
+#include "Common/JobSystem.h"
+
+#include "SelfChecks.h"
+
+int main()
+{
+	// the main thread is attached as worker 0, the same way JoyEngine sets it up
+	JoyEngine::JobSystem jobSystem(0, 1);
+	JoyEngine::JoyContext::Jobs = &jobSystem;
+
+	const uint32_t failureCount = JoyEngine::SelfChecks::Run();
+
+	JoyEngine::JoyContext::Jobs = nullptr;
+
+	if (failureCount != 0)
+	{
+		std::cerr << failureCount << " checks failed" << std::endl;
+		return 1;
+	}
+	std::cout << "All checks passed" << std::endl;
+	return 0;
+}